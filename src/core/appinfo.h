@@ -43,7 +43,7 @@ struct AppInfo
   std::vector<std::string> target_dirs{};
   /*!
    * \brief Number of mods for each \ref Deployer "deployer" belonging to the
-   * \ref ModdedApplication "application".
+   * \ref ModdedApplication "application". -1 for deployers which have not been loaded yet.
    */
   std::vector<int> deployer_mods{};
   /*! \brief For every deployer: Determines how files will be deployed to the target directory. */
@@ -0,0 +1,145 @@
+#include "atomicprogressnode.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+
+AtomicProgressNode::AtomicProgressNode(int id, const std::vector<float>& weights) : id_(id)
+{
+  addChildren(weights);
+}
+
+AtomicProgressNode::AtomicProgressNode(std::function<void(float)> progress_callback,
+                                       const std::vector<float>& weights) : id_(0)
+{
+  addChildren(weights);
+  setProgressCallback(progress_callback);
+}
+
+AtomicProgressNode::AtomicProgressNode(ProgressNode& target) :
+  id_(0), total_steps_(target.totalSteps()), target_(&target)
+{}
+
+AtomicProgressNode::~AtomicProgressNode()
+{
+  if(target_)
+  {
+    sampler_.request_stop();
+    if(sampler_.joinable())
+      sampler_.join();
+    sample();
+  }
+  else if(sampler_.joinable())
+  {
+    sampler_.request_stop();
+    sampler_.join();
+  }
+}
+
+void AtomicProgressNode::advance(uint64_t num_steps)
+{
+  cur_step_.fetch_add(num_steps, std::memory_order_relaxed);
+}
+
+uint64_t AtomicProgressNode::totalSteps() const
+{
+  return total_steps_;
+}
+
+void AtomicProgressNode::setTotalSteps(uint64_t total_steps)
+{
+  if(!children_.empty())
+    throw std::runtime_error("Cannot set total steps for a node with children.");
+  total_steps_ = total_steps;
+}
+
+int AtomicProgressNode::id() const
+{
+  return id_;
+}
+
+void AtomicProgressNode::addChildren(const std::vector<float>& weights)
+{
+  weights_ = weights;
+  for(float& weight : weights_)
+    weight = std::abs(weight);
+  float sum = std::accumulate(weights_.begin(), weights_.end(), 0.0f);
+  if(sum == 0.0f)
+    sum = 1.0f;
+  for(float& weight : weights_)
+    weight /= sum;
+  children_.clear();
+  for(int i = 0; i < weights_.size(); i++)
+    children_.push_back(std::make_unique<AtomicProgressNode>(i));
+}
+
+AtomicProgressNode& AtomicProgressNode::child(int id)
+{
+  return *children_[id];
+}
+
+void AtomicProgressNode::setProgressCallback(std::function<void(float)> progress_callback)
+{
+  progress_callback_ = progress_callback;
+}
+
+float AtomicProgressNode::getProgress() const
+{
+  if(children_.empty())
+  {
+    if(total_steps_ == 0)
+      return cur_step_.load(std::memory_order_relaxed) > 0 ? 1.0f : 0.0f;
+    return std::min(
+      static_cast<float>(cur_step_.load(std::memory_order_relaxed)) / total_steps_, 1.0f);
+  }
+  float progress = 0.0f;
+  for(int i = 0; i < weights_.size(); i++)
+    progress += weights_[i] * children_[i]->getProgress();
+  return progress;
+}
+
+void AtomicProgressNode::startSampling(std::chrono::milliseconds interval)
+{
+  stopSampling();
+  sampler_ = std::jthread(
+    [this, interval](std::stop_token stop_token)
+    {
+      std::mutex mutex;
+      std::condition_variable_any condition;
+      std::unique_lock lock(mutex);
+      while(!stop_token.stop_requested())
+      {
+        condition.wait_for(lock, stop_token, interval, [] { return false; });
+        if(!stop_token.stop_requested())
+          sample();
+      }
+    });
+}
+
+void AtomicProgressNode::stopSampling()
+{
+  if(!sampler_.joinable())
+    return;
+  sampler_.request_stop();
+  sampler_.join();
+  sample();
+}
+
+void AtomicProgressNode::sample()
+{
+  if(target_)
+  {
+    const uint64_t cur_step = cur_step_.load(std::memory_order_relaxed);
+    if(cur_step > forwarded_steps_)
+      target_->advance(cur_step - forwarded_steps_);
+    forwarded_steps_ = cur_step;
+    return;
+  }
+  const float progress = getProgress();
+  if(progress == prev_progress_)
+    return;
+  prev_progress_ = progress;
+  progress_callback_(progress);
+}
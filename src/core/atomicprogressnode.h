@@ -0,0 +1,148 @@
+/*!
+ * \file atomicprogressnode.h
+ * \brief Header for the AtomicProgressNode class.
+ */
+
+#pragma once
+
+#include "progressnode.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+/*!
+ * \brief Represents a node in a tree used to track the progress of a task, which can be
+ * advanced concurrently from multiple threads.
+ *
+ * Unlike ProgressNode, advancing a leaf only increments an atomic counter. The weighted
+ * progress of the tree is computed on demand by \ref getProgress, which is called periodically
+ * by a sampler thread started with \ref startSampling.
+ *
+ * The structure of the tree, i.e. children and total steps, must be set up before worker
+ * threads start advancing it.
+ */
+class AtomicProgressNode
+{
+public:
+  /*!
+   * \brief Constructor.
+   * \param id Id of this node. Used to index weights and children of parent.
+   * \param weights If not empty: Weights of sub-tasks.
+   */
+  AtomicProgressNode(int id, const std::vector<float>& weights = {});
+  /*!
+   * \brief Constructor for a root node.
+   * \param progress_callback A callback function used by the sampler thread of the root node
+   * to inform about changes in the task progress.
+   * \param weights If not empty: Weights of sub-tasks.
+   */
+  AtomicProgressNode(std::function<void(float)> progress_callback,
+                     const std::vector<float>& weights = {});
+  /*!
+   * \brief Constructor for a root leaf node which forwards its progress to the given
+   * ProgressNode leaf. The number of total steps is taken from the target. The sampler
+   * thread advances the target by the number of steps advanced in this node since the last
+   * sample, so that the target is only ever modified by a single thread.
+   * \param target Leaf node to which progress is forwarded.
+   */
+  AtomicProgressNode(ProgressNode& target);
+  /*!
+   * \brief Stops the sampler thread, if it is running. Nodes with a forwarding target
+   * forward all remaining progress.
+   */
+  ~AtomicProgressNode();
+
+  /*! \brief Default interval in which the sampler calls the progress callback. */
+  static constexpr std::chrono::milliseconds DEFAULT_SAMPLE_INTERVAL{ 50 };
+
+  /*!
+   * \brief Advances the current progress of this node by the given amount of steps.
+   * This must be a leaf node. Safe to call from any thread.
+   * \param num_steps Number steps to advance.
+   */
+  void advance(uint64_t num_steps = 1);
+  /*!
+   * \brief Returns the total number of steps in this task.
+   * \return The number of steps.
+   */
+  uint64_t totalSteps() const;
+  /*!
+   * \brief Sets the total number of steps in this task.
+   * \param total_steps The number of steps.
+   */
+  void setTotalSteps(uint64_t total_steps);
+  /*!
+   * \brief Returns the id of this node.
+   * \return The id.
+   */
+  int id() const;
+  /*!
+   * \brief Adds new child nodes with given weights to this node.
+   * \param weights The child weights.
+   */
+  void addChildren(const std::vector<float>& weights);
+  /*!
+   * \brief Returns a reference to the child with the given id.
+   * \param id Target child id.
+   * \return The child.
+   */
+  AtomicProgressNode& child(int id);
+  /*!
+   * \brief Sets a callback function used by the root node to inform about changes in the
+   * task progress.
+   * \param progress_callback The callback function.
+   */
+  void setProgressCallback(std::function<void(float)> progress_callback);
+  /*!
+   * \brief Computes the current progress as the weighted sum of the progress of all
+   * leaves. Safe to call from any thread.
+   * \return The progress.
+   */
+  float getProgress() const;
+  /*!
+   * \brief Starts a thread which calls the progress callback with the current progress in
+   * the given interval, if the progress has changed.
+   * \param interval The interval.
+   */
+  void startSampling(std::chrono::milliseconds interval = DEFAULT_SAMPLE_INTERVAL);
+  /*!
+   * \brief Stops the sampler thread and calls the progress callback with the final progress,
+   * if it has changed since the last sample.
+   */
+  void stopSampling();
+
+private:
+  /*! \brief This nodes id. */
+  int id_;
+  /*! \brief Current step in this task. Only used for leaf nodes. */
+  std::atomic<uint64_t> cur_step_ = 0;
+  /*! \brief Number of total steps in this task. Only used for leaf nodes. */
+  uint64_t total_steps_ = 0;
+  /*! \brief Weights of children. */
+  std::vector<float> weights_;
+  /*!
+   * \brief Children representing sub-tasks of this task. Stored as pointers, since
+   * nodes contain atomics and can not be moved.
+   */
+  std::vector<std::unique_ptr<AtomicProgressNode>> children_;
+  /*! \brief Progress passed to the last call of \ref progress_callback_. */
+  float prev_progress_ = -1.0f;
+  /*! \brief Callback function used to inform about changes in the task progress. */
+  std::function<void(float)> progress_callback_ = [](float f) {};
+  /*! \brief If not null: Leaf node to which advanced steps are forwarded. */
+  ProgressNode* target_ = nullptr;
+  /*! \brief Number of steps which have already been forwarded to \ref target_. */
+  uint64_t forwarded_steps_ = 0;
+  /*! \brief Thread which periodically calls \ref progress_callback_. */
+  std::jthread sampler_;
+
+  /*!
+   * \brief Calls \ref progress_callback_ if the progress has changed since the last call.
+   * If \ref target_ is set, advances it instead.
+   */
+  void sample();
+};
@@ -46,7 +46,7 @@ public:
    * fulfill its conditions.
    * \param files Maps mod ids to a vector of pairs of paths and file names for that mod.
    * \param mods Iterable container containing int ids of all mods to be checked.
-   * \param progress_node Used to inform about progress.
+   * \param progress_node Used to inform about progress and to check for cancellation.
    */
   template<typename View>
   void reapplyMods(const std::map<int, std::vector<std::pair<std::string, std::string>>>& files,
@@ -59,7 +59,10 @@ public:
       if(evaluator_.evaluate(files.at(mod)))
         mods_.push_back(mod);
       if(progress_node)
+      {
+        (*progress_node)->checkCanceled();
         (*progress_node)->advance();
+      }
     }
   }
   /*!
@@ -81,7 +84,7 @@ public:
    * from all given mods when needed.
    * \param files Maps mod ids to a vector of pairs of paths and file names for that mod.
    * \param mods Iterable container containing int ids of all mods to be checked.
-   * \param progress_node Used to inform about progress.
+   * \param progress_node Used to inform about progress and to check for cancellation.
    */
   template<typename View>
   void updateMods(const std::map<int, std::vector<std::pair<std::string, std::string>>>& files,
@@ -96,7 +99,10 @@ public:
       if(evaluator_.evaluate(files.at(mod)))
         mods_.push_back(mod);
       if(progress_node)
+      {
+        (*progress_node)->checkCanceled();
         (*progress_node)->advance();
+      }
     }
   }
   /*!
@@ -151,7 +157,7 @@ public:
    * This vector is used as input for the reapplyMods and updateMods functions.
    * \param staging_dir Staging directory for the given mods.
    * \param mods Iterable container containing int ids of all mods to be checked.
-   * \param progress_node Used to inform about progress.
+   * \param progress_node Used to inform about progress and to check for cancellation.
    * \return The map.
    */
   template<typename View>
@@ -173,7 +179,10 @@ public:
         files[mod].emplace_back(path, dir_entry.path().filename().string());
       }
       if(progress_node)
+      {
+        (*progress_node)->checkCanceled();
         (*progress_node)->advance();
+      }
     }
     return files;
   }
@@ -1,11 +1,21 @@
 #include "backupmanager.h"
+#include "cancellationerror.h"
 #include "parseerror.h"
 #include "pathutils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <format>
 #include <fstream>
+#include <map>
+#include <ranges>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
 
 namespace sfs = std::filesystem;
 namespace pu = path_utils;
+namespace str = std::ranges;
 
 
 void BackupManager::addTarget(const sfs::path& path,
@@ -36,8 +46,8 @@ void BackupManager::addTarget(const sfs::path& path,
                           std::vector<int>(num_profiles_, 0));
     for(int i = 1; i < backup_names.size(); i++)
       addBackup(targets_.size() - 1, backup_names[i]);
+    updateSettings(targets_.size() - 1);
   }
-  updateSettings();
 }
 
 void BackupManager::addTarget(const sfs::path& path)
@@ -58,7 +68,10 @@ void BackupManager::addTarget(const sfs::path& path)
   updateState();
 }
 
-void BackupManager::addBackup(int target_id, const std::string& name, int source)
+void BackupManager::addBackup(int target_id,
+                              const std::string& name,
+                              int source,
+                              std::optional<ProgressNode*> progress_node)
 {
   if(target_id < 0 || target_id >= targets_.size())
     throw std::runtime_error(std::format("Invalid target id: {}", target_id));
@@ -69,24 +82,51 @@ void BackupManager::addBackup(int target_id, const std::string& name, int source
     source_path = getBackupPath(target_id, source);
   else
     source_path = getBackupPath(target_id, target.active_members[cur_profile_]);
-  sfs::copy(source_path,
-            getBackupPath(target.path, target.backup_names.size()),
-            sfs::copy_options::recursive | sfs::copy_options::copy_symlinks);
+  const bool source_is_active = source_path == target.path;
+  if(target.use_chunk_store)
+  {
+    const auto store = getChunkStore(target_id);
+    const std::string new_id = std::to_string(target.backup_names.size());
+    if(source_is_active)
+      store.storeSnapshot(target.path, new_id);
+    else
+      store.copySnapshot(std::to_string(source), new_id);
+  }
+  else
+  {
+    const sfs::path dest_path = getBackupPath(target.path, target.backup_names.size());
+    try
+    {
+      createSnapshot(source_path, dest_path, !source_is_active, progress_node);
+    }
+    catch(CancellationError& error)
+    {
+      sfs::remove_all(dest_path);
+      throw;
+    }
+  }
   target.backup_names.push_back(name);
-  updateSettings();
+  updateSettings(target_id);
+  setDirectoriesVerified(target_id);
 }
 
 void BackupManager::removeTarget(int target_id)
 {
-  for(int backup = 0; backup < targets_[target_id].backup_names.size(); backup++)
+  if(targets_[target_id].use_chunk_store)
+    sfs::remove_all(getChunkStore(target_id).getPath());
+  else
   {
-    if(backup == targets_[target_id].active_members[cur_profile_])
-      continue;
-    const auto path = getBackupPath(target_id, backup);
-    sfs::remove_all(path);
+    for(int backup = 0; backup < targets_[target_id].backup_names.size(); backup++)
+    {
+      if(backup == targets_[target_id].active_members[cur_profile_])
+        continue;
+      const auto path = getBackupPath(target_id, backup);
+      sfs::remove_all(path);
+    }
   }
   const auto config_file = getConfigPath(targets_[target_id].path);
   sfs::remove(config_file);
+  verified_dir_times_.erase(targets_[target_id].path);
   targets_.erase(targets_.begin() + target_id);
 }
 
@@ -108,17 +148,34 @@ void BackupManager::removeBackup(int target_id, int backup_id, bool update_dirs)
     setActiveBackup(target_id, backup_id == 0 ? 1 : 0);
   for(int prof = 0; prof < num_profiles_; prof++)
     target.active_members[prof] = 0;
-  sfs::path backup_path = getBackupPath(target.path, backup_id);
-  sfs::remove_all(backup_path);
-  for(int i = backup_id + 1; i < target.backup_names.size(); i++)
+  if(target.use_chunk_store)
   {
-    sfs::path cur_path = getBackupPath(target.path, i);
-    if(sfs::exists(cur_path))
-      sfs::rename(cur_path, getBackupPath(target.path, i - 1));
+    const auto store = getChunkStore(target_id);
+    store.removeSnapshot(std::to_string(backup_id));
+    for(int i = backup_id + 1; i < target.backup_names.size(); i++)
+    {
+      if(store.hasSnapshot(std::to_string(i)))
+        store.renameSnapshot(std::to_string(i), std::to_string(i - 1));
+    }
+    store.collectGarbage();
+  }
+  else
+  {
+    sfs::path backup_path = getBackupPath(target.path, backup_id);
+    sfs::remove_all(backup_path);
+    for(int i = backup_id + 1; i < target.backup_names.size(); i++)
+    {
+      sfs::path cur_path = getBackupPath(target.path, i);
+      if(sfs::exists(cur_path))
+        sfs::rename(cur_path, getBackupPath(target.path, i - 1));
+    }
   }
   target.backup_names.erase(target.backup_names.begin() + backup_id);
   if(update_dirs)
-    updateSettings();
+  {
+    updateSettings(target_id);
+    setDirectoriesVerified(target_id);
+  }
 }
 
 void BackupManager::setActiveBackup(int target_id, int backup_id)
@@ -133,11 +190,24 @@ void BackupManager::setActiveBackup(int target_id, int backup_id)
   int active_id = target.active_members[cur_profile_];
   if(backup_id == active_id)
     return;
-  sfs::rename(target.path, getBackupPath(target.path, active_id));
-  sfs::rename(getBackupPath(target.path, backup_id), target.path);
+  if(target.use_chunk_store)
+  {
+    const auto store = getChunkStore(target_id);
+    store.storeSnapshot(target.path, std::to_string(active_id));
+    restoreFromChunkStore(target_id, backup_id);
+    store.removeSnapshot(std::to_string(backup_id));
+    store.collectGarbage();
+  }
+  else
+  {
+    sfs::rename(target.path, getBackupPath(target.path, active_id));
+    sfs::rename(getBackupPath(target.path, backup_id), target.path);
+    breakHardLinks(target_id);
+  }
   target.active_members[cur_profile_] = backup_id;
   target.cur_active_member = backup_id;
-  updateSettings();
+  updateSettings(target_id);
+  setDirectoriesVerified(target_id);
 }
 
 void BackupManager::setProfile(int profile)
@@ -206,6 +276,7 @@ std::vector<BackupTarget> BackupManager::getTargets() const
 void BackupManager::reset()
 {
   targets_.clear();
+  verified_dir_times_.clear();
   num_profiles_ = 0;
 }
 
@@ -222,13 +293,13 @@ int BackupManager::getNumBackups(int target_id)
 void BackupManager::setBackupName(int target_id, int backup_id, const std::string& name)
 {
   targets_[target_id].backup_names[backup_id] = name;
-  updateSettings();
+  updateSettings(target_id);
 }
 
 void BackupManager::setBackupTargetName(int target_id, const std::string& name)
 {
   targets_[target_id].target_name = name;
-  updateSettings();
+  updateSettings(target_id);
 }
 
 void BackupManager::overwriteBackup(int target_id, int source_backup, int dest_backup)
@@ -237,9 +308,54 @@ void BackupManager::overwriteBackup(int target_id, int source_backup, int dest_b
     return;
   const auto source_path = getBackupPath(target_id, source_backup);
   const auto dest_path = getBackupPath(target_id, dest_backup);
-  sfs::remove_all(dest_path);
-  sfs::copy(
-    source_path, dest_path, sfs::copy_options::recursive | sfs::copy_options::overwrite_existing);
+  const bool involves_active = source_path == targets_[target_id].path ||
+                               dest_path == targets_[target_id].path;
+  if(targets_[target_id].use_chunk_store)
+  {
+    const auto store = getChunkStore(target_id);
+    if(dest_path == targets_[target_id].path)
+      restoreFromChunkStore(target_id, source_backup);
+    else if(source_path == targets_[target_id].path)
+      store.storeSnapshot(source_path, std::to_string(dest_backup));
+    else
+      store.copySnapshot(std::to_string(source_backup), std::to_string(dest_backup));
+    store.collectGarbage();
+  }
+  else
+  {
+    sfs::remove_all(dest_path);
+    createSnapshot(source_path, dest_path, !involves_active);
+  }
+  setDirectoriesVerified(target_id);
+}
+
+void BackupManager::setUseChunkStore(int target_id, bool use_chunk_store)
+{
+  if(target_id < 0 || target_id >= targets_.size())
+    throw std::runtime_error(std::format("Invalid target id: {}", target_id));
+  updateDirectories(target_id);
+  auto& target = targets_[target_id];
+  if(target.use_chunk_store == use_chunk_store)
+    return;
+  const auto store = getChunkStore(target_id);
+  for(int backup = 0; backup < target.backup_names.size(); backup++)
+  {
+    if(backup == target.active_members[cur_profile_])
+      continue;
+    const auto backup_path = getBackupPath(target.path, backup);
+    if(use_chunk_store)
+    {
+      store.storeSnapshot(backup_path, std::to_string(backup));
+      sfs::remove_all(backup_path);
+    }
+    else
+      store.restoreSnapshot(std::to_string(backup), backup_path);
+  }
+  if(!use_chunk_store)
+    sfs::remove_all(store.getPath());
+  target.use_chunk_store = use_chunk_store;
+  updateSettings(target_id);
+  setDirectoriesVerified(target_id);
 }
 
 void BackupManager::setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log)
@@ -249,11 +365,19 @@ void BackupManager::setLog(const std::function<void(Log::LogLevel, const std::st
 
 void BackupManager::updateDirectories(int target_id)
 {
+  const auto iter = verified_dir_times_.find(targets_[target_id].path);
+  if(iter != verified_dir_times_.end() && iter->second == getDirectoryTimes(target_id))
+    return;
+
   std::vector<int> missing_dirs;
   for(int backup_id = 0; backup_id < targets_[target_id].backup_names.size(); backup_id++)
   {
-    if(!sfs::exists(getBackupPath(targets_[target_id].path, backup_id)) &&
-       backup_id != targets_[target_id].active_members[cur_profile_])
+    if(backup_id == targets_[target_id].active_members[cur_profile_])
+      continue;
+    const bool exists = targets_[target_id].use_chunk_store
+                          ? getChunkStore(target_id).hasSnapshot(std::to_string(backup_id))
+                          : sfs::exists(getBackupPath(targets_[target_id].path, backup_id));
+    if(!exists)
       missing_dirs.push_back(backup_id);
   }
 
@@ -287,6 +411,26 @@ void BackupManager::updateDirectories(int target_id)
       extra_dirs.push_back(dir_entry.path());
   }
 
+  if(targets_[target_id].use_chunk_store)
+  {
+    const auto store = getChunkStore(target_id);
+    for(const auto& name : store.getSnapshots())
+    {
+      if(name.empty() || name.find_first_not_of("0123456789") != name.npos)
+        continue;
+      const int id = std::stoi(name);
+      if(id < targets_[target_id].backup_names.size() &&
+         id != targets_[target_id].active_members[cur_profile_])
+        continue;
+      log_(Log::LOG_WARNING,
+           std::format("Unknown backup \"{}\" found in \"{}\". Renaming to \"{}OLD\".",
+                       name,
+                       store.getPath().string(),
+                       name));
+      store.renameSnapshot(name, name + "OLD");
+    }
+  }
+
   for(const auto& path : extra_dirs)
   {
     sfs::path new_path = path.string() + "OLD";
@@ -298,18 +442,40 @@ void BackupManager::updateDirectories(int target_id)
            "Unknown backup found at \"{}\". Moving to \"{}\".", path.string(), new_path.string()));
     sfs::rename(path, new_path);
   }
-  updateSettings();
+  if(!missing_dirs.empty())
+    updateSettings(target_id);
+  setDirectoriesVerified(target_id);
 }
 
 void BackupManager::updateDirectories()
 {
   for(int target_id = 0; target_id < targets_.size(); target_id++)
     updateDirectories(target_id);
-  updateSettings();
+}
+
+std::vector<sfs::file_time_type> BackupManager::getDirectoryTimes(int target_id) const
+{
+  std::vector<sfs::file_time_type> times{
+    sfs::last_write_time(targets_[target_id].path.parent_path())
+  };
+  if(targets_[target_id].use_chunk_store)
+    times.push_back(getChunkStore(target_id).getSnapshotsWriteTime());
+  return times;
+}
+
+void BackupManager::setDirectoriesVerified(int target_id)
+{
+  const auto times = getDirectoryTimes(target_id);
+  const auto now = sfs::file_time_type::clock::now();
+  if(str::any_of(times, [now](auto time) { return now - time < MIN_CACHED_TIME_AGE; }))
+    verified_dir_times_.erase(targets_[target_id].path);
+  else
+    verified_dir_times_[targets_[target_id].path] = times;
 }
 
 void BackupManager::updateState()
 {
+  verified_dir_times_.clear();
   for(auto& target : targets_)
   {
     const auto settings = readSettings(getConfigPath(target.path));
@@ -345,6 +511,7 @@ void BackupManager::updateState()
       throw ParseError(
         std::format("Failed to parse active_members in \"{}\".", target.path.string()));
     target.target_name = settings["target_name"].asString();
+    target.use_chunk_store = settings.get("use_chunk_store", false).asBool();
     target.backup_names = new_names;
     target.active_members = new_active_members;
   }
@@ -353,17 +520,22 @@ void BackupManager::updateState()
 
 void BackupManager::updateSettings()
 {
-  for(const auto& target : targets_)
-  {
-    Json::Value settings;
-    settings["path"] = target.path.string();
-    settings["target_name"] = target.target_name;
-    for(int i = 0; i < target.backup_names.size(); i++)
-      settings["backup_names"][i] = target.backup_names[i];
-    for(int i = 0; i < target.active_members.size(); i++)
-      settings["active_members"][i] = target.active_members[i];
-    writeSettings(getConfigPath(target.path), settings);
-  }
+  for(int target_id = 0; target_id < targets_.size(); target_id++)
+    updateSettings(target_id);
+}
+
+void BackupManager::updateSettings(int target_id)
+{
+  const auto& target = targets_[target_id];
+  Json::Value settings;
+  settings["path"] = target.path.string();
+  settings["target_name"] = target.target_name;
+  settings["use_chunk_store"] = target.use_chunk_store;
+  for(int i = 0; i < target.backup_names.size(); i++)
+    settings["backup_names"][i] = target.backup_names[i];
+  for(int i = 0; i < target.active_members.size(); i++)
+    settings["active_members"][i] = target.active_members[i];
+  writeSettings(getConfigPath(target.path), settings);
 }
 
 void BackupManager::writeSettings(const sfs::path& path, const Json::Value& settings) const
@@ -410,3 +582,187 @@ sfs::path BackupManager::getBackupPath(int target, int backup) const
     return file_path;
   return getBackupPath(file_path, backup);
 }
+
+ChunkStore BackupManager::getChunkStore(int target_id) const
+{
+  const sfs::path& path = targets_[target_id].path;
+  ChunkStore store(path.parent_path() / ("." + path.filename().string() + STORE_EXTENSION));
+  store.setLog(log_);
+  return store;
+}
+
+void BackupManager::restoreFromChunkStore(int target_id, int backup_id) const
+{
+  // Restore to a temporary path first, so the active backup is only replaced on success
+  const sfs::path& path = targets_[target_id].path;
+  const sfs::path tmp_path = path.string() + RESTORE_EXTENSION;
+  if(pu::exists(tmp_path))
+    sfs::remove_all(tmp_path);
+  getChunkStore(target_id).restoreSnapshot(std::to_string(backup_id), tmp_path);
+  sfs::remove_all(path);
+  sfs::rename(tmp_path, path);
+}
+
+void BackupManager::createSnapshot(const sfs::path& source,
+                                   const sfs::path& dest,
+                                   bool allow_hard_links,
+                                   std::optional<ProgressNode*> progress_node) const
+{
+  const auto start_time = std::chrono::high_resolution_clock::now();
+  std::vector<std::pair<sfs::path, sfs::path>> files;
+  if(sfs::is_directory(source) && !sfs::is_symlink(source))
+  {
+    sfs::create_directories(dest);
+    for(const auto& dir_entry : sfs::recursive_directory_iterator(source))
+    {
+      const sfs::path dest_path = dest / pu::getRelativePath(dir_entry.path(), source);
+      if(dir_entry.is_symlink())
+        sfs::copy_symlink(dir_entry.path(), dest_path);
+      else if(dir_entry.is_directory())
+        sfs::create_directories(dest_path);
+      else
+        files.emplace_back(dir_entry.path(), dest_path);
+    }
+  }
+  else if(sfs::is_symlink(source))
+    sfs::copy_symlink(source, dest);
+  else
+    files.emplace_back(source, dest);
+  if(files.empty())
+    return;
+
+  std::string method;
+  auto remaining_files = files;
+  if(pu::reflinkFile(files[0].first, files[0].second))
+  {
+    method = "reflinks";
+    remaining_files.clear();
+    for(const auto& [source_file, dest_file] : files | std::views::drop(1))
+    {
+      if(progress_node)
+        (*progress_node)->checkCanceled();
+      if(!pu::reflinkFile(source_file, dest_file))
+        remaining_files.emplace_back(source_file, dest_file);
+    }
+  }
+  else if(allow_hard_links)
+  {
+    method = "hard links";
+    remaining_files.clear();
+    for(const auto& [source_file, dest_file] : files)
+    {
+      if(progress_node)
+        (*progress_node)->checkCanceled();
+      std::error_code error;
+      sfs::create_hard_link(source_file, dest_file, error);
+      if(error)
+        remaining_files.emplace_back(source_file, dest_file);
+    }
+  }
+  else
+    method = "copies";
+  copyFilesInParallel(remaining_files, progress_node);
+
+  const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::high_resolution_clock::now() - start_time);
+  log_(Log::LOG_DEBUG,
+       std::format("Created snapshot of \"{}\" with {} files using {} in {}ms. {} files had to "
+                   "be copied.",
+                   source.string(),
+                   files.size(),
+                   method,
+                   duration.count(),
+                   remaining_files.size()));
+}
+
+void BackupManager::breakHardLinks(int target_id) const
+{
+  const auto& target = targets_[target_id];
+  auto get_linked_files = [](const sfs::path& path)
+  {
+    std::map<std::pair<dev_t, ino_t>, sfs::path> linked_files;
+    auto add_file = [&linked_files](const sfs::path& file)
+    {
+      struct stat file_stat;
+      if(lstat(file.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+         file_stat.st_nlink > 1)
+        linked_files[{ file_stat.st_dev, file_stat.st_ino }] = file;
+    };
+    if(sfs::is_directory(path) && !sfs::is_symlink(path))
+    {
+      for(const auto& dir_entry : sfs::recursive_directory_iterator(path))
+        add_file(dir_entry.path());
+    }
+    else
+      add_file(path);
+    return linked_files;
+  };
+
+  const auto target_files = get_linked_files(target.path);
+  if(target_files.empty())
+    return;
+  // Only links shared with other backups are replaced, links created by other programs are kept
+  std::set<sfs::path> shared_files;
+  for(int backup = 0; backup < target.backup_names.size(); backup++)
+  {
+    const auto backup_path = getBackupPath(target.path, backup);
+    if(!pu::exists(backup_path))
+      continue;
+    for(const auto& [inode, path] : get_linked_files(backup_path))
+    {
+      auto iter = target_files.find(inode);
+      if(iter != target_files.end())
+        shared_files.insert(iter->second);
+    }
+  }
+  std::vector<std::pair<sfs::path, sfs::path>> copies;
+  for(const auto& file : shared_files)
+    copies.emplace_back(file, file.string() + ".tmpcopy");
+  copyFilesInParallel(copies);
+  for(const auto& [file, copy] : copies)
+    sfs::rename(copy, file);
+  if(!copies.empty())
+    log_(Log::LOG_DEBUG,
+         std::format("Replaced {} hard links in \"{}\".", copies.size(), target.path.string()));
+}
+
+void BackupManager::copyFilesInParallel(
+  const std::vector<std::pair<sfs::path, sfs::path>>& files,
+  std::optional<ProgressNode*> progress_node) const
+{
+  if(files.empty())
+    return;
+  const int num_threads = std::clamp(
+    static_cast<int>(std::thread::hardware_concurrency()), 1, static_cast<int>(files.size()));
+  std::atomic<int> next_file = 0;
+  std::atomic<bool> has_error = false;
+  std::string error_message;
+  auto copy_files = [&]()
+  {
+    for(int i = next_file++; i < files.size() && !has_error; i = next_file++)
+    {
+      if(progress_node && (*progress_node)->isCanceled())
+        return;
+      try
+      {
+        sfs::copy_file(
+          files[i].first, files[i].second, sfs::copy_options::overwrite_existing);
+      }
+      catch(sfs::filesystem_error& error)
+      {
+        if(!has_error.exchange(true))
+          error_message = error.what();
+      }
+    }
+  };
+  std::vector<std::jthread> threads;
+  for(int i = 1; i < num_threads; i++)
+    threads.emplace_back(copy_files);
+  copy_files();
+  for(auto& thread : threads)
+    thread.join();
+  if(has_error)
+    throw std::runtime_error(error_message);
+  if(progress_node)
+    (*progress_node)->checkCanceled();
+}
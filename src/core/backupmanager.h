@@ -6,10 +6,14 @@
 #pragma once
 
 #include "backuptarget.h"
+#include "chunkstore.h"
 #include "log.h"
+#include "progressnode.h"
+#include <chrono>
 #include <filesystem>
 #include <functional>
 #include <json/json.h>
+#include <map>
 #include <vector>
 
 
@@ -47,8 +51,15 @@ public:
    * \param name Display name for the new backup.
    * \param source Backup from which to copy files to create the new backup. If -1:
    * copy currently active backup.
+   * \param progress_node Used to check for cancellation. Snapshots stored in a chunk store
+   * can not be canceled.
+   * \throws CancellationError If the operation has been canceled. No backup is added in this
+   * case.
    */
-  void addBackup(int target_id, const std::string& name, int source = -1);
+  void addBackup(int target_id,
+                 const std::string& name,
+                 int source = -1,
+                 std::optional<ProgressNode*> progress_node = {});
   /*!
    * \brief Deletes the given backup for given target.
    * \param target_id Target from which to delete a backup.
@@ -116,6 +127,14 @@ public:
    * \param dest_backup Target for data deletion.
    */
   void overwriteBackup(int target_id, int source_backup, int dest_backup);
+  /*!
+   * \brief Enables or disables the use of a deduplicated and compressed
+   * \ref ChunkStore "chunk store" for the inactive backups of the given target.
+   * Existing backups are converted.
+   * \param target_id Target to modify.
+   * \param use_chunk_store If true: Store backups in a chunk store.
+   */
+  void setUseChunkStore(int target_id, bool use_chunk_store);
   /*!
    * \brief Setter for log callback.
    * \param new_log New log callback
@@ -127,15 +146,31 @@ private:
   static inline const std::string BAK_EXTENSION = ".lmmbakman";
   /*! \brief File extension used for the files used to store a targets state. */
   static inline const std::string JSON_EXTENSION = BAK_EXTENSION + ".json";
+  /*! \brief File extension used for chunk store directories. */
+  static inline const std::string STORE_EXTENSION = BAK_EXTENSION + ".store";
+  /*! \brief Extension used for temporary directories while a backup is restored. */
+  static inline const std::string RESTORE_EXTENSION = BAK_EXTENSION + ".tmprestore";
   /*! \brief Contains all managed targets. */
   std::vector<BackupTarget> targets_{};
   /*! \brief Number of profiles. */
   int num_profiles_ = 0;
   /*! \brief Currently active profile. */
   int cur_profile_ = -1;
+  /*!
+   * \brief Minimal age of a directory modification time for it to be cached. Younger
+   * times are not cached, since changes made within the timestamp granularity of the
+   * filesystem can not be detected.
+   */
+  static constexpr std::chrono::seconds MIN_CACHED_TIME_AGE{ 2 };
   /*! \brief Callback for logging. */
   std::function<void(Log::LogLevel, const std::string&)> log_ = [](Log::LogLevel a,
                                                                    const std::string& b) {};
+  /*!
+   * \brief Maps target paths to the modification times of all directories containing their
+   * backups at the time of their last verification by \ref updateDirectories.
+   */
+  std::map<std::filesystem::path, std::vector<std::filesystem::file_time_type>>
+    verified_dir_times_;
 
   /*!
    * \brief Ensures consistency with the data on disk.
@@ -152,14 +187,33 @@ private:
    * This is accomplished by deleting backups for which
    * no file exists and renaming files on disk which should by filename and extension be a
    * backup but have an invalid id. This is done for all files matching the filename
-   * and path of the given target.
+   * and path of the given target. Skipped if no directory containing backups of the
+   * target has been modified since the last check.
    * \param target_id Target to check.
    */
   void updateDirectories(int target_id);
+  /*!
+   * \brief Returns the modification times of all directories containing backups of the
+   * given target.
+   * \param target_id Target for which to get the times.
+   * \return The times.
+   */
+  std::vector<std::filesystem::file_time_type> getDirectoryTimes(int target_id) const;
+  /*!
+   * \brief Marks the directories containing backups of the given target as consistent with
+   * the internal state, which allows \ref updateDirectories to skip them.
+   * \param target_id Target to mark.
+   */
+  void setDirectoriesVerified(int target_id);
   /*! \brief Updates internal state by parsing every targets state file. */
   void updateState();
   /*! \brief Updates every targets state file with the internal state. */
   void updateSettings();
+  /*!
+   * \brief Updates the state file of the given target with the internal state.
+   * \param target_id Target to update.
+   */
+  void updateSettings(int target_id);
   /*!
    * \brief Writes the given json object to disk.
    * \param path Path to write to.
@@ -193,4 +247,47 @@ private:
    * \return The path.
    */
   std::filesystem::path getBackupPath(int target, int backup) const;
+  /*!
+   * \brief Returns the chunk store for the given target.
+   * \param target_id Target for which to get the store.
+   * \return The store.
+   */
+  ChunkStore getChunkStore(int target_id) const;
+  /*!
+   * \brief Replaces the active backup of the given target with a snapshot from its chunk store.
+   * \param target_id Target to modify.
+   * \param backup_id Backup to restore.
+   */
+  void restoreFromChunkStore(int target_id, int backup_id) const;
+  /*!
+   * \brief Creates a copy of the given file or directory.
+   *
+   * Files are reflinked if the filesystem supports this. Otherwise, if allowed, hard links are
+   * created. Since the active backup is modified in place by other programs, hard links
+   * must never be shared with it. They are replaced with real copies by \ref breakHardLinks
+   * when a backup is activated. If neither method is available, files are copied in parallel.
+   * \param source Source file or directory.
+   * \param dest Destination path. Must not exist.
+   * \param allow_hard_links If true: Hard links may be used instead of copies.
+   * \param progress_node Used to check for cancellation.
+   */
+  void createSnapshot(const std::filesystem::path& source,
+                      const std::filesystem::path& dest,
+                      bool allow_hard_links,
+                      std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief Replaces every file in the active backup of the given target which shares a hard link
+   * with another backup with a copy.
+   * \param target_id Target to check.
+   */
+  void breakHardLinks(int target_id) const;
+  /*!
+   * \brief Copies the given files using multiple threads.
+   * \param files Pairs of source and destination paths.
+   * \param progress_node Used to check for cancellation. Files which are being copied when
+   * the operation is canceled are still completed.
+   */
+  void copyFilesInParallel(
+    const std::vector<std::pair<std::filesystem::path, std::filesystem::path>>& files,
+    std::optional<ProgressNode*> progress_node = {}) const;
 };
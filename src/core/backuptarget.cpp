@@ -16,6 +16,7 @@ bool BackupTarget::operator==(const BackupTarget& other) const
     if(active_members[i] != other.active_members[i])
       return false;
   return path == other.path && target_name == other.target_name &&
+         use_chunk_store == other.use_chunk_store &&
          backup_names.size() == other.backup_names.size() &&
          active_members.size() == other.active_members.size();
 }
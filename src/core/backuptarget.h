@@ -24,6 +24,11 @@ struct BackupTarget
   std::vector<int> active_members;
   /*! \brief Active member for current profile. */
   int cur_active_member = 0;
+  /*!
+   * \brief If true: Inactive backups are stored in a deduplicated and compressed
+   * \ref ChunkStore "chunk store" instead of as full copies.
+   */
+  bool use_chunk_store = false;
 
   /*!
    * \brief Constructor.
@@ -0,0 +1,346 @@
+#include "batchrunner.h"
+#include "moddedapplication.h"
+#include "nexus/api.h"
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <thread>
+
+namespace sfs = std::filesystem;
+namespace str = std::ranges;
+
+
+BatchRunner::BatchRunner(const std::vector<sfs::path>& staging_dirs) : staging_dirs_(staging_dirs)
+{}
+
+void BatchRunner::addCommand(const std::string& command)
+{
+  if(str::find(COMMANDS, command) == COMMANDS.end())
+    throw std::runtime_error(std::format("Unknown command: '{}'.", command));
+  commands_.push_back(command);
+}
+
+void BatchRunner::addTarget(int app_id, std::optional<int> profile)
+{
+  if(app_id < 0 || app_id >= staging_dirs_.size())
+    throw std::runtime_error(std::format("Application index {} is out of bounds.", app_id));
+  targets_.push_back({ app_id, profile });
+}
+
+void BatchRunner::setPathPrefix(const std::string& prefix)
+{
+  path_prefix_ = prefix;
+}
+
+void BatchRunner::setRollbackTarget(int deployer, int generation)
+{
+  rollback_target_ = { deployer, generation };
+}
+
+Json::Value BatchRunner::run() const
+{
+  std::vector<Target> targets = targets_;
+  if(targets.empty())
+  {
+    for(int i = 0; i < staging_dirs_.size(); i++)
+      targets.push_back({ i, {} });
+  }
+
+  std::vector<Json::Value> app_results(targets.size());
+  std::atomic<int> next_target = 0;
+  auto run_targets = [&]()
+  {
+    for(int i = next_target++; i < targets.size(); i = next_target++)
+      app_results[i] = runForTarget(targets[i]);
+  };
+  const int num_threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()),
+                                     1,
+                                     std::max(1, static_cast<int>(targets.size())));
+  std::vector<std::jthread> threads;
+  for(int i = 1; i < num_threads; i++)
+    threads.emplace_back(run_targets);
+  run_targets();
+  for(auto& thread : threads)
+    thread.join();
+
+  Json::Value result;
+  result["success"] = true;
+  result["apps"] = Json::arrayValue;
+  for(const auto& app_result : app_results)
+  {
+    if(!app_result["success"].asBool())
+      result["success"] = false;
+    result["apps"].append(app_result);
+  }
+  return result;
+}
+
+Json::Value BatchRunner::runForTarget(const Target& target) const
+{
+  static const std::map<Log::LogLevel, std::string> level_names = {
+    { Log::LOG_ERROR, "error" },
+    { Log::LOG_WARNING, "warning" },
+    { Log::LOG_INFO, "info" },
+    { Log::LOG_DEBUG, "debug" }
+  };
+
+  Json::Value result;
+  result["id"] = target.app_id;
+  result["staging_dir"] = staging_dirs_[target.app_id].string();
+  result["success"] = true;
+  result["log"] = Json::arrayValue;
+  result["commands"] = Json::arrayValue;
+  // deployers may log from multiple threads
+  std::mutex log_mutex;
+  Json::Value& log_entries = result["log"];
+  auto log = [&log_entries, &log_mutex](Log::LogLevel level, const std::string& message)
+  {
+    if(level > Log::log_level)
+      return;
+    Json::Value entry;
+    entry["level"] = level_names.at(level);
+    entry["message"] = message;
+    std::lock_guard lock(log_mutex);
+    log_entries.append(entry);
+  };
+
+  std::optional<ModdedApplication> app;
+  try
+  {
+    app.emplace(staging_dirs_[target.app_id]);
+    app->setLog(log);
+    result["name"] = app->name();
+    if(target.profile)
+    {
+      if(*target.profile < 0 || *target.profile >= app->getProfileNames().size())
+        throw std::runtime_error(
+          std::format("Profile index {} is out of bounds.", *target.profile));
+      app->setProfile(*target.profile);
+    }
+  }
+  catch(std::exception& error)
+  {
+    result["success"] = false;
+    result["error"] = error.what();
+    return result;
+  }
+
+  for(const auto& command : commands_)
+  {
+    Json::Value command_result;
+    command_result["command"] = command;
+    try
+    {
+      if(command == DEPLOY)
+        app->deployMods();
+      else if(command == UNDEPLOY)
+        app->unDeployMods();
+      else if(command == EXTERNAL_CHANGES)
+      {
+        command_result["deployers"] = Json::arrayValue;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+        {
+          const auto changes = app->getExternalChanges(depl);
+          Json::Value deployer;
+          deployer["id"] = depl;
+          deployer["name"] = changes.deployer_name;
+          deployer["files"] = Json::arrayValue;
+          for(const auto& [path, mod_id] : changes.file_changes)
+          {
+            Json::Value file;
+            file["path"] = path.string();
+            file["mod_id"] = mod_id;
+            deployer["files"].append(file);
+          }
+          command_result["deployers"].append(deployer);
+        }
+      }
+      else if(command == CONFLICTS)
+      {
+        std::map<int, std::string> mod_names;
+        for(const auto& info : app->getModInfo())
+          mod_names[info.mod.id] = info.mod.name;
+        const auto deployer_names = app->getDeployerNames();
+        command_result["deployers"] = Json::arrayValue;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+        {
+          Json::Value deployer;
+          deployer["id"] = depl;
+          deployer["name"] = deployer_names[depl];
+          deployer["groups"] = Json::arrayValue;
+          auto groups = app->getConflictGroups(depl);
+          // the last group contains all mods without conflicts
+          if(!groups.empty())
+            groups.pop_back();
+          for(const auto& group : groups)
+          {
+            Json::Value json_group = Json::arrayValue;
+            for(int mod_id : group)
+            {
+              Json::Value mod;
+              mod["id"] = mod_id;
+              mod["name"] = mod_names.contains(mod_id) ? mod_names[mod_id] : "";
+              json_group.append(mod);
+            }
+            deployer["groups"].append(json_group);
+          }
+          command_result["deployers"].append(deployer);
+        }
+      }
+      else if(command == AUDIT || command == REPAIR)
+      {
+        static const std::vector<std::string> status_names = {
+          "identical", "modified", "missing", "orphaned"
+        };
+        command_result["deployers"] = Json::arrayValue;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+        {
+          const auto audit = app->auditDeployment(depl);
+          Json::Value deployer;
+          deployer["id"] = depl;
+          deployer["name"] = audit.deployer_name;
+          deployer["num_identical"] = audit.num_identical;
+          deployer["files"] = Json::arrayValue;
+          for(const auto& entry : audit.entries)
+          {
+            Json::Value file;
+            file["path"] = entry.path.string();
+            file["mod_id"] = entry.mod_id;
+            file["status"] = status_names[entry.status];
+            deployer["files"].append(file);
+          }
+          command_result["deployers"].append(deployer);
+          if(command == REPAIR)
+            app->repairDeployment(depl, audit);
+        }
+      }
+      else if(command == PLAN)
+      {
+        std::vector<int> deployers;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+          deployers.push_back(depl);
+        command_result["deployers"] = Json::arrayValue;
+        for(const auto& plan : app->planDeploy(deployers))
+        {
+          Json::Value deployer;
+          deployer["id"] = plan.deployer_id;
+          deployer["name"] = plan.deployer_name;
+          deployer["supported"] = plan.is_supported;
+          deployer["files_created"] = plan.num_files_created;
+          deployer["files_replaced"] = plan.num_files_replaced;
+          deployer["files_removed"] = plan.num_files_removed;
+          deployer["backups_created"] = plan.num_backups_created;
+          deployer["backups_restored"] = plan.num_backups_restored;
+          deployer["directories_removed"] = plan.num_directories_removed;
+          deployer["bytes_to_copy"] = Json::UInt64(plan.bytes_to_copy);
+          deployer["estimated_seconds"] = plan.estimated_seconds;
+          deployer["overlapping_deployers"] = Json::arrayValue;
+          for(const auto& [other_id, num_files] : plan.overlapping_deployers)
+          {
+            Json::Value overlap;
+            overlap["id"] = other_id;
+            overlap["num_files"] = num_files;
+            deployer["overlapping_deployers"].append(overlap);
+          }
+          command_result["deployers"].append(deployer);
+        }
+      }
+      else if(command == PROVIDERS)
+      {
+        const auto deployer_names = app->getDeployerNames();
+        command_result["deployers"] = Json::arrayValue;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+        {
+          Json::Value deployer;
+          deployer["id"] = depl;
+          deployer["name"] = deployer_names[depl];
+          deployer["files"] = Json::arrayValue;
+          for(const auto& [path, mod_ids, mod_names] : app->getFileProviders(depl, path_prefix_))
+          {
+            Json::Value file;
+            file["path"] = path;
+            file["mods"] = Json::arrayValue;
+            for(const auto& [mod_id, mod_name] : str::zip_view(mod_ids, mod_names))
+            {
+              Json::Value mod;
+              mod["id"] = mod_id;
+              mod["name"] = mod_name;
+              file["mods"].append(mod);
+            }
+            deployer["files"].append(file);
+          }
+          command_result["deployers"].append(deployer);
+        }
+      }
+      else if(command == GENERATIONS)
+      {
+        const auto deployer_names = app->getDeployerNames();
+        command_result["deployers"] = Json::arrayValue;
+        for(int depl = 0; depl < app->getNumDeployers(); depl++)
+        {
+          Json::Value deployer;
+          deployer["id"] = depl;
+          deployer["name"] = deployer_names[depl];
+          deployer["generations"] = Json::arrayValue;
+          for(const auto& generation : app->getDeploymentGenerations(depl))
+          {
+            Json::Value json_generation;
+            json_generation["id"] = generation.id;
+            json_generation["timestamp"] = Json::Int64(generation.timestamp);
+            json_generation["profile"] = generation.profile;
+            json_generation["num_files"] = generation.num_files;
+            json_generation["num_changes"] = generation.num_changes;
+            deployer["generations"].append(json_generation);
+          }
+          command_result["deployers"].append(deployer);
+        }
+      }
+      else if(command == ROLLBACK)
+      {
+        if(!rollback_target_)
+          throw std::runtime_error("No deployment generation has been set for rollback.");
+        const auto [deployer, generation] = *rollback_target_;
+        if(deployer < 0 || deployer >= app->getNumDeployers())
+          throw std::runtime_error(std::format("Deployer index {} is out of bounds.", deployer));
+        app->rollbackDeployment(deployer, generation);
+      }
+      else if(command == REAPPLY_TAGS)
+        app->reapplyAutoTags();
+      else if(command == CHECK_UPDATES)
+      {
+        if(!nexus::Api::isInitialized())
+          throw std::runtime_error("No Nexus API key has been set.");
+        app->checkForModUpdates();
+        command_result["updates"] = Json::arrayValue;
+        for(const auto& info : app->getModInfo())
+        {
+          if(info.mod.remote_update_time <= info.mod.install_time ||
+             info.mod.remote_update_time <= info.mod.suppress_update_time)
+            continue;
+          Json::Value mod;
+          mod["id"] = info.mod.id;
+          mod["name"] = info.mod.name;
+          mod["version"] = info.mod.version;
+          mod["remote_source"] = info.mod.remote_source;
+          command_result["updates"].append(mod);
+        }
+      }
+      command_result["success"] = true;
+    }
+    catch(std::exception& error)
+    {
+      command_result["success"] = false;
+      command_result["error"] = error.what();
+    }
+    result["commands"].append(command_result);
+    if(!command_result["success"].asBool())
+    {
+      result["success"] = false;
+      break;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,129 @@
+/*!
+ * \file batchrunner.h
+ * \brief Header for the BatchRunner class.
+ */
+
+#pragma once
+
+#include "log.h"
+#include <filesystem>
+#include <json/json.h>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Runs a sequence of commands for multiple applications without a user interface.
+ *
+ * Every selected application is loaded and processed on its own thread. Commands for one
+ * application are run in the order in which they were added, if one fails the remaining
+ * commands for that application are skipped. The results are returned as a JSON object.
+ */
+class BatchRunner
+{
+public:
+  /*!
+   * \brief Constructor.
+   * \param staging_dirs Staging directories of all applications. Applications are
+   * identified by their index in this vector.
+   */
+  BatchRunner(const std::vector<std::filesystem::path>& staging_dirs);
+
+  /*! \brief Deploys all mods. */
+  inline static const std::string DEPLOY = "deploy";
+  /*! \brief Undeploys all mods. */
+  inline static const std::string UNDEPLOY = "undeploy";
+  /*! \brief Lists files which have been modified after being deployed. */
+  inline static const std::string EXTERNAL_CHANGES = "external-changes";
+  /*! \brief Lists groups of mods with conflicting files for every deployer. */
+  inline static const std::string CONFLICTS = "conflicts";
+  /*! \brief Reevaluates all auto tags. */
+  inline static const std::string REAPPLY_TAGS = "reapply-tags";
+  /*! \brief Checks all mods with a remote source for updates. Requires an API key. */
+  inline static const std::string CHECK_UPDATES = "check-updates";
+  /*! \brief Lists deployed files which differ from their source files. */
+  inline static const std::string AUDIT = "audit";
+  /*! \brief Audits all deployers and fixes every deployed file which differs from its source. */
+  inline static const std::string REPAIR = "repair";
+  /*! \brief Lists the file operations deployment would perform, without deploying. */
+  inline static const std::string PLAN = "plan";
+  /*!
+   * \brief Lists every file provided by the enabled mods of every deployer and all mods
+   * providing it, in overwrite order. Only files starting with the prefix set by
+   * \ref setPathPrefix are listed.
+   */
+  inline static const std::string PROVIDERS = "providers";
+  /*! \brief Lists the retained deployment generations of every deployer. */
+  inline static const std::string GENERATIONS = "generations";
+  /*!
+   * \brief Rolls the deployer set by \ref setRollbackTarget back to the given deployment
+   * generation.
+   */
+  inline static const std::string ROLLBACK = "rollback";
+  /*! \brief Contains all supported commands. */
+  inline static const std::vector<std::string> COMMANDS = {
+    DEPLOY, UNDEPLOY, EXTERNAL_CHANGES, CONFLICTS, REAPPLY_TAGS, CHECK_UPDATES, AUDIT, REPAIR,
+    PLAN, PROVIDERS, GENERATIONS, ROLLBACK
+  };
+
+  /*!
+   * \brief Appends the given command to the commands run for every application.
+   * \param command One of \ref COMMANDS.
+   * \throws std::runtime_error If the command is not supported.
+   */
+  void addCommand(const std::string& command);
+  /*!
+   * \brief Selects an application to be processed.
+   * \param app_id Index of the application.
+   * \param profile If set: Profile to activate before running any commands.
+   * \throws std::runtime_error If the application index is out of bounds.
+   */
+  void addTarget(int app_id, std::optional<int> profile = {});
+  /*!
+   * \brief Sets the path prefix used by the \ref PROVIDERS command.
+   * \param prefix Path prefix relative to a deployers target directory.
+   */
+  void setPathPrefix(const std::string& prefix);
+  /*!
+   * \brief Sets the deployer and generation used by the \ref ROLLBACK command.
+   * \param deployer Index of the target deployer.
+   * \param generation Id of the target generation.
+   */
+  void setRollbackTarget(int deployer, int generation);
+  /*!
+   * \brief Runs all commands for all selected applications. If no application has been
+   * selected, all applications are processed.
+   * \return For every application: The results of all commands, as well as all log messages.
+   */
+  Json::Value run() const;
+
+private:
+  /*! \brief Application to be processed. */
+  struct Target
+  {
+    /*! \brief Index of the application. */
+    int app_id;
+    /*! \brief If set: Profile to activate before running any commands. */
+    std::optional<int> profile;
+  };
+
+  /*! \brief Staging directories of all applications. */
+  std::vector<std::filesystem::path> staging_dirs_;
+  /*! \brief Commands run for every application. */
+  std::vector<std::string> commands_;
+  /*! \brief Applications to be processed. */
+  std::vector<Target> targets_;
+  /*! \brief Path prefix used by the \ref PROVIDERS command. */
+  std::string path_prefix_;
+  /*! \brief If set: Deployer and generation used by the \ref ROLLBACK command. */
+  std::optional<std::pair<int, int>> rollback_target_;
+
+  /*!
+   * \brief Loads the given application and runs all commands for it.
+   * \param target Application to be processed.
+   * \return The results for this application.
+   */
+  Json::Value runForTarget(const Target& target) const;
+};
@@ -0,0 +1,23 @@
+/*!
+ * \file cancellationerror.h
+ * \brief Contains the CancellationError class.
+ */
+
+#pragma once
+
+#include <stdexcept>
+
+
+/*!
+ * \brief Exception indicating that an operation has been canceled by the user. It is only
+ * thrown once all changes made by the operation are in a consistent state.
+ */
+class CancellationError : public std::runtime_error
+{
+public:
+  /*!
+   * \brief Constructor.
+   * \param message Message for the exception.
+   */
+  CancellationError(const char* message = "Operation canceled.") : std::runtime_error(message) {}
+};
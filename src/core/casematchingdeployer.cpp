@@ -35,6 +35,9 @@ void CaseMatchingDeployer::updateDeployedFilesForMod(
   std::optional<ProgressNode*> progress_node) const
 {
   std::map<sfs::path, int> deployed_files = loadDeployedFiles(progress_node);
+  FilesystemCapabilities capabilities;
+  if(deploy_mode_ == copy)
+    capabilities = FilesystemProbe::probe(source_path_, dest_path_);
   for(const auto& [path, id] : deployed_files)
   {
     if(id != mod_id)
@@ -53,7 +56,7 @@ void CaseMatchingDeployer::updateDeployedFilesForMod(
     if(deploy_mode_ == sym_link)
       sfs::create_symlink(source_path, dest_path);
     else if(deploy_mode_ == DeployMode::copy)
-      sfs::copy(source_path, dest_path);
+      FilesystemProbe::copyFile(source_path, dest_path, capabilities);
     else
       sfs::create_hard_link(source_path, dest_path);
   }
@@ -68,6 +71,9 @@ void CaseMatchingDeployer::adaptDirectoryFiles(const sfs::path& path,
                                                int mod_id,
                                                const sfs::path& target_path) const
 {
+  // the kernel already resolves names in case folded directories
+  if(pu::isCaseFolded(target_path / path))
+    return;
   std::vector<sfs::path> directories;
   for(auto const& dir_entry : sfs::directory_iterator(source_path_ / std::to_string(mod_id) / path))
   {
@@ -123,6 +129,16 @@ void CaseMatchingDeployer::adaptDirectoryFiles(const sfs::path& path,
 void CaseMatchingDeployer::adaptLoadorderFiles(const std::vector<int>& loadorder,
                                                std::optional<ProgressNode*> progress_node) const
 {
+  if(pu::isCaseFolded(dest_path_))
+  {
+    log_(Log::LOG_DEBUG,
+         std::format("Deployer '{}': Target directory is case folded, skipping file name "
+                     "matching.",
+                     name_));
+    if(progress_node)
+      (*progress_node)->advance();
+    return;
+  }
   log_(Log::LOG_INFO, std::format("Deployer '{}': Matching file names...", name_));
   if(progress_node)
   {
@@ -132,6 +148,7 @@ void CaseMatchingDeployer::adaptLoadorderFiles(const std::vector<int>& loadorder
   }
   for(int mod_id : loadorder)
   {
+    invalidateModFileIndex(mod_id);
     if(checkModPathExistsAndMaybeLogError(mod_id))
       adaptDirectoryFiles("", mod_id, dest_path_);
     if(progress_node)
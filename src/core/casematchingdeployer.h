@@ -9,6 +9,12 @@
 
 /*!
  * \brief Automatically renames mod files to match the case of target files.
+ *
+ * Deployment plans are created by the base class implementation of
+ * \ref Deployer.planDeploy() "planDeploy", since matching names only renames files in the
+ * staging directory and does not change which files are deployed. Names in mods which have been
+ * deployed before already match the target, so these plans are exact. For mods with unmatched
+ * names, a replaced file may be counted as one removed and one created file.
  */
 class CaseMatchingDeployer : public Deployer
 {
@@ -55,7 +61,7 @@ public:
 private:
   /*!
    * \brief Recursively renames every file in source_path_/mod_id/path to the name of a file
-   * in dest_path_, if both match case insensitively.
+   * in dest_path_, if both match case insensitively. Skips case folded target directories.
    * \param path Path relative to the mods root directory.
    * \param mod_id Id of the mod containing the source files.
    * \param target_path Path used for file comparisons.
@@ -66,6 +72,8 @@ private:
   /*!
    * \brief Renames every file in every mod in the given load order
    * such that all paths are case invariant and match the case of files in \ref dest_path_.
+   * Does nothing if \ref dest_path_ is case folded, since the kernel then resolves names and
+   * winning files are determined case insensitively.
    * \param loadorder Contains ids of mods the files of which will be adapted.
    * \param progress_node Used to inform about the current progress of deployment.
    */
@@ -0,0 +1,380 @@
+#include "chunkstore.h"
+#include "cryptography.h"
+#include "pathutils.h"
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+#include <zstd.h>
+
+namespace sfs = std::filesystem;
+namespace pu = path_utils;
+
+
+ChunkStore::ChunkStore(const sfs::path& store_path) : store_path_(store_path)
+{
+  sfs::create_directories(store_path_ / CHUNK_DIR);
+  sfs::create_directories(store_path_ / SNAPSHOT_DIR);
+}
+
+void ChunkStore::storeSnapshot(const sfs::path& source, const std::string& name) const
+{
+  Json::Value manifest;
+  std::vector<std::pair<sfs::path, uint64_t>> files;
+  std::vector<int> file_entries;
+  auto add_entry = [&](const sfs::path& path, const std::string& relative_path)
+  {
+    Json::Value entry;
+    entry["path"] = relative_path;
+    const auto status = sfs::symlink_status(path);
+    if(sfs::is_symlink(status))
+    {
+      entry["type"] = "symlink";
+      entry["target"] = sfs::read_symlink(path).string();
+    }
+    else if(sfs::is_directory(status))
+      entry["type"] = "directory";
+    else
+    {
+      entry["type"] = "file";
+      entry["size"] = static_cast<Json::UInt64>(sfs::file_size(path));
+      entry["permissions"] = static_cast<int>(status.permissions());
+      entry["mtime"] =
+        static_cast<Json::Int64>(sfs::last_write_time(path).time_since_epoch().count());
+      files.emplace_back(path, sfs::file_size(path));
+      file_entries.push_back(manifest["entries"].size());
+    }
+    manifest["entries"].append(entry);
+  };
+  add_entry(source, "");
+  if(sfs::is_directory(source) && !sfs::is_symlink(source))
+  {
+    for(const auto& dir_entry : sfs::recursive_directory_iterator(source))
+      add_entry(dir_entry.path(), pu::getRelativePath(dir_entry.path(), source));
+  }
+
+  std::vector<std::pair<int, uint64_t>> chunks;
+  for(int file = 0; file < files.size(); file++)
+  {
+    for(uint64_t offset = 0; offset < files[file].second; offset += CHUNK_SIZE)
+      chunks.emplace_back(file, offset);
+  }
+  std::vector<std::string> hashes(chunks.size());
+  runInParallel(chunks.size(),
+                [&](int chunk)
+                {
+                  const auto& [file, offset] = chunks[chunk];
+                  hashes[chunk] = storeChunk(files[file].first, offset);
+                });
+  for(int chunk = 0; chunk < chunks.size(); chunk++)
+    manifest["entries"][file_entries[chunks[chunk].first]]["chunks"].append(hashes[chunk]);
+  writeManifest(name, manifest);
+  log_(Log::LOG_DEBUG,
+       std::format("Stored snapshot \"{}\" of \"{}\" with {} files and {} chunks.",
+                   name,
+                   source.string(),
+                   files.size(),
+                   chunks.size()));
+}
+
+void ChunkStore::restoreSnapshot(const std::string& name, const sfs::path& dest) const
+{
+  if(pu::exists(dest))
+    throw std::runtime_error(
+      std::format("Cannot restore snapshot to \"{}\": Path already exists.", dest.string()));
+  const Json::Value manifest = readManifest(name);
+  auto get_path = [&dest](const Json::Value& entry)
+  {
+    const std::string relative_path = entry["path"].asString();
+    return relative_path.empty() ? dest : dest / relative_path;
+  };
+
+  std::vector<std::tuple<std::string, sfs::path, uint64_t, uint64_t>> chunks;
+  for(const auto& entry : manifest["entries"])
+  {
+    const sfs::path path = get_path(entry);
+    const std::string type = entry["type"].asString();
+    if(type == "directory")
+      sfs::create_directories(path);
+    else if(type == "symlink")
+      sfs::create_symlink(entry["target"].asString(), path);
+    else
+    {
+      const uint64_t size = entry["size"].asUInt64();
+      const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0)
+        throw std::runtime_error(std::format("Failed to create \"{}\".", path.string()));
+      const bool success = ftruncate(fd, size) == 0;
+      close(fd);
+      if(!success)
+        throw std::runtime_error(
+          std::format("Failed to allocate {} bytes for \"{}\".", size, path.string()));
+      const auto& hashes = entry["chunks"];
+      if(hashes.size() != (size + CHUNK_SIZE - 1) / CHUNK_SIZE)
+        throw std::runtime_error(std::format(
+          "Snapshot \"{}\" is damaged: Invalid chunks for \"{}\".", name, path.string()));
+      for(int i = 0; i < hashes.size(); i++)
+      {
+        const uint64_t offset = i * CHUNK_SIZE;
+        chunks.emplace_back(
+          hashes[i].asString(), path, offset, std::min(CHUNK_SIZE, size - offset));
+      }
+    }
+  }
+
+  runInParallel(chunks.size(),
+                [&](int chunk)
+                {
+                  const auto& [hash, path, offset, size] = chunks[chunk];
+                  restoreChunk(hash, path, offset, size);
+                });
+
+  for(const auto& entry : manifest["entries"])
+  {
+    if(entry["type"].asString() != "file")
+      continue;
+    const sfs::path path = get_path(entry);
+    sfs::permissions(path, static_cast<sfs::perms>(entry["permissions"].asInt()));
+    sfs::last_write_time(
+      path, sfs::file_time_type(sfs::file_time_type::duration(entry["mtime"].asInt64())));
+  }
+  log_(Log::LOG_DEBUG,
+       std::format("Restored snapshot \"{}\" to \"{}\" using {} chunks.",
+                   name,
+                   dest.string(),
+                   chunks.size()));
+}
+
+void ChunkStore::copySnapshot(const std::string& source_name, const std::string& dest_name) const
+{
+  writeManifest(dest_name, readManifest(source_name));
+}
+
+void ChunkStore::renameSnapshot(const std::string& old_name, const std::string& new_name) const
+{
+  sfs::rename(getManifestPath(old_name), getManifestPath(new_name));
+}
+
+void ChunkStore::removeSnapshot(const std::string& name) const
+{
+  sfs::remove(getManifestPath(name));
+}
+
+bool ChunkStore::hasSnapshot(const std::string& name) const
+{
+  return sfs::exists(getManifestPath(name));
+}
+
+std::vector<std::string> ChunkStore::getSnapshots() const
+{
+  std::vector<std::string> names;
+  for(const auto& dir_entry : sfs::directory_iterator(store_path_ / SNAPSHOT_DIR))
+  {
+    if(dir_entry.path().extension() == MANIFEST_EXTENSION)
+      names.push_back(dir_entry.path().stem().string());
+  }
+  return names;
+}
+
+sfs::file_time_type ChunkStore::getSnapshotsWriteTime() const
+{
+  return sfs::last_write_time(store_path_ / SNAPSHOT_DIR);
+}
+
+int ChunkStore::collectGarbage() const
+{
+  std::set<std::string> used_chunks;
+  for(const auto& name : getSnapshots())
+  {
+    const Json::Value manifest = readManifest(name);
+    for(const auto& entry : manifest["entries"])
+    {
+      for(const auto& hash : entry["chunks"])
+        used_chunks.insert(hash.asString());
+    }
+  }
+  std::vector<sfs::path> unused_chunks;
+  for(const auto& dir_entry : sfs::recursive_directory_iterator(store_path_ / CHUNK_DIR))
+  {
+    if(dir_entry.is_regular_file() && !used_chunks.contains(dir_entry.path().filename().string()))
+      unused_chunks.push_back(dir_entry.path());
+  }
+  for(const auto& path : unused_chunks)
+    sfs::remove(path);
+  if(!unused_chunks.empty())
+    log_(Log::LOG_DEBUG,
+         std::format("Removed {} unused chunks from \"{}\".",
+                     unused_chunks.size(),
+                     store_path_.string()));
+  return unused_chunks.size();
+}
+
+sfs::path ChunkStore::getPath() const
+{
+  return store_path_;
+}
+
+void ChunkStore::setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log)
+{
+  log_ = new_log;
+}
+
+sfs::path ChunkStore::getChunkPath(const std::string& hash) const
+{
+  return store_path_ / CHUNK_DIR / hash.substr(0, 2) / hash;
+}
+
+sfs::path ChunkStore::getManifestPath(const std::string& name) const
+{
+  return store_path_ / SNAPSHOT_DIR / (name + MANIFEST_EXTENSION);
+}
+
+Json::Value ChunkStore::readManifest(const std::string& name) const
+{
+  Json::Value manifest;
+  std::ifstream file(getManifestPath(name), std::fstream::binary);
+  if(!file.is_open())
+    throw std::runtime_error(
+      std::format("Could not read snapshot \"{}\" in \"{}\".", name, store_path_.string()));
+  file >> manifest;
+  file.close();
+  return manifest;
+}
+
+void ChunkStore::writeManifest(const std::string& name, const Json::Value& manifest) const
+{
+  const sfs::path path = getManifestPath(name);
+  const sfs::path tmp_path = path.string() + ".tmp";
+  std::ofstream file(tmp_path, std::fstream::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Could not write to \"{}\".", tmp_path.string()));
+  file << manifest;
+  file.close();
+  sfs::rename(tmp_path, path);
+}
+
+std::string ChunkStore::storeChunk(const sfs::path& file, uint64_t offset) const
+{
+  const int fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0)
+    throw std::runtime_error(std::format("Could not read from \"{}\".", file.string()));
+  std::string data(CHUNK_SIZE, '\0');
+  uint64_t size = 0;
+  while(size < CHUNK_SIZE)
+  {
+    const ssize_t bytes_read = pread(fd, data.data() + size, CHUNK_SIZE - size, offset + size);
+    if(bytes_read < 0)
+    {
+      close(fd);
+      throw std::runtime_error(std::format("Could not read from \"{}\".", file.string()));
+    }
+    if(bytes_read == 0)
+      break;
+    size += bytes_read;
+  }
+  close(fd);
+  data.resize(size);
+
+  const std::string hash = cryptography::sha256(data.data(), data.size());
+  const sfs::path chunk_path = getChunkPath(hash);
+  if(sfs::exists(chunk_path))
+    return hash;
+
+  std::string compressed(ZSTD_compressBound(data.size()), '\0');
+  const size_t compressed_size = ZSTD_compress(
+    compressed.data(), compressed.size(), data.data(), data.size(), COMPRESSION_LEVEL);
+  if(ZSTD_isError(compressed_size))
+    throw std::runtime_error(std::format("Failed to compress chunk from \"{}\": {}",
+                                         file.string(),
+                                         ZSTD_getErrorName(compressed_size)));
+  sfs::create_directories(chunk_path.parent_path());
+  // Another thread may store the same chunk concurrently, so write to a unique temporary file
+  const sfs::path tmp_path = std::format(
+    "{}.{}.tmp", chunk_path.string(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  std::ofstream chunk_file(tmp_path, std::fstream::binary);
+  if(!chunk_file.is_open())
+    throw std::runtime_error(std::format("Could not write to \"{}\".", tmp_path.string()));
+  chunk_file.write(compressed.data(), compressed_size);
+  chunk_file.close();
+  sfs::rename(tmp_path, chunk_path);
+  return hash;
+}
+
+void ChunkStore::restoreChunk(const std::string& hash,
+                              const sfs::path& file,
+                              uint64_t offset,
+                              uint64_t size) const
+{
+  const sfs::path chunk_path = getChunkPath(hash);
+  std::ifstream chunk_file(chunk_path, std::fstream::binary);
+  if(!chunk_file.is_open())
+    throw std::runtime_error(
+      std::format("Missing chunk \"{}\" in \"{}\".", hash, store_path_.string()));
+  const std::string compressed((std::istreambuf_iterator<char>(chunk_file)),
+                               std::istreambuf_iterator<char>());
+  chunk_file.close();
+  std::string data(size, '\0');
+  const size_t data_size =
+    ZSTD_decompress(data.data(), data.size(), compressed.data(), compressed.size());
+  if(ZSTD_isError(data_size) || data_size != size)
+    throw std::runtime_error(
+      std::format("Chunk \"{}\" in \"{}\" is damaged.", hash, store_path_.string()));
+
+  const int fd = open(file.c_str(), O_WRONLY);
+  if(fd < 0)
+    throw std::runtime_error(std::format("Could not write to \"{}\".", file.string()));
+  uint64_t bytes_written = 0;
+  while(bytes_written < size)
+  {
+    const ssize_t ret =
+      pwrite(fd, data.data() + bytes_written, size - bytes_written, offset + bytes_written);
+    if(ret <= 0)
+    {
+      close(fd);
+      throw std::runtime_error(std::format("Could not write to \"{}\".", file.string()));
+    }
+    bytes_written += ret;
+  }
+  close(fd);
+}
+
+void ChunkStore::runInParallel(int num_tasks, const std::function<void(int)>& task)
+{
+  if(num_tasks == 0)
+    return;
+  const int num_threads =
+    std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, num_tasks);
+  std::atomic<int> next_task = 0;
+  std::atomic<bool> has_error = false;
+  std::string error_message;
+  std::mutex error_mutex;
+  auto run_tasks = [&]()
+  {
+    for(int i = next_task++; i < num_tasks && !has_error; i = next_task++)
+    {
+      try
+      {
+        task(i);
+      }
+      catch(std::exception& error)
+      {
+        std::lock_guard lock(error_mutex);
+        if(!has_error.exchange(true))
+          error_message = error.what();
+      }
+    }
+  };
+  std::vector<std::jthread> threads;
+  for(int i = 1; i < num_threads; i++)
+    threads.emplace_back(run_tasks);
+  run_tasks();
+  for(auto& thread : threads)
+    thread.join();
+  if(has_error)
+    throw std::runtime_error(error_message);
+}
@@ -0,0 +1,166 @@
+/*!
+ * \file chunkstore.h
+ * \brief Header for the ChunkStore class.
+ */
+
+#pragma once
+
+#include "log.h"
+#include <filesystem>
+#include <functional>
+#include <json/json.h>
+#include <string>
+#include <vector>
+
+
+/*!
+ * \brief Stores snapshots of files or directories in a content addressed, deduplicated form.
+ *
+ * Every file is split into chunks of a fixed size. Every chunk is compressed using zstd and
+ * stored under its SHA-256 digest, so identical chunks are only stored once across all
+ * snapshots. A snapshot consists of a manifest listing all files, directories and symlinks as
+ * well as the chunks for every file.
+ */
+class ChunkStore
+{
+public:
+  /*!
+   * \brief Constructor.
+   * \param store_path Directory in which all data is stored. Created if it does not exist.
+   */
+  ChunkStore(const std::filesystem::path& store_path);
+
+  /*! \brief Size of one chunk in bytes. */
+  static constexpr uint64_t CHUNK_SIZE = 1024 * 1024;
+  /*! \brief Zstd compression level used for new chunks. */
+  static constexpr int COMPRESSION_LEVEL = 3;
+
+  /*!
+   * \brief Stores a snapshot of the given file or directory. Only chunks which do not yet
+   * exist in the store are written. An existing snapshot with the same name is replaced.
+   * \param source File or directory to store.
+   * \param name Name of the new snapshot.
+   * \throws std::runtime_error If a file could not be read or a chunk could not be written.
+   */
+  void storeSnapshot(const std::filesystem::path& source, const std::string& name) const;
+  /*!
+   * \brief Recreates the given snapshot at the given path.
+   * \param name Name of the snapshot.
+   * \param dest Path at which to create the snapshot. Must not exist.
+   * \throws std::runtime_error If the snapshot does not exist or is damaged.
+   */
+  void restoreSnapshot(const std::string& name, const std::filesystem::path& dest) const;
+  /*!
+   * \brief Creates a new snapshot with the same content as an existing snapshot.
+   * \param source_name Name of the existing snapshot.
+   * \param dest_name Name of the new snapshot.
+   */
+  void copySnapshot(const std::string& source_name, const std::string& dest_name) const;
+  /*!
+   * \brief Renames the given snapshot.
+   * \param old_name Current name of the snapshot.
+   * \param new_name New name.
+   */
+  void renameSnapshot(const std::string& old_name, const std::string& new_name) const;
+  /*!
+   * \brief Removes the given snapshot. Chunks are only deleted by \ref collectGarbage.
+   * \param name Name of the snapshot.
+   */
+  void removeSnapshot(const std::string& name) const;
+  /*!
+   * \brief Checks whether a snapshot with the given name exists.
+   * \param name Name of the snapshot.
+   * \return True if the snapshot exists.
+   */
+  bool hasSnapshot(const std::string& name) const;
+  /*!
+   * \brief Returns the names of all snapshots in the store.
+   * \return The names.
+   */
+  std::vector<std::string> getSnapshots() const;
+  /*!
+   * \brief Returns the time at which a snapshot was last added, removed or renamed.
+   * \return The time.
+   */
+  std::filesystem::file_time_type getSnapshotsWriteTime() const;
+  /*!
+   * \brief Deletes all chunks which are not used by any snapshot.
+   * \return The number of deleted chunks.
+   */
+  int collectGarbage() const;
+  /*!
+   * \brief Returns the directory in which all data is stored.
+   * \return The path.
+   */
+  std::filesystem::path getPath() const;
+  /*!
+   * \brief Setter for log callback.
+   * \param new_log New log callback
+   */
+  void setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log);
+
+private:
+  /*! \brief File extension used for snapshot manifests. */
+  static inline const std::string MANIFEST_EXTENSION = ".json";
+  /*! \brief Directory containing all chunks. */
+  static inline const std::string CHUNK_DIR = "chunks";
+  /*! \brief Directory containing all snapshot manifests. */
+  static inline const std::string SNAPSHOT_DIR = "snapshots";
+
+  /*! \brief Directory in which all data is stored. */
+  std::filesystem::path store_path_;
+  /*! \brief Callback for logging. */
+  std::function<void(Log::LogLevel, const std::string&)> log_ = [](Log::LogLevel a,
+                                                                   const std::string& b) {};
+
+  /*!
+   * \brief Returns the path to the chunk with the given digest.
+   * \param hash Digest of the chunk.
+   * \return The path.
+   */
+  std::filesystem::path getChunkPath(const std::string& hash) const;
+  /*!
+   * \brief Returns the path to the manifest of the given snapshot.
+   * \param name Name of the snapshot.
+   * \return The path.
+   */
+  std::filesystem::path getManifestPath(const std::string& name) const;
+  /*!
+   * \brief Reads the manifest of the given snapshot.
+   * \param name Name of the snapshot.
+   * \return The manifest.
+   */
+  Json::Value readManifest(const std::string& name) const;
+  /*!
+   * \brief Atomically replaces the manifest of the given snapshot.
+   * \param name Name of the snapshot.
+   * \param manifest The new manifest.
+   */
+  void writeManifest(const std::string& name, const Json::Value& manifest) const;
+  /*!
+   * \brief Reads, hashes and, if it is not already stored, compresses and stores one chunk.
+   * \param file File containing the chunk.
+   * \param offset Offset of the chunk in the file.
+   * \return The digest of the chunk.
+   */
+  std::string storeChunk(const std::filesystem::path& file, uint64_t offset) const;
+  /*!
+   * \brief Decompresses one chunk and writes it to the given file.
+   * \param hash Digest of the chunk.
+   * \param file Target file.
+   * \param offset Offset in the target file.
+   * \param size Expected size of the uncompressed chunk.
+   */
+  void restoreChunk(const std::string& hash,
+                    const std::filesystem::path& file,
+                    uint64_t offset,
+                    uint64_t size) const;
+  /*!
+   * \brief Calls the given function once for every index in [0, num_tasks) using
+   * multiple threads.
+   * \param num_tasks Number of tasks.
+   * \param task Function to call.
+   * \throws std::runtime_error If any task threw an exception.
+   */
+  static void runInParallel(int num_tasks, const std::function<void(int)>& task);
+};
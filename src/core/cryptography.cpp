@@ -1,9 +1,13 @@
 #include "cryptography.h"
 #include <cmath>
+#include <fcntl.h>
+#include <format>
+#include <memory>
 #include <openssl/aes.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <unistd.h>
 
 
 void throwError(const std::string& step)
@@ -22,6 +26,18 @@ void throwError(const std::string& step)
   throw CryptographyError(error);
 }
 
+std::string toHex(const unsigned char* digest, unsigned int digest_length)
+{
+  constexpr char hex_chars[] = "0123456789abcdef";
+  std::string digest_str;
+  for(int i = 0; i < digest_length; i++)
+  {
+    digest_str += hex_chars[digest[i] >> 4];
+    digest_str += hex_chars[digest[i] & 0xf];
+  }
+  return digest_str;
+}
+
 namespace cryptography
 {
 std::tuple<std::string, std::string, std::string> encrypt(const std::string& plain_text,
@@ -118,4 +134,87 @@ std::string decrypt(const std::string& cipher_text,
 
   return std::string(reinterpret_cast<const char*>(plain_text), plain_text_length);
 }
+
+Md5Hasher::Md5Hasher()
+{
+  ctx_ = EVP_MD_CTX_new();
+  if(!ctx_)
+    throwError("hashing");
+  if(EVP_DigestInit_ex(ctx_, EVP_md5(), NULL) != 1)
+  {
+    EVP_MD_CTX_free(ctx_);
+    throwError("hashing");
+  }
+}
+
+Md5Hasher::~Md5Hasher()
+{
+  EVP_MD_CTX_free(ctx_);
+}
+
+void Md5Hasher::update(const char* data, std::size_t size)
+{
+  if(EVP_DigestUpdate(ctx_, data, size) != 1)
+    throwError("hashing");
+}
+
+std::string Md5Hasher::finalize()
+{
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_length = 0;
+  if(EVP_DigestFinal_ex(ctx_, digest, &digest_length) != 1)
+    throwError("hashing");
+  return toHex(digest, digest_length);
+}
+
+std::string sha256(const char* data, std::size_t size)
+{
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_length = 0;
+  if(EVP_Digest(data, size, digest, &digest_length, EVP_sha256(), NULL) != 1)
+    throwError("hashing");
+  return toHex(digest, digest_length);
+}
+
+std::string sha256File(const std::filesystem::path& path)
+{
+  constexpr std::size_t buffer_size = 1 << 20;
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    throw std::runtime_error(std::format("Could not read '{}'.", path.string()));
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  auto ctx = EVP_MD_CTX_new();
+  if(!ctx || EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) != 1)
+  {
+    EVP_MD_CTX_free(ctx);
+    close(fd);
+    throwError("hashing");
+  }
+  auto buffer = std::make_unique<char[]>(buffer_size);
+  ssize_t bytes_read;
+  while((bytes_read = read(fd, buffer.get(), buffer_size)) > 0)
+  {
+    if(EVP_DigestUpdate(ctx, buffer.get(), bytes_read) != 1)
+    {
+      EVP_MD_CTX_free(ctx);
+      close(fd);
+      throwError("hashing");
+    }
+  }
+  close(fd);
+  if(bytes_read < 0)
+  {
+    EVP_MD_CTX_free(ctx);
+    throw std::runtime_error(std::format("Could not read '{}'.", path.string()));
+  }
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_length = 0;
+  if(EVP_DigestFinal_ex(ctx, digest, &digest_length) != 1)
+  {
+    EVP_MD_CTX_free(ctx);
+    throwError("hashing");
+  }
+  EVP_MD_CTX_free(ctx);
+  return toHex(digest, digest_length);
+}
 }
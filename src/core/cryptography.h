@@ -5,9 +5,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
 #include <stdexcept>
 #include <string>
 
+struct evp_md_ctx_st;
+
 
 /*!
  * \brief Exception indicating an error during a cryptographic operation.
@@ -53,6 +57,59 @@ std::string decrypt(const std::string& cipher_text,
                     const std::string& nonce,
                     const std::string& tag);
 
+/*!
+ * \brief Computes the SHA-256 digest of the given data.
+ * \param data Data to be hashed.
+ * \param size Size of the data.
+ * \return The digest as a lower case hex string.
+ * \throws CryptographyError When an OpenSSL internal error occurs.
+ */
+std::string sha256(const char* data, std::size_t size);
+
+/*!
+ * \brief Computes the SHA-256 digest of the given file using large sequential reads.
+ * \param path Path to the file.
+ * \return The digest as a lower case hex string.
+ * \throws CryptographyError When an OpenSSL internal error occurs.
+ * \throws std::runtime_error When the file cannot be read.
+ */
+std::string sha256File(const std::filesystem::path& path);
+
 /*! \brief A default encryption key used in case no key was specified. */
 constexpr char default_key[] = "rWnYJVdtxz8Iu62GSJy0OPlOat7imMb8";
+
+/*!
+ * \brief Incrementally computes the MD5 digest of data which arrives in multiple parts.
+ */
+class Md5Hasher
+{
+public:
+  /*!
+   * \brief Initializes the digest context.
+   * \throws CryptographyError When an OpenSSL internal error occurs.
+   */
+  Md5Hasher();
+  /*! \brief Frees the digest context. */
+  ~Md5Hasher();
+  Md5Hasher(const Md5Hasher&) = delete;
+  Md5Hasher& operator=(const Md5Hasher&) = delete;
+
+  /*!
+   * \brief Adds the given data to the digest.
+   * \param data Data to be added.
+   * \param size Size of the data in bytes.
+   * \throws CryptographyError When an OpenSSL internal error occurs.
+   */
+  void update(const char* data, std::size_t size);
+  /*!
+   * \brief Finishes the digest computation. No more data can be added after this.
+   * \return The digest as a lower case hex string.
+   * \throws CryptographyError When an OpenSSL internal error occurs.
+   */
+  std::string finalize();
+
+private:
+  /*! \brief OpenSSL digest context. */
+  evp_md_ctx_st* ctx_;
+};
 };
@@ -1,12 +1,19 @@
 #include "deployer.h"
+#include "atomicprogressnode.h"
+#include "cancellationerror.h"
 #include "pathutils.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <format>
 #include <fstream>
 #include <iostream>
 #include <json/json.h>
+#include <mutex>
+#include <numeric>
 #include <ranges>
 #include <set>
+#include <thread>
 #include <unordered_set>
 
 namespace str = std::ranges;
@@ -52,17 +59,61 @@ std::map<int, unsigned long> Deployer::deploy(const std::vector<int>& loadorder,
                    source_files.size(),
                    loadorder.size()));
   if(progress_node)
-    (*progress_node)->addChildren({ 2, 5, 1 });
-  std::map<sfs::path, int> dest_files =
+    (*progress_node)->addChildren({ 2, 6 });
+  // changes made during deployment should not be recorded
+  watcher_.reset();
+  recoverInterruptedDeployment();
+  const std::map<sfs::path, int> dest_files =
     loadDeployedFiles(progress_node ? &(*progress_node)->child(0) : std::optional<ProgressNode*>{});
-  backupOrRestoreFiles(source_files, dest_files);
-  deployFiles(source_files,
-              progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
-  saveDeployedFiles(source_files,
-                    progress_node ? &(*progress_node)->child(2) : std::optional<ProgressNode*>{});
+  applyDeployment(source_files,
+                  dest_files,
+                  dest_files,
+                  progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
   return mod_sizes;
 }
 
+bool Deployer::recoverInterruptedDeployment(std::optional<ProgressNode*> progress_node)
+{
+  DeployJournal journal(dest_path_ / journal_name_);
+  const auto state = journal.load();
+  if(!state)
+    return false;
+  if(!state->is_complete)
+  {
+    // the journal is written completely before any file is changed
+    log_(Log::LOG_INFO,
+         std::format("Deployer '{}': Discarding journal of an interrupted deployment which "
+                     "did not change any files.",
+                     name_));
+    sfs::remove(dest_path_ / pending_deployed_files_name_);
+    journal.remove();
+    return true;
+  }
+
+  const auto batches = DeployJournal::getBatches(state->operations);
+  log_(Log::LOG_WARNING,
+       std::format("Deployer '{}': Completing interrupted deployment. {} of {} batches "
+                   "remaining.",
+                   name_,
+                   batches.size() - std::min<int>(state->completed_batches, batches.size()),
+                   batches.size()));
+  journal.resume();
+  performDeploymentOperations(journal,
+                              state->operations,
+                              state->completed_batches,
+                              static_cast<DeployMode>(state->deploy_mode),
+                              false,
+                              progress_node);
+  if(pu::exists(dest_path_ / pending_deployed_files_name_))
+  {
+    const auto deployed_files = loadDeployedFiles();
+    sfs::rename(dest_path_ / pending_deployed_files_name_, dest_path_ / deployed_files_name_);
+    recordGeneration(deployed_files, loadDeployedFiles());
+  }
+  journal.remove();
+  return true;
+}
+
 std::map<int, unsigned long> Deployer::deploy(std::optional<ProgressNode*> progress_node)
 {
   std::vector<int> loadorder;
@@ -74,6 +125,289 @@ std::map<int, unsigned long> Deployer::deploy(std::optional<ProgressNode*> progr
   return deploy(loadorder, progress_node);
 }
 
+bool Deployer::redeployMods(const std::vector<int>& mod_ids,
+                            std::optional<ProgressNode*> progress_node)
+{
+  if(progress_node)
+    (*progress_node)->addChildren({ 2, 6 });
+  watcher_.reset();
+  recoverInterruptedDeployment();
+  const std::map<sfs::path, int> deployed_files =
+    loadDeployedFiles(progress_node ? &(*progress_node)->child(0) : std::optional<ProgressNode*>{});
+  if(deployed_files.empty())
+  {
+    if(track_external_changes_)
+      startWatcher(deployed_files, false);
+    return false;
+  }
+  // paths of case invariant deployers depend on every mod in the load order
+  if(isCaseInvariant())
+  {
+    deploy(progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
+    return true;
+  }
+
+  log_(Log::LOG_INFO,
+       std::format("Deployer '{}': Redeploying files of {} mods...", name_, mod_ids.size()));
+  const auto provider_map = getFileProviderMap();
+  std::map<int, int> load_positions;
+  for(const auto& [i, entry] : str::enumerate_view(loadorders_[current_profile_]))
+    load_positions[std::get<0>(entry)] = i;
+  auto is_target = [&mod_ids](int mod_id) { return str::find(mod_ids, mod_id) != mod_ids.end(); };
+  std::set<sfs::path> paths;
+  for(const auto& [path, mod_id] : deployed_files)
+  {
+    if(is_target(mod_id))
+      paths.insert(path);
+  }
+  for(const auto& entry : provider_map->getEntries())
+  {
+    if(!str::any_of(entry.mod_ids, is_target))
+      continue;
+    for(sfs::path path = entry.path; !path.empty(); path = path.parent_path())
+      paths.insert(path);
+  }
+
+  // all other deployed paths must match the current load order, otherwise a full deployment
+  // is required
+  std::map<sfs::path, int> expected_files;
+  for(const auto& entry : provider_map->getEntries())
+  {
+    const int mod_id = entry.mod_ids.back();
+    expected_files[entry.path] = mod_id;
+    for(sfs::path path = sfs::path(entry.path).parent_path(); !path.empty();
+        path = path.parent_path())
+    {
+      auto [iter, inserted] = expected_files.emplace(path, mod_id);
+      if(!inserted && load_positions[mod_id] > load_positions[iter->second])
+        iter->second = mod_id;
+    }
+  }
+  auto is_unrelated = [&paths](const auto& pair) { return !paths.contains(pair.first); };
+  if(!str::equal(deployed_files | stv::filter(is_unrelated),
+                 expected_files | stv::filter(is_unrelated)))
+  {
+    log_(Log::LOG_INFO,
+         std::format("Deployer '{}': Deployed files do not match the current load order. "
+                     "Performing a full deployment.",
+                     name_));
+    deploy(progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
+    return true;
+  }
+
+  std::map<sfs::path, int> source_files;
+  std::map<sfs::path, int> dest_files;
+  for(const auto& path : paths)
+  {
+    auto iter = deployed_files.find(path);
+    if(iter != deployed_files.end())
+      dest_files.insert(*iter);
+    const std::string path_string = path.string();
+    if(const auto entry = provider_map->find(path_string))
+    {
+      source_files[path] = entry->mod_ids.back();
+      continue;
+    }
+    // directories are deployed from the last mod containing them
+    int source_mod = -1;
+    for(const auto& entry : provider_map->findPrefix(path_string + "/"))
+    {
+      if(source_mod == -1 || load_positions[entry.mod_ids.back()] > load_positions[source_mod])
+        source_mod = entry.mod_ids.back();
+    }
+    if(source_mod != -1)
+      source_files[path] = source_mod;
+  }
+  applyDeployment(source_files,
+                  dest_files,
+                  deployed_files,
+                  progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
+  return true;
+}
+
+void Deployer::applyDeployment(const std::map<sfs::path, int>& source_files,
+                               const std::map<sfs::path, int>& dest_files,
+                               const std::map<sfs::path, int>& deployed_files,
+                               std::optional<ProgressNode*> progress_node)
+{
+  if(progress_node)
+  {
+    (*progress_node)->addChildren({ 5, 1 });
+    (*progress_node)->child(0).addChildren({ 2, 3 });
+  }
+  const auto operations = getDeploymentOperations(
+    source_files,
+    dest_files,
+    progress_node ? &(*progress_node)->child(0).child(0) : std::optional<ProgressNode*>{});
+  if(progress_node && (*progress_node)->isCanceled())
+  {
+    if(track_external_changes_)
+      startWatcher(deployed_files, false);
+    throw CancellationError();
+  }
+  std::map<sfs::path, int> new_deployed_files = deployed_files;
+  for(const auto& [path, _] : dest_files)
+    new_deployed_files.erase(path);
+  new_deployed_files.insert(source_files.begin(), source_files.end());
+  saveDeployedFiles(new_deployed_files,
+                    progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{},
+                    pending_deployed_files_name_);
+  DeployJournal journal(dest_path_ / journal_name_);
+  if(!operations.empty())
+  {
+    DeployJournal::syncFile(dest_path_ / pending_deployed_files_name_);
+    journal.begin(deploy_mode_, operations);
+  }
+  const int num_completed_batches = performDeploymentOperations(
+    journal,
+    operations,
+    0,
+    deploy_mode_,
+    true,
+    progress_node ? &(*progress_node)->child(0).child(1) : std::optional<ProgressNode*>{});
+  const auto batches = DeployJournal::getBatches(operations);
+  if(num_completed_batches < batches.size())
+  {
+    const int num_performed =
+      num_completed_batches == 0 ? 0 : batches[num_completed_batches - 1].second;
+    log_(Log::LOG_INFO,
+         std::format("Deployer '{}': Deployment canceled after {} of {} file operations.",
+                     name_,
+                     num_performed,
+                     operations.size()));
+    abortDeployment(journal, operations, num_performed, source_files, deployed_files);
+    if(track_external_changes_)
+      startWatcher(loadDeployedFiles(), false);
+    throw CancellationError();
+  }
+  sfs::rename(dest_path_ / pending_deployed_files_name_, dest_path_ / deployed_files_name_);
+  journal.remove();
+  recordGeneration(deployed_files, new_deployed_files);
+  if(track_external_changes_)
+    startWatcher(new_deployed_files, false);
+}
+
+void Deployer::recordGeneration(const std::map<sfs::path, int>& deployed_files,
+                                const std::map<sfs::path, int>& new_deployed_files) const
+{
+  if(max_generations_ <= 0)
+    return;
+  // both maps are sorted, so all changes can be found in a single pass
+  std::map<sfs::path, std::tuple<int, int>> changes;
+  auto old_iter = deployed_files.begin();
+  auto new_iter = new_deployed_files.begin();
+  while(old_iter != deployed_files.end() || new_iter != new_deployed_files.end())
+  {
+    if(new_iter == new_deployed_files.end() ||
+       old_iter != deployed_files.end() && old_iter->first < new_iter->first)
+    {
+      changes[old_iter->first] = { old_iter->second, -1 };
+      old_iter++;
+    }
+    else if(old_iter == deployed_files.end() || new_iter->first < old_iter->first)
+    {
+      changes[new_iter->first] = { -1, new_iter->second };
+      new_iter++;
+    }
+    else
+    {
+      if(old_iter->second != new_iter->second)
+        changes[old_iter->first] = { old_iter->second, new_iter->second };
+      old_iter++;
+      new_iter++;
+    }
+  }
+
+  DeploymentGeneration generation;
+  generation.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  generation.profile = current_profile_;
+  if(current_profile_ >= 0 && current_profile_ < loadorders_.size())
+    generation.loadorder = loadorders_[current_profile_];
+  generation.num_files = new_deployed_files.size();
+  try
+  {
+    DeploymentHistory history(dest_path_ / generations_dir_name_);
+    if(changes.empty())
+    {
+      const auto generations = history.getGenerations();
+      if(!generations.empty() && generations.back().profile == generation.profile &&
+         generations.back().loadorder == generation.loadorder)
+        return;
+    }
+    const int id = history.addGeneration(generation, changes, max_generations_);
+    log_(Log::LOG_DEBUG,
+         std::format("Deployer '{}': Recorded generation {} with {} changed paths.",
+                     name_,
+                     id,
+                     changes.size()));
+  }
+  catch(std::exception& error)
+  {
+    log_(Log::LOG_WARNING,
+         std::format("Deployer '{}': Failed to record deployment generation: {}",
+                     name_,
+                     error.what()));
+  }
+}
+
+DeploymentPlan Deployer::planDeploy(std::optional<ProgressNode*> progress_node) const
+{
+  DeploymentPlan plan;
+  plan.deployer_name = name_;
+  if(is_autonomous_)
+  {
+    plan.is_supported = false;
+    return plan;
+  }
+  std::vector<int> loadorder;
+  for(auto const& [id, enabled] : loadorders_[current_profile_])
+  {
+    if(enabled)
+      loadorder.push_back(id);
+  }
+  if(progress_node)
+    (*progress_node)->addChildren({ 1, 2 });
+  const auto source_files = getDeploymentSourceFilesAndModSizes(loadorder).first;
+  const auto dest_files =
+    loadDeployedFiles(progress_node ? &(*progress_node)->child(0) : std::optional<ProgressNode*>{});
+  const auto operations = getDeploymentOperations(
+    source_files,
+    dest_files,
+    progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
+
+  std::array<int, 4> num_operations{};
+  for(const auto& operation : operations)
+  {
+    num_operations[operation.type]++;
+    if(operation.type == DeployJournal::restore)
+      (operation.has_backup ? plan.num_backups_restored : plan.num_files_removed)++;
+    else if(operation.type == DeployJournal::remove_directory)
+      plan.num_directories_removed++;
+    else if(operation.type == DeployJournal::backup)
+      plan.num_backups_created++;
+    else
+    {
+      (dest_files.contains(operation.path) ? plan.num_files_replaced : plan.num_files_created)++;
+      if(deploy_mode_ == copy)
+        plan.bytes_to_copy +=
+          sfs::file_size(source_path_ / std::to_string(operation.mod_id) / operation.path);
+    }
+  }
+  for(const auto& [path, id] : source_files)
+  {
+    if(!sfs::is_directory(source_path_ / std::to_string(id) / path))
+      plan.target_files.push_back((dest_path_ / path).lexically_normal());
+  }
+
+  const OperationCosts& costs = operation_costs_[deploy_mode_];
+  for(int type = 0; type < num_operations.size(); type++)
+    plan.estimated_seconds += num_operations[type] * costs.operations[type];
+  plan.estimated_seconds += plan.bytes_to_copy * costs.copy_per_byte;
+  return plan;
+}
+
 void Deployer::unDeploy(std::optional<ProgressNode*> progress_node)
 {
   log_(Log::LOG_DEBUG, "Undeploying...");
@@ -118,6 +452,39 @@ void Deployer::changeLoadorder(int from_index, int to_index)
   }
 }
 
+void Deployer::moveMods(const std::vector<std::pair<int, int>>& moves)
+{
+  if(moves.empty())
+    return;
+  // apply all moves to indices only, then rewrite the actual load order once
+  std::vector<int> order(getLoadorder().size());
+  std::iota(order.begin(), order.end(), 0);
+  for(const auto& [from_index, to_index] : moves)
+  {
+    if(to_index == from_index || from_index < 0 || from_index >= order.size() || to_index < 0 ||
+       to_index >= order.size())
+      continue;
+    if(to_index < from_index)
+      std::rotate(
+        order.begin() + to_index, order.begin() + from_index, order.begin() + from_index + 1);
+    else
+      std::rotate(
+        order.begin() + from_index, order.begin() + from_index + 1, order.begin() + to_index + 1);
+  }
+  reorderMods(order);
+}
+
+void Deployer::reorderMods(const std::vector<int>& order)
+{
+  auto& loadorder = loadorders_[current_profile_];
+  checkLoadorderPermutation(order, loadorder.size());
+  std::vector<std::tuple<int, bool>> new_loadorder;
+  new_loadorder.reserve(loadorder.size());
+  for(int index : order)
+    new_loadorder.push_back(loadorder[index]);
+  loadorder = std::move(new_loadorder);
+}
+
 bool Deployer::addMod(int mod_id, bool enabled, bool update_conflicts)
 {
   if(hasMod(mod_id))
@@ -201,6 +568,71 @@ std::vector<ConflictInfo> Deployer::getFileConflicts(
   return conflicts;
 }
 
+std::shared_ptr<const FileProviderMap> Deployer::getFileProviderMap(
+  std::optional<ProgressNode*> progress_node) const
+{
+  if(is_autonomous_)
+    return std::make_shared<FileProviderMap>();
+  std::vector<int> loadorder;
+  for(const auto& [id, enabled] : loadorders_[current_profile_])
+  {
+    if(enabled && checkModPathExistsAndMaybeLogError(id))
+      loadorder.push_back(id);
+  }
+  if(progress_node)
+    (*progress_node)->setTotalSteps(loadorder.size());
+
+  bool index_changed = false;
+  for(int mod_id : loadorder)
+  {
+    if(updateModFileIndex(mod_id))
+      index_changed = true;
+    if(progress_node)
+      (*progress_node)->advance();
+  }
+  if(provider_map_ && !index_changed && loadorder == provider_map_loadorder_)
+    return provider_map_;
+
+  std::vector<std::pair<int, const std::vector<std::string>*>> mod_files;
+  for(int mod_id : loadorder)
+    mod_files.emplace_back(mod_id, &mod_file_index_[mod_id].files);
+  provider_map_ = std::make_shared<FileProviderMap>(mod_files, isCaseInvariant());
+  provider_map_loadorder_ = loadorder;
+  return provider_map_;
+}
+
+bool Deployer::updateModFileIndex(int mod_id) const
+{
+  const sfs::path mod_base_path = source_path_ / std::to_string(mod_id);
+  auto iter = mod_file_index_.find(mod_id);
+  if(iter != mod_file_index_.end())
+  {
+    auto is_unchanged = [&mod_base_path](const auto& pair)
+    {
+      std::error_code ec;
+      const auto write_time = sfs::last_write_time(mod_base_path / pair.first, ec);
+      return !ec && write_time == pair.second;
+    };
+    if(str::all_of(iter->second.directories, is_unchanged))
+      return false;
+  }
+
+  // modification times are read before the contents of a directory, so that files added
+  // during the scan always invalidate the index
+  ModFileIndex index;
+  index.directories.emplace_back("", sfs::last_write_time(mod_base_path));
+  for(const auto& dir_entry : sfs::recursive_directory_iterator(mod_base_path))
+  {
+    const std::string relative_path = pu::getRelativePath(dir_entry.path(), mod_base_path);
+    if(dir_entry.is_directory())
+      index.directories.emplace_back(relative_path, dir_entry.last_write_time());
+    else
+      index.files.push_back(relative_path);
+  }
+  mod_file_index_[mod_id] = std::move(index);
+  return true;
+}
+
 int Deployer::getNumMods() const
 {
   return loadorders_[current_profile_].size();
@@ -214,6 +646,8 @@ const std::filesystem::path& Deployer::destPath() const
 void Deployer::setDestPath(const sfs::path& path)
 {
   dest_path_ = path;
+  if(track_external_changes_)
+    startWatcher(loadDeployedFiles(), true);
 }
 
 std::unordered_set<int> Deployer::getModConflicts(int mod_id,
@@ -279,75 +713,24 @@ int Deployer::getProfile() const
 
 std::pair<int, std::string> Deployer::verifyDirectories()
 {
-  std::string file_name = "_lmm_write_test_file_";
-  try
+  const auto capabilities = FilesystemProbe::probe(source_path_, dest_path_, false);
+  auto get_message = [this](const std::string& error)
   {
-    std::ofstream file(source_path_ / file_name);
-    if(file.is_open())
-      file << "test";
-  }
-  catch(const std::ios_base::failure& f)
+    return std::format(
+      "Deployer name: '{}', type: '{}'. The error was: '{}'", name_, type_, error);
+  };
+  if(!capabilities.source_writable)
+    return { 1, get_message(capabilities.write_error) };
+  if(deploy_mode_ == copy && !capabilities.dest_writable)
+    return { 3, get_message(capabilities.copy_error) };
+  if(deploy_mode_ == sym_link && !capabilities.sym_links)
+    return { 3, get_message(capabilities.sym_link_error) };
+  if(deploy_mode_ == hard_link && !capabilities.hard_links)
   {
-    return { 1,
-             std::format("Deployer name: '{}', type: '{}'. The error was: '{}'. (Code: {}. Message: '{}')",
-                         name_,
-                         type_,
-                         f.what(),
-                         f.code().value(),
-                         f.code().message()) };
+    if(!capabilities.dest_writable)
+      return { 3, get_message(capabilities.copy_error) };
+    return { 2, get_message(capabilities.hard_link_error) };
   }
-  try
-  {
-    sfs::remove(dest_path_ / file_name);
-    if(deploy_mode_ == copy)
-      sfs::copy_file(source_path_ / file_name, dest_path_ / file_name);
-    else if(deploy_mode_ == sym_link)
-      sfs::create_symlink(source_path_ / file_name, dest_path_ / file_name);
-    else
-      sfs::create_hard_link(source_path_ / file_name, dest_path_ / file_name);
-  }
-  catch(sfs::filesystem_error& e)
-  {
-    if(deploy_mode_ != hard_link)
-    {
-      sfs::remove(source_path_ / file_name);
-      return { 3,
-               std::format("Deployer name: '{}', type: '{}'. The error was: '{}'..(Code: {}. Message: '{}')",
-                           name_,
-                           type_,
-                           e.what(),
-                           e.code().value(),
-                           e.code().message()) };
-    }
-    else
-    {
-      try
-      {
-        sfs::copy_file(source_path_ / file_name, dest_path_ / file_name);
-      }
-      catch(sfs::filesystem_error& e)
-      {
-        sfs::remove(source_path_ / file_name);
-        return { 3,
-                 std::format("Deployer name: '{}', type: '{}'. The error was: '{}'..(Code: {}. Message: '{}')",
-                             name_,
-                             type_,
-                             e.what(),
-                             e.code().value(),
-                             e.code().message()) };
-      }
-      sfs::remove(source_path_ / file_name);
-      return { 2,
-               std::format("Deployer name: '{}', type: '{}'. The error was: '{}'..(Code: {}. Message: '{}')",
-                           name_,
-                           type_,
-                           e.what(),
-                           e.code().value(),
-                           e.code().message()) };
-    }
-  }
-  sfs::remove(source_path_ / file_name);
-  sfs::remove(dest_path_ / file_name);
   return { 0, "" };
 }
 
@@ -364,6 +747,61 @@ bool Deployer::swapMod(int old_id, int new_id)
   return true;
 }
 
+bool Deployer::changeActiveGroupMember(const std::vector<int>& group, int active_id)
+{
+  auto is_member = [&group](const auto& entry)
+  { return str::find(group, std::get<0>(entry)) != group.end(); };
+  auto get_sorted_files = [this](int mod_id)
+  {
+    std::vector<std::string> files;
+    if(!modPathExists(mod_id))
+      return files;
+    updateModFileIndex(mod_id);
+    files = mod_file_index_[mod_id].files;
+    if(isCaseInvariant())
+    {
+      for(auto& file : files)
+        file = pu::toLowerCase(file);
+    }
+    str::sort(files);
+    return files;
+  };
+
+  bool current_profile_changed = false;
+  const int current_profile = current_profile_;
+  for(int profile = 0; profile < loadorders_.size(); profile++)
+  {
+    auto& loadorder = loadorders_[profile];
+    auto first_member = str::find_if(loadorder, is_member);
+    if(first_member == loadorder.end())
+      continue;
+    const int old_id = std::get<0>(*first_member);
+    std::get<0>(*first_member) = active_id;
+    const auto removed = str::remove_if(std::next(first_member), loadorder.end(), is_member);
+    const bool removed_members = !removed.empty();
+    loadorder.erase(removed.begin(), removed.end());
+    if(old_id == active_id && !removed_members)
+      continue;
+    if(profile == current_profile)
+      current_profile_changed = true;
+    if(!auto_update_conflict_groups_)
+      continue;
+    // different versions of one mod often contain the same files
+    if(!removed_members && get_sorted_files(old_id) == get_sorted_files(active_id))
+    {
+      for(auto& conflict_group : conflict_groups_[profile])
+        str::replace(conflict_group, old_id, active_id);
+    }
+    else
+    {
+      current_profile_ = profile;
+      rebuildConflictGroups(true, {});
+      current_profile_ = current_profile;
+    }
+  }
+  return current_profile_changed;
+}
+
 void Deployer::sortModsByConflicts(std::optional<ProgressNode*> progress_node)
 {
   updateConflictGroups(progress_node);
@@ -421,6 +859,8 @@ std::filesystem::path Deployer::sourcePath() const
 void Deployer::setSourcePath(const sfs::path& newSourcePath)
 {
   source_path_ = newSourcePath;
+  mod_file_index_.clear();
+  provider_map_.reset();
 }
 
 std::pair<std::map<std::filesystem::path, int>, std::map<int, unsigned long>>
@@ -428,6 +868,9 @@ Deployer::getDeploymentSourceFilesAndModSizes(const std::vector<int>& loadorder)
 {
   std::map<sfs::path, int> source_files{};
   std::map<int, unsigned long> mod_sizes{};
+  // paths which only differ in case refer to the same file for case invariant deployers
+  const bool case_invariant = isCaseInvariant();
+  std::unordered_set<std::string> lower_case_paths;
   for(int i = loadorder.size() - 1; i >= 0; i--)
   {
     if(!checkModPathExistsAndMaybeLogError(loadorder[i]))
@@ -439,16 +882,22 @@ Deployer::getDeploymentSourceFilesAndModSizes(const std::vector<int>& loadorder)
       const bool is_regular_file = dir_entry.is_regular_file();
       if(is_regular_file)
         mod_size += dir_entry.file_size();
-      if(is_regular_file || dir_entry.is_directory())
-        source_files.insert({ pu::getRelativePath(dir_entry.path(), mod_base_path), loadorder[i] });
+      if(!is_regular_file && !dir_entry.is_directory())
+        continue;
+      const std::string relative_path = pu::getRelativePath(dir_entry.path(), mod_base_path);
+      if(case_invariant && !lower_case_paths.insert(pu::toLowerCase(relative_path)).second)
+        continue;
+      source_files.insert({ relative_path, loadorder[i] });
     }
     mod_sizes[loadorder[i]] = mod_size;
   }
   return { source_files, mod_sizes };
 }
 
-void Deployer::backupOrRestoreFiles(const std::map<sfs::path, int>& source_files,
-                                    const std::map<sfs::path, int>& dest_files) const
+std::vector<DeployJournal::Operation> Deployer::getDeploymentOperations(
+  const std::map<sfs::path, int>& source_files,
+  const std::map<sfs::path, int>& dest_files,
+  std::optional<ProgressNode*> progress_node) const
 {
   std::map<sfs::path, int> restore_targets;
   std::map<sfs::path, int> backup_targets;
@@ -465,7 +914,8 @@ void Deployer::backupOrRestoreFiles(const std::map<sfs::path, int>& source_files
                       std::inserter(backup_targets, backup_targets.begin()),
                       source_files.value_comp());
 
-  std::map<sfs::path, int> restore_directories;
+  std::vector<DeployJournal::Operation> operations;
+  std::vector<DeployJournal::Operation> restore_directories;
   for(const auto& [path, id] : restore_targets)
   {
     sfs::path absolute_path = dest_path_ / path;
@@ -473,65 +923,197 @@ void Deployer::backupOrRestoreFiles(const std::map<sfs::path, int>& source_files
       continue;
     if(sfs::is_directory(absolute_path))
     {
-      restore_directories[path] = id;
+      restore_directories.push_back({ DeployJournal::remove_directory, path });
       continue;
     }
-    sfs::path backup_name = absolute_path.string() + backup_extension_;
-    sfs::remove(absolute_path);
-    if(pu::exists(backup_name))
-      sfs::rename(backup_name, absolute_path);
-  }
-  for(const auto& [path, id] : restore_directories)
-  {
-    sfs::path absolute_path = dest_path_ / path;
-    if(pu::directoryIsEmpty(absolute_path, {managed_dir_file_name_}))
-      sfs::remove_all(absolute_path);
+    const bool has_backup = pu::exists(absolute_path.string() + backup_extension_);
+    operations.push_back({ DeployJournal::restore, path, id, has_backup });
   }
+  operations.insert(operations.end(), restore_directories.begin(), restore_directories.end());
 
   for(const auto& [path, id] : backup_targets)
   {
     sfs::path absolute_path = dest_path_ / path;
-    sfs::path backup_name = absolute_path.string() + backup_extension_;
     if(pu::exists(absolute_path) && !sfs::is_directory(absolute_path))
-      sfs::rename(absolute_path, backup_name);
+      operations.push_back({ DeployJournal::backup, path, id });
   }
-}
 
-void Deployer::deployFiles(const std::map<sfs::path, int>& source_files,
-                           std::optional<ProgressNode*> progress_node) const
-{
   if(progress_node)
     (*progress_node)->setTotalSteps(source_files.size());
-
   for(const auto& [path, id] : source_files)
   {
-    sfs::path dest_path = dest_path_ / path;
+    if(progress_node)
+      (*progress_node)->advance();
     if(!checkModPathExistsAndMaybeLogError(id))
       continue;
-    sfs::path source_path = source_path_ / std::to_string(id) / path;
+    const sfs::path dest_path = dest_path_ / path;
+    const sfs::path source_path = source_path_ / std::to_string(id) / path;
     if(sfs::is_directory(source_path) ||
        pu::exists(dest_path) && (deploy_mode_ == hard_link && !sfs::is_symlink(dest_path) &&
                                     sfs::equivalent(source_path, dest_path) ||
                                   deploy_mode_ == sym_link && sfs::is_symlink(dest_path) &&
                                     sfs::read_symlink(dest_path) == source_path))
+      continue;
+    operations.push_back({ DeployJournal::link, path, id });
+  }
+  return operations;
+}
+
+int Deployer::performDeploymentOperations(
+  DeployJournal& journal,
+  const std::vector<DeployJournal::Operation>& operations,
+  int first_batch,
+  DeployMode deploy_mode,
+  bool cancelable,
+  std::optional<ProgressNode*> progress_node) const
+{
+  const auto batches = DeployJournal::getBatches(operations);
+  if(progress_node)
+    (*progress_node)->setTotalSteps(operations.size());
+  FilesystemCapabilities capabilities;
+  if(deploy_mode == copy)
+    capabilities = FilesystemProbe::probe(source_path_, dest_path_);
+
+  // durations are measured to estimate the costs of future deployments
+  std::array<double, 4> durations{};
+  std::array<int, 4> num_operations{};
+  uint64_t bytes_copied = 0;
+  int num_completed_batches = 0;
+  for(int batch = 0; batch < batches.size(); batch++)
+  {
+    const auto [first, last] = batches[batch];
+    if(batch < first_batch)
     {
       if(progress_node)
-        (*progress_node)->advance();
+        (*progress_node)->advance(last - first);
+      num_completed_batches++;
       continue;
     }
+    if(cancelable && progress_node && (*progress_node)->isCanceled())
+      break;
+    for(int i = first; i < last; i++)
+    {
+      const auto start_time = std::chrono::steady_clock::now();
+      performDeploymentOperation(operations[i], deploy_mode, capabilities);
+      durations[operations[i].type] +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+      num_operations[operations[i].type]++;
+      if(deploy_mode == copy && operations[i].type == DeployJournal::link &&
+         pu::exists(dest_path_ / operations[i].path))
+        bytes_copied += sfs::file_size(dest_path_ / operations[i].path);
+      if(progress_node)
+        (*progress_node)->advance();
+    }
+    DeployJournal::syncFilesystem(dest_path_);
+    journal.completeBatch(batch);
+    num_completed_batches++;
+  }
+
+  OperationCosts& costs = operation_costs_[deploy_mode];
+  // in copy mode, most of the time spent on linking is spent copying the file contents
+  if(deploy_mode == copy && bytes_copied > 0)
+  {
+    const double copy_duration =
+      std::max(0.0,
+               durations[DeployJournal::link] -
+                 num_operations[DeployJournal::link] * costs.operations[DeployJournal::link]);
+    costs.copy_per_byte = (costs.copy_per_byte + copy_duration / bytes_copied) / 2;
+    num_operations[DeployJournal::link] = 0;
+  }
+  for(int type = 0; type < num_operations.size(); type++)
+  {
+    if(num_operations[type] > 0)
+      costs.operations[type] =
+        (costs.operations[type] + durations[type] / num_operations[type]) / 2;
+  }
+  return num_completed_batches;
+}
+
+void Deployer::abortDeployment(DeployJournal& journal,
+                               const std::vector<DeployJournal::Operation>& operations,
+                               int num_performed,
+                               const std::map<sfs::path, int>& source_files,
+                               const std::map<sfs::path, int>& dest_files) const
+{
+  std::map<sfs::path, int> deployed_files = dest_files;
+  std::vector<sfs::path> backed_up_files;
+  for(const auto& operation : operations | stv::take(num_performed))
+  {
+    if(operation.type == DeployJournal::restore ||
+       operation.type == DeployJournal::remove_directory)
+      deployed_files.erase(operation.path);
+    else if(operation.type == DeployJournal::backup)
+      backed_up_files.push_back(operation.path);
+    else
+    {
+      deployed_files[operation.path] = operation.mod_id;
+      // directories are recorded so they can be removed when undeploying
+      for(sfs::path dir = operation.path.parent_path(); !dir.empty(); dir = dir.parent_path())
+      {
+        auto iter = source_files.find(dir);
+        if(iter != source_files.end())
+          deployed_files.insert(*iter);
+      }
+    }
+  }
+  // backed up files which have not been replaced by a mod would otherwise be missing
+  for(const auto& path : backed_up_files)
+  {
+    const sfs::path backup_path = (dest_path_ / path).string() + backup_extension_;
+    if(!deployed_files.contains(path) && pu::exists(backup_path) &&
+       !pu::exists(dest_path_ / path))
+      sfs::rename(backup_path, dest_path_ / path);
+  }
+  saveDeployedFiles(deployed_files);
+  DeployJournal::syncFile(dest_path_ / deployed_files_name_);
+  sfs::remove(dest_path_ / pending_deployed_files_name_);
+  journal.remove();
+  // later generations only store their changes, so this partial state has to be recorded
+  recordGeneration(dest_files, deployed_files);
+}
+
+void Deployer::performDeploymentOperation(const DeployJournal::Operation& operation,
+                                          DeployMode deploy_mode,
+                                          const FilesystemCapabilities& capabilities) const
+{
+  const sfs::path dest_path = dest_path_ / operation.path;
+  const sfs::path backup_path = dest_path.string() + backup_extension_;
+  // every operation may be performed again after an interruption, so it has to check whether
+  // it has already been done
+  if(operation.type == DeployJournal::restore)
+  {
+    if(!operation.has_backup)
+      sfs::remove(dest_path);
+    else if(pu::exists(backup_path))
+      sfs::rename(backup_path, dest_path);
+  }
+  else if(operation.type == DeployJournal::remove_directory)
+  {
+    if(pu::exists(dest_path) && sfs::is_directory(dest_path) &&
+       pu::directoryIsEmpty(dest_path, { managed_dir_file_name_ }))
+      sfs::remove_all(dest_path);
+  }
+  else if(operation.type == DeployJournal::backup)
+  {
+    if(pu::exists(dest_path) && !sfs::is_directory(dest_path))
+      sfs::rename(dest_path, backup_path);
+  }
+  else
+  {
+    if(!checkModPathExistsAndMaybeLogError(operation.mod_id))
+      return;
+    const sfs::path source_path =
+      source_path_ / std::to_string(operation.mod_id) / operation.path;
     const auto parent_path = dest_path.parent_path();
     sfs::create_directories(parent_path);
     removeManagedDirFile(parent_path);
     sfs::remove(dest_path);
-    if(deploy_mode_ == copy)
-      sfs::copy_file(source_path, dest_path);
-    else if(deploy_mode_ == sym_link)
+    if(deploy_mode == copy)
+      FilesystemProbe::copyFile(source_path, dest_path, capabilities);
+    else if(deploy_mode == sym_link)
       sfs::create_symlink(source_path, dest_path);
     else
       sfs::create_hard_link(source_path, dest_path);
-
-    if(progress_node)
-      (*progress_node)->advance();
   }
 }
 
@@ -570,7 +1152,8 @@ std::map<sfs::path, int> Deployer::loadDeployedFiles(std::optional<ProgressNode*
 }
 
 void Deployer::saveDeployedFiles(const std::map<sfs::path, int>& deployed_files,
-                                 std::optional<ProgressNode*> progress_node) const
+                                 std::optional<ProgressNode*> progress_node,
+                                 const std::string& file_name) const
 {
   if(progress_node)
   {
@@ -578,7 +1161,8 @@ void Deployer::saveDeployedFiles(const std::map<sfs::path, int>& deployed_files,
     (*progress_node)->child(0).setTotalSteps(deployed_files.size());
     (*progress_node)->child(1).setTotalSteps(1);
   }
-  sfs::path deployed_files_path = dest_path_ / deployed_files_name_;
+  sfs::path deployed_files_path =
+    dest_path_ / (file_name.empty() ? deployed_files_name_ : file_name);
   std::ofstream file(deployed_files_path, std::fstream::binary);
   if(!file.is_open())
     throw std::runtime_error("Could not write \"" + deployed_files_path.string() + "\"");
@@ -627,6 +1211,12 @@ bool Deployer::checkModPathExistsAndMaybeLogError(int mod_id) const
 }
 
 void Deployer::updateConflictGroups(std::optional<ProgressNode*> progress_node)
+{
+  rebuildConflictGroups(false, progress_node);
+}
+
+void Deployer::rebuildConflictGroups(bool use_file_index,
+                                     std::optional<ProgressNode*> progress_node)
 {
   log_(Log::LOG_INFO, std::format("Deployer '{}': Updating conflict groups...", name_));
   std::map<std::string, int> file_map;
@@ -639,12 +1229,15 @@ void Deployer::updateConflictGroups(std::optional<ProgressNode*> progress_node)
   {
     if(!checkModPathExistsAndMaybeLogError(mod_id))
       continue;
-    std::string base_path = (source_path_ / std::to_string(mod_id)).string();
-    for(const auto& dir_entry : sfs::recursive_directory_iterator(base_path))
+    std::vector<std::string> mod_files;
+    if(use_file_index)
+      updateModFileIndex(mod_id);
+    else
+      mod_files = getModFiles(mod_id);
+    for(std::string relative_path : use_file_index ? mod_file_index_[mod_id].files : mod_files)
     {
-      if(dir_entry.is_directory())
-        continue;
-      const auto relative_path = pu::getRelativePath(dir_entry.path(), base_path);
+      if(isCaseInvariant())
+        relative_path = pu::toLowerCase(relative_path);
       if(!file_map.contains(relative_path))
         file_map[relative_path] = mod_id;
       else
@@ -722,6 +1315,8 @@ void Deployer::cleanup()
 {
   deploy(std::vector<int>{});
   sfs::remove(dest_path_ / deployed_files_name_);
+  sfs::remove(dest_path_ / hash_cache_name_);
+  sfs::remove_all(dest_path_ / generations_dir_name_);
 }
 
 bool Deployer::autoUpdateConflictGroups() const
@@ -763,11 +1358,40 @@ std::vector<std::pair<sfs::path, int>> Deployer::getExternallyModifiedFiles(
 
   std::vector<std::pair<sfs::path, int>> modified_files;
   const auto deployed_files = loadDeployedFiles();
+  std::optional<std::set<sfs::path>> changed_paths;
+  if(watcher_)
+    changed_paths = watcher_->takeModifiedPaths();
+
+  std::map<sfs::path, int> changed_files;
+  if(changed_paths)
+  {
+    // a changed directory implies that all files in it may have changed, those files are
+    // stored directly after the directory in the sorted map
+    for(const auto& changed_path : *changed_paths)
+    {
+      for(auto iter = deployed_files.lower_bound(changed_path); iter != deployed_files.end();
+          iter++)
+      {
+        if(std::mismatch(changed_path.begin(),
+                         changed_path.end(),
+                         iter->first.begin(),
+                         iter->first.end())
+             .first != changed_path.end())
+          break;
+        changed_files.insert(*iter);
+      }
+    }
+    log_(Log::LOG_DEBUG,
+         std::format("Deployer '{}': {} deployed files have been changed since the last check",
+                     name_,
+                     changed_files.size()));
+  }
+  const auto& files_to_check = changed_paths ? changed_files : deployed_files;
 
   if(progress_node)
-    (*progress_node)->setTotalSteps(deployed_files.size());
+    (*progress_node)->setTotalSteps(files_to_check.size());
 
-  for(const auto& [path, mod_id] : deployed_files)
+  for(const auto& [path, mod_id] : files_to_check)
   {
     const auto target_path = dest_path_ / path;
     const auto mod_file_path = source_path_ / std::to_string(mod_id) / path;
@@ -784,6 +1408,14 @@ std::vector<std::pair<sfs::path, int>> Deployer::getExternallyModifiedFiles(
       (*progress_node)->advance();
   }
 
+  if(watcher_ && !changed_paths)
+  {
+    std::vector<sfs::path> modified_paths;
+    for(const auto& [path, mod_id] : modified_files)
+      modified_paths.push_back(path);
+    watcher_->addModifiedPaths(modified_paths);
+  }
+
   if(modified_files.empty())
     log_(Log::LOG_INFO, "No changes found");
   else
@@ -792,6 +1424,147 @@ std::vector<std::pair<sfs::path, int>> Deployer::getExternallyModifiedFiles(
   return modified_files;
 }
 
+DeploymentAudit Deployer::auditDeployment(std::optional<ProgressNode*> progress_node) const
+{
+  DeploymentAudit audit;
+  audit.deployer_name = name_;
+  if(is_autonomous_)
+    return audit;
+
+  log_(Log::LOG_INFO, std::format("Deployer '{}': Auditing deployed files...", name_));
+  const auto deployed_files = loadDeployedFiles();
+  const std::vector<std::pair<sfs::path, int>> files(deployed_files.begin(),
+                                                     deployed_files.end());
+  std::vector<DeploymentAudit::Status> statuses(files.size());
+  if(progress_node)
+    (*progress_node)->setTotalSteps(files.size());
+
+  FileHashCache hash_cache(dest_path_ / hash_cache_name_);
+  std::atomic<int> next_file = 0;
+  std::atomic<bool> has_error = false;
+  std::string error_message;
+  std::mutex mutex;
+  std::optional<AtomicProgressNode> atomic_progress;
+  if(progress_node)
+  {
+    atomic_progress.emplace(**progress_node);
+    atomic_progress->startSampling();
+  }
+  auto audit_files = [&]()
+  {
+    for(int i = next_file++; i < files.size() && !has_error; i = next_file++)
+    {
+      try
+      {
+        statuses[i] = getAuditStatus(files[i].first, files[i].second, hash_cache);
+      }
+      catch(std::exception& error)
+      {
+        std::lock_guard lock(mutex);
+        if(!has_error.exchange(true))
+          error_message = error.what();
+      }
+      if(atomic_progress)
+        atomic_progress->advance();
+    }
+  };
+  const int num_threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()),
+                                     1,
+                                     std::max(1, static_cast<int>(files.size())));
+  std::vector<std::jthread> threads;
+  for(int i = 1; i < num_threads; i++)
+    threads.emplace_back(audit_files);
+  audit_files();
+  for(auto& thread : threads)
+    thread.join();
+  if(atomic_progress)
+    atomic_progress->stopSampling();
+  if(has_error)
+    throw std::runtime_error(error_message);
+
+  try
+  {
+    hash_cache.save();
+  }
+  catch(std::runtime_error& error)
+  {
+    log_(Log::LOG_WARNING, error.what());
+  }
+
+  for(int i = 0; i < files.size(); i++)
+  {
+    if(statuses[i] == DeploymentAudit::identical)
+      audit.num_identical++;
+    else
+      audit.entries.push_back({ files[i].first, files[i].second, statuses[i] });
+  }
+  log_(Log::LOG_INFO,
+       std::format("Deployer '{}': {} of {} files are identical to their source.",
+                   name_,
+                   audit.num_identical,
+                   files.size()));
+  return audit;
+}
+
+void Deployer::repairDeployment(const DeploymentAudit& audit)
+{
+  if(is_autonomous_ || audit.entries.empty())
+    return;
+
+  log_(Log::LOG_INFO,
+       std::format("Deployer '{}': Repairing {} files...", name_, audit.entries.size()));
+  const auto old_deployed_files = loadDeployedFiles();
+  auto deployed_files = old_deployed_files;
+  FilesystemCapabilities capabilities;
+  if(deploy_mode_ == copy)
+    capabilities = FilesystemProbe::probe(source_path_, dest_path_);
+  for(const auto& [path, mod_id, status] : audit.entries)
+  {
+    const sfs::path dest_file = dest_path_ / path;
+    const sfs::path source_file = source_path_ / std::to_string(mod_id) / path;
+    if(status == DeploymentAudit::identical || !deployed_files.contains(path))
+      continue;
+    if(status == DeploymentAudit::orphaned)
+    {
+      if(!sfs::is_directory(dest_file))
+        sfs::remove(dest_file);
+      else if(pu::directoryIsEmpty(dest_file, { managed_dir_file_name_ }))
+        sfs::remove_all(dest_file);
+      const sfs::path backup_file = dest_file.string() + backup_extension_;
+      if(pu::exists(backup_file) && !pu::exists(dest_file))
+        sfs::rename(backup_file, dest_file);
+      deployed_files.erase(path);
+      continue;
+    }
+    if(sfs::is_directory(source_file))
+    {
+      if(!sfs::is_directory(dest_file))
+      {
+        sfs::remove(dest_file);
+        sfs::create_directories(dest_file);
+      }
+      continue;
+    }
+    if(sfs::is_directory(dest_file))
+    {
+      log_(Log::LOG_WARNING,
+           std::format("Could not repair '{}', because it has been replaced with a directory.",
+                       dest_file.string()));
+      continue;
+    }
+    sfs::create_directories(dest_file.parent_path());
+    sfs::remove(dest_file);
+    if(deploy_mode_ == copy)
+      FilesystemProbe::copyFile(source_file, dest_file, capabilities);
+    else if(deploy_mode_ == sym_link)
+      sfs::create_symlink(source_file, dest_file);
+    else
+      sfs::create_hard_link(source_file, dest_file);
+  }
+  saveDeployedFiles(deployed_files);
+  recordGeneration(old_deployed_files, deployed_files);
+}
+
 void Deployer::keepOrRevertFileModifications(const FileChangeChoices& changes_to_keep)
 {
   if(deploy_mode_ == copy)
@@ -832,10 +1605,20 @@ void Deployer::keepOrRevertFileModifications(const FileChangeChoices& changes_to
   }
 }
 
+void Deployer::invalidateModFileIndex(int mod_id) const
+{
+  mod_file_index_.erase(mod_id);
+  provider_map_.reset();
+}
+
 void Deployer::updateDeployedFilesForMod(int mod_id,
                                          std::optional<ProgressNode*> progress_node) const
 {
+  invalidateModFileIndex(mod_id);
   std::map<sfs::path, int> deployed_files = loadDeployedFiles(progress_node);
+  FilesystemCapabilities capabilities;
+  if(deploy_mode_ == copy)
+    capabilities = FilesystemProbe::probe(source_path_, dest_path_);
   for(const auto& [path, id] : deployed_files)
   {
     if(id != mod_id)
@@ -851,7 +1634,7 @@ void Deployer::updateDeployedFilesForMod(int mod_id,
     if(deploy_mode_ == sym_link)
       sfs::create_symlink(source_path, dest_path);
     else if(deploy_mode_ == DeployMode::copy)
-      sfs::copy(source_path, dest_path);
+      FilesystemProbe::copyFile(source_path, dest_path, capabilities);
     else
       sfs::create_hard_link(source_path, dest_path);
   }
@@ -862,29 +1645,47 @@ void Deployer::fixInvalidLinkDeployMode()
   if(deploy_mode_ != hard_link)
     return;
 
-  const std::string file_name = "_lmm_write_test_file_";
-  try
-  {
-    sfs::remove(source_path_ / file_name);
-    sfs::remove(dest_path_ / file_name);
-
-    sfs::create_hard_link(source_path_ / file_name, dest_path_ / file_name);
-  }
-  catch(...)
+  const auto capabilities = FilesystemProbe::probe(source_path_, dest_path_);
+  if(!capabilities.source_writable)
   {
-    log_(Log::LOG_DEBUG,
-         std::format("Deployer {} failed to create hard link. Switching to sym link.", name_));
-    deploy_mode_ = sym_link;
-  }
-  try
-  {
-    sfs::remove(source_path_ / file_name);
-    sfs::remove(dest_path_ / file_name);
+    log_(Log::LOG_ERROR, "Failed to write to disk. Ensure that permissions are set correctly.");
+    return;
   }
-  catch(...)
+  const DeployMode new_mode = recommendDeployMode(capabilities);
+  if(new_mode == hard_link)
+    return;
+  log_(Log::LOG_DEBUG,
+       std::format("Deployer {} failed to create hard link. Switching to {}.",
+                   name_,
+                   new_mode == sym_link ? "sym link" : "copy"));
+  deploy_mode_ = new_mode;
+}
+
+Deployer::DeployMode Deployer::recommendDeployMode(const FilesystemCapabilities& capabilities)
+{
+  if(capabilities.hard_links)
+    return hard_link;
+  // reflinks are as cheap as links while keeping deployed files independent
+  if(capabilities.reflinks || !capabilities.sym_links)
+    return copy;
+  return sym_link;
+}
+
+Deployer::OperationCosts Deployer::getOperationCosts(DeployMode deploy_mode) const
+{
+  return operation_costs_[deploy_mode];
+}
+
+void Deployer::setOperationCosts(DeployMode deploy_mode, const OperationCosts& costs)
+{
+  OperationCosts& current_costs = operation_costs_[deploy_mode];
+  for(int type = 0; type < costs.operations.size(); type++)
   {
-    log_(Log::LOG_ERROR, "Failed to write to disk. Ensure that permissions are set correctly.");
+    if(costs.operations[type] >= 0)
+      current_costs.operations[type] = costs.operations[type];
   }
+  if(costs.copy_per_byte >= 0)
+    current_costs.copy_per_byte = costs.copy_per_byte;
 }
 
 int Deployer::getDeployPriority() const
@@ -952,7 +1753,214 @@ void Deployer::setEnableUnsafeSorting(bool enable)
   enable_unsafe_sorting_ = enable;
 }
 
+void Deployer::setTrackExternalChanges(bool track)
+{
+  if(track == track_external_changes_)
+    return;
+  track_external_changes_ = track;
+  if(track)
+    startWatcher(loadDeployedFiles(), true);
+  else
+    watcher_.reset();
+}
+
+bool Deployer::tracksExternalChanges() const
+{
+  return track_external_changes_;
+}
+
+std::vector<DeploymentGeneration> Deployer::getGenerations() const
+{
+  return DeploymentHistory(dest_path_ / generations_dir_name_).getGenerations();
+}
+
+void Deployer::rollbackToGeneration(int generation, std::optional<ProgressNode*> progress_node)
+{
+  DeploymentHistory history(dest_path_ / generations_dir_name_);
+  const auto generations = history.getGenerations();
+  auto target = str::find_if(generations,
+                             [generation](const auto& entry) { return entry.id == generation; });
+  if(target == generations.end())
+    throw std::runtime_error(std::format("Deployment generation {} does not exist.", generation));
+  // the restored load order and deployed files would be applied to the wrong profile
+  if(target->profile != current_profile_)
+    throw std::runtime_error(
+      std::format("Deployment generation {} belongs to profile {}, but profile {} is active.",
+                  generation,
+                  target->profile,
+                  current_profile_));
+  const auto changes = history.getChangesSince(generation);
+
+  if(progress_node)
+    (*progress_node)->addChildren({ 2, 6 });
+  watcher_.reset();
+  recoverInterruptedDeployment();
+  const std::map<sfs::path, int> deployed_files =
+    loadDeployedFiles(progress_node ? &(*progress_node)->child(0) : std::optional<ProgressNode*>{});
+  std::map<sfs::path, int> source_files;
+  std::map<sfs::path, int> dest_files;
+  int num_missing = 0;
+  for(const auto& [path, mod_id] : changes)
+  {
+    auto iter = deployed_files.find(path);
+    if(iter == deployed_files.end() ? mod_id == -1 : iter->second == mod_id)
+      continue;
+    if(mod_id != -1 && !pu::exists(source_path_ / std::to_string(mod_id) / path))
+    {
+      num_missing++;
+      continue;
+    }
+    if(iter != deployed_files.end())
+      dest_files.insert(*iter);
+    if(mod_id != -1)
+      source_files[path] = mod_id;
+  }
+  if(num_missing > 0)
+    log_(Log::LOG_WARNING,
+         std::format("Deployer '{}': {} files of generation {} no longer exist in their mods "
+                     "and will not be restored.",
+                     name_,
+                     num_missing,
+                     generation));
+  log_(Log::LOG_INFO,
+       std::format("Deployer '{}': Rolling back to generation {}, changing {} paths...",
+                   name_,
+                   generation,
+                   std::max(source_files.size(), dest_files.size())));
+
+  // mods which have since been removed are dropped, newly added mods are kept but disabled
+  const int profile = target->profile;
+  std::vector<std::tuple<int, bool>> old_loadorder;
+  if(profile >= 0 && profile < loadorders_.size())
+  {
+    old_loadorder = loadorders_[profile];
+    auto contains = [](const std::vector<std::tuple<int, bool>>& loadorder, int mod_id)
+    {
+      return str::find_if(loadorder,
+                          [mod_id](const auto& entry)
+                          { return std::get<0>(entry) == mod_id; }) != loadorder.end();
+    };
+    std::vector<std::tuple<int, bool>> loadorder;
+    for(const auto& entry : target->loadorder)
+    {
+      if(contains(old_loadorder, std::get<0>(entry)))
+        loadorder.push_back(entry);
+    }
+    for(const auto& [mod_id, _] : old_loadorder)
+    {
+      if(!contains(loadorder, mod_id))
+        loadorder.emplace_back(mod_id, false);
+    }
+    loadorders_[profile] = loadorder;
+  }
+  try
+  {
+    applyDeployment(source_files,
+                    dest_files,
+                    deployed_files,
+                    progress_node ? &(*progress_node)->child(1) : std::optional<ProgressNode*>{});
+  }
+  catch(std::exception& error)
+  {
+    if(profile >= 0 && profile < loadorders_.size())
+      loadorders_[profile] = old_loadorder;
+    throw;
+  }
+}
+
+void Deployer::setMaxGenerations(int max_generations)
+{
+  max_generations_ = std::max(max_generations, 0);
+  try
+  {
+    DeploymentHistory history(dest_path_ / generations_dir_name_);
+    if(max_generations_ == 0)
+      history.clear();
+    else
+      history.prune(max_generations_);
+  }
+  catch(std::exception& error)
+  {
+    log_(Log::LOG_WARNING,
+         std::format("Deployer '{}': Failed to remove old deployment generations: {}",
+                     name_,
+                     error.what()));
+  }
+}
+
+int Deployer::getMaxGenerations() const
+{
+  return max_generations_;
+}
+
+void Deployer::startWatcher(const std::map<sfs::path, int>& deployed_files,
+                            bool require_full_sweep)
+{
+  watcher_.reset();
+  if(is_autonomous_ || !sfs::exists(dest_path_))
+    return;
+  std::set<sfs::path> directories;
+  for(const auto& [path, mod_id] : deployed_files)
+  {
+    if(path.has_parent_path())
+      directories.insert(path.parent_path());
+  }
+  std::erase_if(directories,
+                [this](const sfs::path& dir) { return !sfs::is_directory(dest_path_ / dir); });
+  try
+  {
+    watcher_ = std::make_unique<DeploymentWatcher>(dest_path_, directories, require_full_sweep);
+  }
+  catch(std::runtime_error& error)
+  {
+    log_(Log::LOG_WARNING,
+         std::format("Deployer '{}': Could not track changes in target directory. "
+                     "Checking all files instead.\n{}",
+                     name_,
+                     error.what()));
+  }
+}
+
+void Deployer::checkLoadorderPermutation(const std::vector<int>& order, size_t size)
+{
+  if(order.size() != size)
+    throw std::invalid_argument(
+      std::format("Invalid load order: Expected {} mods but got {}.", size, order.size()));
+  std::vector<bool> seen(size, false);
+  for(int index : order)
+  {
+    if(index < 0 || index >= size || seen[index])
+      throw std::invalid_argument(std::format("Invalid load order: Bad index {}.", index));
+    seen[index] = true;
+  }
+}
+
 void Deployer::removeManagedDirFile(const sfs::path& directory) const
 {
   sfs::remove(directory / managed_dir_file_name_);
 }
+
+DeploymentAudit::Status Deployer::getAuditStatus(const sfs::path& path,
+                                                 int mod_id,
+                                                 FileHashCache& hash_cache) const
+{
+  const sfs::path dest_file = dest_path_ / path;
+  const sfs::path source_file = source_path_ / std::to_string(mod_id) / path;
+  if(!modPathExists(mod_id) || !pu::exists(source_file))
+    return DeploymentAudit::orphaned;
+  if(!pu::exists(dest_file))
+    return DeploymentAudit::missing;
+  if(sfs::is_directory(source_file) || sfs::is_directory(dest_file))
+    return sfs::is_directory(source_file) && sfs::is_directory(dest_file)
+             ? DeploymentAudit::identical
+             : DeploymentAudit::modified;
+  const bool is_symlink = sfs::is_symlink(dest_file);
+  if(deploy_mode_ == hard_link && !is_symlink && sfs::equivalent(source_file, dest_file) ||
+     deploy_mode_ == sym_link && is_symlink && sfs::read_symlink(dest_file) == source_file)
+    return DeploymentAudit::identical;
+  if(sfs::file_size(source_file) != sfs::file_size(dest_file))
+    return DeploymentAudit::modified;
+  return hash_cache.getHash(source_file) == hash_cache.getHash(dest_file)
+           ? DeploymentAudit::identical
+           : DeploymentAudit::modified;
+}
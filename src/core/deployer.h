@@ -6,11 +6,21 @@
 #pragma once
 
 #include "conflictinfo.h"
+#include "deployjournal.h"
+#include "deploymentaudit.h"
+#include "deploymenthistory.h"
+#include "deploymentplan.h"
+#include "deploymentwatcher.h"
+#include "filehashcache.h"
 #include "filechangechoices.h"
+#include "fileprovidermap.h"
+#include "filesystemprobe.h"
 #include "log.h"
 #include "progressnode.h"
+#include <array>
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <optional>
 #include <unordered_set>
 #include <vector>
@@ -33,6 +43,20 @@ public:
     copy = 2
   };
 
+  /*! \brief Measured durations of deployment operations for one deploy mode. */
+  struct OperationCosts
+  {
+    /*!
+     * \brief For every DeployJournal::OperationType: The average duration of one operation
+     * in seconds.
+     */
+    std::array<double, 4> operations = { 5e-5, 2e-5, 5e-5, 1e-4 };
+    /*! \brief The average duration of copying one byte in seconds. */
+    double copy_per_byte = 2e-9;
+
+    bool operator==(const OperationCosts&) const = default;
+  };
+
   /*!
    * \brief Constructor.
    * \param source_path Path to directory containing mods installed using the Installer class.
@@ -71,9 +95,12 @@ public:
    * Previously backed up files are automatically restored if no mod in the current load order
    * overwrites them. Conflicts are handled by overwriting mods earlier in the load order
    * with later mods.
+   * If cancellation is requested through the progress node, deployment stops after the
+   * current batch of file operations and the files deployed so far are recorded.
    * \param loadorder A vector of mod ids representing the load order.
    * \param progress_node Used to inform about the current progress of deployment.
    * \return A map from deployed mod ids to their respective mods total size on disk.
+   * \throws CancellationError If the deployment has been canceled.
    */
   virtual std::map<int, unsigned long> deploy(const std::vector<int>& loadorder,
                                               std::optional<ProgressNode*> progress_node = {});
@@ -87,6 +114,38 @@ public:
    * \return A map from deployed mod ids to their respective mods total size on disk.
    */
   virtual std::map<int, unsigned long> deploy(std::optional<ProgressNode*> progress_node = {});
+  /*!
+   * \brief Updates only paths provided by the given mods, either in the current deployment or
+   * in the current load order, using the internal load order, e.g. after
+   * \ref changeActiveGroupMember. Falls back to a full deployment if any other deployed path
+   * does not match the current load order. Case invariant deployers always perform a full
+   * deployment.
+   * \param mod_ids Mods whose files are redeployed.
+   * \param progress_node Used to inform about the current progress of deployment.
+   * \return False if nothing has been deployed to the target directory, in which case
+   * nothing is done.
+   * \throws CancellationError If the deployment has been canceled.
+   */
+  bool redeployMods(const std::vector<int>& mod_ids,
+                    std::optional<ProgressNode*> progress_node = {});
+  /*!
+   * \brief Determines which file operations deploying the current load order would perform,
+   * without changing any file. Costs of the operations are estimated from the durations
+   * measured during previous deployments.
+   * Autonomous deployers do not support this and return an unsupported plan.
+   * \param progress_node Used to inform about the current progress.
+   * \return The plan.
+   */
+  virtual DeploymentPlan planDeploy(std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief If a previous deployment has been interrupted: Completes all remaining operations
+   * recorded in its journal. Journals which have not been written completely are discarded,
+   * since no files are changed before that. A completed deployment is recorded as a new
+   * generation.
+   * \param progress_node Used to inform about the current progress.
+   * \return True if an interrupted deployment was found.
+   */
+  bool recoverInterruptedDeployment(std::optional<ProgressNode*> progress_node = {});
   /*!
    * \brief Removes all deployed mods from the target directory and restores backups.
    * \param progress_node Used to inform about the current progress.
@@ -113,6 +172,19 @@ public:
    * \param to_index Destination index.
    */
   virtual void changeLoadorder(int from_index, int to_index);
+  /*!
+   * \brief Moves multiple mods at once. The result is the same as calling \ref changeLoadorder
+   * for every move in the given order, but the load order is only rewritten once.
+   * \param moves Pairs of from_index and to_index, applied in the given order.
+   */
+  void moveMods(const std::vector<std::pair<int, int>>& moves);
+  /*!
+   * \brief Replaces the load order with a permutation of itself.
+   * \param order For every position in the new load order: The index of the mod at that
+   * position in the current load order. Must contain every index exactly once.
+   * \throw std::invalid_argument If order is no permutation of the current indices.
+   */
+  virtual void reorderMods(const std::vector<int>& order);
   /*!
    * \brief Appends a new mod to the load order.
    * \param mod_id Id of the mod to be added.
@@ -150,6 +222,17 @@ public:
     int mod_id,
     bool show_disabled = false,
     std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief Maps every file provided by the enabled mods of the current profile to all mods
+   * providing it, in overwrite order. The map is cached and only rebuilt when the load order
+   * or the files of a mod change. Files of every mod are indexed and only read again when the
+   * modification time of the mods directory changes.
+   * Autonomous deployers do not support this and return an empty map.
+   * \param progress_node Used to inform about the current progress.
+   * \return The map.
+   */
+  virtual std::shared_ptr<const FileProviderMap> getFileProviderMap(
+    std::optional<ProgressNode*> progress_node = {}) const;
   /*!
    * \brief Returns the number of mods in the load order.
    * \return The number of mods.
@@ -208,6 +291,16 @@ public:
    * \return True iff the mod has been swapped.
    */
   virtual bool swapMod(int old_id, int new_id);
+  /*!
+   * \brief In the load order of every profile: Replaces the first member of the given group
+   * with the given mod and removes all other members. Conflict groups of changed profiles are
+   * updated in place if the new member contains the same files as the replaced one, otherwise
+   * they are rebuilt using cached file lists.
+   * \param group All members of the group.
+   * \param active_id The new active member.
+   * \return True iff the load order of the current profile has been changed.
+   */
+  bool changeActiveGroupMember(const std::vector<int>& group, int active_id);
   /*!
    * \brief Sorts the load order by grouping mods which contain conflicting files.
    * \param progress_node Used to inform about the current progress.
@@ -254,8 +347,8 @@ public:
    */
   void setLog(const std::function<void(Log::LogLevel, const std::string&)>& newLog);
   /*!
-   * \brief Removes all deployed mods from the target directory and deletes the file
-   * which stores the state of this deployer.
+   * \brief Removes all deployed mods from the target directory and deletes the files
+   * which store the state and deployment history of this deployer.
    */
   virtual void cleanup();
   /*!
@@ -305,6 +398,29 @@ public:
    * that file should be kept.
    */
   virtual void keepOrRevertFileModifications(const FileChangeChoices& changes_to_keep);
+  /*!
+   * \brief Compares the content of every file in the deployment record to its source file
+   * using multiple threads. Hashes are cached by inode, size and modification time in the
+   * target directory, so repeated audits only hash changed files.
+   * Autonomous deployers do not support this and return an empty audit.
+   * \param progress_node Used to inform about the current progress.
+   * \return Every file which is not identical to its source.
+   */
+  virtual DeploymentAudit auditDeployment(std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief Fixes every file in the given audit. Modified and missing files are deployed again,
+   * orphaned files are removed from the target directory and the deployment record. Changes
+   * to the record are stored as a new generation.
+   * \param audit Audit created by \ref auditDeployment.
+   */
+  virtual void repairDeployment(const DeploymentAudit& audit);
+  /*!
+   * \brief Removes the cached list of files of the given mod. Must be called after files in the
+   * mods directory have been changed, since only the modification time of the mods root
+   * directory is checked for changes.
+   * \param mod_id Target mod.
+   */
+  void invalidateModFileIndex(int mod_id) const;
   /*!
    * \brief Updates the deployed files for one mod to match those in the mod's source directory.
    * \param mod_id Target mod.
@@ -312,8 +428,32 @@ public:
    */
   virtual void updateDeployedFilesForMod(int mod_id,
                                          std::optional<ProgressNode*> progress_node = {}) const;
-  /*! \brief If using hard_link deploy mode and links cannot be created: Switch to sym links. */
+  /*!
+   * \brief If using hard_link deploy mode and links cannot be created: Switch to the mode
+   * recommended by \ref recommendDeployMode.
+   */
   virtual void fixInvalidLinkDeployMode();
+  /*!
+   * \brief Selects the cheapest deploy mode which works with the given capabilities.
+   * Prefers hard links, then copies if reflinks are supported, then sym links.
+   * \param capabilities Capabilities of the source and target directories.
+   * \return The recommended deploy mode.
+   */
+  static DeployMode recommendDeployMode(const FilesystemCapabilities& capabilities);
+  /*!
+   * \brief Returns the costs of deployment operations measured by this deployer, which are
+   * used to estimate the duration of planned deployments.
+   * \param deploy_mode Deploy mode for which the costs have been measured.
+   * \return The costs.
+   */
+  OperationCosts getOperationCosts(DeployMode deploy_mode) const;
+  /*!
+   * \brief Sets the costs of deployment operations, e.g. to restore previously measured costs.
+   * Negative costs are ignored.
+   * \param deploy_mode Deploy mode for which the costs have been measured.
+   * \param costs The new costs.
+   */
+  void setOperationCosts(DeployMode deploy_mode, const OperationCosts& costs);
   /*!
    * \brief Returns the order in which the deploy function of different
    *  deployers should be called.
@@ -386,6 +526,46 @@ public:
    * \param The new safe sorting state.
    */
   void setEnableUnsafeSorting(bool enable);
+  /*!
+   * \brief Enables or disables tracking of changes to the target directory using inotify.
+   * While enabled, \ref getExternallyModifiedFiles only checks files which have been changed
+   * since the last deployment or, if this was enabled afterwards, since the first check.
+   * \param track If true: Track changes.
+   */
+  void setTrackExternalChanges(bool track);
+  /*!
+   * \brief Returns whether changes to the target directory are being tracked.
+   * \return The tracking state.
+   */
+  bool tracksExternalChanges() const;
+  /*!
+   * \brief Returns all retained deployment generations, sorted from oldest to newest.
+   * Autonomous deployers do not record generations.
+   * \return The generations.
+   */
+  std::vector<DeploymentGeneration> getGenerations() const;
+  /*!
+   * \brief Restores the target directory and the load order to the state after the
+   * deployment of the given generation. Only paths which have changed since that generation
+   * are redeployed. Paths whose source mod no longer exists are left unchanged. The rollback
+   * itself is recorded as a new generation.
+   * \param generation Id of the target generation.
+   * \param progress_node Used to inform about the current progress.
+   * \throws std::runtime_error If no generation with the given id exists or if it has been
+   * deployed for a profile other than the current profile.
+   * \throws CancellationError If the rollback has been canceled.
+   */
+  void rollbackToGeneration(int generation, std::optional<ProgressNode*> progress_node = {});
+  /*!
+   * \brief Sets the maximum number of generations to retain. Older generations are removed.
+   * \param max_generations The new maximum. If 0: Do not record generations.
+   */
+  void setMaxGenerations(int max_generations);
+  /*!
+   * \brief Returns the maximum number of generations to retain.
+   * \return The maximum.
+   */
+  int getMaxGenerations() const;
 
 protected:
   /*! \brief Type of this deployer, e.g. Simple Deployer. */
@@ -400,6 +580,14 @@ protected:
   const std::string deployed_files_name_ = ".lmmfiles";
   /*! \brief Name of the file indicating that the directory is managed by a deployer. */
   const std::string managed_dir_file_name_ = ".lmm_managed_dir";
+  /*! \brief Name of the file in the target directory used to cache file hashes. */
+  const std::string hash_cache_name_ = ".lmmhashes";
+  /*! \brief Name of the file in the target directory containing the deployment journal. */
+  const std::string journal_name_ = ".lmmjournal";
+  /*! \brief Name of the file containing the deployed files while deployment is in progress. */
+  const std::string pending_deployed_files_name_ = ".lmmfiles.new";
+  /*! \brief Name of the directory in the target directory containing deployment generations. */
+  const std::string generations_dir_name_ = ".lmmgenerations";
   /*! \brief The name of this deployer. */
   std::string name_;
   /*! \brief The currently active profile. */
@@ -419,7 +607,74 @@ protected:
   bool auto_update_conflict_groups_ = false;
   /*! \brief Determines whether sorting mods can affect overwrite behavior. */
   bool enable_unsafe_sorting_ = false;
+  /*! \brief If true: Track changes to the target directory using \ref watcher_. */
+  bool track_external_changes_ = false;
+  /*! \brief Maximum number of deployment generations to retain. If 0: Record none. */
+  int max_generations_ = 10;
+  /*! \brief Records changes to the target directory. Empty if tracking is not possible. */
+  std::unique_ptr<DeploymentWatcher> watcher_;
+  /*!
+   * \brief For every DeployMode: Costs measured during deployments to the target directory.
+   * Updated by \ref performDeploymentOperations.
+   */
+  mutable std::array<OperationCosts, 3> operation_costs_;
+
+  /*! \brief Relative paths of all files in one mod. */
+  struct ModFileIndex
+  {
+    /*!
+     * \brief Relative paths of all directories in the mod, including the mods root directory,
+     * and their modification times when the files were read.
+     */
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> directories;
+    /*! \brief Paths of all files in the mod, excluding directories. */
+    std::vector<std::string> files;
+  };
+  /*! \brief Maps mod ids to the files of that mod. Used to build \ref provider_map_. */
+  mutable std::map<int, ModFileIndex> mod_file_index_;
+  /*! \brief Enabled mods, in load order, used to build \ref provider_map_. */
+  mutable std::vector<int> provider_map_loadorder_;
+  /*! \brief Cached result of \ref getFileProviderMap. Empty if it needs to be rebuilt. */
+  mutable std::shared_ptr<const FileProviderMap> provider_map_;
 
+  /*!
+   * \brief Reads the files of the given mod into \ref mod_file_index_, unless they have
+   * been read since the last modification of any directory in the mod. Adding, removing or
+   * renaming a file changes the modification time of its parent directory.
+   * \param mod_id Target mod. Its directory must exist.
+   * \return True if the files have been read.
+   */
+  bool updateModFileIndex(int mod_id) const;
+  /*!
+   * \brief Updates conflict_groups_ for the current profile.
+   * \param use_file_index If true: Use \ref mod_file_index_ instead of reading every mod.
+   * \param progress_node Used to inform about the current progress.
+   */
+  void rebuildConflictGroups(bool use_file_index, std::optional<ProgressNode*> progress_node);
+  /*!
+   * \brief Changes the target directory from the deployed state to the given state and updates
+   * the deployment record. Only paths contained in either of the given maps are changed.
+   * \param source_files Maps paths to be deployed to their source mods.
+   * \param dest_files Maps paths which are currently deployed and may change to their mods.
+   * \param deployed_files All currently deployed paths.
+   * \param progress_node Used to inform about the current progress.
+   * \throws CancellationError If the deployment has been canceled.
+   */
+  void applyDeployment(const std::map<std::filesystem::path, int>& source_files,
+                       const std::map<std::filesystem::path, int>& dest_files,
+                       const std::map<std::filesystem::path, int>& deployed_files,
+                       std::optional<ProgressNode*> progress_node);
+  /*!
+   * \brief Records a change of the deployment record as a new generation. This has to be
+   * called whenever the record is written, since every generation only stores the changes
+   * to its predecessor. Generations without changed paths are only recorded if the load
+   * order has changed as well. Errors are logged, since they do not affect the deployment
+   * itself.
+   * \param deployed_files All paths deployed before the change.
+   * \param new_deployed_files All paths deployed after the change.
+   */
+  void recordGeneration(const std::map<std::filesystem::path, int>& deployed_files,
+                        const std::map<std::filesystem::path, int>& new_deployed_files) const;
   /*!
    * \brief Creates a pair of maps. One maps relative file paths to the mod id from which that
    * file is to be deployed. The other maps mod ids to their total file size on disk.
@@ -429,20 +684,62 @@ protected:
   std::pair<std::map<std::filesystem::path, int>, std::map<int, unsigned long>>
   getDeploymentSourceFilesAndModSizes(const std::vector<int>& loadorder) const;
   /*!
-   * \brief Backs up all files which would be overwritten during deployment and restores all
-   * files backed up during previous deployments files which are no longer overwritten.
+   * \brief Creates all file operations needed to deploy the given files. Files which would be
+   * overwritten are backed up, backups of files which are no longer overwritten are restored
+   * and files which are not yet correctly deployed are linked.
    * \param source_files A map of files to be deployed to their source mods.
    * \param dest_files A map of files currently deployed to their source mods.
+   * \param progress_node Used to inform about the current progress.
+   * \return The operations, ordered by type.
    */
-  void backupOrRestoreFiles(const std::map<std::filesystem::path, int>& source_files,
-                            const std::map<std::filesystem::path, int>& dest_files) const;
+  std::vector<DeployJournal::Operation> getDeploymentOperations(
+    const std::map<std::filesystem::path, int>& source_files,
+    const std::map<std::filesystem::path, int>& dest_files,
+    std::optional<ProgressNode*> progress_node = {}) const;
   /*!
-   * \brief Hard links all given files to target directory.
-   * \param source_files A map of files to be deployed to their source mods.
-   * \param progress_node Used to inform about the current progress of deployment.
-   */
-  void deployFiles(const std::map<std::filesystem::path, int>& source_files,
-                   std::optional<ProgressNode*> progress_node = {}) const;
+   * \brief Performs the given operations in batches. After every batch, the target
+   * filesystem is synced and the batch is marked as completed in the journal.
+   * \param journal Journal containing the operations.
+   * \param operations Operations to perform.
+   * \param first_batch Index of the first batch to perform. Earlier batches are skipped.
+   * \param deploy_mode Deploy mode used for link operations.
+   * \param cancelable If true: Stop after the current batch if cancellation is requested
+   * through the progress node.
+   * \param progress_node Used to inform about the current progress.
+   * \return The number of completed batches. This is only less than the number of batches
+   * if the operations have been canceled.
+   */
+  int performDeploymentOperations(DeployJournal& journal,
+                                  const std::vector<DeployJournal::Operation>& operations,
+                                  int first_batch,
+                                  DeployMode deploy_mode,
+                                  bool cancelable,
+                                  std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief Ends a deployment which has been canceled after performing the given number of
+   * operations. Files which have been backed up but not yet replaced are restored and the
+   * files which are actually deployed are written to the deployment record and recorded as
+   * a new generation. Finally, the journal is removed.
+   * \param journal Journal of the deployment.
+   * \param operations All operations of the deployment.
+   * \param num_performed Number of operations which have been performed.
+   * \param source_files Files which were to be deployed.
+   * \param dest_files All files which were deployed before the deployment.
+   */
+  void abortDeployment(DeployJournal& journal,
+                       const std::vector<DeployJournal::Operation>& operations,
+                       int num_performed,
+                       const std::map<std::filesystem::path, int>& source_files,
+                       const std::map<std::filesystem::path, int>& dest_files) const;
+  /*!
+   * \brief Performs one operation. Does nothing if the operation has already been performed.
+   * \param operation Operation to perform.
+   * \param deploy_mode Deploy mode used for link operations.
+   * \param capabilities Used to copy files in copy mode.
+   */
+  void performDeploymentOperation(const DeployJournal::Operation& operation,
+                                  DeployMode deploy_mode,
+                                  const FilesystemCapabilities& capabilities) const;
   /*!
    * \brief Creates a map of currently deployed files to their source mods.
    * \param progress_node Used to inform about the current progress.
@@ -456,9 +753,12 @@ protected:
    * \brief Creates a file containing information about currently deployed files.
    * \param deployed_files The currently deployed files.
    * \param progress_node Used to inform about the current progress.
+   * \param file_name Name of the file in the target directory. If empty: Use
+   * \ref deployed_files_name_.
    */
   void saveDeployedFiles(const std::map<std::filesystem::path, int>& deployed_files,
-                         std::optional<ProgressNode*> progress_node = {}) const;
+                         std::optional<ProgressNode*> progress_node = {},
+                         const std::string& file_name = "") const;
   /*!
    * \brief Creates a vector containing every file contained in one mod. Files are
    * represented as paths relative to the mods root directory.
@@ -487,4 +787,30 @@ protected:
    * \param directory Directory from which to remove the file.
    */
   void removeManagedDirFile(const std::filesystem::path& directory) const;
+  /*!
+   * \brief Throws if the given order is no permutation of all indices of a load order.
+   * \param order Order to check.
+   * \param size Size of the load order.
+   * \throw std::invalid_argument If the order is invalid.
+   */
+  static void checkLoadorderPermutation(const std::vector<int>& order, size_t size);
+  /*!
+   * \brief Compares the given deployed file to its source file.
+   * \param path Path to the file, relative to the target directory.
+   * \param mod_id Id of the mod from which the file was deployed.
+   * \param hash_cache Used to compute file hashes.
+   * \return The state of the file.
+   */
+  DeploymentAudit::Status getAuditStatus(const std::filesystem::path& path,
+                                         int mod_id,
+                                         FileHashCache& hash_cache) const;
+  /*!
+   * \brief Replaces \ref watcher_ with a new watcher for all directories containing the given
+   * files.
+   * \param deployed_files Currently deployed files.
+   * \param require_full_sweep If true: The next check for external changes has to check
+   * all files.
+   */
+  void startWatcher(const std::map<std::filesystem::path, int>& deployed_files,
+                    bool require_full_sweep);
 };
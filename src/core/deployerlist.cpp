@@ -0,0 +1,144 @@
+#include "deployerlist.h"
+
+
+DeployerList::Iterator::Iterator(const DeployerList* list, int index) :
+  list_(list), index_(index)
+{}
+
+std::unique_ptr<Deployer>& DeployerList::Iterator::operator*() const
+{
+  return (*list_)[index_];
+}
+
+DeployerList::Iterator& DeployerList::Iterator::operator++()
+{
+  index_++;
+  return *this;
+}
+
+DeployerList::Iterator DeployerList::Iterator::operator+(int offset) const
+{
+  return Iterator(list_, index_ + offset);
+}
+
+bool DeployerList::Iterator::operator==(const Iterator& other) const
+{
+  return list_ == other.list_ && index_ == other.index_;
+}
+
+void DeployerList::push_back(std::unique_ptr<Deployer> deployer)
+{
+  deployer->setTrackExternalChanges(track_external_changes_);
+  entries_.push_back({ std::move(deployer), {}, {} });
+}
+
+void DeployerList::pushLazy(const Properties& properties, const Loader& loader)
+{
+  entries_.push_back({ nullptr, properties, loader });
+}
+
+std::unique_ptr<Deployer>& DeployerList::operator[](int index) const
+{
+  auto& entry = entries_[index];
+  if(!entry.deployer)
+  {
+    entry.deployer = entry.loader();
+    entry.loader = {};
+    entry.deployer->setLog(log_);
+    entry.deployer->setProfile(profile_);
+    entry.deployer->setTrackExternalChanges(track_external_changes_);
+  }
+  return entry.deployer;
+}
+
+std::unique_ptr<Deployer>& DeployerList::back() const
+{
+  return (*this)[entries_.size() - 1];
+}
+
+DeployerList::Iterator DeployerList::begin() const
+{
+  return Iterator(this, 0);
+}
+
+DeployerList::Iterator DeployerList::end() const
+{
+  return Iterator(this, entries_.size());
+}
+
+void DeployerList::erase(const Iterator& position)
+{
+  entries_.erase(entries_.begin() + position.index_);
+}
+
+void DeployerList::clear()
+{
+  entries_.clear();
+}
+
+std::size_t DeployerList::size() const
+{
+  return entries_.size();
+}
+
+bool DeployerList::isLoaded(int index) const
+{
+  return entries_[index].deployer != nullptr;
+}
+
+DeployerList::Properties DeployerList::getProperties(int index) const
+{
+  const auto& entry = entries_[index];
+  if(!entry.deployer)
+    return entry.properties;
+  return { entry.deployer->getType(),
+           entry.deployer->getName(),
+           entry.deployer->sourcePath(),
+           entry.deployer->destPath(),
+           entry.deployer->getDeployMode(),
+           entry.deployer->getEnableUnsafeSorting() };
+}
+
+void DeployerList::setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log)
+{
+  log_ = new_log;
+  for(auto& entry : entries_)
+  {
+    if(entry.deployer)
+      entry.deployer->setLog(new_log);
+  }
+}
+
+void DeployerList::setProfile(int profile)
+{
+  profile_ = profile;
+  for(auto& entry : entries_)
+  {
+    if(entry.deployer)
+      entry.deployer->setProfile(profile);
+  }
+}
+
+void DeployerList::setTrackExternalChanges(bool track)
+{
+  track_external_changes_ = track;
+  for(auto& entry : entries_)
+  {
+    if(entry.deployer)
+      entry.deployer->setTrackExternalChanges(track);
+  }
+}
+
+int DeployerList::loadAll() const
+{
+  int num_loaded = 0;
+  for(int i = 0; i < entries_.size(); i++)
+  {
+    if(!isLoaded(i))
+    {
+      (*this)[i];
+      num_loaded++;
+    }
+  }
+  return num_loaded;
+}
@@ -0,0 +1,188 @@
+/*!
+ * \file deployerlist.h
+ * \brief Header for the DeployerList class.
+ */
+
+#pragma once
+
+#include "deployer.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+/*!
+ * \brief Container for deployers, which can construct deployers on first access.
+ *
+ * Constructing some deployers requires reading and updating plugin files in their target
+ * directory. Such deployers can be added with a loader function, which is only called once
+ * the deployer is first accessed or \ref loadAll is called. Basic properties needed to save
+ * the deployers settings are available without loading it.
+ */
+class DeployerList
+{
+public:
+  /*! \brief Function used to construct a deployer. */
+  using Loader = std::function<std::unique_ptr<Deployer>()>;
+
+  /*! \brief Properties of a deployer which are available without loading it. */
+  struct Properties
+  {
+    /*! \brief Type of the deployer. */
+    std::string type;
+    /*! \brief Name of the deployer. */
+    std::string name;
+    /*! \brief Source path of the deployer. */
+    std::filesystem::path source_path;
+    /*! \brief Target path of the deployer. */
+    std::filesystem::path dest_path;
+    /*! \brief Deploy mode of the deployer. */
+    Deployer::DeployMode deploy_mode;
+    /*! \brief Whether unsafe sorting is enabled. */
+    bool enable_unsafe_sorting;
+  };
+
+  /*! \brief Iterates over all deployers, loading each one when it is dereferenced. */
+  class Iterator
+  {
+  public:
+    /*!
+     * \brief Constructor.
+     * \param list List to iterate over.
+     * \param index Index of the current deployer.
+     */
+    Iterator(const DeployerList* list, int index);
+
+    /*!
+     * \brief Loads and returns the current deployer.
+     * \return The deployer.
+     */
+    std::unique_ptr<Deployer>& operator*() const;
+    /*!
+     * \brief Advances to the next deployer.
+     * \return This iterator.
+     */
+    Iterator& operator++();
+    /*!
+     * \brief Returns an iterator advanced by the given offset.
+     * \param offset The offset.
+     * \return The new iterator.
+     */
+    Iterator operator+(int offset) const;
+    /*!
+     * \brief Compares this iterator to another iterator.
+     * \param other Other iterator.
+     * \return True if both iterators point to the same deployer.
+     */
+    bool operator==(const Iterator& other) const;
+
+  private:
+    /*! \brief List to iterate over. */
+    const DeployerList* list_;
+    /*! \brief Index of the current deployer. */
+    int index_;
+
+    friend class DeployerList;
+  };
+
+  /*!
+   * \brief Appends an already constructed deployer.
+   * \param deployer The deployer.
+   */
+  void push_back(std::unique_ptr<Deployer> deployer);
+  /*!
+   * \brief Appends a deployer which will be constructed on first access.
+   * \param properties Properties of the deployer.
+   * \param loader Function used to construct the deployer.
+   */
+  void pushLazy(const Properties& properties, const Loader& loader);
+  /*!
+   * \brief Returns the deployer at the given index. Loads it, if needed.
+   * \param index Index of the deployer.
+   * \return The deployer.
+   */
+  std::unique_ptr<Deployer>& operator[](int index) const;
+  /*!
+   * \brief Returns the last deployer. Loads it, if needed.
+   * \return The deployer.
+   */
+  std::unique_ptr<Deployer>& back() const;
+  /*!
+   * \brief Returns an iterator to the first deployer.
+   * \return The iterator.
+   */
+  Iterator begin() const;
+  /*!
+   * \brief Returns an iterator past the last deployer.
+   * \return The iterator.
+   */
+  Iterator end() const;
+  /*!
+   * \brief Removes the deployer at the given position.
+   * \param position Position of the deployer.
+   */
+  void erase(const Iterator& position);
+  /*! \brief Removes all deployers. */
+  void clear();
+  /*!
+   * \brief Returns the number of deployers.
+   * \return The number.
+   */
+  std::size_t size() const;
+  /*!
+   * \brief Checks if the deployer at the given index has been constructed.
+   * \param index Index of the deployer.
+   * \return True if the deployer is loaded.
+   */
+  bool isLoaded(int index) const;
+  /*!
+   * \brief Returns the properties of the deployer at the given index without loading it.
+   * \param index Index of the deployer.
+   * \return The properties.
+   */
+  Properties getProperties(int index) const;
+  /*!
+   * \brief Sets the log callback for all loaded deployers and all deployers loaded later.
+   * \param new_log The new log callback.
+   */
+  void setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log);
+  /*!
+   * \brief Sets the active profile for all loaded deployers. Deployers loaded later are
+   * set to this profile after construction.
+   * \param profile The new profile.
+   */
+  void setProfile(int profile);
+  /*!
+   * \brief Enables or disables tracking of external changes for all loaded deployers and all
+   * deployers loaded later.
+   * \param track If true: Track changes.
+   */
+  void setTrackExternalChanges(bool track);
+  /*!
+   * \brief Constructs all deployers which have not been loaded yet.
+   * \return The number of newly loaded deployers.
+   */
+  int loadAll() const;
+
+private:
+  /*! \brief A deployer and, if it has not been constructed yet, the data needed to do so. */
+  struct Entry
+  {
+    /*! \brief The deployer. Empty if it has not been loaded yet. */
+    std::unique_ptr<Deployer> deployer;
+    /*! \brief Properties used while the deployer has not been loaded. */
+    Properties properties;
+    /*! \brief Function used to construct the deployer. */
+    Loader loader;
+  };
+
+  /*! \brief Contains all deployers. Mutable, since loading does not change the list logically. */
+  mutable std::vector<Entry> entries_;
+  /*! \brief Log callback passed to newly loaded deployers. */
+  std::function<void(Log::LogLevel, const std::string&)> log_ = [](Log::LogLevel a,
+                                                                   const std::string& b) {};
+  /*! \brief Profile set for newly loaded deployers. */
+  int profile_ = 0;
+  /*! \brief Whether newly loaded deployers track external changes. */
+  bool track_external_changes_ = false;
+};
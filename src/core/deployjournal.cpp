@@ -0,0 +1,196 @@
+#include "deployjournal.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace sfs = std::filesystem;
+
+
+DeployJournal::DeployJournal(const sfs::path& path) : path_(path) {}
+
+DeployJournal::~DeployJournal()
+{
+  close();
+}
+
+void DeployJournal::begin(int deploy_mode, const std::vector<Operation>& operations)
+{
+  close();
+  fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+  if(fd_ < 0)
+    throw std::runtime_error(
+      std::format("Could not create \"{}\": {}", path_.string(), std::strerror(errno)));
+  std::string text = std::format("{} {}\n", HEADER, deploy_mode);
+  for(const auto& operation : operations)
+    text += std::format("{} {} {} {}\n",
+                        static_cast<int>(operation.type),
+                        operation.mod_id,
+                        operation.has_backup ? 1 : 0,
+                        escapePath(operation.path));
+  append(text);
+  // the operations must be on disk before the commit marker is
+  append(std::format("{}\n", COMMIT));
+}
+
+void DeployJournal::resume()
+{
+  close();
+  fd_ = open(path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  if(fd_ < 0)
+    throw std::runtime_error(
+      std::format("Could not open \"{}\": {}", path_.string(), std::strerror(errno)));
+}
+
+void DeployJournal::completeBatch(int batch)
+{
+  append(std::format("{} {}\n", DONE, batch));
+}
+
+std::optional<DeployJournal::State> DeployJournal::load() const
+{
+  if(!sfs::exists(path_))
+    return {};
+  std::ifstream file(path_, std::fstream::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Could not read \"{}\"", path_.string()));
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string content = buffer.str();
+  // a line without a trailing newline has been interrupted while writing
+  content.erase(content.rfind('\n') == std::string::npos ? 0 : content.rfind('\n') + 1);
+
+  State state;
+  std::istringstream lines(content);
+  std::string line;
+  if(!std::getline(lines, line) || !line.starts_with(HEADER))
+    return state;
+  state.deploy_mode = std::stoi(line.substr(std::strlen(HEADER)));
+  while(std::getline(lines, line))
+  {
+    if(line == COMMIT)
+    {
+      state.is_complete = true;
+      continue;
+    }
+    if(state.is_complete)
+    {
+      if(!line.starts_with(DONE))
+        throw std::runtime_error(std::format("Invalid line in \"{}\": {}", path_.string(), line));
+      state.completed_batches = std::stoi(line.substr(std::strlen(DONE))) + 1;
+      continue;
+    }
+    std::istringstream fields(line);
+    int type;
+    int has_backup;
+    Operation operation;
+    if(!(fields >> type >> operation.mod_id >> has_backup) || type < restore || type > link ||
+       fields.get() != ' ')
+      throw std::runtime_error(std::format("Invalid line in \"{}\": {}", path_.string(), line));
+    operation.type = static_cast<OperationType>(type);
+    operation.has_backup = has_backup != 0;
+    std::string path;
+    std::getline(fields, path);
+    operation.path = unescapePath(path);
+    state.operations.push_back(operation);
+  }
+  return state;
+}
+
+void DeployJournal::remove()
+{
+  close();
+  sfs::remove(path_);
+}
+
+std::vector<std::pair<int, int>> DeployJournal::getBatches(const std::vector<Operation>& operations)
+{
+  auto get_phase = [](OperationType type)
+  { return type == restore || type == remove_directory ? 0 : type == backup ? 1 : 2; };
+  std::vector<std::pair<int, int>> batches;
+  for(int i = 0; i < operations.size(); i++)
+  {
+    if(batches.empty() || batches.back().second - batches.back().first == BATCH_SIZE ||
+       get_phase(operations[i].type) != get_phase(operations[i - 1].type))
+      batches.emplace_back(i, i);
+    batches.back().second++;
+  }
+  return batches;
+}
+
+void DeployJournal::syncFile(const sfs::path& path)
+{
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return;
+  fsync(fd);
+  ::close(fd);
+}
+
+void DeployJournal::syncFilesystem(const sfs::path& path)
+{
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    return;
+  syncfs(fd);
+  ::close(fd);
+}
+
+void DeployJournal::append(const std::string& text)
+{
+  if(fd_ < 0)
+    throw std::runtime_error(std::format("Journal \"{}\" is not open", path_.string()));
+  for(long written = 0; written < text.size();)
+  {
+    const long result = write(fd_, text.data() + written, text.size() - written);
+    if(result < 0 && errno != EINTR)
+      throw std::runtime_error(
+        std::format("Could not write \"{}\": {}", path_.string(), std::strerror(errno)));
+    if(result > 0)
+      written += result;
+  }
+  if(fsync(fd_) != 0)
+    throw std::runtime_error(
+      std::format("Could not sync \"{}\": {}", path_.string(), std::strerror(errno)));
+}
+
+void DeployJournal::close()
+{
+  if(fd_ >= 0)
+    ::close(fd_);
+  fd_ = -1;
+}
+
+std::string DeployJournal::escapePath(const sfs::path& path)
+{
+  std::string escaped;
+  for(char c : path.string())
+  {
+    if(c == '\\')
+      escaped += "\\\\";
+    else if(c == '\n')
+      escaped += "\\n";
+    else
+      escaped += c;
+  }
+  return escaped;
+}
+
+sfs::path DeployJournal::unescapePath(const std::string& escaped)
+{
+  std::string path;
+  for(int i = 0; i < escaped.size(); i++)
+  {
+    if(escaped[i] == '\\' && i + 1 < escaped.size())
+    {
+      i++;
+      path += escaped[i] == 'n' ? '\n' : escaped[i];
+    }
+    else
+      path += escaped[i];
+  }
+  return path;
+}
@@ -0,0 +1,158 @@
+/*!
+ * \file deployjournal.h
+ * \brief Header for the DeployJournal class.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Append-only journal of the file operations performed during a deployment.
+ *
+ * All operations are written and synced before any of them is performed. Operations are then
+ * performed in batches of at most \ref BATCH_SIZE, after each batch the target filesystem is
+ * synced and the batch is marked as completed. Restores, backups and links are never part of
+ * the same batch, so an interrupted deployment can be completed by performing every operation
+ * of all uncompleted batches again.
+ */
+class DeployJournal
+{
+public:
+  /*! \brief Type of a file operation. */
+  enum OperationType
+  {
+    /*! \brief Removes a deployed file and restores its backup, if one exists. */
+    restore = 0,
+    /*! \brief Removes a directory if it is empty. */
+    remove_directory = 1,
+    /*! \brief Renames a file which is to be overwritten to its backup name. */
+    backup = 2,
+    /*! \brief Deploys a file from a mod. */
+    link = 3
+  };
+
+  /*! \brief A single file operation. */
+  struct Operation
+  {
+    /*! \brief Type of the operation. */
+    OperationType type;
+    /*! \brief Target path, relative to the deployers target directory. */
+    std::filesystem::path path;
+    /*! \brief For link operations: Mod from which to deploy the file. */
+    int mod_id = -1;
+    /*! \brief For restore operations: Whether a backup existed before deployment. */
+    bool has_backup = false;
+  };
+
+  /*! \brief Contents of a journal. */
+  struct State
+  {
+    /*! \brief Deploy mode used during deployment. */
+    int deploy_mode = 0;
+    /*! \brief All operations. */
+    std::vector<Operation> operations;
+    /*! \brief Number of batches which have been completed. */
+    int completed_batches = 0;
+    /*!
+     * \brief True if all operations have been written. If this is false, no operation has
+     * been performed yet.
+     */
+    bool is_complete = false;
+  };
+
+  /*! \brief Number of operations performed between two syncs. */
+  static constexpr int BATCH_SIZE = 1024;
+
+  /*!
+   * \brief Constructor. Does not access the journal file.
+   * \param path Path to the journal file.
+   */
+  DeployJournal(const std::filesystem::path& path);
+  /*! \brief Closes the journal file, if it is open. */
+  ~DeployJournal();
+  DeployJournal(const DeployJournal&) = delete;
+  DeployJournal& operator=(const DeployJournal&) = delete;
+
+  /*!
+   * \brief Creates a new journal containing the given operations and syncs it to disk.
+   * \param deploy_mode Deploy mode used during deployment.
+   * \param operations Operations to be performed.
+   * \throws std::runtime_error If the journal can not be written.
+   */
+  void begin(int deploy_mode, const std::vector<Operation>& operations);
+  /*!
+   * \brief Opens an existing journal for appending.
+   * \throws std::runtime_error If the journal can not be opened.
+   */
+  void resume();
+  /*!
+   * \brief Marks the given batch as completed and syncs the journal.
+   * \param batch Index of the batch.
+   */
+  void completeBatch(int batch);
+  /*!
+   * \brief Reads the journal file. Incompletely written lines are ignored.
+   * \return The journal contents or an empty optional, if no journal exists.
+   * \throws std::runtime_error If the journal is invalid.
+   */
+  std::optional<State> load() const;
+  /*! \brief Closes and deletes the journal file. */
+  void remove();
+  /*!
+   * \brief Splits the given operations into batches. A new batch is started after
+   * \ref BATCH_SIZE operations and whenever the operation type changes from restoring to
+   * backing up files or from backing up to linking files.
+   * \param operations Operations, ordered by type.
+   * \return For every batch: The index of its first operation and the index past its last.
+   */
+  static std::vector<std::pair<int, int>> getBatches(const std::vector<Operation>& operations);
+  /*!
+   * \brief Flushes all buffered data of the given file to disk.
+   * \param path File to sync.
+   */
+  static void syncFile(const std::filesystem::path& path);
+  /*!
+   * \brief Flushes all buffered data of the filesystem containing the given path to disk.
+   * \param path A path on the target filesystem.
+   */
+  static void syncFilesystem(const std::filesystem::path& path);
+
+private:
+  /*! \brief First line of every journal. */
+  static constexpr char HEADER[] = "lmm_deploy_journal 1";
+  /*! \brief Marks the end of the operation list. */
+  static constexpr char COMMIT[] = "commit";
+  /*! \brief Marks a batch as completed. */
+  static constexpr char DONE[] = "done";
+
+  /*! \brief Path to the journal file. */
+  std::filesystem::path path_;
+  /*! \brief Descriptor of the open journal file. */
+  int fd_ = -1;
+
+  /*!
+   * \brief Writes the given text to the end of the journal and syncs it.
+   * \param text Text to write.
+   */
+  void append(const std::string& text);
+  /*! \brief Closes the journal file. */
+  void close();
+  /*!
+   * \brief Escapes backslashes and newlines in the given path, so it fits in a single line.
+   * \param path Path to escape.
+   * \return The escaped path.
+   */
+  static std::string escapePath(const std::filesystem::path& path);
+  /*!
+   * \brief Reverts the escaping done by \ref escapePath.
+   * \param escaped The escaped path.
+   * \return The original path.
+   */
+  static std::filesystem::path unescapePath(const std::string& escaped);
+};
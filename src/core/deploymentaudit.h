@@ -0,0 +1,51 @@
+/*!
+ * \file deploymentaudit.h
+ * \brief Contains the DeploymentAudit struct.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+/*!
+ * \brief Contains the result of comparing the files deployed by one deployer to
+ * their source files.
+ */
+struct DeploymentAudit
+{
+  /*! \brief Describes the state of a deployed file. */
+  enum Status
+  {
+    /*! \brief The deployed file matches its source. */
+    identical = 0,
+    /*! \brief The content of the deployed file differs from its source. */
+    modified = 1,
+    /*! \brief The deployed file no longer exists. */
+    missing = 2,
+    /*! \brief The source of the deployed file no longer exists. */
+    orphaned = 3
+  };
+
+  /*! \brief State of one deployed file. */
+  struct Entry
+  {
+    /*! \brief Path to the file, relative to the deployer's target directory. */
+    std::filesystem::path path;
+    /*! \brief Id of the mod from which the file was deployed. */
+    int mod_id;
+    /*! \brief State of the file. */
+    Status status;
+  };
+
+  /*! \brief Contains every file in the deployment record which is not identical to its source. */
+  std::vector<Entry> entries;
+  /*! \brief Number of files which are identical to their source. */
+  int num_identical = 0;
+  /*! \brief Name of the deployer. */
+  std::string deployer_name;
+  /*! \brief Id of the deployer. */
+  int deployer_id = -1;
+};
@@ -0,0 +1,31 @@
+/*!
+ * \file deploymentgeneration.h
+ * \brief Contains the DeploymentGeneration struct.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+
+/*!
+ * \brief Describes the state of a deployers target directory after one successful deployment.
+ * Generations are numbered consecutively and can be used to roll back to earlier deployments.
+ */
+struct DeploymentGeneration
+{
+  /*! \brief Id of the generation. Newer generations have larger ids. */
+  int id = -1;
+  /*! \brief Time of the deployment in seconds since epoch. */
+  int64_t timestamp = 0;
+  /*! \brief Profile which was active during the deployment. */
+  int profile = 0;
+  /*! \brief Load order of that profile at the time of the deployment. */
+  std::vector<std::tuple<int, bool>> loadorder;
+  /*! \brief Number of deployed files and directories after the deployment. */
+  int num_files = 0;
+  /*! \brief Number of paths changed compared to the previous deployment. */
+  int num_changes = 0;
+};
@@ -0,0 +1,167 @@
+#include "deploymenthistory.h"
+#include "pathutils.h"
+#include <format>
+#include <fstream>
+
+namespace sfs = std::filesystem;
+namespace pu = path_utils;
+
+
+DeploymentHistory::DeploymentHistory(const sfs::path& history_path) : history_path_(history_path)
+{}
+
+int DeploymentHistory::addGeneration(DeploymentGeneration generation,
+                                     const std::map<sfs::path, std::tuple<int, int>>& changes,
+                                     int max_generations)
+{
+  sfs::create_directories(history_path_);
+  Json::Value index = readIndex();
+  generation.id = index["next_id"].asInt();
+  generation.num_changes = changes.size();
+
+  Json::Value changes_json;
+  changes_json["changes"] = Json::arrayValue;
+  for(const auto& [path, mod_ids] : changes)
+  {
+    Json::Value entry;
+    entry["path"] = path.string();
+    entry["old"] = std::get<0>(mod_ids);
+    entry["new"] = std::get<1>(mod_ids);
+    changes_json["changes"].append(entry);
+  }
+  writeJson(getChangesFileName(generation.id), changes_json);
+
+  Json::Value entry;
+  entry["id"] = generation.id;
+  entry["timestamp"] = static_cast<Json::Int64>(generation.timestamp);
+  entry["profile"] = generation.profile;
+  entry["num_files"] = generation.num_files;
+  entry["num_changes"] = generation.num_changes;
+  entry["loadorder"] = Json::arrayValue;
+  for(const auto& [mod_id, enabled] : generation.loadorder)
+  {
+    Json::Value mod;
+    mod["id"] = mod_id;
+    mod["enabled"] = enabled;
+    entry["loadorder"].append(mod);
+  }
+  index["generations"].append(entry);
+  index["next_id"] = generation.id + 1;
+  pruneIndex(index, max_generations);
+  writeJson(INDEX_FILE_NAME, index);
+  return generation.id;
+}
+
+std::vector<DeploymentGeneration> DeploymentHistory::getGenerations() const
+{
+  std::vector<DeploymentGeneration> generations;
+  const Json::Value index = readIndex();
+  for(const auto& entry : index["generations"])
+  {
+    DeploymentGeneration generation;
+    generation.id = entry["id"].asInt();
+    generation.timestamp = entry["timestamp"].asInt64();
+    generation.profile = entry["profile"].asInt();
+    generation.num_files = entry["num_files"].asInt();
+    generation.num_changes = entry["num_changes"].asInt();
+    for(const auto& mod : entry["loadorder"])
+      generation.loadorder.emplace_back(mod["id"].asInt(), mod["enabled"].asBool());
+    generations.push_back(std::move(generation));
+  }
+  return generations;
+}
+
+std::map<sfs::path, int> DeploymentHistory::getChangesSince(int id) const
+{
+  const Json::Value index = readIndex();
+  const auto& generations = index["generations"];
+  int target_index = -1;
+  for(int i = 0; i < generations.size(); i++)
+  {
+    if(generations[i]["id"].asInt() == id)
+      target_index = i;
+  }
+  if(target_index == -1)
+    throw std::runtime_error(std::format("Deployment generation {} does not exist.", id));
+
+  // undo the changes of newer generations, newest first, so the oldest change of a path wins
+  std::map<sfs::path, int> changes;
+  for(int i = generations.size() - 1; i > target_index; i--)
+  {
+    const int generation_id = generations[i]["id"].asInt();
+    const sfs::path changes_path = history_path_ / getChangesFileName(generation_id);
+    std::ifstream file(changes_path, std::fstream::binary);
+    if(!file.is_open())
+      throw std::runtime_error(std::format("Could not read \"{}\".", changes_path.string()));
+    Json::Value changes_json;
+    file >> changes_json;
+    for(const auto& change : changes_json["changes"])
+      changes[change["path"].asString()] = change["old"].asInt();
+  }
+  return changes;
+}
+
+void DeploymentHistory::prune(int max_generations)
+{
+  Json::Value index = readIndex();
+  if(pruneIndex(index, max_generations))
+    writeJson(INDEX_FILE_NAME, index);
+}
+
+void DeploymentHistory::clear()
+{
+  if(pu::exists(history_path_))
+    sfs::remove_all(history_path_);
+}
+
+Json::Value DeploymentHistory::readIndex() const
+{
+  Json::Value index;
+  const sfs::path index_path = history_path_ / INDEX_FILE_NAME;
+  if(pu::exists(index_path))
+  {
+    std::ifstream file(index_path, std::fstream::binary);
+    if(!file.is_open())
+      throw std::runtime_error(std::format("Could not read \"{}\".", index_path.string()));
+    file >> index;
+  }
+  if(!index.isMember("next_id"))
+    index["next_id"] = 0;
+  if(!index.isMember("generations"))
+    index["generations"] = Json::arrayValue;
+  return index;
+}
+
+void DeploymentHistory::writeJson(const std::string& file_name, const Json::Value& value) const
+{
+  const sfs::path path = history_path_ / file_name;
+  const sfs::path tmp_path = path.string() + ".tmp";
+  std::ofstream file(tmp_path, std::fstream::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Could not write to \"{}\".", tmp_path.string()));
+  file << value;
+  file.close();
+  sfs::rename(tmp_path, path);
+}
+
+std::string DeploymentHistory::getChangesFileName(int id)
+{
+  return std::format("{}.json", id);
+}
+
+bool DeploymentHistory::pruneIndex(Json::Value& index, int max_generations) const
+{
+  const int num_removed = static_cast<int>(index["generations"].size()) - max_generations;
+  if(num_removed <= 0)
+    return false;
+  Json::Value generations = Json::arrayValue;
+  for(int i = 0; i < index["generations"].size(); i++)
+  {
+    if(i < num_removed)
+      sfs::remove(history_path_ / getChangesFileName(index["generations"][i]["id"].asInt()));
+    else
+      generations.append(index["generations"][i]);
+  }
+  index["generations"] = generations;
+  return true;
+}
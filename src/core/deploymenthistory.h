@@ -0,0 +1,101 @@
+/*!
+ * \file deploymenthistory.h
+ * \brief Header for the DeploymentHistory class.
+ */
+
+#pragma once
+
+#include "deploymentgeneration.h"
+#include <filesystem>
+#include <json/json.h>
+#include <map>
+#include <tuple>
+#include <vector>
+
+
+/*!
+ * \brief Stores one DeploymentGeneration per successful deployment of a deployer.
+ *
+ * Instead of storing every deployed file, every generation only stores the paths which have
+ * changed compared to the previous generation, together with their source mods before and
+ * after the deployment. The state of any retained generation can then be restored by undoing
+ * the changes of all newer generations, which only touches changed paths.
+ */
+class DeploymentHistory
+{
+public:
+  /*!
+   * \brief Constructor. Nothing is read or written until a generation is accessed.
+   * \param history_path Directory in which all generations are stored.
+   */
+  DeploymentHistory(const std::filesystem::path& history_path);
+
+  /*!
+   * \brief Stores a new generation. If more than the given number of generations exist
+   * afterwards, the oldest generations are removed.
+   * \param generation Describes the new generation. Its id and number of changes are set by
+   * this function.
+   * \param changes Maps every changed path to the ids of its source mod before and after
+   * the deployment. -1 indicates that the path was not deployed.
+   * \param max_generations Maximum number of generations to retain.
+   * \return The id of the new generation.
+   * \throws std::runtime_error If the generation could not be written.
+   */
+  int addGeneration(DeploymentGeneration generation,
+                    const std::map<std::filesystem::path, std::tuple<int, int>>& changes,
+                    int max_generations);
+  /*!
+   * \brief Returns all retained generations, sorted from oldest to newest.
+   * \return The generations.
+   */
+  std::vector<DeploymentGeneration> getGenerations() const;
+  /*!
+   * \brief Determines which paths have to change to return from the newest generation to
+   * the given generation.
+   * \param id Id of the target generation.
+   * \return Maps every path changed since the target generation to its source mod in
+   * that generation or to -1 if the path was not deployed.
+   * \throws std::runtime_error If no generation with the given id exists.
+   */
+  std::map<std::filesystem::path, int> getChangesSince(int id) const;
+  /*!
+   * \brief Removes the oldest generations until at most the given number remain.
+   * \param max_generations Maximum number of generations to retain.
+   */
+  void prune(int max_generations);
+  /*! \brief Removes all generations. */
+  void clear();
+
+private:
+  /*! \brief Name of the file containing the descriptions of all generations. */
+  static inline const std::string INDEX_FILE_NAME = "index.json";
+
+  /*! \brief Directory in which all generations are stored. */
+  std::filesystem::path history_path_;
+
+  /*!
+   * \brief Reads the index file.
+   * \return The index or an empty index if the file does not exist.
+   */
+  Json::Value readIndex() const;
+  /*!
+   * \brief Atomically writes the given value to the given file in \ref history_path_.
+   * \param file_name Name of the target file.
+   * \param value Value to write.
+   */
+  void writeJson(const std::string& file_name, const Json::Value& value) const;
+  /*!
+   * \brief Returns the name of the file containing the changes of the given generation.
+   * \param id Id of the generation.
+   * \return The file name.
+   */
+  static std::string getChangesFileName(int id);
+  /*!
+   * \brief Removes the oldest entries from the given index until at most the given number
+   * remain and deletes their changes.
+   * \param index The index.
+   * \param max_generations Maximum number of generations to retain.
+   * \return True if any entry has been removed.
+   */
+  bool pruneIndex(Json::Value& index, int max_generations) const;
+};
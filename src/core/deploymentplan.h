@@ -0,0 +1,66 @@
+/*!
+ * \file deploymentplan.h
+ * \brief Contains the DeploymentPlan struct.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Describes the changes a deployer would make to its target directory when
+ * deploying, without actually making them.
+ */
+struct DeploymentPlan
+{
+  /*! \brief Id of the deployer. */
+  int deployer_id = -1;
+  /*! \brief Name of the deployer. */
+  std::string deployer_name;
+  /*!
+   * \brief False if the deployer manages its own files and can not create a plan. In this
+   * case all counts are zero.
+   */
+  bool is_supported = true;
+  /*! \brief Number of files which will be deployed to paths not used by the deployer. */
+  int num_files_created = 0;
+  /*! \brief Number of previously deployed files which will be deployed again. */
+  int num_files_replaced = 0;
+  /*! \brief Number of deployed files which will be removed without being replaced. */
+  int num_files_removed = 0;
+  /*! \brief Number of files not managed by the deployer which will be backed up. */
+  int num_backups_created = 0;
+  /*! \brief Number of backed up files which will be restored. */
+  int num_backups_restored = 0;
+  /*! \brief Number of empty directories which will be removed. */
+  int num_directories_removed = 0;
+  /*! \brief Total size of all files which will be copied. Only used in copy deploy mode. */
+  uint64_t bytes_to_copy = 0;
+  /*! \brief Estimated duration of the deployment, based on previously measured costs. */
+  double estimated_seconds = 0;
+  /*!
+   * \brief Absolute paths of all files deployed after the planned deployment. Used to find
+   * overlapping deployers.
+   */
+  std::vector<std::filesystem::path> target_files;
+  /*!
+   * \brief Contains the ids of all other planned deployers which deploy to at least one of
+   * the same files and the number of these files.
+   */
+  std::vector<std::pair<int, int>> overlapping_deployers;
+
+  /*!
+   * \brief Returns the total number of file operations in this plan.
+   * \return The number of operations.
+   */
+  int getNumOperations() const
+  {
+    return num_files_created + num_files_replaced + num_files_removed + num_backups_created +
+           num_backups_restored + num_directories_removed;
+  }
+};
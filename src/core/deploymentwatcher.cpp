@@ -0,0 +1,149 @@
+#include "deploymentwatcher.h"
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace sfs = std::filesystem;
+
+
+DeploymentWatcher::DeploymentWatcher(const sfs::path& target_dir,
+                                     const std::set<sfs::path>& directories,
+                                     bool require_full_sweep) :
+  full_sweep_required_(require_full_sweep)
+{
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(inotify_fd_ < 0 || stop_fd_ < 0)
+  {
+    const std::string error = std::strerror(errno);
+    closeDescriptors();
+    throw std::runtime_error(std::format("Failed to initialize inotify: {}", error));
+  }
+
+  constexpr uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY |
+                            IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+  std::set<sfs::path> all_directories = directories;
+  all_directories.insert("");
+  for(const auto& dir : all_directories)
+  {
+    const sfs::path path = dir.empty() ? target_dir : target_dir / dir;
+    const int wd = inotify_add_watch(inotify_fd_, path.c_str(), mask);
+    if(wd < 0)
+    {
+      const std::string error = std::strerror(errno);
+      closeDescriptors();
+      throw std::runtime_error(
+        std::format("Failed to watch directory '{}': {}", path.string(), error));
+    }
+    watched_dirs_[wd] = dir;
+  }
+  thread_ = std::jthread([this](std::stop_token stop_token) { watch(stop_token); });
+}
+
+DeploymentWatcher::~DeploymentWatcher()
+{
+  thread_.request_stop();
+  const uint64_t value = 1;
+  [[maybe_unused]] const long written = write(stop_fd_, &value, sizeof(value));
+  if(thread_.joinable())
+    thread_.join();
+  closeDescriptors();
+}
+
+std::optional<std::set<sfs::path>> DeploymentWatcher::takeModifiedPaths()
+{
+  std::lock_guard lock(mutex_);
+  if(full_sweep_required_ || watch_failed_)
+  {
+    full_sweep_required_ = false;
+    modified_paths_.clear();
+    return {};
+  }
+  return modified_paths_;
+}
+
+void DeploymentWatcher::addModifiedPaths(const std::vector<sfs::path>& paths)
+{
+  std::lock_guard lock(mutex_);
+  modified_paths_.insert(paths.begin(), paths.end());
+}
+
+void DeploymentWatcher::watch(std::stop_token stop_token)
+{
+  alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+  pollfd fds[2] = { { inotify_fd_, POLLIN, 0 }, { stop_fd_, POLLIN, 0 } };
+  while(!stop_token.stop_requested())
+  {
+    if(poll(fds, 2, -1) < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      setWatchFailed();
+      return;
+    }
+    if(fds[1].revents != 0)
+      return;
+    if(fds[0].revents & (POLLERR | POLLNVAL))
+    {
+      setWatchFailed();
+      return;
+    }
+    const long size = read(inotify_fd_, buffer, EVENT_BUFFER_SIZE);
+    if(size < 0)
+    {
+      if(errno == EAGAIN || errno == EINTR)
+        continue;
+      setWatchFailed();
+      return;
+    }
+    processEvents(buffer, size);
+  }
+}
+
+void DeploymentWatcher::processEvents(const char* buffer, long size)
+{
+  std::lock_guard lock(mutex_);
+  for(long pos = 0; pos < size;)
+  {
+    const auto* event = reinterpret_cast<const inotify_event*>(buffer + pos);
+    pos += sizeof(inotify_event) + event->len;
+    if(event->mask & IN_Q_OVERFLOW)
+    {
+      full_sweep_required_ = true;
+      continue;
+    }
+    auto iter = watched_dirs_.find(event->wd);
+    if(iter == watched_dirs_.end())
+      continue;
+    if(event->mask & IN_IGNORED)
+    {
+      // the directory itself has already been recorded by IN_DELETE_SELF or IN_MOVE_SELF
+      watched_dirs_.erase(iter);
+      continue;
+    }
+    if(event->len > 0)
+      modified_paths_.insert(iter->second / event->name);
+    else
+      modified_paths_.insert(iter->second);
+  }
+}
+
+void DeploymentWatcher::setWatchFailed()
+{
+  std::lock_guard lock(mutex_);
+  watch_failed_ = true;
+}
+
+void DeploymentWatcher::closeDescriptors()
+{
+  if(inotify_fd_ >= 0)
+    close(inotify_fd_);
+  if(stop_fd_ >= 0)
+    close(stop_fd_);
+  inotify_fd_ = -1;
+  stop_fd_ = -1;
+}
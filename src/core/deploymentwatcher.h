@@ -0,0 +1,104 @@
+/*!
+ * \file deploymentwatcher.h
+ * \brief Header for the DeploymentWatcher class.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+
+/*!
+ * \brief Uses inotify to record which paths in a target directory have been changed while
+ * the watcher is running. Only directories containing deployed files are watched.
+ *
+ * Creation, deletion and renaming of directory entries are recorded, as well as writes to
+ * files, since these change the content of copied files. If the kernels event queue
+ * overflows, all paths have to be considered changed. If reading events fails, the watcher
+ * stops recording changes and every later call to \ref takeModifiedPaths requires a full check.
+ */
+class DeploymentWatcher
+{
+public:
+  /*!
+   * \brief Starts watching the given directories.
+   * \param target_dir Root directory to watch. Recorded paths are relative to this.
+   * \param directories Directories to watch, relative to target_dir. The root directory is
+   * always watched.
+   * \param require_full_sweep If true: The first call to \ref takeModifiedPaths indicates
+   * that all paths need to be checked. Set this to false if the current state of the target
+   * directory is known to be valid.
+   * \throws std::runtime_error If inotify can not be initialized or a directory can not
+   * be watched.
+   */
+  DeploymentWatcher(const std::filesystem::path& target_dir,
+                    const std::set<std::filesystem::path>& directories,
+                    bool require_full_sweep = true);
+  /*! \brief Stops watching and closes all inotify descriptors. */
+  ~DeploymentWatcher();
+  DeploymentWatcher(const DeploymentWatcher&) = delete;
+  DeploymentWatcher& operator=(const DeploymentWatcher&) = delete;
+
+  /*!
+   * \brief Returns all paths changed since the watcher was started.
+   *
+   * If the returned optional is empty, changes may have been missed and the caller has to
+   * check all paths. In that case the set of changed paths is reset, so the caller should pass
+   * every changed path found during the check to \ref addModifiedPaths. Once the watcher
+   * has failed, the returned optional is always empty.
+   * \return The changed paths, relative to the target directory. A changed directory implies
+   * that all of its contents may have changed.
+   */
+  std::optional<std::set<std::filesystem::path>> takeModifiedPaths();
+  /*!
+   * \brief Marks the given paths as changed.
+   * \param paths Paths relative to the target directory.
+   */
+  void addModifiedPaths(const std::vector<std::filesystem::path>& paths);
+
+private:
+  /*! \brief Size of the buffer used to read inotify events. */
+  static constexpr int EVENT_BUFFER_SIZE = 64 * 1024;
+
+  /*! \brief Descriptor returned by inotify_init1. */
+  int inotify_fd_ = -1;
+  /*! \brief Eventfd used to wake up the watcher thread when stopping. */
+  int stop_fd_ = -1;
+  /*! \brief Maps inotify watch descriptors to their directory, relative to the target. */
+  std::map<int, std::filesystem::path> watched_dirs_;
+  /*! \brief Paths which have been changed. */
+  std::set<std::filesystem::path> modified_paths_;
+  /*! \brief If true: Events may have been lost, so all paths need to be checked. */
+  bool full_sweep_required_;
+  /*! \brief If true: The watcher thread has stopped due to an error, so no changes are recorded. */
+  bool watch_failed_ = false;
+  /*!
+   * \brief Synchronizes access to \ref modified_paths_, \ref full_sweep_required_ and
+   * \ref watch_failed_.
+   */
+  std::mutex mutex_;
+  /*! \brief Reads inotify events. */
+  std::jthread thread_;
+
+  /*!
+   * \brief Reads events until stop is requested.
+   * \param stop_token Used to stop the thread.
+   */
+  void watch(std::stop_token stop_token);
+  /*!
+   * \brief Records all events in the given buffer.
+   * \param buffer Buffer containing events read from \ref inotify_fd_.
+   * \param size Number of bytes in the buffer.
+   */
+  void processEvents(const char* buffer, long size);
+  /*! \brief Marks the watcher as failed. Called by the watcher thread before it exits. */
+  void setWatchFailed();
+  /*! \brief Closes all open descriptors. */
+  void closeDescriptors();
+};
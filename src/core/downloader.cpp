@@ -0,0 +1,478 @@
+#include "downloader.h"
+#include "cryptography.h"
+#include <algorithm>
+#include <chrono>
+#include <cpr/cpr.h>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <json/json.h>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace sfs = std::filesystem;
+
+
+Downloader::Downloader(const std::string& url, const sfs::path& dest_path, int num_connections) :
+  url_(url), dest_path_(dest_path), num_connections_(std::max(1, num_connections))
+{}
+
+void Downloader::init()
+{
+  is_initialized_ = true;
+  total_size_ = {};
+  supports_ranges_ = false;
+  resumed_size_ = 0;
+  chunks_.clear();
+
+  cpr::Response response = cpr::Head(cpr::Url(url_));
+  if(response.status_code == 200)
+  {
+    const auto length_iter = response.header.find("content-length");
+    if(length_iter != response.header.end() && !length_iter->second.empty() &&
+       length_iter->second.find_first_not_of("0123456789") == std::string::npos)
+      total_size_ = std::stoull(length_iter->second);
+    const auto ranges_iter = response.header.find("accept-ranges");
+    supports_ranges_ = total_size_ && ranges_iter != response.header.end() &&
+                       ranges_iter->second.find("bytes") != std::string::npos;
+    if(response.header.contains("etag"))
+      etag_ = response.header["etag"];
+    if(response.header.contains("last-modified"))
+      last_modified_ = response.header["last-modified"];
+  }
+  else
+    log_(Log::LOG_DEBUG,
+         std::format("HEAD request for '{}' failed with code {}. Falling back to a single "
+                     "connection.",
+                     url_,
+                     response.status_code));
+
+  if(hasResumeState(dest_path_))
+  {
+    if(loadResumeState())
+    {
+      resumed_size_ = getWrittenSize();
+      log_(Log::LOG_INFO,
+           std::format("Resuming download of '{}' at {} of {} bytes.",
+                       dest_path_.filename().string(),
+                       resumed_size_,
+                       *total_size_));
+    }
+    else
+      sfs::remove(getResumeStatePath(dest_path_));
+  }
+}
+
+void Downloader::download(std::optional<ProgressNode*> progress_node)
+{
+  if(!is_initialized_)
+    init();
+  const bool is_resuming = !chunks_.empty();
+  if(!is_resuming)
+    createChunks();
+
+  int flags = O_RDWR | O_CREAT;
+  if(!is_resuming)
+    flags |= O_TRUNC;
+  fd_ = open(dest_path_.c_str(), flags, 0644);
+  if(fd_ < 0)
+    throw std::runtime_error(std::format("Failed to open '{}' for writing.", dest_path_.string()));
+  if(total_size_ && *total_size_ > 0)
+  {
+    if(posix_fallocate(fd_, 0, *total_size_) != 0 && ftruncate(fd_, *total_size_) != 0)
+    {
+      closeFile();
+      throw std::runtime_error(
+        std::format("Failed to allocate {} bytes for '{}'.", *total_size_, dest_path_.string()));
+    }
+  }
+
+  log_(Log::LOG_DEBUG,
+       std::format("Downloading '{}' using {} connection{}.",
+                   dest_path_.filename().string(),
+                   chunks_.size(),
+                   chunks_.size() == 1 ? "" : "s"));
+  if(progress_node)
+    (*progress_node)->setTotalSteps(total_size_ ? *total_size_ : 1);
+  uint64_t reported_size = 0;
+  if(progress_node && total_size_)
+  {
+    reported_size = getWrittenSize();
+    (*progress_node)->advance(reported_size);
+  }
+
+  abort_ = false;
+  error_message_.clear();
+  running_workers_ = 0;
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+  {
+    if(!chunkIsComplete(chunk))
+      running_workers_++;
+  }
+  std::vector<std::jthread> workers;
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+  {
+    if(!chunkIsComplete(chunk))
+      workers.emplace_back([this, chunk]() { downloadChunk(chunk); });
+  }
+
+  // Data is hashed in file order. Every chunk is written sequentially, so the hashed prefix
+  // of the file can grow as soon as the chunk containing the next byte receives data.
+  // Without range support a retry restarts at offset 0, so hashing has to wait for completion.
+  // The same data is forwarded to the stream callback.
+  cryptography::Md5Hasher hasher;
+  bool is_streaming = static_cast<bool>(stream_callback_);
+  std::vector<char> hash_buffer(HASH_BUFFER_SIZE);
+  int hash_chunk = 0;
+  uint64_t hash_offset = 0;
+  auto update_hash = [&]()
+  {
+    while(hash_chunk < chunks_.size())
+    {
+      const uint64_t available_end = chunks_[hash_chunk].start + chunk_progress_[hash_chunk];
+      while(hash_offset < available_end)
+      {
+        const uint64_t read_size = std::min(HASH_BUFFER_SIZE, available_end - hash_offset);
+        const ssize_t bytes_read = pread(fd_, hash_buffer.data(), read_size, hash_offset);
+        if(bytes_read <= 0)
+          throw std::runtime_error(
+            std::format("Failed to read from '{}' while hashing.", dest_path_.string()));
+        hasher.update(hash_buffer.data(), bytes_read);
+        if(is_streaming)
+          is_streaming = stream_callback_(hash_buffer.data(), bytes_read);
+        hash_offset += bytes_read;
+      }
+      if(!chunkIsComplete(hash_chunk))
+        return;
+      hash_chunk++;
+    }
+  };
+
+  auto last_save = std::chrono::steady_clock::now();
+  while(running_workers_ > 0 && !abort_)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(UPDATE_INTERVAL_MS));
+    const uint64_t written_size = getWrittenSize();
+    if(progress_node && total_size_ && written_size > reported_size)
+    {
+      (*progress_node)->advance(written_size - reported_size);
+      reported_size = written_size;
+    }
+    if(!supports_ranges_)
+      continue;
+    try
+    {
+      update_hash();
+    }
+    catch(std::runtime_error& error)
+    {
+      setError(error.what());
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if(std::chrono::duration_cast<std::chrono::milliseconds>(now - last_save).count() >
+       SAVE_INTERVAL_MS)
+    {
+      fdatasync(fd_);
+      saveResumeState();
+      last_save = now;
+    }
+  }
+  for(auto& worker : workers)
+    worker.join();
+
+  if(abort_)
+  {
+    if(supports_ranges_)
+    {
+      fdatasync(fd_);
+      saveResumeState();
+    }
+    closeFile();
+    throw std::runtime_error(std::format("Download of '{}' failed: {}",
+                                         dest_path_.filename().string(),
+                                         error_message_));
+  }
+
+  if(!total_size_)
+  {
+    chunks_[0].end = chunk_progress_[0];
+    if(ftruncate(fd_, chunks_[0].end) != 0)
+      log_(Log::LOG_DEBUG, std::format("Failed to truncate '{}'.", dest_path_.string()));
+    if(progress_node)
+      (*progress_node)->advance();
+  }
+  else if(progress_node && *total_size_ > reported_size)
+    (*progress_node)->advance(*total_size_ - reported_size);
+  try
+  {
+    update_hash();
+  }
+  catch(std::runtime_error& error)
+  {
+    closeFile();
+    throw;
+  }
+  md5_ = hasher.finalize();
+  closeFile();
+  sfs::remove(getResumeStatePath(dest_path_));
+
+  std::string expected = expected_md5_;
+  std::transform(expected.begin(),
+                 expected.end(),
+                 expected.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if(!expected.empty() && expected != md5_)
+  {
+    sfs::remove(dest_path_);
+    throw std::runtime_error(
+      std::format("Checksum mismatch for '{}'. Expected MD5 '{}', got '{}'.",
+                  dest_path_.filename().string(),
+                  expected,
+                  md5_));
+  }
+  log_(Log::LOG_DEBUG, std::format("Download complete. MD5: {}", md5_));
+}
+
+std::optional<uint64_t> Downloader::getTotalSize() const
+{
+  return total_size_;
+}
+
+uint64_t Downloader::getResumedSize() const
+{
+  return resumed_size_;
+}
+
+bool Downloader::supportsRanges() const
+{
+  return supports_ranges_;
+}
+
+void Downloader::setExpectedMd5(const std::string& md5)
+{
+  expected_md5_ = md5;
+}
+
+std::string Downloader::getMd5() const
+{
+  return md5_;
+}
+
+void Downloader::setStreamCallback(const std::function<bool(const char*, uint64_t)>& callback)
+{
+  stream_callback_ = callback;
+}
+
+void Downloader::setMaxRetries(int max_retries)
+{
+  max_retries_ = std::max(0, max_retries);
+}
+
+void Downloader::setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log)
+{
+  log_ = new_log;
+}
+
+sfs::path Downloader::getResumeStatePath(const sfs::path& dest_path)
+{
+  return dest_path.string() + RESUME_EXTENSION;
+}
+
+bool Downloader::hasResumeState(const sfs::path& dest_path)
+{
+  return sfs::exists(dest_path) && sfs::exists(getResumeStatePath(dest_path));
+}
+
+void Downloader::createChunks()
+{
+  chunks_.clear();
+  if(!total_size_)
+    chunks_.push_back({ 0, UINT64_MAX });
+  else if(!supports_ranges_)
+    chunks_.push_back({ 0, *total_size_ });
+  else
+  {
+    const uint64_t num_chunks =
+      std::clamp(*total_size_ / MIN_CHUNK_SIZE, (uint64_t)1, (uint64_t)num_connections_);
+    const uint64_t chunk_size = (*total_size_ + num_chunks - 1) / num_chunks;
+    for(uint64_t start = 0; start < *total_size_; start += chunk_size)
+      chunks_.push_back({ start, std::min(start + chunk_size, *total_size_) });
+    if(chunks_.empty())
+      chunks_.push_back({ 0, 0 });
+  }
+  chunk_progress_ = std::make_unique<std::atomic<uint64_t>[]>(chunks_.size());
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+    chunk_progress_[chunk] = 0;
+}
+
+void Downloader::downloadChunk(int chunk)
+{
+  for(int attempt = 0; attempt <= max_retries_ && !abort_; attempt++)
+  {
+    if(!supports_ranges_ && chunk_progress_[chunk] > 0)
+    {
+      log_(Log::LOG_DEBUG, "Server does not support range requests. Restarting download.");
+      chunk_progress_[chunk] = 0;
+    }
+    const uint64_t offset = chunks_[chunk].start + chunk_progress_[chunk];
+    cpr::Header header;
+    if(supports_ranges_)
+      header["Range"] = std::format("bytes={}-{}", offset, chunks_[chunk].end - 1);
+    cpr::Response response = cpr::Get(
+      cpr::Url(url_),
+      header,
+      cpr::WriteCallback([this, chunk](auto data, intptr_t user_data)
+                         { return writeChunkData(chunk, data.data(), data.size()); }));
+    if(abort_)
+      break;
+
+    const long expected_code = supports_ranges_ ? 206 : 200;
+    if(response.error.code == cpr::ErrorCode::OK && response.status_code == expected_code &&
+       (!total_size_ || chunkIsComplete(chunk)))
+    {
+      running_workers_--;
+      return;
+    }
+    if(response.status_code >= 400 && response.status_code < 500)
+    {
+      setError(std::format(
+        "Server responded with \"{}\" (code {}).", response.status_line, response.status_code));
+      break;
+    }
+    log_(Log::LOG_DEBUG,
+         std::format("Connection for chunk {} of '{}' was interrupted (attempt {} of {}): {}",
+                     chunk,
+                     dest_path_.filename().string(),
+                     attempt + 1,
+                     max_retries_ + 1,
+                     response.error.message));
+  }
+  // aborted downloads either have been canceled or already have an error
+  if(!abort_)
+    setError("Connection was interrupted too many times.");
+  running_workers_--;
+}
+
+bool Downloader::writeChunkData(int chunk, const char* data, uint64_t size)
+{
+  if(abort_)
+    return false;
+  const auto& [start, end] = chunks_[chunk];
+  uint64_t offset = start + chunk_progress_[chunk];
+  // never write past the end of the chunk, even if the server sends more data
+  size = std::min(size, end - offset);
+  uint64_t bytes_written = 0;
+  while(bytes_written < size)
+  {
+    const ssize_t ret = pwrite(fd_, data + bytes_written, size - bytes_written, offset);
+    if(ret <= 0)
+    {
+      setError(std::format("Failed to write to '{}'.", dest_path_.string()));
+      return false;
+    }
+    bytes_written += ret;
+    offset += ret;
+    chunk_progress_[chunk] += ret;
+  }
+  return true;
+}
+
+bool Downloader::chunkIsComplete(int chunk) const
+{
+  return chunks_[chunk].start + chunk_progress_[chunk] >= chunks_[chunk].end;
+}
+
+uint64_t Downloader::getWrittenSize() const
+{
+  uint64_t size = 0;
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+    size += chunk_progress_[chunk];
+  return size;
+}
+
+void Downloader::saveResumeState() const
+{
+  Json::Value state;
+  state["size"] = static_cast<Json::UInt64>(*total_size_);
+  state["etag"] = etag_;
+  state["last_modified"] = last_modified_;
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+  {
+    state["chunks"][chunk]["start"] = static_cast<Json::UInt64>(chunks_[chunk].start);
+    state["chunks"][chunk]["end"] = static_cast<Json::UInt64>(chunks_[chunk].end);
+    state["chunks"][chunk]["written"] = static_cast<Json::UInt64>(chunk_progress_[chunk].load());
+  }
+  const sfs::path state_path = getResumeStatePath(dest_path_);
+  const sfs::path tmp_path = state_path.string() + ".tmp";
+  std::ofstream file(tmp_path, std::fstream::binary);
+  if(!file.is_open())
+  {
+    log_(Log::LOG_DEBUG, std::format("Failed to write to '{}'.", tmp_path.string()));
+    return;
+  }
+  file << state;
+  file.close();
+  sfs::rename(tmp_path, state_path);
+}
+
+bool Downloader::loadResumeState()
+{
+  if(!supports_ranges_ || !total_size_)
+    return false;
+  Json::Value state;
+  try
+  {
+    std::ifstream file(getResumeStatePath(dest_path_), std::fstream::binary);
+    if(!file.is_open())
+      return false;
+    file >> state;
+  }
+  catch(Json::Exception& e)
+  {
+    log_(Log::LOG_DEBUG, std::format("Failed to parse download state: {}", e.what()));
+    return false;
+  }
+
+  if(state["size"].asUInt64() != *total_size_ || state["etag"].asString() != etag_ ||
+     state["last_modified"].asString() != last_modified_ || state["chunks"].empty())
+    return false;
+
+  std::vector<Chunk> chunks;
+  std::vector<uint64_t> progress;
+  uint64_t expected_start = 0;
+  for(const auto& chunk : state["chunks"])
+  {
+    const uint64_t start = chunk["start"].asUInt64();
+    const uint64_t end = chunk["end"].asUInt64();
+    const uint64_t written = chunk["written"].asUInt64();
+    if(start != expected_start || end < start || end > *total_size_ || written > end - start)
+      return false;
+    chunks.push_back({ start, end });
+    progress.push_back(written);
+    expected_start = end;
+  }
+  if(expected_start != *total_size_)
+    return false;
+
+  chunks_ = chunks;
+  chunk_progress_ = std::make_unique<std::atomic<uint64_t>[]>(chunks_.size());
+  for(int chunk = 0; chunk < chunks_.size(); chunk++)
+    chunk_progress_[chunk] = progress[chunk];
+  return true;
+}
+
+void Downloader::setError(const std::string& message)
+{
+  std::lock_guard lock(error_mutex_);
+  if(error_message_.empty())
+    error_message_ = message;
+  abort_ = true;
+}
+
+void Downloader::closeFile()
+{
+  if(fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+}
@@ -0,0 +1,221 @@
+/*!
+ * \file downloader.h
+ * \brief Header for the Downloader class.
+ */
+
+#pragma once
+
+#include "log.h"
+#include "progressnode.h"
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+/*!
+ * \brief Downloads a file over HTTP using multiple parallel range requests.
+ *
+ * Data is written into a preallocated file. The download state is periodically stored in a
+ * file next to the target file, which allows interrupted downloads to be resumed. The MD5
+ * digest of the file is computed while the download is in progress.
+ */
+class Downloader
+{
+public:
+  /*!
+   * \brief Constructor.
+   * \param url URL of the file to be downloaded.
+   * \param dest_path Path to which the file is to be written.
+   * \param num_connections Maximum number of parallel connections used for the download.
+   */
+  Downloader(const std::string& url,
+             const std::filesystem::path& dest_path,
+             int num_connections = DEFAULT_NUM_CONNECTIONS);
+
+  /*! \brief File extension used for the file storing the state of an incomplete download. */
+  static inline const std::string RESUME_EXTENSION = ".lmmdownload";
+  /*! \brief Default number of parallel connections. */
+  static constexpr int DEFAULT_NUM_CONNECTIONS = 4;
+  /*! \brief Files are never split into chunks smaller than this. */
+  static constexpr uint64_t MIN_CHUNK_SIZE = 8 * 1024 * 1024;
+
+  /*!
+   * \brief Requests the size of the target file and whether the server supports range
+   * requests. If a matching resume state exists for the target file, it is loaded.
+   * This is automatically called by \ref download, if it has not been called before.
+   */
+  void init();
+  /*!
+   * \brief Downloads the file. Blocks until the download is complete.
+   * \param progress_node Used to inform about the current progress.
+   * \throws std::runtime_error If the download failed or the checksum does not match.
+   */
+  void download(std::optional<ProgressNode*> progress_node = {});
+  /*!
+   * \brief Returns the size of the target file, if the server reported it.
+   * \return The size in bytes.
+   */
+  std::optional<uint64_t> getTotalSize() const;
+  /*!
+   * \brief Returns the number of bytes which had already been downloaded when \ref init
+   * was called.
+   * \return The number of bytes.
+   */
+  uint64_t getResumedSize() const;
+  /*!
+   * \brief Returns whether the server supports range requests for the target file.
+   * \return True if supported.
+   */
+  bool supportsRanges() const;
+  /*!
+   * \brief Sets the MD5 digest the downloaded file is expected to have. If this is not empty,
+   * the digest is verified after the download completes.
+   * \param md5 The expected digest as a hex string.
+   */
+  void setExpectedMd5(const std::string& md5);
+  /*!
+   * \brief Returns the MD5 digest of the downloaded file.
+   * \return The digest as a lower case hex string or an empty string, if the download
+   * has not yet been completed.
+   */
+  std::string getMd5() const;
+  /*!
+   * \brief Sets a callback which receives the downloaded data in file order while the download
+   * is in progress. If the callback returns false, it is no longer called.
+   * \param callback The callback.
+   */
+  void setStreamCallback(const std::function<bool(const char*, uint64_t)>& callback);
+  /*!
+   * \brief Sets how often a request for a chunk is repeated after a connection failure.
+   * \param max_retries The number of retries.
+   */
+  void setMaxRetries(int max_retries);
+  /*!
+   * \brief Setter for log callback.
+   * \param new_log New log callback
+   */
+  void setLog(const std::function<void(Log::LogLevel, const std::string&)>& new_log);
+  /*!
+   * \brief Returns the path to the file used to store the state of an incomplete download.
+   * \param dest_path Path to the downloaded file.
+   * \return The path.
+   */
+  static std::filesystem::path getResumeStatePath(const std::filesystem::path& dest_path);
+  /*!
+   * \brief Checks whether an incomplete download exists at the given path.
+   * \param dest_path Path to the downloaded file.
+   * \return True if the download can potentially be resumed.
+   */
+  static bool hasResumeState(const std::filesystem::path& dest_path);
+
+private:
+  /*! \brief A contiguous part of the target file downloaded by one connection. */
+  struct Chunk
+  {
+    /*! \brief Offset of the first byte. */
+    uint64_t start;
+    /*! \brief Offset one past the last byte. If the file size is unknown, this is UINT64_MAX. */
+    uint64_t end;
+  };
+
+  /*! \brief Size of the buffer used to read back data for hashing. */
+  static constexpr uint64_t HASH_BUFFER_SIZE = 1024 * 1024;
+  /*! \brief Time in milliseconds between progress updates. */
+  static constexpr int UPDATE_INTERVAL_MS = 100;
+  /*! \brief Time in milliseconds between writes of the resume state. */
+  static constexpr int SAVE_INTERVAL_MS = 2000;
+
+  /*! \brief URL of the target file. */
+  std::string url_;
+  /*! \brief Download destination. */
+  std::filesystem::path dest_path_;
+  /*! \brief Maximum number of parallel connections. */
+  int num_connections_;
+  /*! \brief Number of retries per chunk. */
+  int max_retries_ = 3;
+  /*! \brief True after \ref init has been called. */
+  bool is_initialized_ = false;
+  /*! \brief Size of the target file, if known. */
+  std::optional<uint64_t> total_size_;
+  /*! \brief True if the server accepts range requests. */
+  bool supports_ranges_ = false;
+  /*! \brief ETag reported by the server. Used to ensure resumed data belongs to the same file. */
+  std::string etag_;
+  /*! \brief Last-Modified header reported by the server. */
+  std::string last_modified_;
+  /*! \brief Expected MD5 digest. */
+  std::string expected_md5_;
+  /*! \brief Digest of the completed download. */
+  std::string md5_;
+  /*! \brief Chunks into which the file is split. */
+  std::vector<Chunk> chunks_;
+  /*! \brief For every chunk: Number of bytes already written to disk. */
+  std::unique_ptr<std::atomic<uint64_t>[]> chunk_progress_;
+  /*! \brief Number of bytes present on disk when \ref init was called. */
+  uint64_t resumed_size_ = 0;
+  /*! \brief File descriptor of the target file. */
+  int fd_ = -1;
+  /*! \brief Set when a chunk failed, to abort all other connections. */
+  std::atomic<bool> abort_ = false;
+  /*! \brief Contains the first error which occurred during the download. */
+  std::string error_message_;
+  /*! \brief Protects \ref error_message_. */
+  std::mutex error_mutex_;
+  /*! \brief Number of connections which have not yet finished. */
+  std::atomic<int> running_workers_ = 0;
+  /*! \brief Receives downloaded data in file order. */
+  std::function<bool(const char*, uint64_t)> stream_callback_;
+  /*! \brief Callback for logging. */
+  std::function<void(Log::LogLevel, const std::string&)> log_ = [](Log::LogLevel a,
+                                                                   const std::string& b) {};
+
+  /*!
+   * \brief Splits the file into chunks, one for every connection.
+   */
+  void createChunks();
+  /*!
+   * \brief Downloads one chunk. Runs in its own thread.
+   * \param chunk Index of the chunk to download.
+   */
+  void downloadChunk(int chunk);
+  /*!
+   * \brief Writes data received for the given chunk to disk.
+   * \param chunk Index of the target chunk.
+   * \param data Received data.
+   * \param size Size of the received data.
+   * \return False if the transfer should be aborted.
+   */
+  bool writeChunkData(int chunk, const char* data, uint64_t size);
+  /*!
+   * \brief Returns whether all bytes of the given chunk have been written.
+   * \param chunk Target chunk.
+   * \return True if the chunk is complete.
+   */
+  bool chunkIsComplete(int chunk) const;
+  /*!
+   * \brief Returns the total number of bytes written by all chunks.
+   * \return The number of bytes.
+   */
+  uint64_t getWrittenSize() const;
+  /*! \brief Writes the current state of all chunks to the resume file. */
+  void saveResumeState() const;
+  /*!
+   * \brief Reads the resume file and restores the chunk state, if the file belongs to the
+   * same remote file.
+   * \return True if the state was restored.
+   */
+  bool loadResumeState();
+  /*!
+   * \brief Stores the given error message, unless an error has already occurred, and aborts
+   * all connections.
+   * \param message The error message.
+   */
+  void setError(const std::string& message);
+  /*! \brief Closes the target file, if it is open. */
+  void closeFile();
+};
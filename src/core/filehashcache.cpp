@@ -0,0 +1,87 @@
+#include "filehashcache.h"
+#include "cryptography.h"
+#include <format>
+#include <fstream>
+#include <json/json.h>
+#include <sys/stat.h>
+
+namespace sfs = std::filesystem;
+
+
+FileHashCache::FileHashCache(const sfs::path& cache_file) : cache_file_(cache_file)
+{
+  if(!sfs::exists(cache_file_))
+    return;
+  std::ifstream file(cache_file_, std::fstream::binary);
+  if(!file.is_open())
+    return;
+  Json::Value json_object;
+  try
+  {
+    file >> json_object;
+  }
+  catch(Json::Exception& error)
+  {
+    // an invalid cache only means that all files have to be hashed again
+    return;
+  }
+  for(const auto& entry : json_object["files"])
+  {
+    const Key key{ entry["device"].asUInt64(),
+                   entry["inode"].asUInt64(),
+                   entry["size"].asUInt64(),
+                   entry["mtime"].asInt64() };
+    cached_hashes_[key] = entry["hash"].asString();
+  }
+}
+
+std::string FileHashCache::getHash(const sfs::path& path)
+{
+  struct stat file_stat;
+  if(stat(path.c_str(), &file_stat) != 0)
+    throw std::runtime_error(std::format("Could not read '{}'.", path.string()));
+  const Key key{ file_stat.st_dev,
+                 file_stat.st_ino,
+                 file_stat.st_size,
+                 file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec };
+  {
+    std::lock_guard lock(mutex_);
+    auto iter = used_hashes_.find(key);
+    if(iter != used_hashes_.end())
+      return iter->second;
+    iter = cached_hashes_.find(key);
+    if(iter != cached_hashes_.end())
+    {
+      used_hashes_[key] = iter->second;
+      return iter->second;
+    }
+  }
+  const std::string hash = cryptography::sha256File(path);
+  std::lock_guard lock(mutex_);
+  used_hashes_[key] = hash;
+  return hash;
+}
+
+void FileHashCache::save() const
+{
+  Json::Value json_object;
+  json_object["files"] = Json::arrayValue;
+  {
+    std::lock_guard lock(mutex_);
+    for(const auto& [key, hash] : used_hashes_)
+    {
+      const auto& [device, inode, size, mtime] = key;
+      Json::Value entry;
+      entry["device"] = Json::UInt64(device);
+      entry["inode"] = Json::UInt64(inode);
+      entry["size"] = Json::UInt64(size);
+      entry["mtime"] = Json::Int64(mtime);
+      entry["hash"] = hash;
+      json_object["files"].append(entry);
+    }
+  }
+  std::ofstream file(cache_file_, std::fstream::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Could not write \"" + cache_file_.string() + "\"");
+  file << json_object;
+}
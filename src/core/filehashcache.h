@@ -0,0 +1,51 @@
+/*!
+ * \file filehashcache.h
+ * \brief Header for the FileHashCache class.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+
+/*!
+ * \brief Computes and caches content hashes of files. Cached hashes are identified by
+ * the files inode, size and modification time, so renamed or linked files reuse their hash
+ * while modified files are hashed again. Safe to use from multiple threads.
+ */
+class FileHashCache
+{
+public:
+  /*!
+   * \brief Loads cached hashes from the given file, if it exists.
+   * \param cache_file File used to store hashes.
+   */
+  FileHashCache(const std::filesystem::path& cache_file);
+
+  /*!
+   * \brief Returns the hash of the given file, computing it only if no valid cached hash exists.
+   * \param path The file.
+   * \return The hash.
+   * \throws std::runtime_error When the file cannot be read.
+   */
+  std::string getHash(const std::filesystem::path& path);
+  /*! \brief Writes all hashes which have been used since construction to the cache file. */
+  void save() const;
+
+private:
+  /*! \brief Identifies a version of a file: Device, inode, size and modification time. */
+  using Key = std::tuple<uint64_t, uint64_t, uint64_t, int64_t>;
+
+  /*! \brief File used to store hashes. */
+  std::filesystem::path cache_file_;
+  /*! \brief Hashes loaded from \ref cache_file_. */
+  std::map<Key, std::string> cached_hashes_;
+  /*! \brief Hashes used since construction. Only these are saved. */
+  std::map<Key, std::string> used_hashes_;
+  /*! \brief Synchronizes access to the hash maps. */
+  mutable std::mutex mutex_;
+};
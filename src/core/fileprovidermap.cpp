@@ -0,0 +1,175 @@
+#include "fileprovidermap.h"
+#include "pathutils.h"
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <unordered_map>
+
+namespace str = std::ranges;
+namespace pu = path_utils;
+
+
+FileProviderMap::FileProviderMap(
+  const std::vector<std::pair<int, const std::vector<std::string>*>>& mod_files,
+  bool case_invariant) :
+  case_invariant_(case_invariant)
+{
+  // one item per file and mod, grouped by key and sorted by load order within a group
+  struct Item
+  {
+    const std::string* key;
+    int mod_index;
+    const std::string* path;
+  };
+  size_t num_items = 0;
+  for(const auto& [_, files] : mod_files)
+    num_items += files->size();
+  std::vector<std::string> lower_case_paths;
+  if(case_invariant_)
+    lower_case_paths.reserve(num_items);
+  std::vector<Item> items;
+  items.reserve(num_items);
+  for(const auto& [mod_index, mod] : str::enumerate_view(mod_files))
+  {
+    for(const auto& path : *mod.second)
+    {
+      const std::string* key = &path;
+      if(case_invariant_)
+      {
+        lower_case_paths.push_back(pu::toLowerCase(path));
+        key = &lower_case_paths.back();
+      }
+      items.push_back({ key, static_cast<int>(mod_index), &path });
+    }
+  }
+  str::sort(items,
+            [](const Item& a, const Item& b)
+            {
+              const int comparison = a.key->compare(*b.key);
+              return comparison < 0 || (comparison == 0 && a.mod_index < b.mod_index);
+            });
+
+  for(size_t first = 0; first < items.size();)
+  {
+    size_t last = first + 1;
+    while(last < items.size() && *items[last].key == *items[first].key)
+      last++;
+    Entry entry{ *items[last - 1].path, {} };
+    for(size_t i = first; i < last; i++)
+    {
+      // a mod may contain multiple spellings of one file in case invariant maps
+      const int mod_id = mod_files[items[i].mod_index].first;
+      if(entry.mod_ids.empty() || entry.mod_ids.back() != mod_id)
+        entry.mod_ids.push_back(mod_id);
+    }
+    if(case_invariant_)
+      keys_.push_back(*items[first].key);
+    entries_.push_back(std::move(entry));
+    first = last;
+  }
+}
+
+const FileProviderMap::Entry* FileProviderMap::find(const std::string& path) const
+{
+  const std::string key = case_invariant_ ? pu::toLowerCase(path) : path;
+  const size_t index = lowerBound(key);
+  if(index == entries_.size() || getKey(index) != key)
+    return nullptr;
+  return &entries_[index];
+}
+
+std::span<const FileProviderMap::Entry> FileProviderMap::findPrefix(const std::string& prefix) const
+{
+  const std::string key = case_invariant_ ? pu::toLowerCase(prefix) : prefix;
+  const size_t first = lowerBound(key);
+  size_t last = first;
+  // all keys with the prefix directly follow the first one
+  size_t step = 1;
+  while(last + step <= entries_.size() && getKey(last + step - 1).starts_with(key))
+  {
+    last += step;
+    step *= 2;
+  }
+  for(; step > 0; step /= 2)
+  {
+    if(last + step <= entries_.size() && getKey(last + step - 1).starts_with(key))
+      last += step;
+  }
+  return std::span<const Entry>(entries_.begin() + first, entries_.begin() + last);
+}
+
+const std::vector<FileProviderMap::Entry>& FileProviderMap::getEntries() const
+{
+  return entries_;
+}
+
+size_t FileProviderMap::size() const
+{
+  return entries_.size();
+}
+
+void FileProviderMap::writeReport(std::ostream& stream,
+                                  const std::function<std::string(int)>& mod_names,
+                                  bool only_conflicts) const
+{
+  auto to_csv_field = [](const std::string& text)
+  {
+    std::string field = "\"";
+    for(char c : text)
+    {
+      if(c == '"')
+        field += '"';
+      field += c;
+    }
+    return field + '"';
+  };
+  std::unordered_map<int, std::string> mod_fields;
+  auto get_mod_field = [&](int mod_id) -> const std::string&
+  {
+    auto iter = mod_fields.find(mod_id);
+    if(iter == mod_fields.end())
+      iter =
+        mod_fields.emplace(mod_id, std::format("{} [{}]", mod_names(mod_id), mod_id)).first;
+    return iter->second;
+  };
+
+  stream << "\"File\",\"Winner\",\"Overwritten mods\"\n";
+  std::string overwritten;
+  for(const auto& [path, mod_ids] : entries_)
+  {
+    if(only_conflicts && mod_ids.size() < 2)
+      continue;
+    overwritten.clear();
+    for(size_t i = 0; i + 1 < mod_ids.size(); i++)
+    {
+      if(i > 0)
+        overwritten += "; ";
+      overwritten += get_mod_field(mod_ids[i]);
+    }
+    stream << to_csv_field(path) << ',' << to_csv_field(get_mod_field(mod_ids.back())) << ','
+           << to_csv_field(overwritten) << '\n';
+  }
+}
+
+const std::string& FileProviderMap::getKey(size_t index) const
+{
+  return case_invariant_ ? keys_[index] : entries_[index].path;
+}
+
+size_t FileProviderMap::lowerBound(const std::string& key) const
+{
+  size_t first = 0;
+  size_t count = entries_.size();
+  while(count > 0)
+  {
+    const size_t step = count / 2;
+    if(getKey(first + step) < key)
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+      count = step;
+  }
+  return first;
+}
@@ -0,0 +1,98 @@
+/*!
+ * \file fileprovidermap.h
+ * \brief Header for the FileProviderMap class.
+ */
+
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Maps every file deployed by one deployer to the mods providing it, in overwrite
+ * order. Entries are sorted by path, which allows looking up a path in O(log n) and
+ * enumerating all paths with a given prefix, e.g. a directory.
+ */
+class FileProviderMap
+{
+public:
+  /*! \brief All mods providing one file. */
+  struct Entry
+  {
+    /*! \brief Path to the file, relative to the target directory. */
+    std::string path;
+    /*! \brief Ids of all mods containing the file in load order. The last mod wins. */
+    std::vector<int> mod_ids;
+  };
+
+  /*! \brief Creates an empty map. */
+  FileProviderMap() = default;
+  /*!
+   * \brief Creates the map from the files of every mod.
+   * \param mod_files For every enabled mod, in load order: The mods id and the relative paths
+   * of all files in that mod.
+   * \param case_invariant If true: Paths which only differ in case refer to the same file.
+   * The spelling used by the winning mod is stored.
+   */
+  FileProviderMap(const std::vector<std::pair<int, const std::vector<std::string>*>>& mod_files,
+                  bool case_invariant = false);
+
+  /*!
+   * \brief Returns the entry for the given path.
+   * \param path Path relative to the target directory.
+   * \return A pointer to the entry or nullptr if no mod provides the path.
+   */
+  const Entry* find(const std::string& path) const;
+  /*!
+   * \brief Returns all entries whose path starts with the given prefix.
+   * \param prefix The prefix. If empty: Return all entries.
+   * \return The entries, sorted by path.
+   */
+  std::span<const Entry> findPrefix(const std::string& prefix) const;
+  /*!
+   * \brief Returns all entries, sorted by path.
+   * \return The entries.
+   */
+  const std::vector<Entry>& getEntries() const;
+  /*!
+   * \brief Returns the number of files in this map.
+   * \return The number of files.
+   */
+  size_t size() const;
+  /*!
+   * \brief Writes a CSV table with one row per file to the given stream. Every row contains
+   * the path, the winning mod and all overwritten mods in load order, separated by ';'.
+   * \param stream Target stream.
+   * \param mod_names Used to get the name of a mod from its id.
+   * \param only_conflicts If true: Only write files provided by more than one mod.
+   */
+  void writeReport(std::ostream& stream,
+                   const std::function<std::string(int)>& mod_names,
+                   bool only_conflicts = false) const;
+
+private:
+  /*! \brief Entries sorted by \ref keys_ or, if \ref keys_ is empty, by path. */
+  std::vector<Entry> entries_;
+  /*! \brief Lower case paths of all entries. Only used for case invariant maps. */
+  std::vector<std::string> keys_;
+  /*! \brief If true: Paths are compared ignoring case. */
+  bool case_invariant_ = false;
+
+  /*!
+   * \brief Returns the key used for sorting the entry at the given index.
+   * \param index Index of the entry.
+   * \return The key.
+   */
+  const std::string& getKey(size_t index) const;
+  /*!
+   * \brief Returns the index of the first entry whose key is not less than the given key.
+   * \param key The key.
+   * \return The index.
+   */
+  size_t lowerBound(const std::string& key) const;
+};
@@ -0,0 +1,115 @@
+#include "filesystemprobe.h"
+#include "pathutils.h"
+#include <format>
+#include <cctype>
+#include <fstream>
+#include <sys/stat.h>
+
+namespace sfs = std::filesystem;
+namespace pu = path_utils;
+
+
+FilesystemCapabilities FilesystemProbe::probe(const sfs::path& source,
+                                              const sfs::path& dest,
+                                              bool use_cache)
+{
+  const auto key = std::make_pair(source.lexically_normal(), dest.lexically_normal());
+  if(use_cache)
+  {
+    std::lock_guard lock(cache_mutex_);
+    if(cache_.contains(key))
+      return cache_[key];
+  }
+  const auto capabilities = runProbe(source, dest);
+  std::lock_guard lock(cache_mutex_);
+  // failures may be caused by missing directories, which can be created later
+  if(capabilities.source_writable && capabilities.dest_writable)
+    cache_[key] = capabilities;
+  else
+    cache_.erase(key);
+  return capabilities;
+}
+
+void FilesystemProbe::clearCache()
+{
+  std::lock_guard lock(cache_mutex_);
+  cache_.clear();
+}
+
+void FilesystemProbe::copyFile(const sfs::path& source,
+                               const sfs::path& destination,
+                               const FilesystemCapabilities& capabilities)
+{
+  if(capabilities.reflinks && pu::reflinkFile(source, destination))
+    return;
+  if(capabilities.copy_file_range && pu::copyFileRange(source, destination))
+    return;
+  sfs::copy_file(source, destination);
+}
+
+FilesystemCapabilities FilesystemProbe::runProbe(const sfs::path& source, const sfs::path& dest)
+{
+  FilesystemCapabilities capabilities;
+  auto get_message = [](const std::string& operation, const std::error_code& error)
+  {
+    return std::format(
+      "Failed to {}. (Code: {}. Message: '{}')", operation, error.value(), error.message());
+  };
+
+  const sfs::path source_file = source / TEST_FILE_NAME;
+  const sfs::path dest_file = dest / DEST_TEST_FILE_NAME;
+  std::error_code error;
+  sfs::remove(source_file, error);
+  sfs::remove(dest_file, error);
+  {
+    std::ofstream file(source_file);
+    if(file.is_open())
+      file << "test";
+    capabilities.source_writable = file.is_open() && file.good();
+  }
+  if(!capabilities.source_writable)
+  {
+    capabilities.write_error = std::format("Failed to write to '{}'.", source.string());
+    sfs::remove(source_file, error);
+    return capabilities;
+  }
+
+  struct stat source_stat;
+  struct stat dest_stat;
+  capabilities.same_device = stat(source.c_str(), &source_stat) == 0 &&
+                             stat(dest.c_str(), &dest_stat) == 0 &&
+                             source_stat.st_dev == dest_stat.st_dev;
+
+  sfs::create_hard_link(source_file, dest_file, error);
+  capabilities.hard_links = !error;
+  if(error)
+    capabilities.hard_link_error = get_message("create hard link", error);
+  sfs::remove(dest_file, error);
+
+  capabilities.reflinks = pu::reflinkFile(source_file, dest_file);
+  sfs::remove(dest_file, error);
+
+  capabilities.copy_file_range = pu::copyFileRange(source_file, dest_file);
+  sfs::remove(dest_file, error);
+
+  sfs::create_symlink(source_file, dest_file, error);
+  capabilities.sym_links = !error;
+  if(error)
+    capabilities.sym_link_error = get_message("create sym link", error);
+  sfs::remove(dest_file, error);
+
+  sfs::copy_file(source_file, dest_file, error);
+  capabilities.dest_writable = !error;
+  if(error)
+    capabilities.copy_error = get_message("copy file", error);
+  if(capabilities.dest_writable)
+  {
+    std::string upper_case_name = DEST_TEST_FILE_NAME;
+    for(char& c : upper_case_name)
+      c = std::toupper(c);
+    capabilities.case_folding = pu::exists(dest / upper_case_name);
+  }
+  sfs::remove(dest_file, error);
+  sfs::remove(source_file, error);
+  return capabilities;
+}
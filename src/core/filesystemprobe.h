@@ -0,0 +1,98 @@
+/*!
+ * \file filesystemprobe.h
+ * \brief Header for the FilesystemProbe class.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+
+
+/*!
+ * \brief Describes which operations are supported when deploying files from a source
+ * directory to a destination directory.
+ */
+struct FilesystemCapabilities
+{
+  /*! \brief True if files can be created in the source directory. */
+  bool source_writable = false;
+  /*! \brief True if files can be created in the destination directory. */
+  bool dest_writable = false;
+  /*! \brief True if both directories are located on the same device. */
+  bool same_device = false;
+  /*! \brief True if hard links from source to destination can be created. */
+  bool hard_links = false;
+  /*! \brief True if sym links from source to destination can be created. */
+  bool sym_links = false;
+  /*! \brief True if files can be copied as reflinks, which share their data blocks. */
+  bool reflinks = false;
+  /*! \brief True if files can be copied using copy_file_range. */
+  bool copy_file_range = false;
+  /*! \brief True if file names in the destination directory are case insensitive. */
+  bool case_folding = false;
+  /*! \brief Error message if writing to the source directory failed. */
+  std::string write_error = "";
+  /*! \brief Error message if creating a hard link failed. */
+  std::string hard_link_error = "";
+  /*! \brief Error message if creating a sym link failed. */
+  std::string sym_link_error = "";
+  /*! \brief Error message if copying a file failed. */
+  std::string copy_error = "";
+};
+
+/*!
+ * \brief Detects the capabilities of pairs of source and destination directories by
+ * creating test files. Results for which both directories were writable are cached for the
+ * lifetime of the process.
+ */
+class FilesystemProbe
+{
+public:
+  /*! \brief Name of the file used for testing. */
+  inline static const std::string TEST_FILE_NAME = "_lmm_write_test_file_";
+  /*! \brief Name of the files created in the destination directory during testing. */
+  inline static const std::string DEST_TEST_FILE_NAME = "_lmm_link_test_file_";
+
+  /*!
+   * \brief Detects the capabilities of the given directories.
+   * \param source Source directory, e.g. a staging directory.
+   * \param dest Destination directory, e.g. a deployers target directory.
+   * \param use_cache If true: Return a previous result for the same directories, if one exists.
+   * \return The detected capabilities.
+   */
+  static FilesystemCapabilities probe(const std::filesystem::path& source,
+                                      const std::filesystem::path& dest,
+                                      bool use_cache = true);
+  /*! \brief Removes all cached results. */
+  static void clearCache();
+  /*!
+   * \brief Copies the given file using the fastest method supported by the given capabilities.
+   * Tries reflinks, then copy_file_range and finally falls back to a regular copy.
+   * \param source File to copy.
+   * \param destination Path to the new file. Must not exist.
+   * \param capabilities Capabilities of the source and destination directories.
+   */
+  static void copyFile(const std::filesystem::path& source,
+                       const std::filesystem::path& destination,
+                       const FilesystemCapabilities& capabilities);
+
+private:
+  /*! \brief Maps pairs of source and destination directories to their capabilities. */
+  inline static std::map<std::pair<std::filesystem::path, std::filesystem::path>,
+                         FilesystemCapabilities>
+    cache_;
+  /*! \brief Synchronizes access to \ref cache_. */
+  inline static std::mutex cache_mutex_;
+
+  /*!
+   * \brief Detects the capabilities of the given directories without using the cache.
+   * \param source Source directory.
+   * \param dest Destination directory.
+   * \return The detected capabilities.
+   */
+  static FilesystemCapabilities runProbe(const std::filesystem::path& source,
+                                         const std::filesystem::path& dest);
+};
@@ -69,6 +69,11 @@ struct ImportModInfo
   std::filesystem::path target_path;
   /*! \brief Current location of the mod on disk. */
   std::filesystem::path current_path;
+  /*!
+   * \brief If not empty: The archive has already been extracted to this directory while it was
+   * being downloaded.
+   */
+  std::filesystem::path extracted_path;
   /*! \brief Time at which this object was added to the queue. Used for sorting. */
   std::chrono::time_point<std::chrono::high_resolution_clock> queue_time =
     std::chrono::high_resolution_clock::now();
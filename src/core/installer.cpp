@@ -1,9 +1,12 @@
 #include "installer.h"
+#include "cancellationerror.h"
 #include "compressionerror.h"
+#include "lspakwriter.h"
 #include "pathutils.h"
 #include <archive.h>
 #include <archive_entry.h>
 #include <filesystem>
+#include <format>
 #include <ranges>
 #include <regex>
 #define _UNIX
@@ -48,14 +51,90 @@ void Installer::extract(const sfs::path& source_path,
     else
       throw error;
   }
-  for(const auto& dir_entry : sfs::recursive_directory_iterator(dest_path))
+  setExtractedFilePermissions(dest_path);
+}
+
+bool Installer::supportsStreamExtraction(const sfs::path& file_name)
+{
+  std::string name = file_name.filename().string();
+  std::transform(
+    name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+  const std::vector<std::string> extensions{ ".zip",     ".tar",     ".tar.gz", ".tgz",
+                                             ".tar.bz2", ".tbz2",    ".tar.xz", ".txz",
+                                             ".tar.zst", ".tar.lz4" };
+  return std::ranges::any_of(extensions,
+                             [&name](const auto& ext) { return name.ends_with(ext); });
+}
+
+void Installer::extractFromStream(int source_fd, const sfs::path& dest_path)
+{
+  log(Log::LOG_DEBUG, "Beginning extraction from stream");
+
+  constexpr int buffer_size = 65536;
+  if(!sfs::exists(dest_path))
+    sfs::create_directories(dest_path);
+  struct archive* source = archive_read_new();
+  archive_read_support_format_zip_streamable(source);
+  archive_read_support_format_tar(source);
+  archive_read_support_format_gnutar(source);
+  archive_read_support_filter_all(source);
+  struct archive* dest = archive_write_disk_new();
+  // This may run in parallel to other operations, so paths are prefixed with the destination
+  // instead of changing the working directory
+  archive_write_disk_set_options(dest,
+                                 ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_SECURE_NODOTDOT |
+                                   ARCHIVE_EXTRACT_SECURE_SYMLINKS);
+  archive_write_disk_set_standard_lookup(dest);
+  auto free_archives = [source, dest]()
   {
-    auto permissions = sfs::perms::owner_read | sfs::perms::owner_write | sfs::perms::group_read |
-                       sfs::perms::group_write | sfs::perms::others_read;
-    if(dir_entry.is_directory())
-      permissions |= sfs::perms::owner_exec | sfs::perms::group_exec | sfs::perms::others_exec;
-    sfs::permissions(dir_entry.path(), permissions);
+    archive_read_close(source);
+    archive_read_free(source);
+    archive_write_close(dest);
+    archive_write_free(dest);
+  };
+  if(archive_read_open_fd(source, source_fd, buffer_size) != ARCHIVE_OK)
+  {
+    free_archives();
+    throw CompressionError("Could not open archive stream.");
+  }
+
+  struct archive_entry* entry;
+  while(true)
+  {
+    int return_code = archive_read_next_header(source, &entry);
+    if(return_code == ARCHIVE_EOF)
+      break;
+    if(return_code < ARCHIVE_OK)
+    {
+      free_archives();
+      throwCompressionError(source);
+    }
+    archive_entry_set_pathname(entry, (dest_path / archive_entry_pathname(entry)).c_str());
+    const char* link_target = archive_entry_hardlink(entry);
+    if(link_target)
+      archive_entry_set_hardlink(entry, (dest_path / link_target).c_str());
+    if(archive_write_header(dest, entry) < ARCHIVE_OK)
+    {
+      free_archives();
+      throwCompressionError(dest);
+    }
+    try
+    {
+      copyArchive(source, dest);
+    }
+    catch(CompressionError& error)
+    {
+      free_archives();
+      throw error;
+    }
+    if(archive_write_finish_entry(dest) < ARCHIVE_OK)
+    {
+      free_archives();
+      throwCompressionError(dest);
+    }
   }
+  free_archives();
+  setExtractedFilePermissions(dest_path);
 }
 
 unsigned long Installer::install(const sfs::path& source,
@@ -197,6 +276,18 @@ unsigned long Installer::install(const sfs::path& source,
       throw error;
     }
   }
+  if(options & pack_bg3_pak)
+  {
+    try
+    {
+      packBg3Mod(destination);
+    }
+    catch(std::runtime_error& error)
+    {
+      sfs::remove_all(destination);
+      throw;
+    }
+  }
   unsigned long size = 0;
   for(const auto& dir_entry : sfs::recursive_directory_iterator(destination))
     if(dir_entry.is_regular_file())
@@ -331,7 +422,8 @@ void Installer::extractWithProgress(const sfs::path& source_path,
   }
   catch(std::filesystem::filesystem_error& error)
   {}
-  if(!sfs::exists(dest_path))
+  const bool dest_existed = sfs::exists(dest_path);
+  if(!dest_existed)
     sfs::create_directories(dest_path);
   sfs::current_path(dest_path);
   source = archive_read_new();
@@ -408,6 +500,17 @@ void Installer::extractWithProgress(const sfs::path& source_path,
       }
       if(progress_node)
         (*progress_node)->advance(size);
+      if(progress_node && (*progress_node)->isCanceled())
+      {
+        archive_read_close(source);
+        archive_read_free(source);
+        archive_write_close(dest);
+        archive_write_free(dest);
+        sfs::current_path(working_dir);
+        if(!dest_existed)
+          sfs::remove_all(dest_path);
+        throw CancellationError();
+      }
     }
     if(archive_write_finish_entry(dest) < ARCHIVE_OK)
     {
@@ -422,6 +525,18 @@ void Installer::extractWithProgress(const sfs::path& source_path,
   sfs::current_path(working_dir);
 }
 
+void Installer::setExtractedFilePermissions(const sfs::path& dest_path)
+{
+  for(const auto& dir_entry : sfs::recursive_directory_iterator(dest_path))
+  {
+    auto permissions = sfs::perms::owner_read | sfs::perms::owner_write | sfs::perms::group_read |
+                       sfs::perms::group_write | sfs::perms::others_read;
+    if(dir_entry.is_directory())
+      permissions |= sfs::perms::owner_exec | sfs::perms::group_exec | sfs::perms::others_exec;
+    sfs::permissions(dir_entry.path(), permissions);
+  }
+}
+
 void Installer::extractRarArchive(const sfs::path& source_path, const sfs::path& dest_path)
 {
   log(Log::LOG_DEBUG, "Using fallback rar extraction");
@@ -453,3 +568,60 @@ void Installer::extractRarArchive(const sfs::path& source_path, const sfs::path&
     throw CompressionError("Failed to extract RAR archive.");
   RARCloseArchive(hArcData);
 }
+
+void Installer::packBg3Mod(const sfs::path& mod_path)
+{
+  // the Mods directory may have been renamed by case conversion options
+  const std::vector<std::string> pak_directories{ "generated", "localization", "mods", "public" };
+  sfs::path meta_dir;
+  for(const auto& dir_entry : sfs::directory_iterator(mod_path))
+  {
+    const std::string name = pu::toLowerCase(dir_entry.path().filename());
+    if(!dir_entry.is_directory() ||
+       std::ranges::find(pak_directories, name) == pak_directories.end())
+    {
+      // files outside of a pak, e.g. Script Extender binaries, must stay loose
+      log(Log::LOG_WARNING,
+          std::format("Could not pack '{}': '{}' can not be part of a .pak archive.",
+                      mod_path.string(),
+                      dir_entry.path().filename().string()));
+      return;
+    }
+    if(name != "mods")
+      continue;
+    for(const auto& mod_dir : sfs::directory_iterator(dir_entry.path()))
+    {
+      if(mod_dir.is_directory() &&
+         (pu::exists(mod_dir.path() / "meta.lsx") || pu::exists(mod_dir.path() / "META.LSX")))
+      {
+        meta_dir = mod_dir.path();
+        break;
+      }
+    }
+  }
+  if(meta_dir.empty())
+  {
+    log(Log::LOG_WARNING,
+        std::format("Could not pack '{}': No Mods/<name>/meta.lsx file found.", mod_path.string()));
+    return;
+  }
+
+  const std::string pak_name = meta_dir.filename().string() + ".pak";
+  const sfs::path tmp_pak_path =
+    mod_path.parent_path() / (mod_path.filename().string() + "." + MOVE_EXTENSION + ".pak");
+  LsPakWriter writer(tmp_pak_path);
+  writer.addDirectory(mod_path);
+  writer.write();
+  try
+  {
+    sfs::remove_all(mod_path);
+    sfs::create_directories(mod_path);
+    sfs::rename(tmp_pak_path, mod_path / pak_name);
+  }
+  catch(sfs::filesystem_error& error)
+  {
+    sfs::remove(tmp_pak_path);
+    throw error;
+  }
+  log(Log::LOG_INFO, std::format("Packed '{}' into '{}'.", mod_path.string(), pak_name));
+}
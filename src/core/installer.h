@@ -27,12 +27,15 @@ public:
     lower_case = 1 << 0,
     upper_case = 1 << 1,
     preserve_directories = 1 << 2,
-    single_directory = 1 << 3
+    single_directory = 1 << 3,
+    loose_files = 1 << 4,
+    pack_bg3_pak = 1 << 5
   };
   /*! \brief Every vector represents an exclusive group of flags. */
   inline static const std::vector<std::vector<Flag>> OPTION_GROUPS{
     { preserve_case, lower_case, upper_case },
-    { preserve_directories, single_directory }
+    { preserve_directories, single_directory },
+    { loose_files, pack_bg3_pak }
   };
   /*! \brief Maps installer flags to descriptive names. */
   inline static const std::map<Flag, std::string> OPTION_NAMES{
@@ -40,7 +43,9 @@ public:
     { lower_case, "Convert to lower case" },
     { upper_case, "Convert to upper case" },
     { preserve_directories, "Preserve directories" },
-    { single_directory, "Root directory only" }
+    { single_directory, "Root directory only" },
+    { loose_files, "Keep loose files" },
+    { pack_bg3_pak, "Pack into .pak (Baldurs Gate 3)" }
   };
   /*! \brief Maps installer flags to brief descriptions of what they do. */
   inline static const std::map<Flag, std::string> OPTION_DESCRIPTIONS{
@@ -48,7 +53,11 @@ public:
     { lower_case, "Convert file and directory names to lower case (FiLe -> file)" },
     { upper_case, "Convert file and directory names to upper case (FiLe -> FILE)" },
     { preserve_directories, "Do not alter directory structure" },
-    { single_directory, "Move files from all sub directories to the mods root directory" }
+    { single_directory, "Move files from all sub directories to the mods root directory" },
+    { loose_files, "Install files as they are" },
+    { pack_bg3_pak,
+      "Pack loose Baldurs Gate 3 mod files into a .pak archive, which the game loads faster. "
+      "Requires a Mods/<name>/meta.lsx file" }
   };
   /*! \brief Simply extracts files */
   inline static const std::string SIMPLEINSTALLER{ "Simple Installer" };
@@ -73,6 +82,21 @@ public:
   static void extract(const std::filesystem::path& source,
                       const std::filesystem::path& destination,
                       std::optional<ProgressNode*> progress_node = {});
+  /*!
+   * \brief Checks whether archives with the given file name can be extracted while being read
+   * sequentially, i.e. without seeking. This is true for zip and tar archives.
+   * \param file_name Name of the archive.
+   * \return True if the archive can be extracted from a stream.
+   */
+  static bool supportsStreamExtraction(const std::filesystem::path& file_name);
+  /*!
+   * \brief Extracts an archive which is read sequentially from the given file descriptor,
+   * e.g. a pipe or socket. Blocks until the stream is closed or an error occurs.
+   * \param source_fd File descriptor from which the archive is read.
+   * \param dest_path Destination directory for extraction.
+   * \throws CompressionError If the archive could not be extracted.
+   */
+  static void extractFromStream(int source_fd, const std::filesystem::path& dest_path);
   /*!
    * \brief Extracts the archive, performs any actions specified by the installer type,
    * then copies all files to given destination.
@@ -155,7 +179,10 @@ private:
    * extraction progress using the provided node.
    * \param source_path Path to the archive.
    * \param dest_path Destination directory for extraction.
-   * \param progress_node Used to inform about extraction progress.
+   * \param progress_node Used to inform about extraction progress and to check for
+   * cancellation.
+   * \throws CancellationError If extraction has been canceled. The destination directory is
+   * removed in this case, unless it existed before.
    */
   static void extractWithProgress(const std::filesystem::path& source_path,
                                   const std::filesystem::path& dest_path,
@@ -169,4 +196,17 @@ private:
    */
   static void extractRarArchive(const std::filesystem::path& source_path,
                                 const std::filesystem::path& dest_path);
+  /*!
+   * \brief Sets read and write permissions for all extracted files in the given directory.
+   * \param dest_path Directory containing extracted files.
+   */
+  static void setExtractedFilePermissions(const std::filesystem::path& dest_path);
+  /*!
+   * \brief Packs all files of a loose Baldurs Gate 3 mod into a .pak archive which replaces
+   * the loose files. The archive is named after the directory containing the mods meta.lsx.
+   * Mods without a Mods/<name>/meta.lsx file and mods containing anything other than the
+   * Generated, Localization, Mods and Public directories are not modified.
+   * \param mod_path Path to the installed mod.
+   */
+  static void packBg3Mod(const std::filesystem::path& mod_path);
 };
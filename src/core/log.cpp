@@ -1,27 +1,266 @@
 #include "log.h"
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <fstream>
-#include <iomanip>
+#include <condition_variable>
+#include <csignal>
+#include <ctime>
+#include <fcntl.h>
+#include <format>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
 
 namespace sfs = std::filesystem;
 
 inline constexpr std::string default_log_file_name = "limo_log";
 inline constexpr std::string default_log_file_extension = ".txt";
 
+
+/*!
+ * \brief Writes log messages to the log file in a background thread.
+ *
+ * Messages are passed to the writer through a bounded lock-free multi producer, single
+ * consumer ring buffer. The writer keeps the log file open and writes all pending messages
+ * in one batch, either periodically or immediately when requested.
+ */
+class LogWriter
+{
+public:
+  /*! \brief Number of messages which can be buffered. Must be a power of 2. */
+  static constexpr uint64_t CAPACITY = 4096;
+  /*! \brief Maximal time after which buffered messages are written. */
+  static constexpr std::chrono::milliseconds FLUSH_INTERVAL{ 200 };
+
+  LogWriter()
+  {
+    for(uint64_t i = 0; i < CAPACITY; i++)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  ~LogWriter()
+  {
+    if(writer_thread_.joinable())
+    {
+      writer_thread_.request_stop();
+      condition_.notify_all();
+      writer_thread_.join();
+    }
+    if(fd_ >= 0)
+      close(fd_);
+  }
+
+  /*!
+   * \brief Returns the writer used for all log files.
+   * \return The writer.
+   */
+  static LogWriter& instance()
+  {
+    static LogWriter writer;
+    return writer;
+  }
+
+  /*!
+   * \brief Adds the given message to the buffer. Blocks only when the buffer is full.
+   * \param message Message to write.
+   * \param write_now If true: Wake up the writer to write all buffered messages.
+   */
+  void push(std::string message, bool write_now)
+  {
+    std::call_once(start_flag_, [this]() { start(); });
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while(true)
+    {
+      slot = &slots_[pos & (CAPACITY - 1)];
+      const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      const int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+      if(diff == 0)
+      {
+        if(enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(diff < 0)
+      {
+        // buffer is full
+        condition_.notify_one();
+        std::this_thread::yield();
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+      else
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+    slot->message = std::move(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    if(write_now)
+      condition_.notify_one();
+  }
+
+  /*! \brief Blocks until all messages pushed before this call have been written. */
+  void flush()
+  {
+    std::call_once(start_flag_, [this]() { start(); });
+    const uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+    std::unique_lock lock(mutex_);
+    condition_.notify_one();
+    written_condition_.wait(lock, [this, target]() { return written_pos_ >= target; });
+  }
+
+  /*!
+   * \brief Writes all buffered messages and then changes the log file.
+   * \param path Path to the new log file.
+   */
+  void setFile(const sfs::path& path)
+  {
+    flush();
+    std::lock_guard lock(mutex_);
+    if(fd_ >= 0)
+      close(fd_);
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  }
+
+  /*!
+   * \brief Writes all buffered messages using only async signal safe functions.
+   * Used when the application crashes.
+   */
+  void emergencyFlush()
+  {
+    const int fd = fd_;
+    if(fd < 0)
+      return;
+    uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while(true)
+    {
+      Slot& slot = slots_[pos & (CAPACITY - 1)];
+      if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        break;
+      ::write(fd, slot.message.data(), slot.message.size());
+      ::write(fd, "\n", 1);
+      pos++;
+    }
+  }
+
+private:
+  /*! \brief One entry in the ring buffer. */
+  struct Slot
+  {
+    /*! \brief Used to synchronize producers and the consumer. */
+    std::atomic<uint64_t> sequence;
+    /*! \brief The message. */
+    std::string message;
+  };
+
+  /*! \brief The ring buffer. */
+  std::array<Slot, CAPACITY> slots_;
+  /*! \brief Position at which the next message will be inserted. */
+  alignas(64) std::atomic<uint64_t> enqueue_pos_ = 0;
+  /*! \brief Position of the next message to be written. */
+  alignas(64) std::atomic<uint64_t> dequeue_pos_ = 0;
+  /*! \brief Number of messages which have been written. Guarded by \ref mutex_. */
+  uint64_t written_pos_ = 0;
+  /*! \brief Descriptor of the current log file. Guarded by \ref mutex_. */
+  int fd_ = -1;
+  /*! \brief Guards the log file. */
+  std::mutex mutex_;
+  /*! \brief Used to wake up the writer thread. */
+  std::condition_variable_any condition_;
+  /*! \brief Notified after messages have been written. */
+  std::condition_variable written_condition_;
+  /*! \brief Used to start the writer thread once. */
+  std::once_flag start_flag_;
+  /*! \brief Thread writing buffered messages. */
+  std::jthread writer_thread_;
+
+  /*! \brief Starts the writer thread and installs handlers which flush the log on crashes. */
+  void start()
+  {
+    writer_thread_ = std::jthread([this](std::stop_token stop_token) { run(stop_token); });
+    for(int signal : { SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS })
+      std::signal(signal, onCrash);
+  }
+
+  /*!
+   * \brief Writes buffered messages until a stop is requested.
+   * \param stop_token Used to stop the thread.
+   */
+  void run(std::stop_token stop_token)
+  {
+    std::string batch;
+    std::unique_lock lock(mutex_);
+    while(true)
+    {
+      condition_.wait_for(lock, stop_token, FLUSH_INTERVAL, [this]() { return hasMessage(); });
+      batch.clear();
+      uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+      while(true)
+      {
+        Slot& slot = slots_[pos & (CAPACITY - 1)];
+        if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+          break;
+        batch += slot.message;
+        batch += "\n";
+        slot.message.clear();
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        pos++;
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+      }
+      uint64_t bytes_written = 0;
+      while(fd_ >= 0 && bytes_written < batch.size())
+      {
+        const ssize_t ret =
+          ::write(fd_, batch.data() + bytes_written, batch.size() - bytes_written);
+        if(ret <= 0)
+          break;
+        bytes_written += ret;
+      }
+      written_pos_ = pos;
+      written_condition_.notify_all();
+      if(stop_token.stop_requested() && !hasMessage())
+        return;
+    }
+  }
+
+  /*!
+   * \brief Checks if there is a message ready to be written.
+   * \return True if a message is ready.
+   */
+  bool hasMessage() const
+  {
+    const uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    return slots_[pos & (CAPACITY - 1)].sequence.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  /*!
+   * \brief Writes all buffered messages and then raises the given signal again using the
+   * default handler.
+   * \param signal The signal.
+   */
+  static void onCrash(int signal)
+  {
+    instance().emergencyFlush();
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+  }
+};
+
 std::string getTimestamp(Log::LogLevel log_level)
 {
   const auto now = std::chrono::system_clock::now();
-  auto cur_time = std::chrono::system_clock::to_time_t(now);
-  std::stringstream ss;
-  ss << std::put_time(std::localtime(&cur_time), "%F %T");
-  if(log_level == Log::LOG_DEBUG)
-    ss << "."
-       << std::chrono::time_point_cast<std::chrono::milliseconds>(now).time_since_epoch().count() %
-            1000;
-  return ss.str();
+  const auto cur_time = std::chrono::system_clock::to_time_t(now);
+  std::tm local_time;
+  localtime_r(&cur_time, &local_time);
+  char buffer[32];
+  const size_t length = std::strftime(buffer, sizeof(buffer), "%F %T", &local_time);
+  if(log_level != Log::LOG_DEBUG)
+    return std::string(buffer, length);
+  return std::format(
+    "{}.{:03}",
+    std::string_view(buffer, length),
+    std::chrono::time_point_cast<std::chrono::milliseconds>(now).time_since_epoch().count() %
+      1000);
 }
 
-void writeLog(const std::string& message, Log::LogLevel log_level, int target_printer = 0)
+void writeLog(std::string message, Log::LogLevel log_level, int target_printer = 0)
 {
   if(Log::log_level >= log_level && Log::log_printers.size() > target_printer)
     Log::log_printers[target_printer](message, log_level);
@@ -29,19 +268,7 @@ void writeLog(const std::string& message, Log::LogLevel log_level, int target_pr
   if(Log::log_file_path.empty())
     return;
 
-  try
-  {
-    std::ofstream fstream(Log::log_file_path, std::ios::app);
-    if(!fstream.is_open())
-      return;
-    fstream << message << "\n";
-    fstream.flush();
-  }
-  catch(...)
-  {
-    if(Log::log_printers.size() > target_printer)
-      Log::log_printers[target_printer]("Failed to write to log file!", Log::LOG_DEBUG);
-  }
+  LogWriter::instance().push(std::move(message), log_level == Log::LOG_ERROR);
 }
 
 std::string getOldLogFileName(int log_num)
@@ -132,9 +359,12 @@ void init(sfs::path log_dir_path)
         sfs::rename(cur_file, prev_file);
     }
 
-    log_file_path = log_dir_path / (default_log_file_name + default_log_file_extension);
-    if(sfs::exists(log_file_path))
-      sfs::rename(log_file_path, log_dir_path / getLogFileName(0));
+    const sfs::path new_log_file_path =
+      log_dir_path / (default_log_file_name + default_log_file_extension);
+    if(sfs::exists(new_log_file_path))
+      sfs::rename(new_log_file_path, log_dir_path / getLogFileName(0));
+    LogWriter::instance().setFile(new_log_file_path);
+    log_file_path = new_log_file_path;
   }
   catch(...)
   {
@@ -143,4 +373,9 @@ void init(sfs::path log_dir_path)
   }
 }
 
+void flush()
+{
+  LogWriter::instance().flush();
+}
+
 }
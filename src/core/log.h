@@ -74,4 +74,11 @@ void error(const std::string& message, int target_printer = 0);
  * \param target_printer Log printer to use for output.
  */
 void log(LogLevel level, const std::string& message, int target_printer = 0);
+/*!
+ * \brief Blocks until all messages logged so far have been written to the log file.
+ *
+ * Log files are written asynchronously by a background thread, which writes messages in
+ * batches. Errors are written immediately.
+ */
+void flush();
 }
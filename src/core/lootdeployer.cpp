@@ -169,7 +169,10 @@ void LootDeployer::sortModsByConflicts(std::optional<ProgressNode*> progress_nod
   }
   updateMasterList();
   if(progress_node)
+  {
     (*progress_node)->child(0).advance();
+    (*progress_node)->checkCanceled();
+  }
 
   sfs::path master_list_path = dest_path_ / "masterlist.yaml";
   if(!sfs::exists(master_list_path))
@@ -188,7 +191,10 @@ void LootDeployer::sortModsByConflicts(std::optional<ProgressNode*> progress_nod
     prelude_path = "";
   loot_handle->GetDatabase().LoadLists(master_list_path, user_list_path, prelude_path);
   if(progress_node)
+  {
     (*progress_node)->child(1).advance();
+    (*progress_node)->checkCanceled();
+  }
 
   std::vector<sfs::path> plugin_paths;
   std::vector<std::string> plugin_file_names;
@@ -202,7 +208,10 @@ void LootDeployer::sortModsByConflicts(std::optional<ProgressNode*> progress_nod
   loot_handle->LoadPlugins(plugin_paths, false);
   auto sorted_plugins = loot_handle->SortPlugins(plugin_file_names);
   if(progress_node)
+  {
     (*progress_node)->child(2).advance();
+    (*progress_node)->checkCanceled();
+  }
 
   std::vector<std::pair<std::string, bool>> new_plugins;
   new_plugins.reserve(plugins_.size());
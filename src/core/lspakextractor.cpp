@@ -1,13 +1,26 @@
 #include "lspakextractor.h"
+#include "atomicprogressnode.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
 #include <format>
 #include <fstream>
 #include <iostream>
 #include <lz4.h>
+#include <map>
+#include <ranges>
+#include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 #include <zstd.h>
 #include <zlib.h>
 
 namespace sfs = std::filesystem;
+namespace str = std::ranges;
 
 
 LsPakExtractor::LsPakExtractor(const sfs::path& source_path) : source_path_(source_path) {}
@@ -43,7 +56,8 @@ std::string LsPakExtractor::extractData(unsigned long offset,
 {
   // this is used to extract xml files; they should never exceed 1GiB
   if(uncompressed_size > 1 << 30)
-    throw std::runtime_error(std::format("Uncompressed file size is too large: {}B.", uncompressed_size));
+    throw std::runtime_error(
+      std::format("Uncompressed file size is too large: {}B.", uncompressed_size));
 
   std::ifstream file(source_path_, std::ios::binary);
   std::vector<char> input_buffer(length);
@@ -52,26 +66,44 @@ std::string LsPakExtractor::extractData(unsigned long offset,
 
   if(compression_type == COMPRESSION_NONE)
     return { input_buffer.data(), length };
+  std::string output(uncompressed_size, '\0');
+  decompress(
+    input_buffer.data(), length, output.data(), uncompressed_size, compression_type, false);
+  return output;
+}
+
+void LsPakExtractor::decompress(const char* input,
+                                size_t length,
+                                char* output,
+                                size_t output_size,
+                                int compression_type,
+                                bool strict)
+{
+  if(compression_type == COMPRESSION_NONE)
+    std::memcpy(output, input, std::min(length, output_size));
   else if(compression_type == COMPRESSION_LZ4)
   {
-    std::vector<char> output_buffer(uncompressed_size);
-    int ret_code = LZ4_decompress_safe_partial(
-      input_buffer.data(), output_buffer.data(), length, uncompressed_size, uncompressed_size);
+    const int ret_code =
+      strict ? LZ4_decompress_safe(input, output, length, output_size)
+             : LZ4_decompress_safe_partial(input, output, length, output_size, output_size);
     if(ret_code < 0)
       throw std::runtime_error(std::format("LZ4 decompression failed with code: {}", ret_code));
-
-    return { output_buffer.data(), uncompressed_size };
+    if(strict && static_cast<size_t>(ret_code) != output_size)
+      throw std::runtime_error(std::format(
+        "LZ4 decompression produced {} bytes, expected {}.", ret_code, output_size));
   }
   else if(compression_type == COMPRESSION_ZSTD)
   {
-    std::vector<char> output_buffer(uncompressed_size);
-    const size_t actual_size = ZSTD_decompress(reinterpret_cast<void*>(output_buffer.data()),
-                                               uncompressed_size,
-                                               reinterpret_cast<const void*>(input_buffer.data()),
-                                               input_buffer.size());
+    const size_t actual_size = ZSTD_decompress(reinterpret_cast<void*>(output),
+                                               output_size,
+                                               reinterpret_cast<const void*>(input),
+                                               length);
     if(ZSTD_isError(actual_size))
-      throw std::runtime_error(std::format("zstd decompression failed with code: {}", actual_size));
-    return { output_buffer.data(), uncompressed_size };
+      throw std::runtime_error(
+        std::format("zstd decompression failed: {}", ZSTD_getErrorName(actual_size)));
+    if(strict && actual_size != output_size)
+      throw std::runtime_error(std::format(
+        "zstd decompression produced {} bytes, expected {}.", actual_size, output_size));
   }
   else if(compression_type == COMPRESSION_ZLIB)
   {
@@ -79,20 +111,22 @@ std::string LsPakExtractor::extractData(unsigned long offset,
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
     stream.opaque = Z_NULL;
-    if (inflateInit(&stream) != Z_OK)
+    stream.avail_in = 0;
+    stream.next_in = Z_NULL;
+    if(inflateInit(&stream) != Z_OK)
       throw std::runtime_error("zlib initialization failed.");
-    stream.avail_in = input_buffer.size();
-    stream.next_in = reinterpret_cast<Bytef*>(input_buffer.data());
-
-    std::vector<char> output_buffer(uncompressed_size);
-    stream.avail_out = uncompressed_size;
-    stream.next_out = reinterpret_cast<Bytef*>(output_buffer.data());
-    inflateInit(&stream);
-    int code = inflate(&stream, Z_NO_FLUSH);
+    stream.avail_in = length;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+    stream.avail_out = output_size;
+    stream.next_out = reinterpret_cast<Bytef*>(output);
+    int code = inflate(&stream, strict ? Z_FINISH : Z_NO_FLUSH);
+    const size_t actual_size = stream.total_out;
     inflateEnd(&stream);
-    if(code < 0)
+    if(strict ? code != Z_STREAM_END : code < 0)
       throw std::runtime_error(std::format("zlib decompression failed with code: {}", code));
-    return { output_buffer.data(), uncompressed_size };
+    if(strict && actual_size != output_size)
+      throw std::runtime_error(std::format(
+        "zlib decompression produced {} bytes, expected {}.", actual_size, output_size));
   }
   else
     throw std::runtime_error(std::format("Unsopported compression type: {}", compression_type));
@@ -130,3 +164,297 @@ unsigned int LsPakExtractor::readFileList()
     file_list_.push_back(*reinterpret_cast<LsPakFileListEntry*>(data.data() + i));
   return compressed_size;
 }
+
+std::vector<LsPakExtractor::FileInfo> LsPakExtractor::getFileInfos() const
+{
+  std::vector<FileInfo> infos;
+  infos.reserve(file_list_.size());
+  for(const auto& entry : file_list_)
+    infos.push_back({ getEntryPath(entry),
+                      getExtractedSize(entry),
+                      entry.compressed_size,
+                      static_cast<int>(entry.archive_part) });
+  return infos;
+}
+
+int LsPakExtractor::extractFiles(const sfs::path& dest_path,
+                                 const std::function<bool(const std::string&)>& filter,
+                                 std::optional<ProgressNode*> progress_node) const
+{
+  std::vector<int> file_ids;
+  std::vector<sfs::path> target_paths;
+  std::set<sfs::path> directories;
+  uint64_t total_size = 0;
+  for(const auto& [i, entry] : str::enumerate_view(file_list_))
+  {
+    const std::string path = getEntryPath(entry);
+    if(filter && !filter(path))
+      continue;
+    const sfs::path relative_path = sfs::path(path).lexically_normal();
+    if(relative_path.empty() || relative_path.is_absolute() || *relative_path.begin() == "..")
+      throw std::runtime_error(std::format("Invalid path in archive: '{}'.", path));
+    file_ids.push_back(i);
+    target_paths.push_back(dest_path / relative_path);
+    directories.insert(target_paths.back().parent_path());
+    total_size += getExtractedSize(entry);
+  }
+  if(progress_node)
+    (*progress_node)->setTotalSteps(std::max(total_size, static_cast<uint64_t>(1)));
+  if(file_ids.empty())
+    return 0;
+
+  const auto parts = mapParts(file_ids);
+  for(const auto& directory : directories)
+    sfs::create_directories(directory);
+
+  const int num_threads = std::clamp(
+    static_cast<int>(std::thread::hardware_concurrency()), 1, static_cast<int>(file_ids.size()));
+  std::atomic<int> next_file = 0;
+  std::atomic<bool> has_error = false;
+  std::string error_message;
+  std::optional<AtomicProgressNode> atomic_progress;
+  if(progress_node)
+  {
+    atomic_progress.emplace(**progress_node);
+    atomic_progress->startSampling();
+  }
+  auto extract_files = [&]()
+  {
+    for(int i = next_file++; i < file_ids.size() && !has_error; i = next_file++)
+    {
+      if(progress_node && (*progress_node)->isCanceled())
+        return;
+      const auto& entry = file_list_[file_ids[i]];
+      try
+      {
+        writeEntry(entry, parts, target_paths[i]);
+      }
+      catch(std::runtime_error& error)
+      {
+        if(!has_error.exchange(true))
+          error_message = error.what();
+      }
+      if(atomic_progress)
+        atomic_progress->advance(getExtractedSize(entry));
+    }
+  };
+  std::vector<std::jthread> threads;
+  for(int i = 1; i < num_threads; i++)
+    threads.emplace_back(extract_files);
+  extract_files();
+  for(auto& thread : threads)
+    thread.join();
+  if(atomic_progress)
+    atomic_progress->stopSampling();
+  if(has_error)
+    throw std::runtime_error(error_message);
+  if(progress_node)
+    (*progress_node)->checkCanceled();
+  return file_ids.size();
+}
+
+LsPakExtractor::ContentDiff LsPakExtractor::diff(const LsPakExtractor& other) const
+{
+  auto get_indices = [](const std::vector<LsPakFileListEntry>& file_list)
+  {
+    std::map<std::string, int> indices;
+    for(const auto& [i, entry] : str::enumerate_view(file_list))
+      indices[getEntryPath(entry)] = i;
+    return indices;
+  };
+  const auto indices = get_indices(file_list_);
+  const auto other_indices = get_indices(other.file_list_);
+
+  std::vector<int> file_ids;
+  std::vector<int> other_file_ids;
+  for(const auto& [path, index] : indices)
+  {
+    auto iter = other_indices.find(path);
+    if(iter != other_indices.end() &&
+       getExtractedSize(file_list_[index]) == getExtractedSize(other.file_list_[iter->second]))
+    {
+      file_ids.push_back(index);
+      other_file_ids.push_back(iter->second);
+    }
+  }
+  const auto parts = mapParts(file_ids);
+  const auto other_parts = other.mapParts(other_file_ids);
+
+  ContentDiff diff;
+  for(const auto& [path, index] : indices)
+  {
+    auto iter = other_indices.find(path);
+    if(iter == other_indices.end())
+    {
+      diff.removed.push_back(path);
+      continue;
+    }
+    const auto& entry = file_list_[index];
+    const auto& other_entry = other.file_list_[iter->second];
+    bool is_equal = getExtractedSize(entry) == getExtractedSize(other_entry);
+    if(is_equal && (entry.flags & COMPRESSION_MASK) == (other_entry.flags & COMPRESSION_MASK) &&
+       entry.compressed_size == other_entry.compressed_size)
+      is_equal = std::memcmp(getEntryData(entry, parts),
+                             other.getEntryData(other_entry, other_parts),
+                             entry.compressed_size) == 0;
+    else if(is_equal)
+      is_equal = readEntry(entry, parts) == other.readEntry(other_entry, other_parts);
+    (is_equal ? diff.unchanged : diff.changed).push_back(path);
+  }
+  for(const auto& [path, index] : other_indices)
+  {
+    if(!indices.contains(path))
+      diff.added.push_back(path);
+  }
+  return diff;
+}
+
+std::string LsPakExtractor::getEntryPath(const LsPakFileListEntry& entry)
+{
+  return std::string(entry.path, strnlen(entry.path, sizeof(entry.path)));
+}
+
+unsigned int LsPakExtractor::getExtractedSize(const LsPakFileListEntry& entry)
+{
+  if((entry.flags & COMPRESSION_MASK) == COMPRESSION_NONE)
+    return entry.compressed_size;
+  return entry.uncompressed_size;
+}
+
+sfs::path LsPakExtractor::getPartPath(int part) const
+{
+  if(part == 0)
+    return source_path_;
+  return source_path_.parent_path() /
+         std::format("{}_{}{}",
+                     source_path_.stem().string(),
+                     part,
+                     source_path_.extension().string());
+}
+
+std::vector<std::unique_ptr<LsPakExtractor::MappedPart>> LsPakExtractor::mapParts(
+  const std::vector<int>& file_ids) const
+{
+  std::vector<std::unique_ptr<MappedPart>> parts;
+  for(int file_id : file_ids)
+  {
+    const int part = file_list_[file_id].archive_part;
+    if(part >= parts.size())
+      parts.resize(part + 1);
+    if(!parts[part])
+    {
+      const sfs::path part_path = getPartPath(part);
+      if(!sfs::exists(part_path))
+        throw std::runtime_error(std::format("Archive part '{}' is missing.", part_path.string()));
+      parts[part] = std::make_unique<MappedPart>(part_path);
+    }
+  }
+  return parts;
+}
+
+const char* LsPakExtractor::getEntryData(
+  const LsPakFileListEntry& entry,
+  const std::vector<std::unique_ptr<MappedPart>>& parts) const
+{
+  const MappedPart& part = *parts[entry.archive_part];
+  const uint64_t offset = entry.offset;
+  if(offset + entry.compressed_size > part.size())
+    throw std::runtime_error(
+      std::format("File '{}' exceeds archive '{}'.",
+                  getEntryPath(entry),
+                  getPartPath(entry.archive_part).string()));
+  return part.data() + offset;
+}
+
+std::string LsPakExtractor::readEntry(const LsPakFileListEntry& entry,
+                                      const std::vector<std::unique_ptr<MappedPart>>& parts) const
+{
+  std::string data(getExtractedSize(entry), '\0');
+  decompress(getEntryData(entry, parts),
+             entry.compressed_size,
+             data.data(),
+             data.size(),
+             entry.flags & COMPRESSION_MASK);
+  return data;
+}
+
+void LsPakExtractor::writeEntry(const LsPakFileListEntry& entry,
+                                const std::vector<std::unique_ptr<MappedPart>>& parts,
+                                const sfs::path& dest_path) const
+{
+  const char* input = getEntryData(entry, parts);
+  const size_t size = getExtractedSize(entry);
+  const int fd = open(dest_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+    throw std::runtime_error(std::format("Failed to open '{}' for writing.", dest_path.string()));
+  if(size == 0)
+  {
+    close(fd);
+    return;
+  }
+  if(posix_fallocate(fd, 0, size) != 0 && ftruncate(fd, size) != 0)
+  {
+    close(fd);
+    throw std::runtime_error(
+      std::format("Failed to allocate {} bytes for '{}'.", size, dest_path.string()));
+  }
+  void* output = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(output == MAP_FAILED)
+    throw std::runtime_error(std::format("Failed to map '{}'.", dest_path.string()));
+  try
+  {
+    decompress(input,
+               entry.compressed_size,
+               static_cast<char*>(output),
+               size,
+               entry.flags & COMPRESSION_MASK);
+  }
+  catch(std::runtime_error& error)
+  {
+    munmap(output, size);
+    throw std::runtime_error(
+      std::format("Failed to extract '{}': {}", dest_path.string(), error.what()));
+  }
+  munmap(output, size);
+}
+
+LsPakExtractor::MappedPart::MappedPart(const sfs::path& path)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    throw std::runtime_error(std::format("Failed to open '{}'.", path.string()));
+  struct stat file_stat;
+  if(fstat(fd, &file_stat) != 0)
+  {
+    close(fd);
+    throw std::runtime_error(std::format("Failed to read '{}'.", path.string()));
+  }
+  size_ = file_stat.st_size;
+  if(size_ > 0)
+  {
+    data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data_ == MAP_FAILED)
+    {
+      close(fd);
+      throw std::runtime_error(std::format("Failed to map '{}'.", path.string()));
+    }
+  }
+  close(fd);
+}
+
+LsPakExtractor::MappedPart::~MappedPart()
+{
+  if(data_)
+    munmap(data_, size_);
+}
+
+const char* LsPakExtractor::MappedPart::data() const
+{
+  return static_cast<const char*>(data_);
+}
+
+size_t LsPakExtractor::MappedPart::size() const
+{
+  return size_;
+}
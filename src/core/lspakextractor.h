@@ -7,7 +7,12 @@
 
 #include "lspakfilelistentry.h"
 #include "lspakheader.h"
+#include "progressnode.h"
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 
@@ -17,6 +22,32 @@
 class LsPakExtractor
 {
 public:
+  /*! \brief Describes one file in the archive. */
+  struct FileInfo
+  {
+    /*! \brief Path of the file inside the archive. */
+    std::string path;
+    /*! \brief Size of the extracted file. */
+    unsigned int size;
+    /*! \brief Size of the file inside the archive. */
+    unsigned int compressed_size;
+    /*! \brief Index of the archive part containing the file. */
+    int archive_part;
+  };
+
+  /*! \brief Difference between the contents of two archives, all lists are sorted by path. */
+  struct ContentDiff
+  {
+    /*! \brief Files only contained in the other archive. */
+    std::vector<std::string> added;
+    /*! \brief Files only contained in this archive. */
+    std::vector<std::string> removed;
+    /*! \brief Files contained in both archives with different contents. */
+    std::vector<std::string> changed;
+    /*! \brief Files contained in both archives with identical contents. */
+    std::vector<std::string> unchanged;
+  };
+
   /*!
    * \brief Sets the archive path to the given path.
    * \param source_path Target archive path.
@@ -36,6 +67,35 @@ public:
    * \return The uncompressed file as a string.
    */
   std::string extractFile(int file_id);
+  /*!
+   * \brief Returns information about every file in the archive.
+   * \return One entry per file, in archive order.
+   */
+  std::vector<FileInfo> getFileInfos() const;
+  /*!
+   * \brief Extracts all files accepted by the given filter to the given directory.
+   * Files are decompressed in parallel from memory mapped archive parts directly into
+   * preallocated output files. Parts of multi-part archives are expected next to the
+   * source archive, named like "Name_1.pak".
+   * \param dest_path Target directory. Paths inside the archive are relative to this.
+   * \param filter Called with the path of every file in the archive. Only files for
+   * which this returns true are extracted. If empty: Extract all files.
+   * \param progress_node Used to inform about the current progress.
+   * \return The number of extracted files.
+   * \throw std::runtime_error If a path inside the archive points outside of the target
+   * directory, an archive part is missing or a file could not be extracted.
+   */
+  int extractFiles(const std::filesystem::path& dest_path,
+                   const std::function<bool(const std::string&)>& filter = {},
+                   std::optional<ProgressNode*> progress_node = {}) const;
+  /*!
+   * \brief Compares the contents of this archive to those of another archive.
+   * Files of equal size are compared byte by byte, decompressing them only if they use
+   * different compression settings.
+   * \param other The other archive, must be initialized.
+   * \return The difference from this archive to the other.
+   */
+  ContentDiff diff(const LsPakExtractor& other) const;
 
 private:
   /*! \brief Mask used to get compression type from file list entry flags. */
@@ -52,6 +112,39 @@ private:
   static constexpr unsigned int LS_PAK_MAGIC_HEADER_NUMBER = 0x4b50534c;
   /*! \brief Currently the only supported archive format version. */
   static constexpr unsigned int LS_PAK_SUPPORTED_VERSION = 18;
+  /*! \brief Read only memory mapping of one archive part. */
+  class MappedPart
+  {
+  public:
+    /*!
+     * \brief Maps the given file into memory.
+     * \param path Path to the file.
+     * \throw std::runtime_error If the file could not be mapped.
+     */
+    MappedPart(const std::filesystem::path& path);
+    MappedPart(const MappedPart&) = delete;
+    MappedPart& operator=(const MappedPart&) = delete;
+    /*! \brief Unmaps the file. */
+    ~MappedPart();
+
+    /*!
+     * \brief Returns a pointer to the mapped data.
+     * \return The pointer.
+     */
+    const char* data() const;
+    /*!
+     * \brief Returns the size of the mapped file.
+     * \return The size.
+     */
+    size_t size() const;
+
+  private:
+    /*! \brief Start of the mapped data. */
+    void* data_ = nullptr;
+    /*! \brief Size of the mapped file. */
+    size_t size_ = 0;
+  };
+
   /*! \brief Path to the source archive. */
   std::filesystem::path source_path_;
   /*! \brief Contains the archive's header. */
@@ -76,4 +169,71 @@ private:
    * \return The compressed size of the file list.
    */
   unsigned int readFileList();
+  /*!
+   * \brief Decompresses the given data into the given buffer.
+   * \param input Data to decompress.
+   * \param length Size of the input data.
+   * \param output Target buffer, must be able to hold output_size bytes.
+   * \param output_size Size of the uncompressed data.
+   * \param compression_type Compression type used.
+   * \param strict If true: Throw if the data does not decompress to exactly output_size bytes.
+   * Otherwise, only decompression errors are reported.
+   */
+  static void decompress(const char* input,
+                         size_t length,
+                         char* output,
+                         size_t output_size,
+                         int compression_type,
+                         bool strict = true);
+  /*!
+   * \brief Returns the path of the given file list entry.
+   * \param entry Target entry.
+   * \return The path.
+   */
+  static std::string getEntryPath(const LsPakFileListEntry& entry);
+  /*!
+   * \brief Returns the size of the given file after extraction. Uncompressed files store
+   * no separate uncompressed size.
+   * \param entry Target entry.
+   * \return The size.
+   */
+  static unsigned int getExtractedSize(const LsPakFileListEntry& entry);
+  /*!
+   * \brief Returns the path to the given part of the source archive.
+   * \param part Index of the part.
+   * \return The path.
+   */
+  std::filesystem::path getPartPath(int part) const;
+  /*!
+   * \brief Maps all archive parts containing at least one of the given files into memory.
+   * \param file_ids Indices of files in file_list_.
+   * \return One entry per archive part, parts containing none of the files are empty.
+   */
+  std::vector<std::unique_ptr<MappedPart>> mapParts(const std::vector<int>& file_ids) const;
+  /*!
+   * \brief Returns the data of the given file inside its mapped archive part.
+   * \param entry Target file.
+   * \param parts Mapped archive parts.
+   * \return Pointer to the start of the stored data.
+   * \throw std::runtime_error If the file exceeds its archive part.
+   */
+  const char* getEntryData(const LsPakFileListEntry& entry,
+                           const std::vector<std::unique_ptr<MappedPart>>& parts) const;
+  /*!
+   * \brief Decompresses the given file into a string.
+   * \param entry Target file.
+   * \param parts Mapped archive parts.
+   * \return The file contents.
+   */
+  std::string readEntry(const LsPakFileListEntry& entry,
+                        const std::vector<std::unique_ptr<MappedPart>>& parts) const;
+  /*!
+   * \brief Decompresses the given file into a preallocated, memory mapped output file.
+   * \param entry Target file.
+   * \param parts Mapped archive parts.
+   * \param dest_path Path to the output file.
+   */
+  void writeEntry(const LsPakFileListEntry& entry,
+                  const std::vector<std::unique_ptr<MappedPart>>& parts,
+                  const std::filesystem::path& dest_path) const;
 };
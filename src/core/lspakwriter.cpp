@@ -0,0 +1,242 @@
+#include "lspakwriter.h"
+#include "atomicprogressnode.h"
+#include "cancellationerror.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <lz4.h>
+#include <thread>
+#include <zstd.h>
+
+namespace sfs = std::filesystem;
+
+
+LsPakWriter::LsPakWriter(const sfs::path& dest_path, Compression compression) :
+  dest_path_(dest_path), compression_(compression)
+{}
+
+void LsPakWriter::addFile(const sfs::path& source_path, const std::string& archive_path)
+{
+  if(archive_path.size() >= sizeof(LsPakFileListEntry::path))
+    throw std::runtime_error(
+      std::format("Path is too long for .pak archives: '{}'.", archive_path));
+  files_.emplace_back(source_path, archive_path);
+}
+
+void LsPakWriter::addDirectory(const sfs::path& source_path)
+{
+  std::vector<std::pair<sfs::path, std::string>> files;
+  for(const auto& dir_entry : sfs::recursive_directory_iterator(source_path))
+  {
+    if(dir_entry.is_regular_file())
+      files.emplace_back(dir_entry.path(),
+                         dir_entry.path().lexically_relative(source_path).generic_string());
+  }
+  // sort files to make the resulting archive independent of directory iteration order
+  std::ranges::sort(files, [](const auto& a, const auto& b) { return a.second < b.second; });
+  for(const auto& [path, archive_path] : files)
+    addFile(path, archive_path);
+}
+
+void LsPakWriter::write(std::optional<ProgressNode*> progress_node) const
+{
+  try
+  {
+    writeArchive(progress_node);
+  }
+  catch(CancellationError& error)
+  {
+    sfs::remove(dest_path_);
+    throw;
+  }
+  catch(std::runtime_error& error)
+  {
+    sfs::remove(dest_path_);
+    throw;
+  }
+}
+
+void LsPakWriter::writeArchive(std::optional<ProgressNode*> progress_node) const
+{
+  std::vector<uint64_t> file_sizes;
+  file_sizes.reserve(files_.size());
+  for(const auto& [path, archive_path] : files_)
+  {
+    file_sizes.push_back(sfs::file_size(path));
+    if(file_sizes.back() > std::numeric_limits<uint32_t>::max())
+      throw std::runtime_error(
+        std::format("File is too large for .pak archives: '{}'.", path.string()));
+  }
+  if(progress_node)
+    (*progress_node)->setTotalSteps(std::max(files_.size(), static_cast<size_t>(1)));
+  std::optional<AtomicProgressNode> atomic_progress;
+  if(progress_node)
+  {
+    atomic_progress.emplace(**progress_node);
+    atomic_progress->startSampling();
+  }
+
+  std::ofstream file(dest_path_, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Could not write to '{}'.", dest_path_.string()));
+  LsPakHeader header{};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(LsPakHeader));
+  uint64_t offset = sizeof(LsPakHeader);
+
+  std::vector<LsPakFileListEntry> file_list(files_.size());
+  std::memset(file_list.data(), 0, file_list.size() * sizeof(LsPakFileListEntry));
+  // files are compressed in batches of limited size, so not all data has to be kept in memory
+  for(size_t batch_start = 0; batch_start < files_.size();)
+  {
+    size_t batch_end = batch_start;
+    uint64_t batch_size = 0;
+    while(batch_end < files_.size() &&
+          (batch_end == batch_start || batch_size + file_sizes[batch_end] <= MAX_BATCH_SIZE))
+      batch_size += file_sizes[batch_end++];
+
+    std::vector<std::string> data(batch_end - batch_start);
+    std::vector<Compression> compression(batch_end - batch_start, none);
+    const int num_threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()),
+                                       1,
+                                       static_cast<int>(data.size()));
+    std::atomic<int> next_file = 0;
+    std::atomic<bool> has_error = false;
+    std::string error_message;
+    auto compress_files = [&]()
+    {
+      for(int i = next_file++; i < data.size() && !has_error; i = next_file++)
+      {
+        if(progress_node && (*progress_node)->isCanceled())
+          return;
+        const sfs::path& path = files_[batch_start + i].first;
+        std::ifstream in_file(path, std::ios::binary);
+        std::string raw_data(file_sizes[batch_start + i], '\0');
+        in_file.read(raw_data.data(), raw_data.size());
+        if(!in_file)
+        {
+          if(!has_error.exchange(true))
+            error_message = std::format("Could not read '{}'.", path.string());
+          return;
+        }
+        if(compression_ != none && !raw_data.empty())
+        {
+          try
+          {
+            std::string compressed_data = compress(raw_data, compression_);
+            if(compressed_data.size() < raw_data.size())
+            {
+              data[i] = std::move(compressed_data);
+              compression[i] = compression_;
+              if(atomic_progress)
+                atomic_progress->advance();
+              continue;
+            }
+          }
+          catch(std::runtime_error& error)
+          {
+            if(!has_error.exchange(true))
+              error_message = error.what();
+            return;
+          }
+        }
+        data[i] = std::move(raw_data);
+        if(atomic_progress)
+          atomic_progress->advance();
+      }
+    };
+    std::vector<std::jthread> threads;
+    for(int i = 1; i < num_threads; i++)
+      threads.emplace_back(compress_files);
+    compress_files();
+    for(auto& thread : threads)
+      thread.join();
+    if(has_error)
+      throw std::runtime_error(error_message);
+    if(progress_node)
+      (*progress_node)->checkCanceled();
+
+    for(int i = 0; i < data.size(); i++)
+    {
+      auto& entry = file_list[batch_start + i];
+      const std::string& archive_path = files_[batch_start + i].second;
+      std::memcpy(entry.path, archive_path.data(), archive_path.size());
+      entry.offset = offset;
+      entry.archive_part = 0;
+      entry.compressed_size = data[i].size();
+      // uncompressed files store no separate uncompressed size
+      if(compression[i] == none)
+      {
+        entry.flags = none;
+        entry.uncompressed_size = 0;
+      }
+      else
+      {
+        entry.flags = compression[i] | DEFAULT_COMPRESSION_LEVEL_FLAG;
+        entry.uncompressed_size = file_sizes[batch_start + i];
+      }
+      file.write(data[i].data(), data[i].size());
+      offset += data[i].size();
+    }
+    batch_start = batch_end;
+  }
+  if(atomic_progress)
+    atomic_progress->stopSampling();
+
+  const int file_list_size = file_list.size() * sizeof(LsPakFileListEntry);
+  std::string compressed_file_list(LZ4_compressBound(file_list_size), '\0');
+  const int compressed_size = LZ4_compress_default(reinterpret_cast<const char*>(file_list.data()),
+                                                   compressed_file_list.data(),
+                                                   file_list_size,
+                                                   compressed_file_list.size());
+  if(compressed_size <= 0)
+    throw std::runtime_error("Failed to compress the file list.");
+  const uint32_t num_files = file_list.size();
+  const uint32_t compressed_file_list_size = compressed_size;
+  file.write(reinterpret_cast<const char*>(&num_files), sizeof(num_files));
+  file.write(reinterpret_cast<const char*>(&compressed_file_list_size),
+             sizeof(compressed_file_list_size));
+  file.write(compressed_file_list.data(), compressed_size);
+
+  header.magic_number = LS_PAK_MAGIC_HEADER_NUMBER;
+  header.version = LS_PAK_VERSION;
+  header.file_list_offset = offset;
+  header.file_list_size = compressed_size + 8;
+  header.num_parts = 1;
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(LsPakHeader));
+  file.close();
+  if(file.fail())
+    throw std::runtime_error(std::format("Could not write to '{}'.", dest_path_.string()));
+}
+
+std::string LsPakWriter::compress(const std::string& data, Compression compression)
+{
+  if(compression == lz4)
+  {
+    const int bound = LZ4_compressBound(data.size());
+    // data exceeds the maximum input size for lz4
+    if(bound <= 0)
+      return data;
+    std::string output(bound, '\0');
+    const int size = LZ4_compress_default(data.data(), output.data(), data.size(), output.size());
+    if(size <= 0)
+      throw std::runtime_error("LZ4 compression failed.");
+    output.resize(size);
+    return output;
+  }
+  if(compression == zstd)
+  {
+    std::string output(ZSTD_compressBound(data.size()), '\0');
+    const size_t size = ZSTD_compress(
+      output.data(), output.size(), data.data(), data.size(), ZSTD_COMPRESSION_LEVEL);
+    if(ZSTD_isError(size))
+      throw std::runtime_error(
+        std::format("zstd compression failed: {}", ZSTD_getErrorName(size)));
+    output.resize(size);
+    return output;
+  }
+  return data;
+}
@@ -0,0 +1,92 @@
+/*!
+ * \file lspakwriter.h
+ * \brief Header for the LsPakWriter class
+ */
+
+#pragma once
+
+#include "lspakfilelistentry.h"
+#include "lspakheader.h"
+#include "progressnode.h"
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Class for creating .pak archives used for Baldurs Gate 3. Created archives can be
+ * read using LsPakExtractor.
+ */
+class LsPakWriter
+{
+public:
+  /*! \brief Compression types supported for files in the archive. */
+  enum Compression
+  {
+    none = 0,
+    lz4 = 2,
+    zstd = 3
+  };
+
+  /*!
+   * \brief Sets the archive path and the compression used.
+   * \param dest_path Path to the archive to be created.
+   * \param compression Compression used for every file. Files which can not be compressed
+   * are stored uncompressed.
+   */
+  LsPakWriter(const std::filesystem::path& dest_path, Compression compression = lz4);
+
+  /*!
+   * \brief Adds a file to the archive.
+   * \param source_path Path to the file on disk.
+   * \param archive_path Path of the file inside the archive.
+   * \throw std::runtime_error If the path is too long for the archive format.
+   */
+  void addFile(const std::filesystem::path& source_path, const std::string& archive_path);
+  /*!
+   * \brief Recursively adds all files in the given directory to the archive. Paths inside
+   * the archive are relative to the directory.
+   * \param source_path Path to the directory.
+   */
+  void addDirectory(const std::filesystem::path& source_path);
+  /*!
+   * \brief Compresses all added files in parallel and writes the archive.
+   * \param progress_node Used to inform about the current progress.
+   * \throw std::runtime_error If a file could not be read or the archive could not be
+   * written. The partially written archive is removed in this case.
+   */
+  void write(std::optional<ProgressNode*> progress_node = {}) const;
+
+private:
+  /*! \brief Indicates file is a supported .pak archive. */
+  static constexpr unsigned int LS_PAK_MAGIC_HEADER_NUMBER = 0x4b50534c;
+  /*! \brief Archive format version written. */
+  static constexpr unsigned int LS_PAK_VERSION = 18;
+  /*! \brief File list entry flag indicating default compression level. */
+  static constexpr int DEFAULT_COMPRESSION_LEVEL_FLAG = 0x20;
+  /*! \brief Compression level used for zstd. */
+  static constexpr int ZSTD_COMPRESSION_LEVEL = 3;
+  /*! \brief Maximum accumulated size of files compressed before being written. */
+  static constexpr uint64_t MAX_BATCH_SIZE = 1 << 28;
+  /*! \brief Path to the archive to be created. */
+  std::filesystem::path dest_path_;
+  /*! \brief Compression used for files. */
+  Compression compression_;
+  /*! \brief Paths on disk and inside the archive of every added file. */
+  std::vector<std::pair<std::filesystem::path, std::string>> files_;
+
+  /*!
+   * \brief Writes the archive to \ref dest_path_.
+   * \param progress_node Used to inform about the current progress.
+   */
+  void writeArchive(std::optional<ProgressNode*> progress_node) const;
+  /*!
+   * \brief Compresses the given data.
+   * \param data Data to compress.
+   * \param compression Compression type to use.
+   * \return The compressed data.
+   */
+  static std::string compress(const std::string& data, Compression compression);
+};
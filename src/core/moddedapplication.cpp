@@ -1,4 +1,5 @@
 #include "moddedapplication.h"
+#include "cancellationerror.h"
 #include "deployerfactory.h"
 #include "installer.h"
 #include "parseerror.h"
@@ -63,21 +64,30 @@ void ModdedApplication::deployModsFor(std::vector<int> deployers)
       weights.push_back(num_mods);
   }
 
-  ProgressNode node(progress_callback_, weights);
-  for(auto [i, deployer] : str::enumerate_view(deployers))
+  ProgressNode node(progress_callback_, weights, cancel_flag_);
+  try
   {
-    const auto mod_sizes = deployers_[deployer]->deploy(&(node.child(i)));
-    if(!deployers_[deployer]->isAutonomous())
+    for(auto [i, deployer] : str::enumerate_view(deployers))
     {
-      for(const auto [mod_id, mod_size] : mod_sizes)
+      const auto mod_sizes = deployers_[deployer]->deploy(&(node.child(i)));
+      if(!deployers_[deployer]->isAutonomous())
       {
-        auto mod_iter =
-          str::find_if(installed_mods_, [id = mod_id](const Mod& m) { return m.id == id; });
-        if(mod_iter != installed_mods_.end())
-          mod_iter->size_on_disk = mod_size;
+        for(const auto [mod_id, mod_size] : mod_sizes)
+        {
+          auto mod_iter =
+            str::find_if(installed_mods_, [id = mod_id](const Mod& m) { return m.id == id; });
+          if(mod_iter != installed_mods_.end())
+            mod_iter->size_on_disk = mod_size;
+        }
       }
     }
   }
+  catch(CancellationError& error)
+  {
+    // deployers which have already finished may have changed their state
+    updateSettings(true);
+    throw;
+  }
 
   updateSettings(true);
 }
@@ -109,9 +119,17 @@ void ModdedApplication::unDeployModsFor(std::vector<int> deployers)
       weights.push_back(num_mods);
   }
 
-  ProgressNode node(progress_callback_, weights);
-  for(auto [i, deployer] : str::enumerate_view(deployers))
-    deployers_[deployer]->unDeploy(&(node.child(i)));
+  ProgressNode node(progress_callback_, weights, cancel_flag_);
+  try
+  {
+    for(auto [i, deployer] : str::enumerate_view(deployers))
+      deployers_[deployer]->unDeploy(&(node.child(i)));
+  }
+  catch(CancellationError& error)
+  {
+    updateSettings(true);
+    throw;
+  }
 
   updateSettings(true);
 }
@@ -131,21 +149,15 @@ void ModdedApplication::installMod(const ImportModInfo& info)
   else
     progress_node.addChildren({ 1 });
   progress_node.child(0).setTotalSteps(1);
-  int mod_id = 0;
-  if(!installed_mods_.empty())
-    mod_id = std::max_element(installed_mods_.begin(), installed_mods_.end())->id + 1;
-  while(pu::exists(staging_dir_ / std::to_string(mod_id)) &&
-        mod_id < std::numeric_limits<int>().max())
-    mod_id++;
-  if(mod_id == std::numeric_limits<int>().max())
-    throw std::runtime_error("Error: Could not generate new mod id.");
+  const int mod_id = getNewModId();
   last_mod_id_ = mod_id;
   const auto mod_size = Installer::install(info.current_path,
                                            staging_dir_ / std::to_string(mod_id),
-                                           info.installer_flags,
+                                           getInstallerFlags(info),
                                            info.installer,
                                            info.root_level,
                                            info.files);
+  invalidateModFileIndex(mod_id);
   const auto time_now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
   installed_mods_.emplace_back(mod_id,
                                info.name,
@@ -216,6 +228,7 @@ void ModdedApplication::uninstallMods(const std::vector<int>& mod_ids,
     if(installer_type == "" && installer_map_.contains(mod_id))
       installer = installer_map_[mod_id];
     Installer::uninstall(staging_dir_ / std::to_string(mod_id), installer);
+    invalidateModFileIndex(mod_id);
 
     for(auto& tag : manual_tags_)
       tag.removeMod(mod_id);
@@ -243,6 +256,18 @@ void ModdedApplication::changeLoadorder(int deployer, int from_index, int to_ind
   updateSettings(true);
 }
 
+void ModdedApplication::moveMods(int deployer, const std::vector<std::pair<int, int>>& moves)
+{
+  deployers_[deployer]->moveMods(moves);
+  updateSettings(true);
+}
+
+void ModdedApplication::reorderMods(int deployer, const std::vector<int>& order)
+{
+  deployers_[deployer]->reorderMods(order);
+  updateSettings(true);
+}
+
 void ModdedApplication::addModToDeployer(int deployer,
                                          int mod_id,
                                          bool update_conflicts,
@@ -340,8 +365,8 @@ void ModdedApplication::removeDeployer(int deployer, bool cleanup)
 std::vector<std::string> ModdedApplication::getDeployerNames() const
 {
   std::vector<std::string> names;
-  for(const auto& deployer : deployers_)
-    names.push_back(deployer->getName());
+  for(int depl = 0; depl < deployers_.size(); depl++)
+    names.push_back(deployers_.getProperties(depl).name);
   return names;
 }
 
@@ -461,6 +486,46 @@ std::vector<ConflictInfo> ModdedApplication::getFileConflicts(int deployer,
   return conflicts;
 }
 
+std::vector<ConflictInfo> ModdedApplication::getFileProviders(int deployer,
+                                                               const std::string& prefix,
+                                                               int max_files) const
+{
+  ProgressNode node(progress_callback_);
+  const auto provider_map = deployers_[deployer]->getFileProviderMap(&node);
+  auto entries = provider_map->findPrefix(prefix);
+  if(max_files > 0 && entries.size() > max_files)
+    entries = entries.first(max_files);
+
+  std::map<int, std::string> mod_names;
+  for(const auto& mod : installed_mods_)
+    mod_names[mod.id] = mod.name;
+  std::vector<ConflictInfo> providers;
+  providers.reserve(entries.size());
+  for(const auto& [path, mod_ids] : entries)
+  {
+    ConflictInfo info{ path, mod_ids, {} };
+    for(int id : mod_ids)
+      info.mod_names.push_back(mod_names.contains(id) ? mod_names[id] : "");
+    providers.push_back(std::move(info));
+  }
+  return providers;
+}
+
+void ModdedApplication::exportOverwriteReport(int deployer,
+                                              const sfs::path& path,
+                                              bool only_conflicts) const
+{
+  ProgressNode node(progress_callback_);
+  const auto provider_map = deployers_[deployer]->getFileProviderMap(&node);
+  std::ofstream file(path, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Failed to open \"{}\".", path.string()));
+  provider_map->writeReport(
+    file, [this](int mod_id) { return getModName(mod_id); }, only_conflicts);
+  if(!file)
+    throw std::runtime_error(std::format("Failed to write to \"{}\".", path.string()));
+}
+
 AppInfo ModdedApplication::getAppInfo() const
 {
   AppInfo info;
@@ -470,15 +535,18 @@ AppInfo ModdedApplication::getAppInfo() const
   info.num_mods = installed_mods_.size();
   info.app_version = app_versions_[current_profile_];
   info.steam_app_id = steam_app_id_;
-  for(const auto& deployer : deployers_)
+  for(int depl = 0; depl < deployers_.size(); depl++)
   {
-    info.deployers.push_back(deployer->getName());
-    info.deployer_types.push_back(deployer->getType());
-    info.target_dirs.push_back(deployer->getDestPath());
-    info.deployer_source_dirs.push_back(deployer->getSourcePath());
-    info.deployer_mods.push_back(deployer->getNumMods());
-    info.deploy_modes.push_back(deployer->getDeployMode());
-    info.deployer_is_case_invariant.push_back(deployer->isCaseInvariant());
+    const auto properties = deployers_.getProperties(depl);
+    const bool is_loaded = deployers_.isLoaded(depl);
+    info.deployers.push_back(properties.name);
+    info.deployer_types.push_back(properties.type);
+    info.target_dirs.push_back(properties.dest_path.string());
+    info.deployer_source_dirs.push_back(properties.source_path.string());
+    // deferred deployers only know their mods after reading their plugin files
+    info.deployer_mods.push_back(is_loaded ? deployers_[depl]->getNumMods() : -1);
+    info.deploy_modes.push_back(properties.deploy_mode);
+    info.deployer_is_case_invariant.push_back(is_loaded && deployers_[depl]->isCaseInvariant());
   }
   info.tools = tools_;
   for(const auto& tag : manual_tags_)
@@ -576,8 +644,7 @@ void ModdedApplication::setProfile(int profile)
   if(profile < 0 || profile >= profile_names_.size())
     return;
   bak_man_.setProfile(profile);
-  for(const auto& deployer : deployers_)
-    deployer->setProfile(profile);
+  deployers_.setProfile(profile);
   current_profile_ = profile;
 }
 
@@ -763,8 +830,29 @@ void ModdedApplication::changeActiveGroupMember(int group,
      std::find(groups_[group].begin(), groups_[group].end(), mod_id) == groups_[group].end())
     return;
   active_group_members_[group] = mod_id;
-  ProgressNode node(progress_callback_);
-  updateDeployerGroups(progress_node ? progress_node : &node);
+  // only load order entries of this group change, so other groups need not be checked
+  std::vector<int> redeploy_targets;
+  for(int depl = 0; depl < deployers_.size(); depl++)
+  {
+    if(deployers_[depl]->isAutonomous())
+      continue;
+    if(deployers_[depl]->changeActiveGroupMember(groups_[group], mod_id) &&
+       deployers_[depl]->getModStatus(mod_id).value_or(false))
+      redeploy_targets.push_back(depl);
+  }
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
+  ProgressNode* root_node = progress_node ? *progress_node : &node;
+  root_node->addChildren(std::vector<float>(redeploy_targets.size(), 1));
+  try
+  {
+    for(const auto& [i, depl] : str::enumerate_view(redeploy_targets))
+      deployers_[depl]->redeployMods(groups_[group], &root_node->child(i));
+  }
+  catch(CancellationError& error)
+  {
+    updateSettings(true);
+    throw;
+  }
   updateSettings(true);
 }
 
@@ -797,7 +885,7 @@ int ModdedApplication::getModGroup(int mod_id)
 
 void ModdedApplication::sortModsByConflicts(int deployer)
 {
-  ProgressNode node(progress_callback_);
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
   deployers_[deployer]->sortModsByConflicts(&node);
   updateSettings(true);
 }
@@ -966,15 +1054,22 @@ DeployerInfo ModdedApplication::getDeployerInfo(int deployer)
 void ModdedApplication::setLog(const std::function<void(Log::LogLevel, const std::string&)>& newLog)
 {
   log_ = newLog;
-  for(auto& deployer : deployers_)
-    deployer->setLog(newLog);
+  deployers_.setLog(newLog);
+}
+
+void ModdedApplication::setTrackExternalChanges(bool track)
+{
+  deployers_.setTrackExternalChanges(track);
 }
 
 void ModdedApplication::addBackupTarget(const sfs::path& path,
                                         const std::string& name,
-                                        const std::vector<std::string>& backup_names)
+                                        const std::vector<std::string>& backup_names,
+                                        bool use_chunk_store)
 {
   bak_man_.addTarget(path, name, backup_names);
+  if(use_chunk_store)
+    bak_man_.setUseChunkStore(bak_man_.getNumTargets() - 1, true);
   updateSettings(true);
 }
 
@@ -996,7 +1091,8 @@ void ModdedApplication::addBackup(int target_id, const std::string& name, int so
 {
   if(target_id < 0 || target_id >= bak_man_.getNumTargets())
     return;
-  bak_man_.addBackup(target_id, name, source);
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
+  bak_man_.addBackup(target_id, name, source, &node);
 }
 
 void ModdedApplication::removeBackup(int target_id, int backup_id)
@@ -1058,6 +1154,11 @@ void ModdedApplication::setProgressCallback(const std::function<void(float)>& pr
   progress_callback_ = progress_callback;
 }
 
+void ModdedApplication::setCancelFlag(const std::atomic<bool>* cancel_flag)
+{
+  cancel_flag_ = cancel_flag;
+}
+
 void ModdedApplication::uninstallGroupMembers(const std::vector<int>& mod_ids)
 {
   std::vector<int> uninstall_targets;
@@ -1338,7 +1439,7 @@ void ModdedApplication::editAutoTags(const std::vector<EditAutoTagAction>& actio
 void ModdedApplication::reapplyAutoTags()
 {
   log_(Log::LOG_INFO, "Reapplying auto tags to all mods...");
-  ProgressNode node(progress_callback_);
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
   node.addChildren({ 1.0f, 8.0f });
   node.child(0).setTotalSteps(installed_mods_.size());
   std::vector<float> weights;
@@ -1350,8 +1451,11 @@ void ModdedApplication::reapplyAutoTags()
   auto select_id = [](const auto& mod) { return mod.id; };
   auto mods = str::transform_view(installed_mods_, select_id);
   const auto files = AutoTag::readModFiles(staging_dir_, mods, &node.child(0));
-  for(int i = 0; i < auto_tags_.size(); i++)
-    auto_tags_[i].reapplyMods(files, mods, &node.child(1).child(i));
+  // tags are only replaced once all of them have been reapplied
+  auto auto_tags = auto_tags_;
+  for(int i = 0; i < auto_tags.size(); i++)
+    auto_tags[i].reapplyMods(files, mods, &node.child(1).child(i));
+  auto_tags_ = std::move(auto_tags);
   updateAutoTagMap();
   updateSettings(true);
 }
@@ -1359,7 +1463,7 @@ void ModdedApplication::reapplyAutoTags()
 void ModdedApplication::updateAutoTags(const std::vector<int> mod_ids)
 {
   log_(Log::LOG_INFO, std::format("Reapplying auto tags to {} mods...", mod_ids.size()));
-  ProgressNode node(progress_callback_);
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
   node.addChildren(
     { 1.0f, std::max(1.0f, 8.0f * (float)mod_ids.size() / (float)installed_mods_.size()) });
   node.child(0).setTotalSteps(mod_ids.size());
@@ -1370,8 +1474,10 @@ void ModdedApplication::updateAutoTags(const std::vector<int> mod_ids)
   for(int i = 0; i < weights.size(); i++)
     node.child(1).child(i).setTotalSteps(mod_ids.size());
   const auto files = AutoTag::readModFiles(staging_dir_, mod_ids, &node.child(0));
-  for(int i = 0; i < auto_tags_.size(); i++)
-    auto_tags_[i].updateMods(files, mod_ids, &node.child(1).child(i));
+  auto auto_tags = auto_tags_;
+  for(int i = 0; i < auto_tags.size(); i++)
+    auto_tags[i].updateMods(files, mod_ids, &node.child(1).child(i));
+  auto_tags_ = std::move(auto_tags);
   updateAutoTagMap();
   updateSettings(true);
 }
@@ -1468,10 +1574,76 @@ void ModdedApplication::keepOrRevertFileModifications(
   deployers_[deployer]->keepOrRevertFileModifications(changes_to_keep);
 }
 
+DeploymentAudit ModdedApplication::auditDeployment(int deployer)
+{
+  ProgressNode node(progress_callback_);
+  auto audit = deployers_[deployer]->auditDeployment({ &node });
+  audit.deployer_id = deployer;
+  return audit;
+}
+
+void ModdedApplication::repairDeployment(int deployer, const DeploymentAudit& audit)
+{
+  deployers_[deployer]->repairDeployment(audit);
+}
+
+std::vector<DeploymentPlan> ModdedApplication::planDeploy(const std::vector<int>& deployers)
+{
+  std::vector<DeploymentPlan> plans;
+  if(deployers.empty())
+    return plans;
+  ProgressNode node(progress_callback_, std::vector<float>(deployers.size(), 1));
+  for(int i = 0; i < deployers.size(); i++)
+  {
+    plans.push_back(deployers_[deployers[i]]->planDeploy(&node.child(i)));
+    plans.back().deployer_id = deployers[i];
+  }
+
+  // deployers may share a target directory or deploy into each others target directories
+  std::map<sfs::path, std::vector<int>> file_deployers;
+  for(int i = 0; i < plans.size(); i++)
+  {
+    for(const auto& path : plans[i].target_files)
+      file_deployers[path].push_back(i);
+    plans[i].target_files.clear();
+  }
+  std::vector<std::map<int, int>> overlaps(plans.size());
+  for(const auto& [path, plan_ids] : file_deployers)
+  {
+    for(int plan_id : plan_ids)
+    {
+      for(int other_id : plan_ids)
+      {
+        if(plan_id != other_id)
+          overlaps[plan_id][plans[other_id].deployer_id]++;
+      }
+    }
+  }
+  for(int i = 0; i < plans.size(); i++)
+    plans[i].overlapping_deployers.assign(overlaps[i].begin(), overlaps[i].end());
+  return plans;
+}
+
+std::vector<DeploymentGeneration> ModdedApplication::getDeploymentGenerations(int deployer)
+{
+  return deployers_[deployer]->getGenerations();
+}
+
+void ModdedApplication::rollbackDeployment(int deployer, int generation)
+{
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
+  deployers_[deployer]->rollbackToGeneration(generation, &node);
+  updateSettings(true);
+}
+
 void ModdedApplication::fixInvalidHardLinkDeployers()
 {
-  for(auto& depl : deployers_)
-    depl->fixInvalidLinkDeployMode();
+  // deferred deployers manage plugin files and never use links
+  for(int depl = 0; depl < deployers_.size(); depl++)
+  {
+    if(deployers_.isLoaded(depl))
+      deployers_[depl]->fixInvalidLinkDeployMode();
+  }
 }
 
 void ModdedApplication::exportConfiguration(const std::vector<int>& deployers,
@@ -1563,6 +1735,11 @@ std::filesystem::path ModdedApplication::getDownloadDir() const
   return staging_dir_ / DOWNLOAD_DIR;
 }
 
+int ModdedApplication::loadDeployers()
+{
+  return deployers_.loadAll();
+}
+
 sfs::path ModdedApplication::iconPath() const
 {
   return icon_path_;
@@ -1603,19 +1780,32 @@ void ModdedApplication::updateSettings(bool write)
 
   for(int depl = 0; depl < deployers_.size(); depl++)
   {
-    json_settings_["deployers"][depl]["dest_path"] = deployers_[depl]->getDestPath();
-    if(deployers_[depl]->isAutonomous())
-      json_settings_["deployers"][depl]["source_path"] = deployers_[depl]->sourcePath().string();
+    const auto properties = deployers_.getProperties(depl);
+    const bool is_autonomous = DeployerFactory::AUTONOMOUS_DEPLOYERS.at(properties.type);
+    json_settings_["deployers"][depl]["dest_path"] = properties.dest_path.string();
+    if(is_autonomous)
+      json_settings_["deployers"][depl]["source_path"] = properties.source_path.string();
     else
       json_settings_["deployers"][depl]["source_path"] = staging_dir_.string();
-    json_settings_["deployers"][depl]["name"] = deployers_[depl]->getName();
-    json_settings_["deployers"][depl]["type"] = deployers_[depl]->getType();
-    json_settings_["deployers"][depl]["deploy_mode"] = deployers_[depl]->getDeployMode();
+    json_settings_["deployers"][depl]["name"] = properties.name;
+    json_settings_["deployers"][depl]["type"] = properties.type;
+    json_settings_["deployers"][depl]["deploy_mode"] = properties.deploy_mode;
     json_settings_["deployers"][depl]["enable_unsafe_sorting"] =
-      deployers_[depl]->getEnableUnsafeSorting();
+      properties.enable_unsafe_sorting;
 
-    if(!deployers_[depl]->isAutonomous())
+    if(!is_autonomous)
     {
+      json_settings_["deployers"][depl]["max_generations"] =
+        deployers_[depl]->getMaxGenerations();
+      for(int mode = Deployer::hard_link; mode <= Deployer::copy; mode++)
+      {
+        const auto costs =
+          deployers_[depl]->getOperationCosts(static_cast<Deployer::DeployMode>(mode));
+        Json::Value& json_costs = json_settings_["deployers"][depl]["operation_costs"][mode];
+        for(int type = 0; type < costs.operations.size(); type++)
+          json_costs["operations"][type] = costs.operations[type];
+        json_costs["copy_per_byte"] = costs.copy_per_byte;
+      }
       for(int prof = 0; prof < profile_names_.size(); prof++)
       {
         deployers_[depl]->setProfile(prof);
@@ -1636,8 +1826,8 @@ void ModdedApplication::updateSettings(bool write)
               conflict_groups[group][i];
         }
       }
+      deployers_[depl]->setProfile(current_profile_);
     }
-    deployers_[depl]->setProfile(current_profile_);
   }
 
   for(int tool = 0; tool < tools_.size(); tool++)
@@ -1774,6 +1964,8 @@ void ModdedApplication::updateState(bool read)
     active_group_members_.push_back(groups[group]["active_member"].asInt());
   }
   Json::Value deployers = json_settings_["deployers"];
+  deployers_.setLog(log_);
+  deployers_.setProfile(current_profile_);
   for(int depl = 0; depl < deployers.size(); depl++)
   {
     std::vector<std::string> types = DeployerFactory::DEPLOYER_TYPES;
@@ -1788,14 +1980,41 @@ void ModdedApplication::updateState(bool read)
         deployers[depl]["use_copy_deployment"].asBool() ? Deployer::copy : Deployer::hard_link;
     else
       deploy_mode = static_cast<Deployer::DeployMode>(deployers[depl]["deploy_mode"].asInt());
+    const sfs::path source_path = deployers[depl]["source_path"].asString();
+    const sfs::path dest_path = deployers[depl]["dest_path"].asString();
+    const std::string name = deployers[depl]["name"].asString();
+    const bool enable_unsafe_sorting = deployers[depl].get("enable_unsafe_sorting", false).asBool();
+    // deployers managing plugin files read and update them on construction
+    if(DeployerFactory::AUTONOMOUS_DEPLOYERS.at(type) && type != DeployerFactory::REVERSEDEPLOYER)
+    {
+      auto loader = [=]()
+      {
+        auto deployer =
+          DeployerFactory::makeDeployer(type, source_path, dest_path, name, deploy_mode);
+        if(enable_unsafe_sorting)
+          deployer->setEnableUnsafeSorting(true);
+        return deployer;
+      };
+      deployers_.pushLazy(
+        { type, name, source_path, dest_path, deploy_mode, enable_unsafe_sorting }, loader);
+      continue;
+    }
     deployers_.push_back(
-      DeployerFactory::makeDeployer(type,
-                                    sfs::path(deployers[depl]["source_path"].asString()),
-                                    sfs::path(deployers[depl]["dest_path"].asString()),
-                                    deployers[depl]["name"].asString(),
-                                    deploy_mode));
+      DeployerFactory::makeDeployer(type, source_path, dest_path, name, deploy_mode));
     if(deployers[depl].isMember("enable_unsafe_sorting"))
-      deployers_.back()->setEnableUnsafeSorting(deployers[depl]["enable_unsafe_sorting"].asBool());
+      deployers_.back()->setEnableUnsafeSorting(enable_unsafe_sorting);
+    if(deployers[depl].isMember("max_generations"))
+      deployers_.back()->setMaxGenerations(deployers[depl]["max_generations"].asInt());
+    // costs measured during previous deployments are used to estimate deployment durations
+    const Json::Value json_costs = deployers[depl]["operation_costs"];
+    for(int mode = 0; mode < json_costs.size() && mode <= Deployer::copy; mode++)
+    {
+      Deployer::OperationCosts costs;
+      for(int type = 0; type < costs.operations.size(); type++)
+        costs.operations[type] = json_costs[mode]["operations"].get(type, -1.0).asDouble();
+      costs.copy_per_byte = json_costs[mode].get("copy_per_byte", -1.0).asDouble();
+      deployers_.back()->setOperationCosts(static_cast<Deployer::DeployMode>(mode), costs);
+    }
 
     if(!deployers_[depl]->isAutonomous())
     {
@@ -1846,6 +2065,17 @@ void ModdedApplication::updateState(bool read)
           profile_names_.size()));
     }
     deployers_[depl]->setProfile(current_profile_);
+    try
+    {
+      deployers_[depl]->recoverInterruptedDeployment();
+    }
+    catch(std::exception& error)
+    {
+      log_(Log::LOG_ERROR,
+           std::format("Failed to complete interrupted deployment for deployer '{}': {}",
+                       name,
+                       error.what()));
+    }
   }
   Json::Value tools = json_settings_["tools"];
   for(int tool = 0; tool < tools.size(); tool++)
@@ -2027,8 +2257,81 @@ void ModdedApplication::splitMod(int mod_id, int deployer)
         "Mod '{}' has been split because it contains" " a sub-directory managed by deployer '{}'.",
         iter->name,
         deployers_[depl]->getName()));
-    installMod(info);
-    sfs::remove_all(mod_dir);
+    unsigned long mod_size = 0;
+    for(const auto& dir_entry : sfs::recursive_directory_iterator(mod_dir))
+    {
+      if(dir_entry.is_regular_file())
+        mod_size += dir_entry.file_size();
+    }
+    const int new_mod_id = getNewModId();
+    last_mod_id_ = new_mod_id;
+    std::error_code error;
+    sfs::rename(mod_dir, staging_dir_ / std::to_string(new_mod_id), error);
+    // renaming fails if the sub-directory is on a different filesystem
+    if(error)
+    {
+      installMod(info);
+      sfs::remove_all(mod_dir);
+      invalidateModFileIndex(mod_id);
+      continue;
+    }
+    invalidateModFileIndex(mod_id);
+    invalidateModFileIndex(new_mod_id);
+    iter->size_on_disk -= std::min(mod_size, iter->size_on_disk);
+    const auto time_now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    installed_mods_.emplace_back(new_mod_id,
+                                 info.name,
+                                 info.version,
+                                 time_now,
+                                 info.local_source,
+                                 info.remote_source,
+                                 time_now,
+                                 mod_size,
+                                 time_now,
+                                 info.remote_mod_id,
+                                 info.remote_file_id,
+                                 info.remote_type);
+    installer_map_[new_mod_id] = info.installer;
+    addModToDeployer(depl, new_mod_id, true);
+    for(auto& tag : auto_tags_)
+      tag.updateMods(staging_dir_, std::vector<int>{ new_mod_id });
+    updateAutoTagMap();
+    updateSettings(true);
+  }
+}
+
+int ModdedApplication::getNewModId() const
+{
+  int mod_id = 0;
+  if(!installed_mods_.empty())
+    mod_id = std::max_element(installed_mods_.begin(), installed_mods_.end())->id + 1;
+  while(pu::exists(staging_dir_ / std::to_string(mod_id)) &&
+        mod_id < std::numeric_limits<int>().max())
+    mod_id++;
+  if(mod_id == std::numeric_limits<int>().max())
+    throw std::runtime_error("Error: Could not generate new mod id.");
+  return mod_id;
+}
+
+int ModdedApplication::getInstallerFlags(const ImportModInfo& info) const
+{
+  // packed mods can only be deployed by the Baldurs Gate 3 deployer
+  for(int depl : info.deployers)
+  {
+    if(depl >= 0 && depl < deployers_.size() &&
+       deployers_.getProperties(depl).type == DeployerFactory::BG3DEPLOYER)
+      return info.installer_flags;
+  }
+  return info.installer_flags & ~Installer::pack_bg3_pak;
+}
+
+void ModdedApplication::invalidateModFileIndex(int mod_id)
+{
+  // deferred deployers build their index when they are loaded
+  for(int depl = 0; depl < deployers_.size(); depl++)
+  {
+    if(deployers_.isLoaded(depl))
+      deployers_[depl]->invalidateModFileIndex(mod_id);
   }
 }
 
@@ -2057,13 +2360,14 @@ void ModdedApplication::replaceMod(const ImportModInfo& info)
 
   const auto mod_size = Installer::install(info.current_path,
                                            tmp_replace_dir,
-                                           info.installer_flags,
+                                           getInstallerFlags(info),
                                            info.installer,
                                            info.root_level,
                                            info.files);
   const sfs::path old_mod_path = staging_dir_ / std::to_string(info.target_group_id);
   sfs::remove_all(old_mod_path);
   sfs::rename(tmp_replace_dir, old_mod_path);
+  invalidateModFileIndex(info.target_group_id);
 
   index->name = info.name;
   index->version = info.version;
@@ -2164,11 +2468,17 @@ void ModdedApplication::performUpdateCheck(const std::vector<int>& target_mod_in
        std::format("Checking for updates for {} mod{}...",
                    target_mod_indices.size(),
                    target_mod_indices.size() > 1 ? "s" : ""));
-  ProgressNode node(progress_callback_);
+  ProgressNode node(progress_callback_, {}, cancel_flag_);
   node.setTotalSteps(target_mod_indices.size());
   int num_available_updates = 0;
   for(int i : target_mod_indices)
   {
+    // results for mods which have already been checked are kept
+    if(node.isCanceled())
+    {
+      updateSettings(true);
+      throw CancellationError();
+    }
     installed_mods_[i].remote_update_time =
       nexus::Api::getNexusPage(installed_mods_[i].remote_source).mod.updated_time;
     if(installed_mods_[i].remote_update_time > installed_mods_[i].install_time)
@@ -2251,10 +2561,10 @@ void ModdedApplication::updateSteamAppId()
   }
 
   std::regex steam_regex(R"(/steamapps/compatdata/(\d+))");
-  for(const auto& depl : deployers_)
+  for(int depl = 0; depl < deployers_.size(); depl++)
   {
     std::smatch match;
-    std::string path = depl->getDestPath();
+    std::string path = deployers_.getProperties(depl).dest_path.string();
     if(std::regex_search(path, match, steam_regex))
     {
       steam_app_id_ = std::stol(match[1]);
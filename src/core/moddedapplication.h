@@ -10,6 +10,7 @@
 #include "backupmanager.h"
 #include "deployer.h"
 #include "deployerinfo.h"
+#include "deployerlist.h"
 #include "editautotagaction.h"
 #include "editdeployerinfo.h"
 #include "editmanualtagaction.h"
@@ -20,6 +21,7 @@
 #include "modinfo.h"
 #include "nexus/api.h"
 #include "tool.h"
+#include <atomic>
 #include <filesystem>
 #include <json/json.h>
 #include <string>
@@ -88,6 +90,19 @@ public:
    * \param to_index Destination index.
    */
   void changeLoadorder(int deployer, int from_index, int to_index);
+  /*!
+   * \brief Applies multiple load order moves for given Deployer at once. Settings are only
+   * saved once, after all moves have been applied.
+   * \param deployer The target Deployer.
+   * \param moves Pairs of from_index and to_index, applied in the given order.
+   */
+  void moveMods(int deployer, const std::vector<std::pair<int, int>>& moves);
+  /*!
+   * \brief Replaces the load order of given Deployer with a permutation of itself.
+   * \param deployer The target Deployer.
+   * \param order For every new position: The current index of the mod at that position.
+   */
+  void reorderMods(int deployer, const std::vector<int>& order);
   /*!
    * \brief Appends a new mod to the load order for given Deployer.
    * \param deployer The target Deployer
@@ -198,6 +213,28 @@ public:
    * \return A vector with information about conflicts with every other mod.
    */
   std::vector<ConflictInfo> getFileConflicts(int deployer, int mod_id, bool show_disabled) const;
+  /*!
+   * \brief Finds all files provided by the enabled mods of one Deployer whose path starts
+   * with the given prefix, as well as all mods providing these files.
+   * \param deployer The target Deployer.
+   * \param prefix Path prefix, relative to the deployers target directory. If empty: Find
+   * all files.
+   * \param max_files If positive: Return at most this many files.
+   * \return For every file: Its path and all mods providing it, in overwrite order.
+   */
+  std::vector<ConflictInfo> getFileProviders(int deployer,
+                                             const std::string& prefix,
+                                             int max_files = -1) const;
+  /*!
+   * \brief Writes a CSV file containing every file provided by the enabled mods of one
+   * Deployer, the winning mod and all overwritten mods.
+   * \param deployer The target Deployer.
+   * \param path Path to the CSV file.
+   * \param only_conflicts If true: Only export files provided by more than one mod.
+   */
+  void exportOverwriteReport(int deployer,
+                             const std::filesystem::path& path,
+                             bool only_conflicts) const;
   /*!
    * \brief Fills an AppInfo object with information about this object.
    * \return The AppInfo object.
@@ -310,7 +347,9 @@ public:
                    int second_mod_id,
                    std::optional<ProgressNode*> progress_node = {});
   /*!
-   * \brief Changes the active member of given group to given mod.
+   * \brief Changes the active member of given group to given mod. Only load order entries of
+   * the group are updated. Deployers which currently deploy the group are redeployed, but only
+   * files provided by members of the group are changed.
    * \param group Target group.
    * \param mod_id The new active member.
    * \param progress_node Used to inform about the current progress.
@@ -381,15 +420,24 @@ public:
   DeployerInfo getDeployerInfo(int deployer);
   /*! \brief Setter for log callback. */
   void setLog(const std::function<void(Log::LogLevel, const std::string&)>& newLog);
+  /*!
+   * \brief Enables or disables tracking of changes to the target directories of all deployers.
+   * While enabled, checking for external changes only needs to check files which have been
+   * changed while tracking.
+   * \param track If true: Track changes.
+   */
+  void setTrackExternalChanges(bool track);
   /*!
    * \brief Adds a new target file or directory to be managed by the BackupManager.
    * \param path Path to the target file or directory.
    * \param name Display name for this target.
    * \param backup_names Display names for initial backups. Must contain at least one.
+   * \param use_chunk_store If true: Store inactive backups in a deduplicated chunk store.
    */
   void addBackupTarget(const std::filesystem::path& path,
                        const std::string& name,
-                       const std::vector<std::string>& backup_names);
+                       const std::vector<std::string>& backup_names,
+                       bool use_chunk_store = false);
   /*!
    * \brief Removes the given backup target by deleting all backups, except for the active one,
    * and all config files.
@@ -454,6 +502,13 @@ public:
    * \param progress_callback The function.
    */
   void setProgressCallback(const std::function<void(float)>& progress_callback);
+  /*!
+   * \brief Sets the flag used to request cancellation of long running operations like
+   * deployment, sorting, auto tag reapplication, update checks and backup creation. Canceled
+   * operations throw a CancellationError.
+   * \param cancel_flag The flag. May be nullptr, which disables cancellation.
+   */
+  void setCancelFlag(const std::atomic<bool>* cancel_flag);
   /*!
    * \brief Uninstalls all mods which are inactive group members of any group which contains
    * any of the given mods.
@@ -614,6 +669,39 @@ public:
    * that file should be kept.
    */
   void keepOrRevertFileModifications(int deployer, const FileChangeChoices& changes_to_keep) const;
+  /*!
+   * \brief Compares every file deployed by the given deployer to its source file.
+   * \param deployer Target deployer.
+   * \return Every file which is not identical to its source.
+   */
+  DeploymentAudit auditDeployment(int deployer);
+  /*!
+   * \brief Fixes every file in the given audit by deploying it again or, if its source no
+   * longer exists, by removing it.
+   * \param deployer Target deployer.
+   * \param audit Audit created by \ref auditDeployment.
+   */
+  void repairDeployment(int deployer, const DeploymentAudit& audit);
+  /*!
+   * \brief Determines which file operations deploying the given deployers would perform,
+   * without changing any file. Also finds deployers which would deploy to the same files.
+   * \param deployers Target deployers.
+   * \return One plan per deployer.
+   */
+  std::vector<DeploymentPlan> planDeploy(const std::vector<int>& deployers);
+  /*!
+   * \brief Returns all retained deployment generations of the given deployer.
+   * \param deployer Target deployer.
+   * \return The generations, sorted from oldest to newest.
+   */
+  std::vector<DeploymentGeneration> getDeploymentGenerations(int deployer);
+  /*!
+   * \brief Restores the files deployed by the given deployer and its load order to the
+   * state after the given generation.
+   * \param deployer Target deployer.
+   * \param generation Id of the target generation.
+   */
+  void rollbackDeployment(int deployer, int generation);
   /*! \brief For all deployers: If using hard links that can't be created, switch to sym links. */
   void fixInvalidHardLinkDeployers();
   /*!
@@ -647,6 +735,11 @@ public:
    * \return The download path.
    */
   std::filesystem::path getDownloadDir() const;
+  /*!
+   * \brief Constructs all deployers which have been deferred until their first use.
+   * \return The number of newly constructed deployers.
+   */
+  int loadDeployers();
 
 private:
   /*! \brief The subdirectory used to store downloads. */
@@ -660,8 +753,11 @@ private:
   std::filesystem::path staging_dir_;
   /*! \brief Contains all currently installed mods. */
   std::vector<Mod> installed_mods_;
-  /*! \brief Contains every Deployer used by this application. */
-  std::vector<std::unique_ptr<Deployer>> deployers_;
+  /*!
+   * \brief Contains every Deployer used by this application. Deployers managing plugin files
+   * are only constructed on first use.
+   */
+  DeployerList deployers_;
   /*! \brief Contains all tools for this application. */
   std::vector<Tool> tools_;
   /*! \brief The command used to run this application. */
@@ -704,6 +800,8 @@ private:
   std::vector<std::string> app_versions_;
   /*! \brief Callback used to inform about the current task's progress. */
   std::function<void(float)> progress_callback_ = [](float f) {};
+  /*! \brief If this points to true: Cancel the current operation. */
+  const std::atomic<bool>* cancel_flag_ = nullptr;
   /*! \brief File name used to store exported deployers and auto tags. */
   std::string export_file_name = "exported_config";
   /*! \brief Steam app id. Or -1 if not a Steam app. */
@@ -745,11 +843,31 @@ private:
   void updateDeployerGroups(std::optional<ProgressNode*> progress_node = {});
   /*!
    * \brief If given mod contains a sub-directory managed by a deployer that is not the given
-   * deployer, creates a new mod which contains that sub-directory.
+   * deployer, creates a new mod which contains that sub-directory. The sub-directory is moved
+   * into the new mod, it is only copied if it can not be renamed.
    * \param mod_id Mod to check.
    * \param deployer Deployer which currently manages the given mod.
    */
   void splitMod(int mod_id, int deployer);
+  /*!
+   * \brief Returns an id which is neither used by an installed mod nor by a directory in the
+   * staging directory.
+   * \return The id.
+   */
+  int getNewModId() const;
+  /*!
+   * \brief Returns the installer flags for the given mod. Removes the flag for packing
+   * Baldurs Gate 3 mods if this application has no Baldurs Gate 3 deployer.
+   * \param info Contains the requested flags.
+   * \return The flags passed to the Installer.
+   */
+  int getInstallerFlags(const ImportModInfo& info) const;
+  /*!
+   * \brief Removes the cached list of files of the given mod from every loaded deployer.
+   * Must be called after the files in the mods directory have been changed.
+   * \param mod_id Target mod.
+   */
+  void invalidateModFileIndex(int mod_id);
   /*!
    * \brief Replaces an existing mod with the mod specified by the given argument.
    * \param info Contains all data needed to install the mod.
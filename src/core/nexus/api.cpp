@@ -381,3 +381,35 @@ std::optional<std::smatch> Api::nxmUrlIsValid(const std::string& nxm_url)
     return {};
   return match;
 }
+
+std::optional<bool> Api::verifyFileMd5(const std::string& mod_url,
+                                       long file_id,
+                                       const std::string& md5)
+{
+  auto domain_and_mod = extractDomainAndModId(mod_url);
+  if(!domain_and_mod || md5.empty())
+    return {};
+
+  const auto [domain_name, mod_id] = *domain_and_mod;
+  cpr::Response response = cpr::Get(
+    cpr::Url(std::format(
+      "https://api.nexusmods.com/v1/games/{}/mods/md5_search/{}.json", domain_name, md5)),
+    cpr::Header{ { "apikey", api_key_ } });
+  // NexusMods responds with 404 if no file with the given digest exists
+  if(response.status_code == 404)
+    return false;
+  if(response.status_code != 200)
+    return {};
+
+  Json::Value json_body;
+  Json::Reader reader;
+  if(!reader.parse(response.text.c_str(), json_body))
+    return {};
+  for(int i = 0; i < json_body.size(); i++)
+  {
+    if(json_body[i]["mod"]["mod_id"].asInt64() == mod_id &&
+       json_body[i]["file_details"]["file_id"].asInt64() == file_id)
+      return true;
+  }
+  return false;
+}
@@ -162,6 +162,17 @@ public:
    * URL. If the URL is invalid: An empty optional.
    */
   static std::optional<std::smatch> nxmUrlIsValid(const std::string& nxm_url);
+  /*!
+   * \brief Checks whether the given MD5 digest belongs to the given file on NexusMods.
+   * \param mod_url URL to the mod on NexusMods.
+   * \param file_id Id of the file on NexusMods.
+   * \param md5 MD5 digest of the local file as a hex string.
+   * \return True if the digest matches the file, false if it does not. An empty optional if
+   * the check could not be performed.
+   */
+  static std::optional<bool> verifyFileMd5(const std::string& mod_url,
+                                           long file_id,
+                                           const std::string& md5);
 
 private:
   /*! \brief The API key used for all operations. */
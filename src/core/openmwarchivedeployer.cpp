@@ -1,4 +1,5 @@
 #include "openmwarchivedeployer.h"
+#include "openmwconfig.h"
 #include <format>
 #include <fstream>
 #include <ranges>
@@ -56,56 +57,15 @@ void OpenMwArchiveDeployer::writePlugins() const
 {
   PluginDeployer::writePlugins();
 
-  const sfs::path plugin_file_path = dest_path_ / OPEN_MW_CONFIG_FILE_NAME;
-  std::ifstream in_file(plugin_file_path);
-  if(!in_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", plugin_file_path.string()));
-
-  std::vector<std::string> lines;
-  int archive_line = -1;
-  bool found_archive = false;
-  std::regex archive_regex(R"(^fallback-archive=.*)");
-  std::string line;
-  int i = 0;
-  while(getline(in_file, line))
-  {
-    std::smatch match;
-    if(std::regex_match(line, match, archive_regex))
-    {
-      if(!found_archive)
-        archive_line = i;
-      found_archive = true;
-    }
-    else
-      lines.push_back(line);
-    i++;
-  }
-  in_file.close();
-
-  std::ofstream out_file(plugin_file_path);
-  if(!out_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", plugin_file_path.string()));
-
-  if(archive_line == -1)
-  {
-    for(const auto& [plugin, enabled] : plugins_)
-    {
-      if(enabled)
-        out_file << "content=" + plugin + "\n";
-    }
-  }
-  for(const auto& [i, line] : str::enumerate_view(lines))
+  std::vector<std::string> archives;
+  for(const auto& [plugin, enabled] : plugins_)
   {
-    if(i == archive_line)
-    {
-      for(const auto& [plugin, enabled] : plugins_)
-      {
-        if(enabled)
-          out_file << "fallback-archive=" + plugin + "\n";
-      }
-    }
-    out_file << line << "\n";
+    if(enabled)
+      archives.push_back(plugin);
   }
+  OpenMwConfig config(dest_path_ / OPEN_MW_CONFIG_FILE_NAME);
+  config.setValues("fallback-archive", archives);
+  config.write();
 }
 
 void OpenMwArchiveDeployer::updatePluginTags() {}
@@ -116,18 +76,11 @@ bool OpenMwArchiveDeployer::initPluginFile()
   if(sfs::exists(plugin_file_path))
     return false;
 
-  const sfs::path config_file_path = dest_path_ / OPEN_MW_CONFIG_FILE_NAME;
-  std::ifstream in_file(config_file_path);
-  if(!in_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", config_file_path.string()));
-
-  std::string line;
-  std::regex archive_regex(R"(^fallback-archive=(.*?\.[bB][sS][aA]))");
-  while(getline(in_file, line))
+  const OpenMwConfig config(dest_path_ / OPEN_MW_CONFIG_FILE_NAME);
+  for(const auto& archive : config.getValues("fallback-archive"))
   {
-    std::smatch match;
-    if(std::regex_match(line, match, archive_regex))
-      plugins_.emplace_back(match[1], true);
+    if(std::regex_match(archive, plugin_regex_))
+      plugins_.emplace_back(archive, true);
   }
 
   PluginDeployer::writePlugins();
@@ -0,0 +1,137 @@
+#include "openmwconfig.h"
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+
+namespace sfs = std::filesystem;
+namespace str = std::ranges;
+
+
+OpenMwConfig::OpenMwConfig(const sfs::path& path) : path_(path)
+{
+  std::ifstream file(path_, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Error: Could not open '{}'.", path_.string()));
+  content_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  file.close();
+
+  for(size_t start = 0; start < content_.size();)
+  {
+    size_t end = content_.find('\n', start);
+    if(end == std::string::npos)
+      end = content_.size();
+    // keys start at the beginning of a line and end at the first '='
+    size_t key_length = content_.find('=', start);
+    if(key_length >= end || content_[start] == '#')
+      key_length = 0;
+    else
+      key_length -= start;
+    lines_.push_back({ start, end - start, key_length });
+    start = end + 1;
+  }
+}
+
+std::vector<std::string> OpenMwConfig::getValues(const std::string& key) const
+{
+  std::vector<std::string> values;
+  for(const auto& line : lines_)
+  {
+    if(line.key_length == 0 || getKey(line) != key)
+      continue;
+    values.push_back(getValue(line));
+  }
+  return values;
+}
+
+std::vector<std::pair<std::string, std::string>> OpenMwConfig::getEntries() const
+{
+  std::vector<std::pair<std::string, std::string>> entries;
+  for(const auto& line : lines_)
+  {
+    if(line.key_length > 0)
+      entries.emplace_back(getKey(line), getValue(line));
+  }
+  return entries;
+}
+
+void OpenMwConfig::setValues(const std::string& key, const std::vector<std::string>& values)
+{
+  auto iter =
+    str::find_if(new_values_, [&key](const auto& pair) { return pair.first == key; });
+  if(iter == new_values_.end())
+    new_values_.emplace_back(key, values);
+  else
+    iter->second = values;
+}
+
+bool OpenMwConfig::write() const
+{
+  std::string content;
+  content.reserve(content_.size() + 1);
+  std::vector<bool> was_written(new_values_.size(), false);
+  auto write_values = [&](int index)
+  {
+    const auto& [key, values] = new_values_[index];
+    for(const auto& value : values)
+    {
+      content += key;
+      content += '=';
+      content += value;
+      content += '\n';
+    }
+    was_written[index] = true;
+  };
+
+  for(const auto& line : lines_)
+  {
+    if(line.key_length > 0)
+    {
+      const std::string_view key = getKey(line);
+      auto iter =
+        str::find_if(new_values_, [key](const auto& pair) { return pair.first == key; });
+      if(iter != new_values_.end())
+      {
+        const int index = iter - new_values_.begin();
+        if(!was_written[index])
+          write_values(index);
+        continue;
+      }
+    }
+    content.append(content_, line.start, line.length);
+    content += '\n';
+  }
+  for(int i = 0; i < new_values_.size(); i++)
+  {
+    if(!was_written[i])
+      write_values(i);
+  }
+
+  if(content == content_)
+    return false;
+  const sfs::path tmp_path = path_.string() + ".tmp";
+  std::ofstream file(tmp_path, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error(std::format("Error: Could not open '{}'.", tmp_path.string()));
+  file << content;
+  file.close();
+  if(file.fail())
+    throw std::runtime_error(std::format("Error: Could not write to '{}'.", tmp_path.string()));
+  sfs::rename(tmp_path, path_);
+  return true;
+}
+
+std::string_view OpenMwConfig::getKey(const Line& line) const
+{
+  return std::string_view(content_).substr(line.start, line.key_length);
+}
+
+std::string OpenMwConfig::getValue(const Line& line) const
+{
+  std::string value =
+    content_.substr(line.start + line.key_length + 1, line.length - line.key_length - 1);
+  if(value.ends_with('\r'))
+    value.pop_back();
+  return value;
+}
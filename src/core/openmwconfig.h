@@ -0,0 +1,89 @@
+/*!
+ * \file openmwconfig.h
+ * \brief Header for the OpenMwConfig class.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+/*!
+ * \brief Represents an openmw.cfg file. The file is parsed once, after which all values
+ * for any number of keys, e.g. content or groundcover, can be replaced and written back
+ * in a single pass.
+ */
+class OpenMwConfig
+{
+public:
+  /*!
+   * \brief Reads and parses the given file.
+   * \param path Path to the config file.
+   * \throw std::runtime_error If the file could not be read.
+   */
+  OpenMwConfig(const std::filesystem::path& path);
+
+  /*!
+   * \brief Returns all values of the given key, in the order in which they appear in the file.
+   * \param key Target key, e.g. "content".
+   * \return The values.
+   */
+  std::vector<std::string> getValues(const std::string& key) const;
+  /*!
+   * \brief Returns all key value pairs, in the order in which they appear in the file.
+   * \return The pairs.
+   */
+  std::vector<std::pair<std::string, std::string>> getEntries() const;
+  /*!
+   * \brief Replaces all values of the given key. The new values are written at the position
+   * of the first line containing the key or, if no such line exists, at the end of the file.
+   * \param key Target key, e.g. "content".
+   * \param values The new values.
+   */
+  void setValues(const std::string& key, const std::vector<std::string>& values);
+  /*!
+   * \brief Writes all changes to disk. To avoid leaving a partially written config, the new
+   * contents are written to a temporary file which then replaces the config file.
+   * \return True if the file has been written, false if there were no changes.
+   * \throw std::runtime_error If the file could not be written.
+   */
+  bool write() const;
+
+private:
+  /*! \brief Position of one line in \ref content_. */
+  struct Line
+  {
+    /*! \brief Index of the first character. */
+    size_t start;
+    /*! \brief Length of the line, excluding the line break. */
+    size_t length;
+    /*! \brief Length of the key at the start of the line or 0 if the line contains no key. */
+    size_t key_length;
+  };
+
+  /*! \brief Path to the config file. */
+  std::filesystem::path path_;
+  /*! \brief Contents of the file at the time it was read. */
+  std::string content_;
+  /*! \brief All lines in the file. */
+  std::vector<Line> lines_;
+  /*! \brief Keys whose values have been replaced, in the order they were set in. */
+  std::vector<std::pair<std::string, std::vector<std::string>>> new_values_;
+
+  /*!
+   * \brief Returns the key of the given line.
+   * \param line Target line.
+   * \return The key or an empty view if the line contains no key.
+   */
+  std::string_view getKey(const Line& line) const;
+  /*!
+   * \brief Returns the value of the given line.
+   * \param line Target line, must contain a key.
+   * \return The value, without a trailing carriage return.
+   */
+  std::string getValue(const Line& line) const;
+};
@@ -1,4 +1,5 @@
 #include "openmwplugindeployer.h"
+#include "openmwconfig.h"
 #include "pathutils.h"
 #include <format>
 #include <fstream>
@@ -168,26 +169,16 @@ bool OpenMwPluginDeployer::initPluginFile()
   if(sfs::exists(plugin_file_path))
     return false;
 
-  const sfs::path config_file_path = dest_path_ / OPEN_MW_CONFIG_FILE_NAME;
-  std::ifstream in_file(config_file_path);
-  if(!in_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", config_file_path.string()));
-
-  std::string line;
-  std::regex plugin_regex(R"(^content=(.*\.(?:es[pm]|omwscripts|omwaddon|omwgame)))",
-                          std::regex_constants::icase);
-  std::regex groundcover_regex(R"(^groundcover=(.*\.(?:es[pm]|omwscripts|omwaddon|omwgame)))",
-                               std::regex_constants::icase);
+  const OpenMwConfig config(dest_path_ / OPEN_MW_CONFIG_FILE_NAME);
   num_groundcover_plugins_ = 0;
-  while(getline(in_file, line))
+  for(const auto& [key, plugin] : config.getEntries())
   {
-    std::smatch match;
-    if(std::regex_match(line, match, plugin_regex))
-      plugins_.emplace_back(match[1], true);
-    else if(std::regex_match(line, match, groundcover_regex))
+    if((key != "content" && key != "groundcover") || !std::regex_match(plugin, plugin_regex_))
+      continue;
+    plugins_.emplace_back(plugin, true);
+    if(key == "groundcover")
     {
-      plugins_.emplace_back(match[1], true);
-      groundcover_plugins_.insert(match[1]);
+      groundcover_plugins_.insert(plugin);
       num_groundcover_plugins_++;
     }
   }
@@ -328,75 +319,23 @@ void OpenMwPluginDeployer::writePluginTagsPrivate() const
   file.close();
 }
 
-void OpenMwPluginDeployer::writePluginsToOpenMwConfig(const std::string& line_prefix,
-                                                      const std::regex& line_regex,
-                                                      std::function<bool(int)> plugin_filter) const
+void OpenMwPluginDeployer::writePluginsPrivate() const
 {
-  const sfs::path plugin_file_path = dest_path_ / OPEN_MW_CONFIG_FILE_NAME;
-  std::ifstream in_file(plugin_file_path);
-  if(!in_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", plugin_file_path.string()));
+  PluginDeployer::writePlugins();
 
-  std::vector<std::string> lines;
-  int target_line = -1;
-  bool found_target = false;
-  std::string line;
-  int i = 0;
-  while(getline(in_file, line))
+  std::vector<std::string> content;
+  std::vector<std::string> groundcover;
+  for(const auto& [plugin, enabled] : plugins_)
   {
-    std::smatch match;
-    if(std::regex_match(line, match, line_regex))
-    {
-      if(!found_target)
-        target_line = i;
-      found_target = true;
-    }
+    if(!enabled)
+      continue;
+    if(groundcover_plugins_.contains(plugin))
+      groundcover.push_back(plugin);
     else
-      lines.push_back(line);
-    i++;
+      content.push_back(plugin);
   }
-  in_file.close();
-
-  std::ofstream out_file(plugin_file_path);
-  if(!out_file.is_open())
-    throw std::runtime_error(std::format("Error: Could not open '{}'.", plugin_file_path.string()));
-
-  for(const auto& [i, line] : str::enumerate_view(lines))
-  {
-    if(i == target_line)
-    {
-      for(const auto& [i, pair] : str::enumerate_view(plugins_))
-      {
-        if(plugin_filter(i))
-          out_file << line_prefix + pair.first + "\n";
-      }
-    }
-    out_file << line << "\n";
-  }
-  if(target_line == -1 || target_line >= lines.size())
-  {
-    for(const auto& [i, pair] : str::enumerate_view(plugins_))
-    {
-      if(plugin_filter(i))
-        out_file << line_prefix + pair.first + "\n";
-    }
-  }
-}
-
-void OpenMwPluginDeployer::writePluginsPrivate() const
-{
-  PluginDeployer::writePlugins();
-
-  writePluginsToOpenMwConfig("content=",
-                             std::regex(R"(^content=.*)"),
-                             [this](int i) {
-                               return plugins_[i].second &&
-                                      !groundcover_plugins_.contains(plugins_[i].first);
-                             });
-  writePluginsToOpenMwConfig("groundcover=",
-                             std::regex(R"(^groundcover=.*)"),
-                             [this](int i) {
-                               return plugins_[i].second &&
-                                      groundcover_plugins_.contains(plugins_[i].first);
-                             });
+  OpenMwConfig config(dest_path_ / OPEN_MW_CONFIG_FILE_NAME);
+  config.setValues("content", content);
+  config.setValues("groundcover", groundcover);
+  config.write();
 }
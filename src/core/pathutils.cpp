@@ -1,11 +1,20 @@
 #include "pathutils.h"
 #include <algorithm>
+#include <fcntl.h>
+#include <linux/fs.h>
 #include <regex>
 #include <set>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace sfs = std::filesystem;
 namespace pu = path_utils;
 
+#ifndef FS_CASEFOLD_FL
+#define FS_CASEFOLD_FL 0x40000000
+#endif
+
 
 namespace path_utils
 {
@@ -206,4 +215,76 @@ bool exists(const std::filesystem::path& path)
 {
   return sfs::status(path).type() != sfs::file_type::not_found;
 }
+
+bool reflinkFile(const sfs::path& source, const sfs::path& destination)
+{
+  const int source_fd = open(source.c_str(), O_RDONLY);
+  if(source_fd < 0)
+    return false;
+  struct stat source_stat;
+  if(fstat(source_fd, &source_stat) != 0)
+  {
+    close(source_fd);
+    return false;
+  }
+  const int dest_fd = open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL, source_stat.st_mode);
+  if(dest_fd < 0)
+  {
+    close(source_fd);
+    return false;
+  }
+  const bool success = ioctl(dest_fd, FICLONE, source_fd) == 0;
+  close(source_fd);
+  close(dest_fd);
+  if(!success)
+    sfs::remove(destination);
+  return success;
+}
+
+bool copyFileRange(const sfs::path& source, const sfs::path& destination)
+{
+  const int source_fd = open(source.c_str(), O_RDONLY);
+  if(source_fd < 0)
+    return false;
+  struct stat source_stat;
+  if(fstat(source_fd, &source_stat) != 0)
+  {
+    close(source_fd);
+    return false;
+  }
+  const int dest_fd = open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL, source_stat.st_mode);
+  if(dest_fd < 0)
+  {
+    close(source_fd);
+    return false;
+  }
+  bool success = true;
+  off_t remaining = source_stat.st_size;
+  while(remaining > 0)
+  {
+    const ssize_t ret = copy_file_range(source_fd, nullptr, dest_fd, nullptr, remaining, 0);
+    if(ret <= 0)
+    {
+      success = false;
+      break;
+    }
+    remaining -= ret;
+  }
+  close(source_fd);
+  close(dest_fd);
+  if(!success)
+    sfs::remove(destination);
+  return success;
+}
+
+bool isCaseFolded(const sfs::path& directory)
+{
+  const int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if(fd < 0)
+    return false;
+  int flags = 0;
+  const bool success = ioctl(fd, FS_IOC_GETFLAGS, &flags) == 0;
+  close(fd);
+  return success && (flags & FS_CASEFOLD_FL) != 0;
+}
 }
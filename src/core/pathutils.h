@@ -114,4 +114,28 @@ void copyOrMoveFiles(const std::filesystem::path& source,
  * \return True if path exists.
  */
 bool exists(const std::filesystem::path& path);
+/*!
+ * \brief Creates a copy of the given file which shares its data blocks with the source, if
+ * the filesystem supports this. The new file is only written to disk once either file is
+ * modified.
+ * \param source File to copy.
+ * \param destination Path to the new file. Must not exist.
+ * \return True if the copy was created, false if the filesystem does not support reflinks.
+ */
+bool reflinkFile(const std::filesystem::path& source, const std::filesystem::path& destination);
+/*!
+ * \brief Copies the given file using copy_file_range, which lets the kernel copy the data
+ * without passing it through user space and enables server side copies on network filesystems.
+ * \param source File to copy.
+ * \param destination Path to the new file. Must not exist.
+ * \return True if the copy was created, false if copy_file_range is not supported.
+ */
+bool copyFileRange(const std::filesystem::path& source, const std::filesystem::path& destination);
+/*!
+ * \brief Checks if the given directory has the casefold attribute, i.e. if the kernel
+ * resolves names of files in it case insensitively. Supported by ext4 and f2fs.
+ * \param directory Directory to check.
+ * \return True if the directory is case folded.
+ */
+bool isCaseFolded(const std::filesystem::path& directory);
 }
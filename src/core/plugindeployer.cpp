@@ -72,6 +72,26 @@ void PluginDeployer::changeLoadorder(int from_index, int to_index)
   writePlugins();
 }
 
+void PluginDeployer::reorderMods(const std::vector<int>& order)
+{
+  checkLoadorderPermutation(order, plugins_.size());
+  std::vector<std::pair<std::string, bool>> new_plugins;
+  new_plugins.reserve(plugins_.size());
+  for(int index : order)
+    new_plugins.push_back(std::move(plugins_[index]));
+  plugins_ = std::move(new_plugins);
+  if(tags_.size() == plugins_.size())
+  {
+    std::vector<std::vector<std::string>> new_tags;
+    new_tags.reserve(tags_.size());
+    for(int index : order)
+      new_tags.push_back(std::move(tags_[index]));
+    tags_ = std::move(new_tags);
+  }
+  writePluginTags();
+  writePlugins();
+}
+
 void PluginDeployer::setModStatus(int mod_id, bool status)
 {
   if(mod_id >= plugins_.size() || mod_id < 0)
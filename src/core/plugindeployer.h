@@ -47,6 +47,12 @@ public:
    * \param to_index Destination index.
    */
   virtual void changeLoadorder(int from_index, int to_index) override;
+  /*!
+   * \brief Replaces the plugin load order with a permutation of itself. Saves changes to disk.
+   * \param order For every new position: The current index of the plugin at that position.
+   * \throw std::invalid_argument If order is no permutation of the current indices.
+   */
+  virtual void reorderMods(const std::vector<int>& order) override;
   /*!
    * \brief Enables or disables the given mod in the load order. Saves changes to disk.
    * \param mod_id Mod to be edited.
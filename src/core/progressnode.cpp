@@ -1,17 +1,20 @@
 #include "progressnode.h"
+#include "cancellationerror.h"
 #include <limits>
 #include <numeric>
 
 
 ProgressNode::ProgressNode(int id,
                            const std::vector<float>& weights,
-                           std::optional<ProgressNode*> parent) : id_(id), parent_(parent)
+                           std::optional<ProgressNode*> parent) :
+  id_(id), parent_(parent), cancel_flag_(parent ? (*parent)->cancel_flag_ : nullptr)
 {
   addChildren(weights);
 }
 
 ProgressNode::ProgressNode(std::function<void(float)> progress_callback,
-                           const std::vector<float>& weights)
+                           const std::vector<float>& weights,
+                           const std::atomic<bool>* cancel_flag) : cancel_flag_(cancel_flag)
 {
   addChildren(weights);
   setProgressCallback(progress_callback);
@@ -86,6 +89,17 @@ float ProgressNode::getProgress() const
   return progress_;
 }
 
+bool ProgressNode::isCanceled() const
+{
+  return cancel_flag_ != nullptr && cancel_flag_->load(std::memory_order_relaxed);
+}
+
+void ProgressNode::checkCanceled() const
+{
+  if(isCanceled())
+    throw CancellationError();
+}
+
 void ProgressNode::updateProgress()
 {
   progress_ = 0.0f;
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -17,6 +18,9 @@
  * Each node in the tree represents the progress in a sub-task. Each sub-task has
  * a weight associated to it, which should be proportional to the time this task takes
  * to be completed.
+ *
+ * A root node can be given a flag used to request cancellation of the task. All nodes of the
+ * tree share this flag, so long running loops can poll it cheaply using \ref isCanceled.
  */
 class ProgressNode
 {
@@ -33,9 +37,11 @@ public:
    * \param progress_callback a callback function used by the root node to inform about
    * changes in the task progress.
    * \param weights If not empty: Weights of sub-tasks.
+   * \param cancel_flag If not null: Setting this flag to true requests cancellation of the task.
    */
   ProgressNode(std::function<void(float)> progress_callback,
-               const std::vector<float>& weights = {});
+               const std::vector<float>& weights = {},
+               const std::atomic<bool>* cancel_flag = nullptr);
 
   /*!
    * \brief Advances the current progress of this node by the given amount of steps.
@@ -90,6 +96,17 @@ public:
    * \return The progress.
    */
   float getProgress() const;
+  /*!
+   * \brief Checks if cancellation of the task has been requested. Safe to call from any thread.
+   * \return True if the task should be canceled.
+   */
+  bool isCanceled() const;
+  /*!
+   * \brief Throws a CancellationError if cancellation of the task has been requested.
+   * Callers must ensure that all changes made so far are in a consistent state.
+   * \throws CancellationError If the task should be canceled.
+   */
+  void checkCanceled() const;
 
 private:
   /*! \brief This nodes id. */
@@ -110,6 +127,8 @@ private:
   std::vector<float> weights_;
   /*! \brief Children representing sub-tasks of this task. */
   std::vector<ProgressNode> children_;
+  /*! \brief Flag of the root node used to request cancellation. May be null. */
+  const std::atomic<bool>* cancel_flag_ = nullptr;
 
   /*!
    * \brief Callback function used by the root node to inform about changes in the
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <numeric>
 #include <ranges>
+#include <sys/stat.h>
 
 namespace sfs = std::filesystem;
 namespace pu = path_utils;
@@ -96,6 +97,7 @@ void ReverseDeployer::unDeploy(std::optional<ProgressNode*> progress_node)
   }
   deployed_profile_ = -1;
   deployed_loadorder_.clear();
+  deployed_fingerprints_.clear();
 }
 
 void ReverseDeployer::changeLoadorder(int from_index, int to_index)
@@ -110,6 +112,13 @@ void ReverseDeployer::changeLoadorder(int from_index, int to_index)
                                                                                                 ".");
 }
 
+void ReverseDeployer::reorderMods(const std::vector<int>& order)
+{
+  log_(Log::LOG_DEBUG,
+       "WARNING: You are trying to change the load order of a reverse deployer. "
+       "This will have no effect.");
+}
+
 void ReverseDeployer::setModStatus(int mod_id, bool status)
 {
   if(mod_id >= current_loadorder_.size() || mod_id < 0)
@@ -632,10 +641,21 @@ void ReverseDeployer::readManagedFiles()
     }
   }
   deployed_loadorder_.clear();
+  deployed_fingerprints_.clear();
+  auto read_fingerprint = [](const Json::Value& json)
+  {
+    return Fingerprint{
+      json[0].asUInt64(), json[1].asUInt64(), json[2].asUInt64(), json[3].asInt64()
+    };
+  };
   for(int i = 0; i < json_object["deployed_loadorder"].size(); i++)
   {
-    deployed_loadorder_.emplace_back(json_object["deployed_loadorder"][i]["path"].asString(),
-                                     json_object["deployed_loadorder"][i]["enabled"].asBool());
+    const auto& entry = json_object["deployed_loadorder"][i];
+    deployed_loadorder_.emplace_back(entry["path"].asString(), entry["enabled"].asBool());
+    if(entry.isMember("target_stat") && entry.isMember("source_stat"))
+      deployed_fingerprints_[deployed_loadorder_.back().first] = {
+        read_fingerprint(entry["target_stat"]), read_fingerprint(entry["source_stat"])
+      };
   }
   updateCurrentLoadorder();
 }
@@ -656,11 +676,29 @@ void ReverseDeployer::writeManagedFiles() const
       json_object["managed_files"][prof]["files"][(int)i]["enabled"] = enabled;
     }
   }
+  auto write_fingerprint = [](const Fingerprint& fingerprint)
+  {
+    const auto& [device, inode, size, mtime] = fingerprint;
+    Json::Value json = Json::arrayValue;
+    json.append(Json::UInt64(device));
+    json.append(Json::UInt64(inode));
+    json.append(Json::UInt64(size));
+    json.append(Json::Int64(mtime));
+    return json;
+  };
   for(const auto& [i, pair] : str::enumerate_view(deployed_loadorder_))
   {
     const auto& [path, enabled] = pair;
     json_object["deployed_loadorder"][(int)i]["path"] = path.string();
     json_object["deployed_loadorder"][(int)i]["enabled"] = enabled;
+    auto iter = deployed_fingerprints_.find(path);
+    if(iter != deployed_fingerprints_.end())
+    {
+      json_object["deployed_loadorder"][(int)i]["target_stat"] =
+        write_fingerprint(iter->second.first);
+      json_object["deployed_loadorder"][(int)i]["source_stat"] =
+        write_fingerprint(iter->second.second);
+    }
   }
 
   const sfs::path managed_files_path = source_path_ / managed_files_name_;
@@ -695,6 +733,9 @@ int ReverseDeployer::updateFilesInDir(const sfs::path& target_dir,
 
   for(const auto& dir_entry : sfs::directory_iterator(target_dir))
   {
+    // contains the deployment history of another deployer
+    if(dir_entry.path().filename() == generations_dir_name_)
+      continue;
     if(dir_entry.is_directory())
       dirs.push_back(dir_entry.path());
     else
@@ -709,7 +750,9 @@ int ReverseDeployer::updateFilesInDir(const sfs::path& target_dir,
     const sfs::path file_name = file.filename();
     const sfs::path path_relative_to_target = pu::getRelativePath(file, dest_path_);
     if(file_name == deployed_files_name_ || file_name == ignore_list_file_name_ ||
-       file_name.extension() == backup_extension_ || file_name == managed_dir_file_name_)
+       file_name.extension() == backup_extension_ || file_name == managed_dir_file_name_ ||
+       file_name == hash_cache_name_ || file_name == journal_name_ ||
+       file_name == pending_deployed_files_name_)
       continue;
     if(ignored_files_.contains(path_relative_to_target) || current_deployed_files.contains(file))
     {
@@ -745,9 +788,18 @@ int ReverseDeployer::updateFilesInDir(const sfs::path& target_dir,
 void ReverseDeployer::moveFilesFromTargetToSource() const
 {
   bool move_failed = false;
+  const bool check_fingerprints = deployed_profile_ == current_profile_;
   for(const auto& [path, enabled] : current_loadorder_)
   {
     const sfs::path full_dest_path = dest_path_ / path;
+    if(check_fingerprints)
+    {
+      // files which have not changed since deployment can not contain new data
+      auto iter = deployed_fingerprints_.find(path);
+      if(iter != deployed_fingerprints_.end() &&
+         getFingerprint(full_dest_path) == iter->second.first)
+        continue;
+    }
     const sfs::path full_source_path = getSourcePath(path, current_profile_);
     const bool dest_exists = pu::exists(full_dest_path);
     const bool source_exists = sfs::exists(full_source_path);
@@ -816,11 +868,37 @@ void ReverseDeployer::updateCurrentLoadorder()
 void ReverseDeployer::deployManagedFiles()
 {
   log_(Log::LOG_INFO, std::format("Deployer '{}': Deploying managed files...", name_));
+  std::unordered_map<sfs::path, bool> deployed_status;
+  if(deployed_profile_ == current_profile_)
+  {
+    deployed_status.reserve(deployed_loadorder_.size());
+    for(const auto& [path, enabled] : deployed_loadorder_)
+      deployed_status[path] = enabled;
+  }
+  std::unordered_map<sfs::path, std::pair<Fingerprint, Fingerprint>> new_fingerprints;
+  new_fingerprints.reserve(current_loadorder_.size());
+  int num_changed = 0;
   for(const auto& [path, enabled] : current_loadorder_)
   {
     const sfs::path full_dest_path = dest_path_ / path;
     const sfs::path full_source_path = getSourcePath(path, current_profile_);
 
+    auto status_iter = deployed_status.find(path);
+    if(status_iter != deployed_status.end() && status_iter->second == enabled)
+    {
+      if(!enabled && !getFingerprint(full_dest_path))
+        continue;
+      auto iter = deployed_fingerprints_.find(path);
+      if(enabled && iter != deployed_fingerprints_.end() &&
+         getFingerprint(full_dest_path) == iter->second.first &&
+         getFingerprint(full_source_path) == iter->second.second)
+      {
+        new_fingerprints.insert(*iter);
+        continue;
+      }
+    }
+    num_changed++;
+
     if(!sfs::exists(full_source_path))
     {
       log_(Log::LOG_ERROR,
@@ -840,9 +918,30 @@ void ReverseDeployer::deployManagedFiles()
       sfs::create_symlink(full_source_path, full_dest_path);
     else
       sfs::copy(full_source_path, full_dest_path);
+    const auto dest_fingerprint = getFingerprint(full_dest_path);
+    const auto source_fingerprint = getFingerprint(full_source_path);
+    if(dest_fingerprint && source_fingerprint)
+      new_fingerprints[path] = { *dest_fingerprint, *source_fingerprint };
   }
+  log_(Log::LOG_DEBUG,
+       std::format("Deployer '{}': Updated {} of {} managed files.",
+                   name_,
+                   num_changed,
+                   current_loadorder_.size()));
   deployed_profile_ = current_profile_;
   deployed_loadorder_ = current_loadorder_;
+  deployed_fingerprints_ = std::move(new_fingerprints);
+}
+
+std::optional<ReverseDeployer::Fingerprint> ReverseDeployer::getFingerprint(const sfs::path& path)
+{
+  struct stat file_stat;
+  if(lstat(path.c_str(), &file_stat) != 0)
+    return {};
+  return Fingerprint{ file_stat.st_dev,
+                      file_stat.st_ino,
+                      static_cast<uint64_t>(file_stat.st_size),
+                      file_stat.st_mtim.tv_sec * 1000000000 + file_stat.st_mtim.tv_nsec };
 }
 
 sfs::path ReverseDeployer::getSourcePath(const sfs::path& path, int profile) const
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "deployer.h"
+#include <unordered_map>
 
 
 /*!
@@ -66,6 +67,11 @@ public:
    * \param to_index Destination index.
    */
   void changeLoadorder(int from_index, int to_index) override;
+  /*!
+   * \brief Reverse deployers have no load order, this only logs a warning.
+   * \param order Ignored.
+   */
+  void reorderMods(const std::vector<int>& order) override;
   /*!
    * \brief Enables or disables the given mod in the load order. Saves changes to disk.
    * \param mod_id Mod to be edited.
@@ -300,6 +306,15 @@ private:
   std::vector<std::pair<std::filesystem::path, bool>> current_loadorder_;
   /*! \brief Contains all files and their enabled status for the currently deployed load order. */
   std::vector<std::pair<std::filesystem::path, bool>> deployed_loadorder_;
+  /*! \brief Identifies one version of a file: Device, inode, size and modification time. */
+  using Fingerprint = std::tuple<uint64_t, uint64_t, uint64_t, int64_t>;
+  /*!
+   * \brief For every enabled file in \ref deployed_loadorder_: Fingerprints of the file in the
+   * target directory and of its source, taken after deployment. Files whose fingerprints still
+   * match are not touched by subsequent deployments.
+   */
+  std::unordered_map<std::filesystem::path, std::pair<Fingerprint, Fingerprint>>
+    deployed_fingerprints_;
   /*! \brief Contains all files which should be ignored by this deployer. */
   std::unordered_set<std::string> ignored_files_;
   /*! \brief Currently deployed profile. */
@@ -336,12 +351,25 @@ private:
                        std::filesystem::path current_deployer_path,
                        bool update_ignored_files = false,
                        std::optional<ProgressNode*> progress_node = {});
-  /*! \brief Moves all managed files from dest_path_ to source_path_. */
+  /*!
+   * \brief Moves all managed files from dest_path_ to source_path_. Files which are still
+   * deployed as recorded in \ref deployed_fingerprints_ are skipped.
+   */
   void moveFilesFromTargetToSource() const;
   /*! \brief Updates current_loadorder_ to reflect managed_files_[current_profile_]. */
   void updateCurrentLoadorder();
-  /*! \brief Uses the operation specified in deploy mode to copy/ link files from source to target.*/
+  /*!
+   * \brief Uses the operation specified in deploy mode to copy/ link files from source to target.
+   * Only files whose enabled status, source or deployed file changed since the last deployment
+   * are updated.
+   */
   void deployManagedFiles();
+  /*!
+   * \brief Returns the fingerprint of the given file. Symbolic links are not followed.
+   * \param path Path to the file.
+   * \return The fingerprint or nothing if the file does not exist.
+   */
+  static std::optional<Fingerprint> getFingerprint(const std::filesystem::path& path);
   /*!
    * \brief Returns the full path pointing to the given file in source_path_.
    * \param path Relative path to to convert.
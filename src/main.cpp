@@ -3,27 +3,151 @@
  * \brief Contains the main function
  */
 
+#include "core/batchrunner.h"
+#include "core/cryptography.h"
+#include "core/nexus/api.h"
 #include "ui/ipcclient.h"
 #include "ui/mainwindow.h"
+#include "ui/settingsdialog.h"
 #include <QApplication>
+#include <QSettings>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
 
 
+/*!
+ * \brief Checks if the given arguments select a mode which does not need a user interface.
+ * \param argc Number of arguments passed to the application.
+ * \param argv Array of arguments passed to the application.
+ * \return True if no QApplication is needed.
+ */
+bool isHeadless(int argc, char* argv[])
+{
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg(argv[i]);
+    if(arg == "-l" || arg == "--list" || arg.starts_with("-d") || arg.starts_with("--deploy") ||
+       arg.starts_with("-b") || arg.starts_with("--batch"))
+      return true;
+  }
+  return false;
+}
+
+/*!
+ * \brief Sets the Nexus API key used by the batch runner. The key is read from the
+ * LIMO_NEXUS_API_KEY environment variable or, if it was stored without a password, from
+ * the settings.
+ */
+void initApiKey()
+{
+  if(const char* api_key = std::getenv("LIMO_NEXUS_API_KEY"); api_key != nullptr)
+  {
+    nexus::Api::setApiKey(api_key);
+    return;
+  }
+  const auto details = SettingsDialog::getNexusApiKeyDetails();
+  if(!details)
+    return;
+  const auto [cipher, nonce, tag, is_default_pw] = *details;
+  if(!is_default_pw)
+    return;
+  try
+  {
+    nexus::Api::setApiKey(cryptography::decrypt(cipher, cryptography::default_key, nonce, tag));
+  }
+  catch(CryptographyError& e)
+  {}
+}
+
+/*!
+ * \brief Runs the given commands for the given applications and prints the results as JSON.
+ * \param commands Comma separated list of commands.
+ * \param apps Comma separated list of application ids, each optionally followed by ':'
+ * and a profile id. If empty: Use all applications.
+ * \param path_prefix Path prefix used by the providers command.
+ * \param generation Deployer id, followed by ':' and a generation id, used by the rollback
+ * command. May be empty if that command is not used.
+ * \return 0: All commands succeeded. 1: An error occurred while parsing arguments.
+ * 3: At least one command failed.
+ */
+int runBatch(const QString& commands,
+             const QString& apps,
+             const QString& path_prefix,
+             const QString& generation)
+{
+  std::vector<std::filesystem::path> staging_dirs;
+  QSettings settings(QCoreApplication::applicationName());
+  int num_apps = settings.beginReadArray("staging_directories");
+  for(int i = 0; i < num_apps; i++)
+  {
+    settings.setArrayIndex(i);
+    staging_dirs.push_back(settings.value(QString::number(i)).toString().toStdString());
+  }
+  settings.endArray();
+
+  BatchRunner runner(staging_dirs);
+  try
+  {
+    for(const auto& command : commands.split(',', Qt::SkipEmptyParts))
+      runner.addCommand(command.trimmed().toStdString());
+    for(const auto& app : apps.split(',', Qt::SkipEmptyParts))
+    {
+      const auto parts = app.split(':');
+      bool app_is_int;
+      bool profile_is_int = true;
+      const int app_id = parts[0].trimmed().toInt(&app_is_int);
+      const int profile = parts.size() > 1 ? parts[1].trimmed().toInt(&profile_is_int) : -1;
+      if(!app_is_int || !profile_is_int || parts.size() > 2)
+        throw std::runtime_error("Invalid application: '" + app.toStdString() + "'.");
+      runner.addTarget(app_id, parts.size() > 1 ? std::optional<int>(profile) : std::nullopt);
+    }
+    runner.setPathPrefix(path_prefix.toStdString());
+    if(!generation.isEmpty())
+    {
+      const auto parts = generation.split(':');
+      bool deployer_is_int = false;
+      bool generation_is_int = false;
+      const int deployer_id = parts[0].trimmed().toInt(&deployer_is_int);
+      const int generation_id =
+        parts.size() == 2 ? parts[1].trimmed().toInt(&generation_is_int) : -1;
+      if(!deployer_is_int || !generation_is_int)
+        throw std::runtime_error("Invalid generation: '" + generation.toStdString() + "'.");
+      runner.setRollbackTarget(deployer_id, generation_id);
+    }
+  }
+  catch(std::runtime_error& error)
+  {
+    std::cout << "Error: " << error.what() << std::endl;
+    return 1;
+  }
+  initApiKey();
+  const Json::Value result = runner.run();
+  std::cout << result << std::endl;
+  return result["success"].asBool() ? 0 : 3;
+}
+
 /*!
  * \brief Main function of Limo.
  * \param argc Number of arguments passed to the application.
  * \param argv Array of arguments passed to the application.
  * \return 0: Application exited normally. 1: An error occurred while parsing arguments.
- * 2: Execution canceled, another Limo instance is already running.
+ * 2: Execution canceled, another Limo instance is already running. 3: At least one batch
+ * command failed.
  */
 int main(int argc, char* argv[])
 {
   QCoreApplication::setApplicationName("Limo");
-  QApplication app(argc, argv);
-  QIcon::setFallbackSearchPaths(
-    QIcon::fallbackSearchPaths()
-    << (std::filesystem::path(__FILE__).parent_path().parent_path() / "resources").c_str());
+  std::unique_ptr<QCoreApplication> app;
+  if(isHeadless(argc, argv))
+    app = std::make_unique<QCoreApplication>(argc, argv);
+  else
+  {
+    app = std::make_unique<QApplication>(argc, argv);
+    QIcon::setFallbackSearchPaths(
+      QIcon::fallbackSearchPaths()
+      << (std::filesystem::path(__FILE__).parent_path().parent_path() / "resources").c_str());
+  }
   QCommandLineParser parser;
   parser.setApplicationDescription("A simple tool for managing mods.");
   parser.addHelpOption();
@@ -35,14 +159,46 @@ int main(int argc, char* argv[])
                                    "application");
   QCommandLineOption profile_option(
     QStringList() << "p" << "profile", "Set a <profile> to use for deployment.", "profile");
+  QCommandLineOption batch_option(
+    QStringList() << "b" << "batch",
+    "Run comma separated <commands> without starting the user interface and print the results "
+    "as JSON. Supported commands: deploy, undeploy, external-changes, conflicts, reapply-tags, "
+    "check-updates, audit, repair, plan, providers, generations, rollback.",
+    "commands");
+  QCommandLineOption apps_option(QStringList() << "a" << "apps",
+                                 "Comma separated list of <applications> used for --batch. "
+                                 "Each application id can be followed by ':' and a profile id. "
+                                 "Default: All applications.",
+                                 "applications");
+  QCommandLineOption path_option(QStringList() << "path",
+                                 "Only list files starting with <prefix> for the batch "
+                                 "command providers. Default: All files.",
+                                 "prefix");
+  QCommandLineOption generation_option(QStringList() << "generation",
+                                       "<deployer>:<generation> to restore for the batch "
+                                       "command rollback.",
+                                       "generation");
   QCommandLineOption debug_option(QStringList() << "D" << "debug" << "Show debug log messages.");
   parser.addOption(list_option);
   parser.addOption(deploy_option);
   parser.addOption(profile_option);
+  parser.addOption(batch_option);
+  parser.addOption(apps_option);
+  parser.addOption(path_option);
+  parser.addOption(generation_option);
   parser.addOption(debug_option);
   parser.addPositionalArgument("url", "Imports the mod at this URL.");
-  parser.process(app);
+  parser.process(*app);
   const bool debug_mode = parser.isSet(debug_option);
+  if(parser.isSet(batch_option))
+  {
+    if(debug_mode)
+      Log::log_level = Log::LOG_DEBUG;
+    return runBatch(parser.value(batch_option),
+                    parser.value(apps_option),
+                    parser.value(path_option),
+                    parser.value(generation_option));
+  }
   if(parser.isSet(list_option))
   {
     ApplicationManager app_man;
@@ -117,7 +273,7 @@ int main(int argc, char* argv[])
     return 0;
   }
 
-  app.setWindowIcon(QIcon(":/logo.png"));
+  QApplication::setWindowIcon(QIcon(":/logo.png"));
   MainWindow w;
   w.setDebugMode(debug_mode);
   if(!pos_args.empty())
@@ -125,5 +281,5 @@ int main(int argc, char* argv[])
   emit w.getApplicationNames(false);
   w.show();
   w.initChangelog();
-  return app.exec();
+  return app->exec();
 }
@@ -39,6 +39,7 @@ void AddBackupTargetDialog::resetDialog(int app_id)
   ui->target_path_field->setText("");
   ui->default_backup_field->setText("");
   ui->first_backup_field->setText("");
+  ui->chunk_store_box->setChecked(false);
   updateOkButton();
   dialog_completed_ = false;
 }
@@ -82,7 +83,8 @@ void AddBackupTargetDialog::on_buttonBox_accepted()
                          ui->target_name_field->text(),
                          ui->target_path_field->text(),
                          ui->default_backup_field->text(),
-                         ui->first_backup_field->text());
+                         ui->first_backup_field->text(),
+                         ui->chunk_store_box->isChecked());
 }
 
 
@@ -94,10 +94,12 @@ signals:
    * \param target_path Path to the file or directory to be managed.
    * \param default_backup Name of the currently active version of the target.
    * \param first_backup If not empty: Name of the first backup.
+   * \param use_chunk_store If true: Store inactive backups in a deduplicated chunk store.
    */
   void backupTargetAdded(int app_id,
                          QString target_name,
                          QString target_path,
                          QString default_backup,
-                         QString first_backup);
+                         QString first_backup,
+                         bool use_chunk_store);
 };
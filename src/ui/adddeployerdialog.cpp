@@ -54,9 +54,10 @@ void AddDeployerDialog::updateOkButton()
                  ui->source_path_field->hasValidText());
 }
 
-void AddDeployerDialog::setAddMode(int app_id)
+void AddDeployerDialog::setAddMode(int app_id, const QString& staging_dir)
 {
   app_id_ = app_id;
+  staging_dir_ = staging_dir;
   setWindowTitle("New Deployer");
   ui->name_field->clear();
   ui->path_field->clear();
@@ -64,6 +65,7 @@ void AddDeployerDialog::setAddMode(int app_id)
   ui->deploy_mode_box->setCurrentIndex(Deployer::hard_link);
   ui->warning_label->setHidden(true);
   ui->sym_link_label->setHidden(true);
+  ui->capabilities_label->setHidden(true);
   edit_mode_ = false;
   setupTypeBox();
   enableOkButton(false);
@@ -106,6 +108,7 @@ void AddDeployerDialog::setEditMode(const QString& type,
   setupTypeBox();
   setWindowTitle("Edit " + name);
   edit_mode_ = true;
+  ui->capabilities_label->setHidden(true);
   ui->name_field->setText(name);
   ui->path_field->setText(target_path);
   for(int i = 0; i < ui->type_box->count(); i++)
@@ -155,6 +158,43 @@ void AddDeployerDialog::updateSourceFields()
                                         !has_ignored_files_);
   ui->unsafe_sorting_box->setHidden(!is_openmw_plugin_deployer);
   updateOkButton();
+  updateDeployModeRecommendation();
+}
+
+void AddDeployerDialog::updateDeployModeRecommendation()
+{
+  const QString source_path = edit_mode_ ? source_path_ : staging_dir_;
+  if(ui->deploy_mode_box->isHidden() || source_path.isEmpty() || !pathIsValid())
+  {
+    ui->capabilities_label->setHidden(true);
+    return;
+  }
+  const auto capabilities = FilesystemProbe::probe(source_path.toStdString(),
+                                                   ui->path_field->text().toStdString());
+  if(!capabilities.source_writable)
+  {
+    ui->capabilities_label->setHidden(true);
+    return;
+  }
+  const auto deploy_mode = Deployer::recommendDeployMode(capabilities);
+  if(!edit_mode_)
+    ui->deploy_mode_box->setCurrentIndex(deploy_mode);
+  QStringList supported;
+  if(capabilities.hard_links)
+    supported << "hard links";
+  if(capabilities.reflinks)
+    supported << "reflinks";
+  if(capabilities.copy_file_range)
+    supported << "fast copies";
+  if(capabilities.sym_links)
+    supported << "sym links";
+  QString text = "Supported by the target directory: " +
+                 (supported.isEmpty() ? "regular copies" : supported.join(", ")) + ".";
+  if(capabilities.case_folding)
+    text += " File names are case insensitive.";
+  text += " Recommended method: " + ui->deploy_mode_box->itemText(deploy_mode) + ".";
+  ui->capabilities_label->setText(text);
+  ui->capabilities_label->setHidden(false);
 }
 
 void AddDeployerDialog::on_file_picker_button_clicked()
@@ -183,6 +223,11 @@ void AddDeployerDialog::on_path_field_textChanged(const QString& text)
   updateOkButton();
 }
 
+void AddDeployerDialog::on_path_field_editingFinished()
+{
+  updateDeployModeRecommendation();
+}
+
 
 void AddDeployerDialog::on_buttonBox_accepted()
 {
@@ -218,7 +263,10 @@ void AddDeployerDialog::on_buttonBox_accepted()
 void AddDeployerDialog::onFileDialogAccepted(const QString& path)
 {
   if(!path.isEmpty())
+  {
     ui->path_field->setText(path);
+    updateDeployModeRecommendation();
+  }
 }
 
 void AddDeployerDialog::on_type_box_currentIndexChanged(int index)
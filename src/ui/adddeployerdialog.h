@@ -32,8 +32,9 @@ public:
   /*!
    *  \brief Initializes this dialog to allow creating a new Deployer.
    *  \param app_id Id of the ModdedApplication owning the edited Deployer.
+   *  \param staging_dir Staging directory of the ModdedApplication.
    */
-  void setAddMode(int app_id);
+  void setAddMode(int app_id, const QString& staging_dir);
   /*!
    * \brief setEditMode Initializes this dialog to allow editing an existing Deployer.
    * \param type Current type of the edited Deployer.
@@ -80,6 +81,8 @@ private:
   bool dialog_completed_ = false;
   /*! \brief Current target directory of the edited Deployer. */
   QString source_path_;
+  /*! \brief Staging directory of the ModdedApplication owning the new Deployer. */
+  QString staging_dir_;
   /*!
    * \brief Used by ReverseDeployers: If true: Store files on a per profile basis.
    * Else: All profiles use the same files.
@@ -97,6 +100,11 @@ private:
   void enableOkButton(bool state);
   /*! \brief Checks whether the currently entered path exists. */
   bool pathIsValid();
+  /*!
+   * \brief Probes the capabilities of the source and target directories and displays them.
+   * When creating a new Deployer, selects the recommended deployment method.
+   */
+  void updateDeployModeRecommendation();
   /*! \brief Adds all available Deployer types to the type combo box. */
   void setupTypeBox();
   /*! \brief Updates the state of this dialog's OK button to only be enabled when all inputs are
@@ -110,6 +118,8 @@ private slots:
   void on_name_field_textChanged(const QString& text);
   /*! \brief Only enable the OK button if a valid target directory path has been entered. */
   void on_path_field_textChanged(const QString& text);
+  /*! \brief Updates the recommended deployment method for the new target directory. */
+  void on_path_field_editingFinished();
   /*! \brief Closes the dialog and emits a signal for completion. */
   void on_buttonBox_accepted();
   /*! \brief Updates the target path with given path. */
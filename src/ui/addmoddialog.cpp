@@ -171,6 +171,7 @@ bool AddModDialog::setupDialog(const QStringList& deployers,
                                const QStringList& deployer_paths,
                                const std::vector<bool>& autonomous_deployers,
                                const std::vector<bool>& case_invariant_deployers,
+                               bool has_bg3_deployer,
                                const QString& app_version,
                                const ImportModInfo& info,
                                const std::vector<RootLevelCondition>& root_level_conditions)
@@ -204,6 +205,15 @@ bool AddModDialog::setupDialog(const QStringList& deployers,
   ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
   ui->group_check->setCheckState(Qt::Unchecked);
   autonomous_deployers_ = autonomous_deployers;
+  for(const auto group : static_cast<const QList<QButtonGroup*>>(option_groups_))
+  {
+    auto pack_button = group->button(Installer::pack_bg3_pak);
+    if(!pack_button)
+      continue;
+    pack_button->setVisible(has_bg3_deployer);
+    if(!has_bg3_deployer && pack_button->isChecked())
+      group->buttons().first()->setChecked(true);
+  }
 
   int mod_index = -1;
   if(info.target_group_id != -1)
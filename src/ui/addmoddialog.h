@@ -53,6 +53,7 @@ public:
    * if that deployer is autonomous.
    * \param case_invariant_deployers Vector of bools indicating for each deployer
    * if that deployer is case invariant.
+   * \param has_bg3_deployer If false: Hide the option to pack mods for Baldurs Gate 3.
    * \param info Contains data relating to the current status of the mod import.
    * \param root_level_conditions Contains all root level conditions for the current app.
    * \return True if dialog creation was successful.
@@ -62,6 +63,7 @@ public:
                    const QStringList& deployer_paths,
                    const std::vector<bool>& autonomous_deployers,
                    const std::vector<bool>& case_invariant_deployers,
+                   bool has_bg3_deployer,
                    const QString& app_version,
                    const ImportModInfo& info,
                    const std::vector<RootLevelCondition>& root_level_conditions);
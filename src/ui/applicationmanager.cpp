@@ -1,5 +1,6 @@
 #include "applicationmanager.h"
 #include "../core/deployerfactory.h"
+#include "../core/downloader.h"
 #include "../core/installer.h"
 #include "../core/pathutils.h"
 #include <QCoreApplication>
@@ -8,10 +9,38 @@
 #include <QSettings>
 #include <QUrl>
 #include <regex>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
 
 namespace sfs = std::filesystem;
 namespace pu = path_utils;
 
+std::string formatFileSize(uint64_t size_in_bytes)
+{
+  std::string size_string;
+  uint64_t last_size = 0;
+  uint64_t size = size_in_bytes;
+  int exp = 0;
+  const std::vector<std::string> units{ "B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
+  while(size > 1024 && exp < units.size())
+  {
+    last_size = size;
+    size /= 1024;
+    exp++;
+  }
+  last_size /= 1.024;
+  size_string = std::to_string(size);
+  const int first_digit = (last_size / 100) % 10;
+  const int second_digit = (last_size / 10) % 10;
+  if(first_digit != 0 || second_digit != 0)
+    size_string += "." + std::to_string(first_digit);
+  if(second_digit != 0)
+    size_string += std::to_string(second_digit);
+  size_string += units[exp];
+  return size_string;
+}
+
 bool performDownload(ImportModInfo& info, ApplicationManager* app_mgr)
 {
   app_mgr->sendLogMessage(Log::LOG_DEBUG,
@@ -23,81 +52,143 @@ bool performDownload(ImportModInfo& info, ApplicationManager* app_mgr)
   sfs::path download_path = info.target_path;
   if(!sfs::exists(download_path))
     sfs::create_directories(download_path);
-  sfs::path file_name = match[1].str();
+  std::string file_name_str = match[1].str();
+  auto pos = file_name_str.find("%20");
+  while(pos != std::string::npos)
+  {
+    file_name_str.replace(pos, 3, " ");
+    pos = file_name_str.find("%20");
+  }
+  sfs::path file_name = file_name_str;
   const std::string file_name_prefix = file_name.stem();
   const std::string extension = file_name.extension();
   int suffix = 1;
-  while(pu::exists(download_path / file_name))
+  // an incomplete download of the same file is resumed instead of being replaced
+  while(pu::exists(download_path / file_name) &&
+        !Downloader::hasResumeState(download_path / file_name))
   {
     file_name = file_name_prefix + "(" + std::to_string(suffix) + ")" + extension;
     suffix++;
   }
-  std::string file_name_str = file_name.string();
-  auto pos = file_name_str.find("%20");
-  while(pos != std::string::npos)
-  {
-    file_name_str.replace(pos, 3, " ");
-    pos = file_name_str.find("%20");
-  }
-  file_name = file_name_str;
 
-  auto progress_callback = [app_mgr](float progress) { app_mgr->sendUpdateProgress(progress); };
-  std::ofstream fstream(download_path / file_name, std::ios::binary);
-  if(!fstream.is_open())
-    throw std::runtime_error("Failed to write to disk.");
-  bool message_sent = false;
-  cpr::Response response = cpr::Download(
-    fstream,
-    cpr::Url(info.remote_download_url),
-    cpr::ProgressCallback(
-      [app_mgr, &message_sent, &file_name, progress_callback](auto download_total,
-                                                              auto download_now,
-                                                              auto upload_total,
-                                                              auto upload_now,
-                                                              intptr_t user_data)
+  Downloader downloader(info.remote_download_url, download_path / file_name);
+  downloader.setLog([app_mgr](Log::LogLevel log_level, const std::string& message)
+                    { app_mgr->sendLogMessage(log_level, message); });
+  downloader.init();
+  const auto total_size = downloader.getTotalSize();
+  if(total_size)
+    app_mgr->sendLogMessage(Log::LOG_INFO,
+                            std::format("Downloading \"{}\" with size: {}...",
+                                        file_name.string(),
+                                        formatFileSize(*total_size)));
+
+  // Stream friendly archives are extracted while they are being downloaded. The downloaded data
+  // is passed to the extracting thread through a socket pair, since writing to a socket whose
+  // reader has closed fails with EPIPE instead of raising SIGPIPE.
+  const bool use_streaming =
+    !info.extracted_path.empty() && Installer::supportsStreamExtraction(file_name);
+  int stream_fds[2] = { -1, -1 };
+  std::thread extraction_thread;
+  std::atomic<bool> extraction_successful = false;
+  if(use_streaming && socketpair(AF_UNIX, SOCK_STREAM, 0, stream_fds) == 0)
+  {
+    if(sfs::exists(info.extracted_path))
+      sfs::remove_all(info.extracted_path);
+    extraction_thread = std::thread(
+      [app_mgr, &info, &extraction_successful, read_fd = stream_fds[0]]()
       {
-        if(!message_sent && download_total > 0)
+        try
+        {
+          Installer::extractFromStream(read_fd, info.extracted_path);
+          extraction_successful = true;
+        }
+        catch(std::runtime_error& error)
         {
-          std::string size_string;
-          long last_size = 0;
-          long size = download_total;
-          int exp = 0;
-          const std::vector<std::string> units{ "B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
-          while(size > 1024 && exp < units.size())
-          {
-            last_size = size;
-            size /= 1024;
-            exp++;
-          }
-          last_size /= 1.024;
-          size_string = std::to_string(size);
-          const int first_digit = (last_size / 100) % 10;
-          const int second_digit = (last_size / 10) % 10;
-          if(first_digit != 0 || second_digit != 0)
-            size_string += "." + std::to_string(first_digit);
-          if(second_digit != 0)
-            size_string += std::to_string(second_digit);
-          size_string += units[exp];
-
           app_mgr->sendLogMessage(
-            Log::LOG_INFO,
-            ("Downloading \"" + file_name.string() + "\" with size: ").c_str() + size_string +
-              "...");
-          message_sent = true;
+            Log::LOG_DEBUG,
+            std::format("Extraction during download failed: {}. Falling back to extraction "
+                        "after download.",
+                        error.what()));
+        }
+        shutdown(read_fd, SHUT_RDWR);
+      });
+    downloader.setStreamCallback(
+      [write_fd = stream_fds[1]](const char* data, uint64_t size)
+      {
+        uint64_t bytes_sent = 0;
+        while(bytes_sent < size)
+        {
+          const ssize_t ret = send(write_fd, data + bytes_sent, size - bytes_sent, MSG_NOSIGNAL);
+          if(ret <= 0)
+            return false;
+          bytes_sent += ret;
         }
-        if(download_total != 0)
-          progress_callback((float)download_now / (float)download_total);
         return true;
-      }));
-  if(response.status_code != 200)
+      });
+  }
+  auto finish_extraction = [&extraction_thread, &stream_fds]()
+  {
+    if(stream_fds[1] >= 0)
+      shutdown(stream_fds[1], SHUT_WR);
+    if(extraction_thread.joinable())
+      extraction_thread.join();
+    for(int& fd : stream_fds)
+    {
+      if(fd >= 0)
+        close(fd);
+      fd = -1;
+    }
+  };
+
+  auto progress_callback = [app_mgr](float progress) { app_mgr->sendUpdateProgress(progress); };
+  ProgressNode node(progress_callback);
+  try
   {
-    sfs::remove(download_path / file_name);
-    throw std::runtime_error("Download failed with response: \"" + response.status_line +
-                             "\" (code " + std::to_string(response.status_code) + ").");
+    downloader.download(&node);
+  }
+  catch(std::runtime_error& error)
+  {
+    finish_extraction();
+    if(!info.extracted_path.empty() && sfs::exists(info.extracted_path))
+      sfs::remove_all(info.extracted_path);
+    throw;
+  }
+  finish_extraction();
+  if(!extraction_successful)
+  {
+    if(sfs::exists(info.extracted_path))
+      sfs::remove_all(info.extracted_path);
+    info.extracted_path.clear();
+  }
+
+  if(info.remote_type == ImportModInfo::nexus && info.remote_file_id != -1 &&
+     nexus::Api::modUrlIsValid(info.remote_source))
+  {
+    const auto is_valid =
+      nexus::Api::verifyFileMd5(info.remote_source, info.remote_file_id, downloader.getMd5());
+    if(!is_valid)
+      app_mgr->sendLogMessage(Log::LOG_WARNING,
+                              std::format("Could not verify the checksum of \"{}\".",
+                                          file_name.string()));
+    else if(!*is_valid)
+    {
+      sfs::remove(download_path / file_name);
+      if(!info.extracted_path.empty())
+        sfs::remove_all(info.extracted_path);
+      throw std::runtime_error(
+        std::format("Checksum of \"{}\" does not match the file on NexusMods. The download "
+                    "is likely corrupted.",
+                    file_name.string()));
+    }
   }
-  fstream.close();
   info.local_source = download_path / file_name;
   info.current_path = info.local_source;
+  if(!info.extracted_path.empty())
+  {
+    QSettings settings(QCoreApplication::applicationName());
+    if(!settings.value("keep_streamed_archives", true).toBool())
+      sfs::remove(info.local_source);
+  }
   return true;
 }
 
@@ -105,8 +196,14 @@ bool performExtraction(ImportModInfo& info, ApplicationManager* app_mgr)
 {
   info.last_action_was_successful = false;
   auto progress_callback = [app_mgr](float progress) { app_mgr->sendUpdateProgress(progress); };
-  ProgressNode node(progress_callback);
-  Installer::extract(info.local_source, info.target_path, &node);
+  ProgressNode node(progress_callback, {}, app_mgr->getCancelFlag());
+  if(!info.extracted_path.empty() && sfs::exists(info.extracted_path))
+  {
+    Installer::extract(info.extracted_path, info.target_path, &node);
+    info.extracted_path.clear();
+  }
+  else
+    Installer::extract(info.local_source, info.target_path, &node);
   info.current_path = info.target_path;
   info.last_action_was_successful = true;
   return true;
@@ -185,6 +282,7 @@ void ApplicationManager::updateState()
 {
   apps_.clear();
   QSettings settings(QCoreApplication::applicationName());
+  const bool track_external_changes = settings.value("track_external_changes", false).toBool();
   int num_apps = settings.beginReadArray("staging_directories");
   for(int i = 0; i < num_apps; i++)
   {
@@ -210,6 +308,8 @@ void ApplicationManager::updateState()
                                        { app_mgr->sendUpdateProgress(p); });
       apps_.back().setLog([app_mgr = this](Log::LogLevel log_level, const std::string& message)
                           { app_mgr->sendLogMessage(log_level, message); });
+      apps_.back().setCancelFlag(&cancel_requested_);
+      apps_.back().setTrackExternalChanges(track_external_changes);
     }
     catch(Json::RuntimeError& error)
     {
@@ -322,6 +422,16 @@ void ApplicationManager::sendUpdateProgress(float progress)
   emit updateProgress(progress);
 }
 
+void ApplicationManager::cancelOperation()
+{
+  cancel_requested_ = true;
+}
+
+const std::atomic<bool>* ApplicationManager::getCancelFlag() const
+{
+  return &cancel_requested_;
+}
+
 void ApplicationManager::sendLogMessage(Log::LogLevel level, QString message)
 {
   emit logMessage(level, message);
@@ -340,6 +450,10 @@ void ApplicationManager::addApplication(EditApplicationInfo info)
                                        { app_mgr->sendUpdateProgress(p); });
       apps_.back().setLog([app_mgr = this](Log::LogLevel log_level, const std::string& message)
                           { app_mgr->sendLogMessage(log_level, message); });
+      apps_.back().setCancelFlag(&cancel_requested_);
+      QSettings settings(QCoreApplication::applicationName());
+      apps_.back().setTrackExternalChanges(
+        settings.value("track_external_changes", false).toBool());
 
       for(const auto& depl_info : info.deployers)
         apps_.back().addDeployer(depl_info);
@@ -593,6 +707,22 @@ void ApplicationManager::getAppInfo(int app_id)
   emit sendAppInfo(apps_[app_id].getAppInfo());
 }
 
+void ApplicationManager::loadDeployers(int app_id)
+{
+  if(!appIndexIsValid(app_id, false))
+    return;
+  handleExceptions<&ModdedApplication::loadDeployers>(app_id);
+  if(app_id + 1 < apps_.size())
+    QMetaObject::invokeMethod(
+      this, [this, app_id]() { loadDeployers(app_id + 1); }, Qt::QueuedConnection);
+}
+
+void ApplicationManager::setTrackExternalChanges(bool track)
+{
+  for(int app_id = 0; app_id < apps_.size(); app_id++)
+    handleExceptions<&ModdedApplication::setTrackExternalChanges>(app_id, track);
+}
+
 void ApplicationManager::addTool(int app_id, Tool tool)
 {
   if(appIndexIsValid(app_id))
@@ -736,7 +866,8 @@ void ApplicationManager::addBackupTarget(int app_id,
                                          QString path,
                                          QString name,
                                          QString default_backup,
-                                         QString first_backup)
+                                         QString first_backup,
+                                         bool use_chunk_store)
 {
   if(appIndexIsValid(app_id))
   {
@@ -744,7 +875,7 @@ void ApplicationManager::addBackupTarget(int app_id,
     if(!first_backup.isEmpty())
       backup_names.push_back(first_backup.toStdString());
     handleExceptions<&ModdedApplication::addBackupTarget>(
-      app_id, path.toStdString(), name.toStdString(), backup_names);
+      app_id, path.toStdString(), name.toStdString(), backup_names, use_chunk_store);
   }
   emit completedOperations("Backup target added");
 }
@@ -970,6 +1101,9 @@ void ApplicationManager::downloadMod(ImportModInfo info)
   }
 
   info.target_path = apps_[info.app_id].getDownloadDir();
+  QSettings settings(QCoreApplication::applicationName());
+  if(settings.value("stream_extraction", false).toBool())
+    info.extracted_path = apps_[info.app_id].getStagingDir() / STREAM_EXTRACT_DIR;
   auto download_successful = handleExceptionsForFunction(performDownload, info, this);
   if(!download_successful)
   {
@@ -1065,3 +1199,100 @@ void ApplicationManager::applyModAction(int app_id, int deployer, int action, in
   if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
     handleExceptions<&ModdedApplication::applyModAction>(app_id, deployer, action, mod_id);
 }
+
+void ApplicationManager::planDeployment(int app_id, std::vector<int> deployers)
+{
+  if(appIndexIsValid(app_id))
+  {
+    for(int deployer : deployers)
+    {
+      if(!deployerIndexIsValid(app_id, deployer))
+      {
+        emit completedOperations();
+        return;
+      }
+    }
+    auto plans = handleExceptions(&ModdedApplication::planDeploy, apps_[app_id], deployers);
+    if(plans)
+      emit sendDeploymentPlans(*plans);
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::getFileProviders(int app_id, int deployer, QString prefix, int max_files)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    auto providers = handleExceptions(&ModdedApplication::getFileProviders,
+                                      apps_[app_id],
+                                      deployer,
+                                      prefix.toStdString(),
+                                      max_files);
+    if(providers)
+      emit sendFileProviders(*providers);
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::exportOverwriteReport(int app_id, int deployer, QString path)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    if(!handleExceptions<&ModdedApplication::exportOverwriteReport>(
+         app_id, deployer, path.toStdString(), false))
+    {
+      emit completedOperations("Overwrite report exported");
+      return;
+    }
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::getDeploymentGenerations(int app_id, int deployer)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    auto generations =
+      handleExceptions(&ModdedApplication::getDeploymentGenerations, apps_[app_id], deployer);
+    if(generations)
+      emit sendDeploymentGenerations(*generations);
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::rollbackDeployment(int app_id, int deployer, int generation)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    if(!handleExceptions<&ModdedApplication::rollbackDeployment>(app_id, deployer, generation))
+    {
+      emit completedOperations("Deployment rolled back");
+      return;
+    }
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::auditDeployment(int app_id, int deployer)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    auto audit = handleExceptions(&ModdedApplication::auditDeployment, apps_[app_id], deployer);
+    if(audit)
+      emit sendDeploymentAudit(*audit);
+  }
+  emit completedOperations();
+}
+
+void ApplicationManager::repairDeployment(int app_id, int deployer, DeploymentAudit audit)
+{
+  if(appIndexIsValid(app_id) && deployerIndexIsValid(app_id, deployer))
+  {
+    if(!handleExceptions<&ModdedApplication::repairDeployment>(app_id, deployer, audit))
+    {
+      emit completedOperations("Deployment repaired");
+      return;
+    }
+  }
+  emit completedOperations();
+}
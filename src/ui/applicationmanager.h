@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "../core/cancellationerror.h"
 #include "../core/compressionerror.h"
 #include "../core/editapplicationinfo.h"
 #include "../core/editautotagaction.h"
@@ -16,6 +17,7 @@
 #include <QDebug>
 #include <QObject>
 #include <QStandardPaths>
+#include <atomic>
 #include <filesystem>
 
 
@@ -77,6 +79,17 @@ public:
    * \param progress The progress.
    */
   void sendUpdateProgress(float progress);
+  /*!
+   * \brief Requests cancellation of the currently running operation. Cancelable operations
+   * stop at the next safe point and leave a consistent state. Unlike slots, this is thread
+   * safe and is intended to be called directly from the gui thread.
+   */
+  void cancelOperation();
+  /*!
+   * \brief Returns the flag set by \ref cancelOperation.
+   * \return A pointer to the flag.
+   */
+  const std::atomic<bool>* getCancelFlag() const;
 
 private:
   /*!
@@ -92,6 +105,8 @@ private:
   {
     std::string message;
     bool has_thrown = false;
+    bool was_canceled = false;
+    cancel_requested_ = false;
     try
     {
       (this->apps_[app_id].*f)(std::forward<Args>(args)...);
@@ -132,6 +147,14 @@ private:
       if(throw_exceptions_)
         throw error;
     }
+    catch(CancellationError& error)
+    {
+      has_thrown = true;
+      was_canceled = true;
+      message = error.what();
+      if(throw_exceptions_)
+        throw error;
+    }
     catch(std::runtime_error& error)
     {
       has_thrown = true;
@@ -154,7 +177,9 @@ private:
         throw std::runtime_error("An unexpected error occured!");
     }
 
-    if(has_thrown)
+    if(was_canceled)
+      sendLogMessage(Log::LOG_INFO, message);
+    else if(has_thrown)
       emit sendError("Error", message.c_str());
     return has_thrown;
   }
@@ -175,6 +200,8 @@ private:
     decltype((obj.*f)(std::forward<Args>(args)...)) ret_value;
     std::string message;
     bool has_thrown = false;
+    bool was_canceled = false;
+    cancel_requested_ = false;
     try
     {
       ret_value = (obj.*f)(std::forward<Args>(args)...);
@@ -215,6 +242,14 @@ private:
       if(throw_exceptions_)
         throw error;
     }
+    catch(CancellationError& error)
+    {
+      has_thrown = true;
+      was_canceled = true;
+      message = error.what();
+      if(throw_exceptions_)
+        throw error;
+    }
     catch(std::runtime_error& error)
     {
       has_thrown = true;
@@ -237,6 +272,11 @@ private:
         throw std::runtime_error("An unexpected error occured!");
     }
 
+    if(was_canceled)
+    {
+      sendLogMessage(Log::LOG_INFO, message);
+      return {};
+    }
     if(has_thrown)
     {
       emit sendError("Error", message.c_str());
@@ -260,6 +300,8 @@ private:
     decltype((f)(std::forward<Args>(args)...)) ret_value;
     std::string message;
     bool has_thrown = false;
+    bool was_canceled = false;
+    cancel_requested_ = false;
     try
     {
       ret_value = (f)(std::forward<Args>(args)...);
@@ -300,6 +342,14 @@ private:
       if(throw_exceptions_)
         throw error;
     }
+    catch(CancellationError& error)
+    {
+      has_thrown = true;
+      was_canceled = true;
+      message = error.what();
+      if(throw_exceptions_)
+        throw error;
+    }
     catch(std::runtime_error& error)
     {
       has_thrown = true;
@@ -322,6 +372,11 @@ private:
         throw std::runtime_error("An unexpected error occured!");
     }
 
+    if(was_canceled)
+    {
+      sendLogMessage(Log::LOG_INFO, message);
+      return {};
+    }
     if(has_thrown)
     {
       emit sendError("Error", message.c_str());
@@ -334,6 +389,8 @@ private:
   std::vector<ModdedApplication> apps_;
   /*! \brief If true: Do not catch exceptions. */
   bool throw_exceptions_ = false;
+  /*! \brief Set by \ref cancelOperation, reset whenever a new operation starts. */
+  std::atomic<bool> cancel_requested_ = false;
 
   /*!
    * \brief Updates the settings file with the current state of this object.
@@ -389,6 +446,8 @@ private:
 
   /*! \brief Counter for the number of instances of this class. */
   inline static int number_of_instances_ = 0;
+  /*! \brief Directory in the staging directory to which archives are extracted during download. */
+  inline static const std::string STREAM_EXTRACT_DIR = "lmm_tmp_stream_extract_.dir";
 
 private:
   /*!
@@ -522,6 +581,27 @@ signals:
    * \param deploy If True: Deploy mods after checking, else: Undeploy mods.
    */
   void externalChangesHandled(int app_id, int deployer, int num_deployers, bool deploy);
+  /*!
+   * \brief Sends deployment plans for one \ref ModdedApplication "application".
+   * \param plans One plan per planned deployer.
+   */
+  void sendDeploymentPlans(std::vector<DeploymentPlan> plans);
+  /*!
+   * \brief Sends all retained deployment generations of one deployer.
+   * \param generations The generations, sorted from oldest to newest.
+   */
+  void sendDeploymentGenerations(std::vector<DeploymentGeneration> generations);
+  /*!
+   * \brief Sends the result of comparing the files deployed by one deployer to their sources.
+   * \param audit The audit.
+   */
+  void sendDeploymentAudit(DeploymentAudit audit);
+  /*!
+   * \brief Sends all files provided by one deployer which match a search and the mods
+   * providing them.
+   * \param providers For every file: Its path and all mods providing it, in overwrite order.
+   */
+  void sendFileProviders(std::vector<ConflictInfo> providers);
 
 public slots:
   /*!
@@ -673,6 +753,19 @@ public slots:
    * \param app_id The target \ref ModdedApplication "application".
    */
   void getAppInfo(int app_id);
+  /*!
+   * \brief Constructs all deployers of the given \ref ModdedApplication "application",
+   * which have been deferred until their first use. Then schedules the same for the next
+   * application, so that other requests can be handled in between.
+   * \param app_id The target \ref ModdedApplication "application".
+   */
+  void loadDeployers(int app_id);
+  /*!
+   * \brief Enables or disables tracking of external changes for all
+   * \ref ModdedApplication "applications".
+   * \param track If true: Track changes.
+   */
+  void setTrackExternalChanges(bool track);
   /*!
    * \brief Adds a new tool to given \ref ModdedApplication "application".
    * \param app_id The target \ref ModdedApplication "application".
@@ -807,12 +900,14 @@ public slots:
    * \param name Display name for this target.
    * \param default_backup Display name for the currently active version of the target.
    * \param first_backup If not empty: Create a backup of the target with this as name.
+   * \param use_chunk_store If true: Store inactive backups in a deduplicated chunk store.
    */
   void addBackupTarget(int app_id,
                        QString path,
                        QString name,
                        QString default_backup,
-                       QString first_backup);
+                       QString first_backup,
+                       bool use_chunk_store);
   /*!
    * \brief Removes the given backup target from the given ModdedApplication by deleting
    * all relevant backups and config files.
@@ -1047,4 +1142,57 @@ public slots:
    * \param mod_id Target mod.
    */
   void applyModAction(int app_id, int deployer, int action, int mod_id);
+  /*!
+   * \brief Determines which file operations deploying the given deployers would perform.
+   * Emits \ref sendDeploymentPlans.
+   * \param app_id Target app.
+   * \param deployers Target deployers.
+   */
+  void planDeployment(int app_id, std::vector<int> deployers);
+  /*!
+   * \brief Finds all files provided by the enabled mods of one deployer whose path starts
+   * with the given prefix. Emits \ref sendFileProviders.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param prefix Path prefix, relative to the deployers target directory.
+   * \param max_files Maximum number of files to find.
+   */
+  void getFileProviders(int app_id, int deployer, QString prefix, int max_files);
+  /*!
+   * \brief Writes a CSV file containing every file provided by the enabled mods of one
+   * deployer, the winning mod and all overwritten mods.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param path Path to the CSV file.
+   */
+  void exportOverwriteReport(int app_id, int deployer, QString path);
+  /*!
+   * \brief Gets all retained deployment generations of one deployer.
+   * Emits \ref sendDeploymentGenerations.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   */
+  void getDeploymentGenerations(int app_id, int deployer);
+  /*!
+   * \brief Restores the files and load order of one deployer to the state after the given
+   * deployment generation.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param generation Id of the target generation.
+   */
+  void rollbackDeployment(int app_id, int deployer, int generation);
+  /*!
+   * \brief Compares every file deployed by one deployer to its source file.
+   * Emits \ref sendDeploymentAudit.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   */
+  void auditDeployment(int app_id, int deployer);
+  /*!
+   * \brief Fixes every file in the given audit of one deployer.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param audit Audit created by \ref auditDeployment.
+   */
+  void repairDeployment(int app_id, int deployer, DeploymentAudit audit);
 };
@@ -63,7 +63,13 @@ QVariant ConflictsModel::data(const QModelIndex& index, int role) const
   }
 
   if(role == Qt::ForegroundRole)
+  {
+    if(base_id_ < 0 && conflicts_[row].mod_ids.size() == 1)
+      return QVariant();
+    if(base_id_ < 0)
+      return colors::RED;
     return conflicts_[row].mod_ids.back() == base_id_ ? colors::GREEN : colors::RED;
+  }
 
   return QVariant();
 }
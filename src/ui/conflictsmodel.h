@@ -62,7 +62,8 @@ public:
   /*!
    * \brief Updates the data in this model with the new conflicts.
    * \param newConflicts Contains file, winner name and winner id for every conflict.
-   * \param base_id Id of the mod for which the conflicts are displayed.
+   * \param base_id Id of the mod for which the conflicts are displayed. If negative: Files
+   * provided by more than one mod are highlighted instead.
    */
   void setConflicts(const std::vector<ConflictInfo>& newConflicts, int base_id);
 
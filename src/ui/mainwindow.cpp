@@ -24,6 +24,9 @@
 #include "versionboxdelegate.h"
 #include <QCheckBox>
 #include <QDesktopServices>
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QLocale>
 #include <QMessageBox>
 #include <QMetaType>
 #include <QPainter>
@@ -33,6 +36,7 @@
 #include <QSettings>
 #include <QToolButton>
 #include <QtConcurrent/QtConcurrent>
+#include <array>
 #include <ranges>
 #include <regex>
 
@@ -63,6 +67,9 @@ Q_DECLARE_METATYPE(ExternalChangesInfo);
 Q_DECLARE_METATYPE(FileChangeChoices);
 Q_DECLARE_METATYPE(Tool);
 Q_DECLARE_METATYPE(ImportModInfo);
+Q_DECLARE_METATYPE(std::vector<DeploymentPlan>);
+Q_DECLARE_METATYPE(std::vector<DeploymentGeneration>);
+Q_DECLARE_METATYPE(DeploymentAudit);
 
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow)
@@ -89,6 +96,8 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
   setupIpcServer();
   addAction(ui->actionSelect_All);
   setWindowTitle("Limo");
+  // deployers managing plugins are loaded in the background once the window is up
+  emit loadDeployers(0);
   Log::info("Startup complete");
 }
 
@@ -187,6 +196,9 @@ void MainWindow::setupConnections()
   qRegisterMetaType<FileChangeChoices>();
   qRegisterMetaType<Tool>();
   qRegisterMetaType<ImportModInfo>();
+  qRegisterMetaType<std::vector<DeploymentPlan>>();
+  qRegisterMetaType<std::vector<DeploymentGeneration>>();
+  qRegisterMetaType<DeploymentAudit>();
 
   connect(this, &MainWindow::getModInfo,
           app_manager_, &ApplicationManager::getModInfo);
@@ -236,6 +248,32 @@ void MainWindow::setupConnections()
           this, &MainWindow::onGetFileConflicts);
   connect(this, &MainWindow::getAppInfo,
           app_manager_, &ApplicationManager::getAppInfo);
+  connect(this, &MainWindow::loadDeployers,
+          app_manager_, &ApplicationManager::loadDeployers);
+  connect(this, &MainWindow::setTrackExternalChanges,
+          app_manager_, &ApplicationManager::setTrackExternalChanges);
+  connect(this, &MainWindow::planDeployment,
+          app_manager_, &ApplicationManager::planDeployment);
+  connect(app_manager_, &ApplicationManager::sendDeploymentPlans,
+          this, &MainWindow::onGetDeploymentPlans);
+  connect(this, &MainWindow::getFileProviders,
+          app_manager_, &ApplicationManager::getFileProviders);
+  connect(app_manager_, &ApplicationManager::sendFileProviders,
+          this, &MainWindow::onGetFileProviders);
+  connect(this, &MainWindow::getDeploymentGenerations,
+          app_manager_, &ApplicationManager::getDeploymentGenerations);
+  connect(app_manager_, &ApplicationManager::sendDeploymentGenerations,
+          this, &MainWindow::onGetDeploymentGenerations);
+  connect(this, &MainWindow::rollbackDeployment,
+          app_manager_, &ApplicationManager::rollbackDeployment);
+  connect(this, &MainWindow::auditDeployment,
+          app_manager_, &ApplicationManager::auditDeployment);
+  connect(app_manager_, &ApplicationManager::sendDeploymentAudit,
+          this, &MainWindow::onGetDeploymentAudit);
+  connect(this, &MainWindow::repairDeployment,
+          app_manager_, &ApplicationManager::repairDeployment);
+  connect(this, &MainWindow::exportOverwriteReport,
+          app_manager_, &ApplicationManager::exportOverwriteReport);
   connect(app_manager_, &ApplicationManager::sendAppInfo,
           this, &MainWindow::onGetAppInfo);
   connect(this, &MainWindow::addTool,
@@ -497,6 +535,39 @@ void MainWindow::setupLists()
   conflicts_list_->verticalHeader()->setVisible(false);
   conflicts_window_->resize(1200, 600);
 
+  // deployed files list
+  deployed_files_model_ = new ConflictsModel(this);
+  deployed_files_window_ = new QWidget();
+  QVBoxLayout* deployed_files_layout = new QVBoxLayout();
+  deployed_files_window_->setLayout(deployed_files_layout);
+  QHBoxLayout* deployed_files_search_layout = new QHBoxLayout();
+  deployed_files_layout->addLayout(deployed_files_search_layout);
+  deployed_files_search_ = new QLineEdit(deployed_files_window_);
+  deployed_files_search_->setPlaceholderText("Path prefix, e.g. Data/Textures/");
+  deployed_files_search_->setClearButtonEnabled(true);
+  connect(deployed_files_search_,
+          &QLineEdit::returnPressed,
+          this,
+          &MainWindow::onShowDeployedFilesMenuClicked);
+  deployed_files_search_layout->addWidget(deployed_files_search_);
+  QPushButton* export_report_button = new QPushButton("Export Report", deployed_files_window_);
+  export_report_button->setIcon(QIcon::fromTheme("document-export"));
+  connect(export_report_button,
+          &QPushButton::clicked,
+          this,
+          &MainWindow::onExportOverwriteReportClicked);
+  deployed_files_search_layout->addWidget(export_report_button);
+  deployed_files_list_ = new QTableView(deployed_files_window_);
+  deployed_files_layout->addWidget(deployed_files_list_);
+  deployed_files_list_->setModel(deployed_files_model_);
+  deployed_files_list_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  deployed_files_list_->setSelectionMode(QAbstractItemView::NoSelection);
+  deployed_files_list_->setSelectionBehavior(QAbstractItemView::SelectRows);
+  deployed_files_list_->horizontalHeader()->setStretchLastSection(true);
+  deployed_files_list_->setAlternatingRowColors(true);
+  deployed_files_list_->verticalHeader()->setVisible(false);
+  deployed_files_window_->resize(1200, 600);
+
   // tools list
   ui->info_tool_list->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Fixed);
   ui->info_tool_list->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Fixed);
@@ -790,10 +861,43 @@ void MainWindow::setupButtons()
   edit_deployer_action_->setText("Edit");
   edit_deployer_action_->setIcon(QIcon::fromTheme("editor"));
   connect(edit_deployer_action_, &QAction::triggered, this, &MainWindow::onEditDeployerMenuClicked);
+  plan_deployment_action_ = new QAction(this);
+  plan_deployment_action_->setToolTip("Show which files deploying would change");
+  plan_deployment_action_->setText("Plan Deployment");
+  plan_deployment_action_->setIcon(QIcon::fromTheme("document-preview"));
+  connect(
+    plan_deployment_action_, &QAction::triggered, this, &MainWindow::onPlanDeploymentMenuClicked);
+  show_deployed_files_action_ = new QAction(this);
+  show_deployed_files_action_->setToolTip("Show which mods provide the files of this deployer");
+  show_deployed_files_action_->setText("Deployed Files");
+  show_deployed_files_action_->setIcon(QIcon::fromTheme("document-open"));
+  connect(show_deployed_files_action_,
+          &QAction::triggered,
+          this,
+          &MainWindow::onShowDeployedFilesMenuClicked);
+  deployment_history_action_ = new QAction(this);
+  deployment_history_action_->setToolTip("Roll back to an earlier deployment");
+  deployment_history_action_->setText("Deployment History");
+  deployment_history_action_->setIcon(QIcon::fromTheme("document-revert"));
+  connect(deployment_history_action_,
+          &QAction::triggered,
+          this,
+          &MainWindow::onDeploymentHistoryMenuClicked);
+  audit_deployment_action_ = new QAction(this);
+  audit_deployment_action_->setToolTip(
+    "Check whether deployed files have been changed and repair them");
+  audit_deployment_action_->setText("Verify Deployment");
+  audit_deployment_action_->setIcon(QIcon::fromTheme("security-high"));
+  connect(
+    audit_deployment_action_, &QAction::triggered, this, &MainWindow::onAuditDeploymentMenuClicked);
   QMenu* deployer_menu = new QMenu(this);
   deployer_menu->addActions(QList<QAction*>{ add_deployer_action_,
                                              remove_deployer_action_,
                                              edit_deployer_action_,
+                                             plan_deployment_action_,
+                                             show_deployed_files_action_,
+                                             deployment_history_action_,
+                                             audit_deployment_action_,
                                              ui->actionbrowse_deployer_files });
   ui->deployer_tool_button->setDefaultAction(add_deployer_action_);
   ui->deployer_tool_button->setMenu(deployer_menu);
@@ -903,6 +1007,8 @@ void MainWindow::setBusyStatus(bool busy, bool show_progress_bar, bool disable_a
     last_progress_update_time_ = std::chrono::high_resolution_clock::now();
     progress_bar_->setEnabled(busy);
     progress_bar_->setVisible(busy);
+    cancel_button_->setEnabled(busy);
+    cancel_button_->setVisible(busy);
     progress_bar_->setMaximum(0);
     progress_bar_->setMinimum(0);
   }
@@ -1756,6 +1862,14 @@ void MainWindow::onAddToDeployerAccept(std::vector<int>& mod_ids, std::vector<bo
   emit getDeployerInfo(currentApp(), currentDeployer());
 }
 
+void MainWindow::onCancelButtonClicked()
+{
+  // the worker thread is busy, so the flag is set directly instead of using a signal
+  app_manager_->cancelOperation();
+  cancel_button_->setEnabled(false);
+  setStatusMessage("Canceling...");
+}
+
 void MainWindow::onCompletedOperations(QString message)
 {
   setStatusMessage(message, 3000);
@@ -1780,6 +1894,147 @@ void MainWindow::onGetFileConflicts(std::vector<ConflictInfo> conflicts)
   conflicts_window_->show();
 }
 
+void MainWindow::onGetFileProviders(std::vector<ConflictInfo> providers)
+{
+  QString title = "Deployed files for \"" + ui->deployer_selection_box->currentText() + "\"";
+  if(providers.size() >= MAX_DEPLOYED_FILES)
+    title += QString(" (showing the first %1 files)").arg(MAX_DEPLOYED_FILES);
+  deployed_files_model_->setConflicts(providers, -1);
+  deployed_files_list_->resizeColumnToContents(0);
+  deployed_files_list_->resizeColumnToContents(1);
+  deployed_files_window_->setWindowTitle(title);
+  deployed_files_window_->show();
+}
+
+void MainWindow::onGetDeploymentPlans(std::vector<DeploymentPlan> plans)
+{
+  QString text;
+  for(const auto& plan : plans)
+  {
+    text += QString("<b>%1</b><br>")
+              .arg(QString::fromStdString(plan.deployer_name).toHtmlEscaped());
+    if(!plan.is_supported)
+    {
+      text += "This deployer manages its own files.<br><br>";
+      continue;
+    }
+    if(plan.getNumOperations() == 0)
+      text += "All files are deployed.<br>";
+    else
+    {
+      text += QString("Files created: %1, replaced: %2, removed: %3<br>")
+                .arg(plan.num_files_created)
+                .arg(plan.num_files_replaced)
+                .arg(plan.num_files_removed);
+      text += QString("Backups created: %1, restored: %2<br>")
+                .arg(plan.num_backups_created)
+                .arg(plan.num_backups_restored);
+      if(plan.bytes_to_copy > 0)
+        text +=
+          QString("Data to copy: %1<br>").arg(QLocale().formattedDataSize(plan.bytes_to_copy));
+      text += QString("Estimated time: %1 s<br>").arg(plan.estimated_seconds, 0, 'f', 1);
+    }
+    for(const auto& [other_id, num_files] : plan.overlapping_deployers)
+    {
+      auto other_plan =
+        str::find_if(plans, [id = other_id](const auto& p) { return p.deployer_id == id; });
+      text += QString("Shares %1 files with \"%2\"<br>")
+                .arg(num_files)
+                .arg(QString::fromStdString(other_plan->deployer_name).toHtmlEscaped());
+    }
+    text += "<br>";
+  }
+  QMessageBox box(QMessageBox::Information, "Deployment Plan", text, QMessageBox::Ok, this);
+  box.setTextFormat(Qt::RichText);
+  box.exec();
+}
+
+void MainWindow::onGetDeploymentGenerations(std::vector<DeploymentGeneration> generations)
+{
+  if(generations.empty())
+  {
+    QMessageBox::information(this,
+                             "Deployment History",
+                             "No deployments have been recorded for this deployer.");
+    return;
+  }
+  QStringList items;
+  for(const auto& generation : generations | stv::reverse)
+  {
+    const QString time =
+      QLocale().toString(QDateTime::fromSecsSinceEpoch(generation.timestamp), QLocale::ShortFormat);
+    QString item = QString("%1: %2, %3 files, %4 changed")
+                     .arg(generation.id)
+                     .arg(time)
+                     .arg(generation.num_files)
+                     .arg(generation.num_changes);
+    if(generation.profile >= 0 && generation.profile < ui->profile_selection_box->count())
+      item += QString(" (%1)").arg(ui->profile_selection_box->itemText(generation.profile));
+    if(generation.id == generations.back().id)
+      item += " [current]";
+    items.append(item);
+  }
+  bool accepted = false;
+  const QString selection = QInputDialog::getItem(
+    this, "Deployment History", "Roll back to deployment:", items, 0, false, &accepted);
+  const int index = items.indexOf(selection);
+  if(!accepted || index <= 0)
+    return;
+  const int generation = generations[generations.size() - 1 - index].id;
+  Log::info(std::format("Rolling back deployer \"{}\" to generation {}",
+                        ui->deployer_selection_box->currentText().toStdString(),
+                        generation));
+  setStatusMessage("Rolling back deployment");
+  setBusyStatus(true);
+  emit rollbackDeployment(currentApp(), currentDeployer(), generation);
+  emit getDeployerInfo(currentApp(), currentDeployer());
+}
+
+void MainWindow::onGetDeploymentAudit(DeploymentAudit audit)
+{
+  const QString deployer_name = QString::fromStdString(audit.deployer_name).toHtmlEscaped();
+  if(audit.entries.empty())
+  {
+    QMessageBox::information(
+      this,
+      "Deployment Audit",
+      QString("All %1 files deployed by \"%2\" are intact.")
+        .arg(audit.num_identical)
+        .arg(QString::fromStdString(audit.deployer_name)));
+    return;
+  }
+  std::array<int, 4> num_entries{};
+  for(const auto& entry : audit.entries)
+    num_entries[entry.status]++;
+  QString text = QString("<b>%1</b><br>").arg(deployer_name);
+  text += QString("Intact: %1, modified: %2, missing: %3, without source: %4<br><br>")
+            .arg(audit.num_identical)
+            .arg(num_entries[DeploymentAudit::modified])
+            .arg(num_entries[DeploymentAudit::missing])
+            .arg(num_entries[DeploymentAudit::orphaned]);
+  constexpr int max_shown_entries = 20;
+  for(const auto& entry : audit.entries | stv::take(max_shown_entries))
+    text += QString::fromStdString(entry.path.string()).toHtmlEscaped() + "<br>";
+  if(audit.entries.size() > max_shown_entries)
+    text += QString("... and %1 more<br>").arg(audit.entries.size() - max_shown_entries);
+  text += "<br>Deploy modified and missing files again and remove files without a source?";
+  QMessageBox box(QMessageBox::Question,
+                  "Deployment Audit",
+                  text,
+                  QMessageBox::Yes | QMessageBox::No,
+                  this);
+  box.setTextFormat(Qt::RichText);
+  if(box.exec() != QMessageBox::Yes)
+    return;
+  Log::info(std::format("Repairing {} files of deployer \"{}\"",
+                        audit.entries.size(),
+                        audit.deployer_name));
+  setStatusMessage("Repairing deployment");
+  setBusyStatus(true);
+  emit repairDeployment(currentApp(), audit.deployer_id, audit);
+  emit getDeployerInfo(currentApp(), currentDeployer());
+}
+
 void MainWindow::onGetAppInfo(AppInfo app_info)
 {
   ignore_tool_changes_ = true;
@@ -1842,8 +2097,9 @@ void MainWindow::onGetAppInfo(AppInfo app_info)
     ui->info_deployer_list->setCellWidget(i, 0, button);
     ui->info_deployer_list->setItem(i, 1, new QTableWidgetItem(app_info.deployers[i].c_str()));
     ui->info_deployer_list->setItem(i, 2, new QTableWidgetItem(app_info.deployer_types[i].c_str()));
-    ui->info_deployer_list->setItem(
-      i, 3, new QTableWidgetItem(QString::number(app_info.deployer_mods[i])));
+    const QString num_mods =
+      app_info.deployer_mods[i] < 0 ? "-" : QString::number(app_info.deployer_mods[i]);
+    ui->info_deployer_list->setItem(i, 3, new QTableWidgetItem(num_mods));
     QString deploy_mode = deploy_mode_hard_link;
     if(app_info.deploy_modes[i] == Deployer::sym_link)
       deploy_mode = deploy_mode_sym_link;
@@ -2081,12 +2337,17 @@ void MainWindow::onExtractionComplete(ImportModInfo info)
   QStringList deployer_paths;
   for(const auto& path : app_info_.target_dirs)
     deployer_paths.append(path.c_str());
+  const bool has_bg3_deployer = std::find(app_info_.deployer_types.begin(),
+                                          app_info_.deployer_types.end(),
+                                          DeployerFactory::BG3DEPLOYER) !=
+                                app_info_.deployer_types.end();
   info.action_type = ImportModInfo::ActionType::install_dialog;
   bool was_successful = add_mod_dialog_->setupDialog(deployers,
                                                      deployer,
                                                      deployer_paths,
                                                      auto_deployers,
                                                      app_info_.deployer_is_case_invariant,
+                                                     has_bg3_deployer,
                                                      ui->info_version_label->text(),
                                                      info,
                                                      root_level_conditions_);
@@ -2111,6 +2372,7 @@ void MainWindow::onSettingsDialogComplete()
   ask_remove_backup_target_ = settings_dialog_->askRemoveBackupTarget();
   ask_remove_backup_ = settings_dialog_->askRemoveBackup();
   ask_remove_tool_ = settings_dialog_->askRemoveTool();
+  emit setTrackExternalChanges(settings_dialog_->trackExternalChanges());
   if(debug_mode_)
     Log::log_level = Log::LOG_DEBUG;
 }
@@ -2129,9 +2391,10 @@ void MainWindow::onBackupTargetAdded(int app_id,
                                      QString name,
                                      QString path,
                                      QString default_backup,
-                                     QString first_backup)
+                                     QString first_backup,
+                                     bool use_chunk_store)
 {
-  emit addBackupTarget(app_id, path, name, default_backup, first_backup);
+  emit addBackupTarget(app_id, path, name, default_backup, first_backup, use_chunk_store);
   setStatusMessage("Adding backup target");
   setBusyStatus(true);
   if(app_id == currentApp())
@@ -2205,6 +2468,13 @@ void MainWindow::setupProgressBar()
   auto layout = new QHBoxLayout();
   layout->insertSpacing(0, 375);
   layout->addWidget(progress_bar_);
+  cancel_button_ = new QPushButton();
+  cancel_button_->setIcon(QIcon::fromTheme("process-stop"));
+  cancel_button_->setFlat(true);
+  cancel_button_->setMaximumSize(15, 15);
+  cancel_button_->setToolTip("Cancel the current operation");
+  connect(cancel_button_, &QPushButton::clicked, this, &MainWindow::onCancelButtonClicked);
+  layout->addWidget(cancel_button_);
   layout->setSpacing(0);
   layout->setMargin(0);
   layout->setAlignment(Qt::AlignCenter);
@@ -2212,6 +2482,7 @@ void MainWindow::setupProgressBar()
   container->setMaximumHeight(15);
   ui->statusbar->insertPermanentWidget(0, container);
   progress_bar_->setVisible(false);
+  cancel_button_->setVisible(false);
 }
 
 void MainWindow::setupFilters()
@@ -2291,7 +2562,7 @@ void MainWindow::onAddDeployerButtonClicked()
 {
   if(ui->app_selection_box->count() == 0)
     return;
-  add_deployer_dialog_->setAddMode(currentApp());
+  add_deployer_dialog_->setAddMode(currentApp(), app_info_.staging_dir.c_str());
   setBusyStatus(true, false);
   add_deployer_dialog_->show();
 }
@@ -2539,6 +2810,66 @@ void MainWindow::onEditDeployerMenuClicked()
   showEditDeployerDialog(currentDeployer());
 }
 
+void MainWindow::onPlanDeploymentMenuClicked()
+{
+  if(ui->app_selection_box->count() == 0 || ui->deployer_selection_box->count() == 0)
+    return;
+  std::vector<int> deployers;
+  if(deploy_for_all_)
+  {
+    for(int i = 0; i < ui->deployer_selection_box->count(); i++)
+      deployers.push_back(i);
+  }
+  else
+    deployers.push_back(currentDeployer());
+  setStatusMessage("Planning deployment");
+  setBusyStatus(true);
+  emit planDeployment(currentApp(), deployers);
+}
+
+void MainWindow::onDeploymentHistoryMenuClicked()
+{
+  if(ui->app_selection_box->count() == 0 || ui->deployer_selection_box->count() == 0)
+    return;
+  setStatusMessage("Reading deployment history");
+  setBusyStatus(true);
+  emit getDeploymentGenerations(currentApp(), currentDeployer());
+}
+
+void MainWindow::onAuditDeploymentMenuClicked()
+{
+  if(ui->app_selection_box->count() == 0 || ui->deployer_selection_box->count() == 0)
+    return;
+  setStatusMessage("Verifying deployment");
+  setBusyStatus(true);
+  emit auditDeployment(currentApp(), currentDeployer());
+}
+
+void MainWindow::onShowDeployedFilesMenuClicked()
+{
+  if(ui->app_selection_box->count() == 0 || ui->deployer_selection_box->count() == 0)
+    return;
+  setStatusMessage("Finding deployed files");
+  setBusyStatus(true);
+  emit getFileProviders(
+    currentApp(), currentDeployer(), deployed_files_search_->text(), MAX_DEPLOYED_FILES);
+}
+
+void MainWindow::onExportOverwriteReportClicked()
+{
+  if(ui->app_selection_box->count() == 0 || ui->deployer_selection_box->count() == 0)
+    return;
+  const QString path = QFileDialog::getSaveFileName(deployed_files_window_,
+                                                    "Export Overwrite Report",
+                                                    QDir::homePath() + "/overwrite_report.csv",
+                                                    "CSV files (*.csv)");
+  if(path.isEmpty())
+    return;
+  setStatusMessage("Exporting overwrite report");
+  setBusyStatus(true);
+  emit exportOverwriteReport(currentApp(), currentDeployer(), path);
+}
+
 void MainWindow::on_profile_selection_box_currentIndexChanged(int index)
 {
   auto settings = QSettings(QCoreApplication::applicationName());
@@ -44,10 +44,12 @@
 #include <QDragEnterEvent>
 #include <QDragLeaveEvent>
 #include <QDropEvent>
+#include <QLineEdit>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QPlainTextEdit>
 #include <QProgressBar>
+#include <QPushButton>
 #include <QTableWidget>
 #include <QThread>
 #include <QtCore>
@@ -163,6 +165,14 @@ private:
   QAction* remove_deployer_action_;
   /*! \brief Action used to edit the current \ref Deployer "deployer". */
   QAction* edit_deployer_action_;
+  /*! \brief Action used to show which files deploying would change. */
+  QAction* plan_deployment_action_;
+  /*! \brief Action used to show which mods provide the files of the current deployer. */
+  QAction* show_deployed_files_action_;
+  /*! \brief Action used to roll back the current deployer to an earlier deployment. */
+  QAction* deployment_history_action_;
+  /*! \brief Action used to check the files deployed by the current deployer. */
+  QAction* audit_deployment_action_;
   /*! \brief Action used to add a new profile. */
   QAction* add_profile_action_;
   /*! \brief Action used to remove a profile. */
@@ -263,8 +273,20 @@ private:
   QWidget* conflicts_window_;
   /*! \brief Used to display file conflicts. */
   QTableView* conflicts_list_;
+  /*! \brief Model used to hold data for the deployed files window. */
+  ConflictsModel* deployed_files_model_;
+  /*! \brief Shows all files provided by the current deployer and the mods providing them. */
+  QWidget* deployed_files_window_;
+  /*! \brief Used to search for file paths in \ref deployed_files_window_. */
+  QLineEdit* deployed_files_search_;
+  /*! \brief Used to display deployed files. */
+  QTableView* deployed_files_list_;
+  /*! \brief Maximum number of files shown in \ref deployed_files_window_. */
+  static constexpr int MAX_DEPLOYED_FILES = 10000;
   /*! \brief Progress bar shown in the status bar. */
   QProgressBar* progress_bar_;
+  /*! \brief Shown next to \ref progress_bar_, used to cancel the current operation. */
+  QPushButton* cancel_button_;
   /*!
    *  \brief Maps the names of all manual tags for the current app to the number of mods with that
    * tag.
@@ -563,6 +585,28 @@ public slots:
    * \param conflicts Conflicts to be shown.
    */
   void onGetFileConflicts(std::vector<ConflictInfo> conflicts);
+  /*!
+   * \brief Shows the given files in the deployed files window.
+   * \param providers For every file: Its path and all mods providing it.
+   */
+  void onGetFileProviders(std::vector<ConflictInfo> providers);
+  /*!
+   * \brief Shows a summary of the given deployment plans.
+   * \param plans Plans to be shown.
+   */
+  void onGetDeploymentPlans(std::vector<DeploymentPlan> plans);
+  /*!
+   * \brief Shows a dialog listing the given generations of the current deployer. If one is
+   * selected, rolls the deployer back to that generation.
+   * \param generations Generations to be shown, sorted from oldest to newest.
+   */
+  void onGetDeploymentGenerations(std::vector<DeploymentGeneration> generations);
+  /*!
+   * \brief Shows a summary of the given audit. If any file is not identical to its source,
+   * asks whether the deployment should be repaired.
+   * \param audit Audit to be shown.
+   */
+  void onGetDeploymentAudit(DeploymentAudit audit);
   /*!
    * \brief Updates the "App" tab.
    * \param app_info New data used for the update.
@@ -655,12 +699,14 @@ public slots:
    * \param path Path to the file or directory to be managed.
    * \param default_backup Name of the currently active version of the target.
    * \param first_backup If not empty: Name of the first backup.
+   * \param use_chunk_store If true: Store inactive backups in a deduplicated chunk store.
    */
   void onBackupTargetAdded(int app_id,
                            QString name,
                            QString path,
                            QString default_backup,
-                           QString first_backup);
+                           QString first_backup,
+                           bool use_chunk_store);
   /*!
    * \brief Called on right clicking in ui->backup_list. Shows a context menu
    * at the given position.
@@ -734,6 +780,21 @@ private slots:
   void on_actionmove_mod_triggered();
   /*! \brief Shows a dialog to edit the currently active Deployer. */
   void onEditDeployerMenuClicked();
+  /*!
+   * \brief Plans deployment for the current deployer or, if deploying for all deployers, for
+   * all deployers.
+   */
+  void onPlanDeploymentMenuClicked();
+  /*! \brief Shows all files of the current deployer which match the current search. */
+  void onShowDeployedFilesMenuClicked();
+  /*! \brief Requests the deployment generations of the current deployer. */
+  void onDeploymentHistoryMenuClicked();
+  /*! \brief Compares the files deployed by the current deployer to their sources. */
+  void onAuditDeploymentMenuClicked();
+  /*! \brief Shows a dialog to export the overwrite report for the current deployer. */
+  void onExportOverwriteReportClicked();
+  /*! \brief Requests cancellation of the currently running operation. */
+  void onCancelButtonClicked();
   /*! \brief Updates the currently active profile. */
   void on_profile_selection_box_currentIndexChanged(int index);
   /*! \brief Shows a dialog to add a new profile. */
@@ -1256,6 +1317,67 @@ signals:
    * \param app_id The target \ref ModdedApplication "application".
    */
   void getAppInfo(int app_id);
+  /*!
+   * \brief Constructs all deployers, starting at the given
+   * \ref ModdedApplication "application", which have been deferred until their first use.
+   * \param app_id The first \ref ModdedApplication "application".
+   */
+  void loadDeployers(int app_id);
+  /*!
+   * \brief Enables or disables tracking of external changes for all
+   * \ref ModdedApplication "applications".
+   * \param track If true: Track changes.
+   */
+  void setTrackExternalChanges(bool track);
+  /*!
+   * \brief Determines which file operations deploying the given deployers would perform.
+   * \param app_id Target app.
+   * \param deployers Target deployers.
+   */
+  void planDeployment(int app_id, std::vector<int> deployers);
+  /*!
+   * \brief Finds all files provided by one deployer whose path starts with the given prefix.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param prefix Path prefix.
+   * \param max_files Maximum number of files to find.
+   */
+  void getFileProviders(int app_id, int deployer, QString prefix, int max_files);
+  /*!
+   * \brief Writes a CSV file containing every file provided by one deployer and all mods
+   * providing it.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param path Path to the CSV file.
+   */
+  void exportOverwriteReport(int app_id, int deployer, QString path);
+  /*!
+   * \brief Gets all retained deployment generations of one deployer.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   */
+  void getDeploymentGenerations(int app_id, int deployer);
+  /*!
+   * \brief Restores the files and load order of one deployer to the state after the given
+   * deployment generation.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param generation Id of the target generation.
+   */
+  void rollbackDeployment(int app_id, int deployer, int generation);
+  /*!
+   * \brief Compares every file deployed by one deployer to its source file.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   */
+  void auditDeployment(int app_id, int deployer);
+  /*!
+   * \brief Fixes every file in the given audit of one deployer.
+   * \param app_id Target app.
+   * \param deployer Target deployer.
+   * \param audit Audit to be repaired.
+   */
+  void repairDeployment(int app_id, int deployer, DeploymentAudit audit);
   /*!
    * \brief Adds a new tool to given \ref ModdedApplication "application".
    * \param app_id The target \ref ModdedApplication "application".
@@ -1394,12 +1516,14 @@ signals:
    * \param name Display name for this target.
    * \param default_backup Display name for the currently active version of the target.
    * \param first_backup If not empty: Create a backup of the target with this as name.
+   * \param use_chunk_store If true: Store inactive backups in a deduplicated chunk store.
    */
   void addBackupTarget(int app_id,
                        QString path,
                        QString name,
                        QString default_backup,
-                       QString first_backup);
+                       QString first_backup,
+                       bool use_chunk_store);
   /*!
    * \brief Removes the given backup target from the given ModdedApplication by deleting
    * all relevant backups and config files.
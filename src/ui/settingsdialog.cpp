@@ -86,6 +86,12 @@ void SettingsDialog::init()
   ui->show_error_cb->setCheckState(settings.value("log_on_error", true).toBool() ? Qt::Checked
                                                                                  : Qt::Unchecked);
   ui->deploy_for_box->setCurrentIndex(settings.value("deploy_for_all", true).toBool() ? 0 : 1);
+  ui->track_changes_cb->setCheckState(
+    settings.value("track_external_changes", false).toBool() ? Qt::Checked : Qt::Unchecked);
+  ui->stream_extraction_cb->setCheckState(
+    settings.value("stream_extraction", false).toBool() ? Qt::Checked : Qt::Unchecked);
+  ui->keep_streamed_archives_cb->setCheckState(
+    settings.value("keep_streamed_archives", true).toBool() ? Qt::Checked : Qt::Unchecked);
 
   settings.beginGroup("nexus");
   ui->premium_user_label->setText(
@@ -170,6 +176,12 @@ void SettingsDialog::on_buttonBox_accepted()
   ask_remove_tool_ = ui->remove_tool_cb->isChecked();
   settings.setValue("ask_remove_tool", ask_remove_tool_);
 
+  track_external_changes_ = ui->track_changes_cb->isChecked();
+  settings.setValue("track_external_changes", track_external_changes_);
+
+  settings.setValue("stream_extraction", ui->stream_extraction_cb->isChecked());
+  settings.setValue("keep_streamed_archives", ui->keep_streamed_archives_cb->isChecked());
+
   emit settingsDialogAccepted();
 }
 
@@ -183,6 +195,11 @@ bool SettingsDialog::askRemoveTool() const
   return ask_remove_tool_;
 }
 
+bool SettingsDialog::trackExternalChanges() const
+{
+  return track_external_changes_;
+}
+
 std::optional<std::tuple<std::string, std::string, std::string, bool>>
 SettingsDialog::getNexusApiKeyDetails()
 {
@@ -81,6 +81,11 @@ public:
    * \return The selection.
    */
   bool askRemoveTool() const;
+  /*!
+   * \brief Returns true if the track external changes option has been selected.
+   * \return The selection.
+   */
+  bool trackExternalChanges() const;
   /*!
    * \brief Reads the key cipher, nonce, tag and the is_default flag for the Nexus API key from
    * the settings file.
@@ -137,6 +142,8 @@ private:
   bool ask_remove_backup_ = true;
   /*! \brief True if the ask when removing a tool option has been selected. */
   bool ask_remove_tool_ = true;
+  /*! \brief True if the track external changes option has been selected. */
+  bool track_external_changes_ = false;
   /*! \brief Indicates whether the dialog has been completed. */
   bool dialog_completed_ = false;
   /*! \brief Icon used to indicate that the password is to be shown. */
@@ -0,0 +1,79 @@
+#include "../src/core/atomicprogressnode.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("Progress is aggregated", "[progress]")
+{
+  std::vector<float> reported;
+  AtomicProgressNode root([&reported](float progress) { reported.push_back(progress); },
+                          { 1.0f, 3.0f });
+  root.child(0).setTotalSteps(10);
+  root.child(1).addChildren({ 1.0f, 1.0f });
+  root.child(1).child(0).setTotalSteps(4);
+  root.child(1).child(1).setTotalSteps(0);
+  REQUIRE(root.getProgress() == 0.0f);
+  root.child(0).advance(5);
+  REQUIRE(root.getProgress() == 0.125f);
+  root.child(1).child(0).advance(2);
+  REQUIRE(root.getProgress() == 0.3125f);
+  root.child(1).child(1).advance();
+  root.child(0).advance(100);
+  REQUIRE(root.getProgress() == 0.8125f);
+  root.child(1).child(0).advance(2);
+  REQUIRE(root.getProgress() == 1.0f);
+  REQUIRE_THROWS(root.child(1).setTotalSteps(1));
+}
+
+TEST_CASE("Progress is advanced concurrently", "[progress]")
+{
+  std::vector<float> reported;
+  AtomicProgressNode root([&reported](float progress) { reported.push_back(progress); },
+                          { 1.0f, 1.0f, 1.0f, 1.0f });
+  const int num_steps = 100000;
+  for(int i = 0; i < 4; i++)
+    root.child(i).setTotalSteps(num_steps);
+  root.startSampling(std::chrono::milliseconds(1));
+  std::vector<std::jthread> workers;
+  for(int i = 0; i < 4; i++)
+    workers.emplace_back(
+      [&root, i]()
+      {
+        for(int step = 0; step < num_steps; step++)
+          root.child(i).advance();
+      });
+  workers.clear();
+  root.stopSampling();
+  REQUIRE(root.getProgress() == 1.0f);
+  REQUIRE_FALSE(reported.empty());
+  REQUIRE(reported.back() == 1.0f);
+  REQUIRE(std::is_sorted(reported.begin(), reported.end()));
+}
+
+TEST_CASE("Progress is forwarded to ProgressNode", "[progress]")
+{
+  std::vector<float> reported;
+  ProgressNode root([&reported](float progress) { reported.push_back(progress); }, { 1.0f, 1.0f });
+  root.child(0).setTotalSteps(1);
+  root.child(0).advance();
+  root.child(1).setTotalSteps(40000);
+  {
+    AtomicProgressNode forwarder(root.child(1));
+    REQUIRE(forwarder.totalSteps() == 40000);
+    forwarder.startSampling(std::chrono::milliseconds(1));
+    std::vector<std::jthread> workers;
+    for(int i = 0; i < 4; i++)
+      workers.emplace_back(
+        [&forwarder]()
+        {
+          for(int step = 0; step < 10000; step++)
+            forwarder.advance();
+        });
+  }
+  REQUIRE(root.getProgress() == 1.0f);
+  REQUIRE_FALSE(reported.empty());
+  REQUIRE(reported.back() == 1.0f);
+  REQUIRE(std::is_sorted(reported.begin(), reported.end()));
+}
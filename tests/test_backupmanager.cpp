@@ -207,3 +207,76 @@ TEST_CASE("Backups are overwritten", "[backup]")
   bak_man.overwriteBackup(0, 1, 0);
   verifyDirsAreEqual(DATA_DIR / "app" / "a", DATA_DIR / "target" / "bak_man" / "overwrite1", true);
 }
+
+TEST_CASE("Snapshots do not share data with the active backup", "[backup]")
+{
+  resetAppDir();
+  BackupManager bak_man;
+  bak_man.addProfile();
+  bak_man.addTarget(DATA_DIR / "app" / "a", "t", { "b0", "b1" });
+  bak_man.addBackup(0, "b2", 1);
+  verifyDirsAreEqual(DATA_DIR / "app" / "a.1.lmmbakman", DATA_DIR / "app" / "a.2.lmmbakman", true);
+  bak_man.setActiveBackup(0, 2);
+  {
+    std::ofstream file(DATA_DIR / "app" / "a" / "2.txt", std::ios::app);
+    file << "modified";
+  }
+  verifyDirsAreEqual(DATA_DIR / "app" / "a.0.lmmbakman", DATA_DIR / "app" / "a.1.lmmbakman", true);
+  verifyFilesAreEqual(DATA_DIR / "source" / "app" / "a" / "2.txt",
+                      DATA_DIR / "app" / "a.1.lmmbakman" / "2.txt");
+  REQUIRE(sfs::hard_link_count(DATA_DIR / "app" / "a" / "2.txt") == 1);
+}
+
+TEST_CASE("Backups are stored in chunk stores", "[backup]")
+{
+  resetAppDir();
+  BackupManager bak_man;
+  bak_man.addProfile();
+  bak_man.addTarget(DATA_DIR / "app" / "a", "t", { "b0", "b1" });
+  bak_man.setUseChunkStore(0, true);
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / "a.1.lmmbakman"));
+  REQUIRE(sfs::exists(DATA_DIR / "app" / ".a.lmmbakman.store"));
+  bak_man.addBackup(0, "b2", 0);
+  {
+    std::ofstream file(DATA_DIR / "app" / "a" / "2.txt", std::ios::app);
+    file << "modified";
+  }
+  bak_man.setActiveBackup(0, 2);
+  verifyDirsAreEqual(DATA_DIR / "app" / "a", DATA_DIR / "source" / "app" / "a", true);
+  bak_man.setActiveBackup(0, 0);
+  std::ifstream file(DATA_DIR / "app" / "a" / "2.txt");
+  const std::string content(std::istreambuf_iterator<char>(file), {});
+  REQUIRE(content.ends_with("modified"));
+
+  BackupManager bak_man2;
+  bak_man2.addProfile();
+  bak_man2.addTarget(DATA_DIR / "app" / "a");
+  REQUIRE(bak_man.getTargets() == bak_man2.getTargets());
+  bak_man2.setUseChunkStore(0, false);
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".a.lmmbakman.store"));
+  verifyDirsAreEqual(DATA_DIR / "app" / "a.2.lmmbakman", DATA_DIR / "source" / "app" / "a", true);
+}
+
+TEST_CASE("Only modified targets are updated", "[backup]")
+{
+  resetAppDir();
+  BackupManager bak_man;
+  bak_man.addProfile();
+  bak_man.addTarget(DATA_DIR / "app" / "a", "t", { "b0", "b1" });
+  bak_man.addTarget(DATA_DIR / "app" / "b", "t2", { "b0", "b1" });
+  const auto old_time = sfs::file_time_type::clock::now() - std::chrono::hours(1);
+  sfs::last_write_time(DATA_DIR / "app" / ".b.lmmbakman.json", old_time);
+  bak_man.setActiveBackup(0, 1);
+  bak_man.addBackup(0, "b2");
+  bak_man.removeBackup(0, 0);
+  REQUIRE(sfs::last_write_time(DATA_DIR / "app" / ".b.lmmbakman.json") == old_time);
+
+  sfs::last_write_time(DATA_DIR / "app", old_time);
+  bak_man.setBackupName(0, 0, "b1");
+  sfs::remove_all(DATA_DIR / "app" / "a.1.lmmbakman");
+  bak_man.setActiveBackup(1, 1);
+  REQUIRE(bak_man.getNumBackups(0) == 2);
+  bak_man.addBackup(0, "b3");
+  REQUIRE(bak_man.getNumBackups(0) == 2);
+  REQUIRE(sfs::exists(DATA_DIR / "app" / "a.1.lmmbakman"));
+}
@@ -0,0 +1,63 @@
+#include "../src/core/batchrunner.h"
+#include "../src/core/deployerfactory.h"
+#include "../src/core/installer.h"
+#include "../src/core/moddedapplication.h"
+#include "test_utils.h"
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("Batch commands are run", "[batch]")
+{
+  resetStagingDir();
+  resetAppDir();
+  {
+    ModdedApplication app(DATA_DIR / "staging", "test");
+    app.addDeployer(
+      { DeployerFactory::SIMPLEDEPLOYER, "depl0", DATA_DIR / "app", Deployer::hard_link });
+    ImportModInfo info;
+    info.name = "mod 0";
+    info.version = "1.0";
+    info.installer = Installer::SIMPLEINSTALLER;
+    info.current_path = DATA_DIR / "source" / "mod0.tar.gz";
+    info.deployers = { 0 };
+    info.installer_flags = Installer::preserve_case | Installer::preserve_directories;
+    info.root_level = 0;
+    app.installMod(info);
+    info.name = "mod 1";
+    info.current_path = DATA_DIR / "source" / "mod1.zip";
+    app.installMod(info);
+    info.name = "mod 2";
+    info.current_path = DATA_DIR / "source" / "mod2.tar.gz";
+    app.installMod(info);
+  }
+
+  BatchRunner runner({ DATA_DIR / "staging" });
+  runner.addCommand(BatchRunner::DEPLOY);
+  runner.addCommand(BatchRunner::CONFLICTS);
+  runner.addCommand(BatchRunner::EXTERNAL_CHANGES);
+  runner.addTarget(0, 0);
+  const auto result = runner.run();
+  REQUIRE(result["success"].asBool());
+  REQUIRE(result["apps"].size() == 1);
+  const auto& app_result = result["apps"][0];
+  REQUIRE(app_result["name"].asString() == "test");
+  REQUIRE(app_result["commands"].size() == 3);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  REQUIRE(app_result["commands"][2]["deployers"][0]["files"].empty());
+
+  BatchRunner invalid_profile_runner({ DATA_DIR / "staging" });
+  invalid_profile_runner.addCommand(BatchRunner::UNDEPLOY);
+  invalid_profile_runner.addTarget(0, 5);
+  const auto invalid_result = invalid_profile_runner.run();
+  REQUIRE_FALSE(invalid_result["success"].asBool());
+  REQUIRE_FALSE(invalid_result["apps"][0]["error"].asString().empty());
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+}
+
+TEST_CASE("Invalid batch arguments are rejected", "[batch]")
+{
+  BatchRunner runner({ DATA_DIR / "staging" });
+  REQUIRE_THROWS(runner.addCommand("invalid"));
+  REQUIRE_THROWS(runner.addTarget(1));
+  REQUIRE_THROWS(runner.addTarget(-1));
+}
@@ -1,9 +1,13 @@
 #include "test_utils.h"
 #include "../src/core/bg3deployer.h"
+#include "../src/core/lspakextractor.h"
+#include "../src/core/lspakwriter.h"
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_vector.hpp>
 #include <ranges>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
 
 namespace str = std::ranges;
 
@@ -90,3 +94,147 @@ TEST_CASE("Profiles are managed", "[bg3]")
   verifyFilesAreEqual(DATA_DIR / "target" / "bg3" / "target" / "modsettings.lsx",
                       DATA_DIR / "target" / "bg3" / "1" / "modsettings.lsx");
 }
+
+TEST_CASE("Pak files are extracted and compared", "[bg3]")
+{
+  const sfs::path source = DATA_DIR / "source" / "bg3" / "source";
+  const sfs::path target = DATA_DIR / "target" / "bg3" / "extracted";
+  if(sfs::exists(target))
+    sfs::remove_all(target);
+
+  LsPakExtractor extractor(source / "mod1.pak");
+  extractor.init();
+  const auto infos = extractor.getFileInfos();
+  REQUIRE(!infos.empty());
+  REQUIRE(extractor.extractFiles(target) == infos.size());
+  for(const auto& [i, info] : str::enumerate_view(infos))
+  {
+    REQUIRE(sfs::file_size(target / info.path) == info.size);
+    std::ifstream file(target / info.path, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    REQUIRE(content == extractor.extractFile(i));
+  }
+  sfs::remove_all(target);
+  REQUIRE(extractor.extractFiles(target, [](const std::string& path) { return false; }) == 0);
+  REQUIRE_FALSE(sfs::exists(target));
+
+  auto diff = extractor.diff(extractor);
+  REQUIRE(diff.unchanged.size() == infos.size());
+  REQUIRE(diff.added.empty());
+  REQUIRE(diff.removed.empty());
+  REQUIRE(diff.changed.empty());
+}
+
+TEST_CASE("Pak contents are compared", "[bg3]")
+{
+  const sfs::path base_path = DATA_DIR / "target" / "bg3" / "diff";
+  if(sfs::exists(base_path))
+    sfs::remove_all(base_path);
+  auto write_file =
+    [&base_path](const std::string& dir, const std::string& name, const std::string& content)
+  {
+    sfs::create_directories(base_path / dir);
+    std::ofstream(base_path / dir / name, std::ios::binary) << content;
+  };
+  const std::string long_content(4096, 'a');
+  write_file("old", "unchanged", long_content);
+  write_file("old", "same_size", long_content);
+  write_file("old", "other_size", "content");
+  write_file("old", "removed", "content");
+  write_file("new", "unchanged", long_content);
+  write_file("new", "same_size", std::string(4095, 'a') + "b");
+  write_file("new", "other_size", "other content");
+  write_file("new", "added", "content");
+
+  for(auto compression : { LsPakWriter::none, LsPakWriter::lz4, LsPakWriter::zstd })
+  {
+    for(const std::string dir : { "old", "new" })
+    {
+      LsPakWriter writer(base_path / (dir + ".pak"), compression);
+      writer.addDirectory(base_path / dir);
+      writer.write();
+    }
+    LsPakExtractor old_pak(base_path / "old.pak");
+    old_pak.init();
+    LsPakExtractor new_pak(base_path / "new.pak");
+    new_pak.init();
+    const auto diff = old_pak.diff(new_pak);
+    REQUIRE(diff.added == std::vector<std::string>{ "added" });
+    REQUIRE(diff.removed == std::vector<std::string>{ "removed" });
+    REQUIRE(diff.changed == std::vector<std::string>{ "other_size", "same_size" });
+    REQUIRE(diff.unchanged == std::vector<std::string>{ "unchanged" });
+  }
+  sfs::remove_all(base_path);
+}
+
+TEST_CASE("Corrupt pak entries are rejected", "[bg3]")
+{
+  const sfs::path base_path = DATA_DIR / "target" / "bg3" / "corrupt";
+  if(sfs::exists(base_path))
+    sfs::remove_all(base_path);
+  sfs::create_directories(base_path / "source");
+  std::ofstream(base_path / "source" / "file", std::ios::binary) << std::string(4096, 'a');
+
+  for(auto compression : { LsPakWriter::lz4, LsPakWriter::zstd })
+  {
+    LsPakWriter writer(base_path / "corrupt.pak", compression);
+    writer.addDirectory(base_path / "source");
+    writer.write();
+    {
+      // entry data directly follows the header
+      std::fstream file(base_path / "corrupt.pak",
+                        std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(sizeof(LsPakHeader));
+      const std::string zeros(8, '\0');
+      file.write(zeros.data(), zeros.size());
+    }
+    LsPakExtractor extractor(base_path / "corrupt.pak");
+    extractor.init();
+    REQUIRE(extractor.getFileInfos().size() == 1);
+    REQUIRE(extractor.getFileInfos()[0].compressed_size < 4096);
+    REQUIRE_THROWS(extractor.extractFile(0));
+    REQUIRE_THROWS(extractor.extractFiles(base_path / "extracted"));
+  }
+  sfs::remove_all(base_path);
+}
+
+TEST_CASE("Packed pak files can be extracted", "[bg3]")
+{
+  const sfs::path source = DATA_DIR / "source" / "0";
+  const sfs::path pak_path = DATA_DIR / "target" / "bg3" / "packed.pak";
+  const sfs::path target = DATA_DIR / "target" / "bg3" / "packed";
+  auto read_file = [](const sfs::path& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  };
+  for(auto compression : { LsPakWriter::none, LsPakWriter::lz4, LsPakWriter::zstd })
+  {
+    if(sfs::exists(target))
+      sfs::remove_all(target);
+    LsPakWriter writer(pak_path, compression);
+    writer.addDirectory(source);
+    writer.write();
+
+    LsPakExtractor extractor(pak_path);
+    extractor.init();
+    int num_files = 0;
+    for(const auto& dir_entry : sfs::recursive_directory_iterator(source))
+    {
+      if(dir_entry.is_regular_file())
+        num_files++;
+    }
+    REQUIRE(extractor.getFileInfos().size() == num_files);
+    REQUIRE(extractor.extractFiles(target) == num_files);
+    for(const auto& dir_entry : sfs::recursive_directory_iterator(source))
+    {
+      if(!dir_entry.is_regular_file())
+        continue;
+      const sfs::path relative_path = dir_entry.path().lexically_relative(source);
+      REQUIRE(read_file(target / relative_path) == read_file(dir_entry.path()));
+    }
+  }
+  sfs::remove(pak_path);
+  sfs::remove_all(target);
+}
@@ -47,3 +47,22 @@ TEST_CASE("String are encrypted", "[crypto]")
   REQUIRE_THROWS_AS(cryptography::decrypt(cipher, key, nonce, tag == "a" ? "b" : "a"),
                     CryptographyError);
 }
+
+TEST_CASE("MD5 digests are computed incrementally", "[crypto]")
+{
+  cryptography::Md5Hasher empty_hasher;
+  REQUIRE(empty_hasher.finalize() == "d41d8cd98f00b204e9800998ecf8427e");
+
+  cryptography::Md5Hasher hasher;
+  const std::string text = "abc";
+  hasher.update(text.data(), 1);
+  hasher.update(text.data() + 1, 2);
+  REQUIRE(hasher.finalize() == "900150983cd24fb0d6963f7d28e17f72");
+}
+
+TEST_CASE("SHA-256 digests are computed", "[crypto]")
+{
+  const std::string text = "abc";
+  REQUIRE(cryptography::sha256(text.data(), text.size()) ==
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
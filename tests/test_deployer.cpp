@@ -1,11 +1,15 @@
+#include "../src/core/cancellationerror.h"
 #include "../src/core/casematchingdeployer.h"
 #include "../src/core/deployer.h"
 #include "test_utils.h"
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <ranges>
+#include <sstream>
 
 
 TEST_CASE("Mods are added and removed", "[deployer]")
@@ -95,6 +99,28 @@ TEST_CASE("Loadorder is being changed", "[deployer]")
   verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
 }
 
+TEST_CASE("Loadorder is being changed in batches", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(2, true);
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.moveMods({ { 1, 0 }, { 1, 2 }, { 5, 0 } });
+  std::vector<std::tuple<int, bool>> expected = { { 0, true }, { 1, true }, { 2, true } };
+  REQUIRE(depl.getLoadorder() == expected);
+  depl.reorderMods({ 2, 0, 1 });
+  expected = { { 2, true }, { 0, true }, { 1, true } };
+  REQUIRE(depl.getLoadorder() == expected);
+  REQUIRE_THROWS_AS(depl.reorderMods({ 0, 0, 1 }), std::invalid_argument);
+  REQUIRE_THROWS_AS(depl.reorderMods({ 0, 1 }), std::invalid_argument);
+  REQUIRE(depl.getLoadorder() == expected);
+  depl.reorderMods({ 1, 2, 0 });
+  depl.deploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+}
+
 TEST_CASE("Profiles", "[deployer]")
 {
   resetAppDir();
@@ -204,6 +230,48 @@ TEST_CASE("Case matching deployer", "[deployer]")
                      false);
 }
 
+TEST_CASE("Case invariant conflicts are resolved", "[deployer]")
+{
+  resetAppDir();
+  const sfs::path source_path = DATA_DIR / "source" / "case_conflicts";
+  sfs::remove_all(source_path);
+  auto write_file = [&source_path](int mod_id, const sfs::path& path, const std::string& content)
+  {
+    sfs::create_directories((source_path / std::to_string(mod_id) / path).parent_path());
+    std::ofstream file(source_path / std::to_string(mod_id) / path);
+    file << content;
+  };
+  write_file(0, "Data/A.txt", "0");
+  write_file(1, "data/a.txt", "1");
+  write_file(2, "b.txt", "2");
+  CaseMatchingDeployer depl(source_path, DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+
+  depl.updateConflictGroups();
+  REQUIRE_THAT(depl.getConflictGroups(),
+               Catch::Matchers::UnorderedEquals(std::vector<std::vector<int>>{ { 0, 1 }, { 2 } }));
+
+  // deploy without matching file names, as is done for case folded target directories
+  depl.Deployer::deploy({ 0, 1, 2 });
+  REQUIRE(sfs::exists(DATA_DIR / "app" / "b.txt"));
+  REQUIRE(sfs::exists(DATA_DIR / "app" / "data" / "a.txt"));
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / "Data"));
+  std::ifstream file(DATA_DIR / "app" / "data" / "a.txt");
+  std::string content;
+  file >> content;
+  REQUIRE(content == "1");
+
+  depl.Deployer::deploy({ 1, 0, 2 });
+  REQUIRE(sfs::exists(DATA_DIR / "app" / "Data" / "A.txt"));
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / "data"));
+  depl.unDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+  sfs::remove_all(source_path);
+}
+
 TEST_CASE("External changes are handeld", "[deployer]")
 {
   resetAppDir();
@@ -269,7 +337,376 @@ TEST_CASE("Files are deployed as sym links", "[deployer]")
     if(!dir_entry.is_directory() && dir_entry.path().extension() != ".lmmbak"
       && dir_entry.path().filename() != ".lmmfiles" && dir_entry.path().filename() != "file.cfg"
       && dir_entry.path().filename() != "wasd" && dir_entry.path().filename() != "0"
-      && dir_entry.path().filename() != ".lmm_managed_dir")
+      && dir_entry.path().filename() != ".lmm_managed_dir"
+      && dir_entry.path().parent_path().filename() != ".lmmgenerations")
         REQUIRE(std::filesystem::is_symlink(dir_entry.path()));
   }
 }
+
+TEST_CASE("Deployments are audited and repaired", "[deployer]")
+{
+  resetAppDir();
+  resetStagingDir();
+  sfs::copy(DATA_DIR / "source" / "1", DATA_DIR / "staging" / "1", sfs::copy_options::recursive);
+
+  Deployer depl = Deployer(DATA_DIR / "staging", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(1, true);
+  depl.deploy();
+
+  auto audit = depl.auditDeployment();
+  REQUIRE(audit.entries.empty());
+  REQUIRE(audit.num_identical > 0);
+
+  sfs::remove(DATA_DIR / "app" / "6");
+  sfs::remove(DATA_DIR / "app" / "7");
+  sfs::copy(DATA_DIR / "source" / "external_changes" / "6", DATA_DIR / "app" / "7");
+
+  audit = depl.auditDeployment();
+  std::set<std::tuple<std::string, int, DeploymentAudit::Status>> expected_entries = {
+    { "6", 1, DeploymentAudit::missing }, { "7", 1, DeploymentAudit::modified }
+  };
+  REQUIRE(audit.entries.size() == expected_entries.size());
+  for(const auto& entry : audit.entries)
+    REQUIRE(expected_entries.contains({ entry.path.string(), entry.mod_id, entry.status }));
+
+  depl.repairDeployment(audit);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod1", true);
+  REQUIRE(sfs::equivalent(DATA_DIR / "staging" / "1" / "6", DATA_DIR / "app" / "6"));
+  REQUIRE(sfs::equivalent(DATA_DIR / "staging" / "1" / "7", DATA_DIR / "app" / "7"));
+  REQUIRE(depl.auditDeployment().entries.empty());
+
+  REQUIRE(sfs::exists(DATA_DIR / "app" / ".lmmhashes"));
+  depl.cleanup();
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".lmmhashes"));
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
+
+// simulates a deployment which is interrupted after the given number of file operations
+class InterruptedDeployer : public Deployer
+{
+public:
+  using Deployer::Deployer;
+
+  int deployPartially(const std::vector<int>& loadorder, int num_operations)
+  {
+    const auto [source_files, mod_sizes] = getDeploymentSourceFilesAndModSizes(loadorder);
+    const auto operations = getDeploymentOperations(source_files, loadDeployedFiles());
+    saveDeployedFiles(source_files, {}, pending_deployed_files_name_);
+    DeployJournal journal(dest_path_ / journal_name_);
+    journal.begin(deploy_mode_, operations);
+    const auto batches = DeployJournal::getBatches(operations);
+    for(int batch = 0; batch < batches.size(); batch++)
+    {
+      for(int i = batches[batch].first; i < batches[batch].second; i++)
+      {
+        if(i >= num_operations)
+          return operations.size();
+        performDeploymentOperation(operations[i], deploy_mode_, {});
+      }
+      journal.completeBatch(batch);
+    }
+    return operations.size();
+  }
+};
+
+TEST_CASE("Interrupted deployments are completed", "[deployer]")
+{
+  int num_operations = 1;
+  for(int cut = 0; cut <= num_operations; cut++)
+  {
+    resetAppDir();
+    Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+    depl.addProfile();
+    depl.addMod(1, true);
+    depl.deploy();
+    REQUIRE_FALSE(depl.recoverInterruptedDeployment());
+
+    InterruptedDeployer interrupted_depl(DATA_DIR / "source", DATA_DIR / "app", "");
+    num_operations = interrupted_depl.deployPartially({ 0, 1, 2 }, cut);
+    REQUIRE(depl.recoverInterruptedDeployment());
+    verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+    REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".lmmjournal"));
+
+    interrupted_depl.deployPartially({}, cut);
+    REQUIRE(depl.recoverInterruptedDeployment());
+    verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+  }
+
+  resetAppDir();
+  std::ofstream(DATA_DIR / "app" / ".lmmjournal") << "lmm_deploy_journal 1 0\n0 -1 0 0.txt\n";
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  REQUIRE(depl.recoverInterruptedDeployment());
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".lmmjournal"));
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
+
+TEST_CASE("Canceled deployments leave a consistent state", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+
+  std::atomic<bool> cancel = true;
+  ProgressNode canceled_node([](float f) {}, {}, &cancel);
+  REQUIRE_THROWS_AS(depl.deploy(&canceled_node), CancellationError);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+
+  // cancel once the first file has been backed up
+  cancel = false;
+  ProgressNode node([&cancel](float progress)
+                    { cancel = cancel || sfs::exists(DATA_DIR / "app" / "0.txt.lmmbak"); },
+                    {},
+                    &cancel);
+  REQUIRE_THROWS_AS(depl.deploy(&node), CancellationError);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".lmmjournal"));
+  REQUIRE_FALSE(depl.recoverInterruptedDeployment());
+
+  depl.deploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  depl.unDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
+
+TEST_CASE("Active group members are switched", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addProfile();
+  depl.setProfile(1);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+  depl.setProfile(0);
+  REQUIRE_FALSE(depl.redeployMods({ 1, 2 }));
+  depl.deploy();
+
+  REQUIRE(depl.changeActiveGroupMember({ 1, 2 }, 2));
+  REQUIRE_THAT(depl.getLoadorder(),
+               Catch::Matchers::Equals(std::vector<std::tuple<int, bool>>{ { 0, true }, { 2, true } }));
+  depl.setProfile(1);
+  REQUIRE_THAT(depl.getLoadorder(),
+               Catch::Matchers::Equals(std::vector<std::tuple<int, bool>>{ { 2, true } }));
+  depl.setProfile(0);
+  REQUIRE_FALSE(depl.changeActiveGroupMember({ 1, 2 }, 2));
+
+  REQUIRE(depl.redeployMods({ 1, 2 }));
+  const auto redeployed_path = DATA_DIR / "app_redeployed";
+  sfs::remove_all(redeployed_path);
+  sfs::copy(DATA_DIR / "app", redeployed_path, sfs::copy_options::recursive);
+  depl.unDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+  depl.deploy();
+  verifyDirsAreEqual(DATA_DIR / "app", redeployed_path, true);
+
+  // other changes to the load order since the last deployment require a full deployment
+  depl.setModStatus(0, false);
+  REQUIRE(depl.changeActiveGroupMember({ 1, 2 }, 1));
+  REQUIRE(depl.redeployMods({ 1, 2 }));
+  sfs::remove_all(redeployed_path);
+  sfs::copy(DATA_DIR / "app", redeployed_path, sfs::copy_options::recursive);
+  depl.unDeploy();
+  depl.deploy();
+  verifyDirsAreEqual(DATA_DIR / "app", redeployed_path, true);
+  sfs::remove_all(redeployed_path);
+}
+
+TEST_CASE("Deployments are planned", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(2, false);
+
+  auto plan = depl.planDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+  REQUIRE(plan.is_supported);
+  REQUIRE(plan.num_files_created == 9);
+  REQUIRE(plan.num_backups_created == 4);
+  REQUIRE(plan.num_files_replaced == 0);
+  REQUIRE(plan.target_files.size() == 9);
+  REQUIRE(plan.estimated_seconds > 0);
+
+  // costs are only measured for the deploy mode used
+  const auto copy_costs = depl.getOperationCosts(Deployer::copy);
+  depl.deploy();
+  REQUIRE(depl.planDeploy().getNumOperations() == 0);
+  REQUIRE(depl.getOperationCosts(Deployer::copy) == copy_costs);
+  REQUIRE_FALSE(depl.getOperationCosts(Deployer::hard_link) == copy_costs);
+  REQUIRE(Deployer(DATA_DIR / "source", DATA_DIR / "app", "").getOperationCosts(
+            Deployer::hard_link) == copy_costs);
+
+  depl.setModStatus(0, false);
+  depl.setModStatus(2, true);
+  plan = depl.planDeploy();
+  REQUIRE(plan.num_files_created == 2);
+  REQUIRE(plan.num_files_replaced == 3);
+  REQUIRE(plan.num_files_removed == 3);
+  REQUIRE(plan.num_backups_restored == 3);
+  REQUIRE(plan.num_backups_created == 0);
+  REQUIRE(plan.bytes_to_copy == 0);
+
+  depl.setDeployMode(Deployer::copy);
+  REQUIRE(depl.planDeploy().bytes_to_copy > 0);
+  Deployer::OperationCosts costs;
+  costs.operations = { 1.0, 1.0, 1.0, 1.0 };
+  costs.copy_per_byte = -1.0;
+  depl.setOperationCosts(Deployer::copy, costs);
+  REQUIRE(depl.getOperationCosts(Deployer::copy).operations == costs.operations);
+  REQUIRE(depl.getOperationCosts(Deployer::copy).copy_per_byte == copy_costs.copy_per_byte);
+  REQUIRE(depl.planDeploy().estimated_seconds > plan.getNumOperations());
+}
+
+TEST_CASE("File providers are mapped", "[deployer]")
+{
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+
+  auto provider_map = depl.getFileProviderMap();
+  REQUIRE(provider_map->size() == 15);
+  REQUIRE(provider_map == depl.getFileProviderMap());
+  REQUIRE(provider_map->find("0.txt")->mod_ids == std::vector<int>{ 0, 2 });
+  REQUIRE(provider_map->find("a/b/2.txt")->mod_ids == std::vector<int>{ 0, 2 });
+  REQUIRE(provider_map->find("6")->mod_ids == std::vector<int>{ 1 });
+  REQUIRE(provider_map->find("a") == nullptr);
+  REQUIRE(provider_map->findPrefix("a/").size() == 5);
+  REQUIRE(provider_map->findPrefix("f/").size() == 2);
+  REQUIRE(provider_map->findPrefix("x").empty());
+  REQUIRE(provider_map->findPrefix("").size() == 15);
+
+  std::stringstream report;
+  provider_map->writeReport(report, [](int id) { return "mod" + std::to_string(id); }, true);
+  REQUIRE(report.str() == "\"File\",\"Winner\",\"Overwritten mods\"\n"
+                          "\"0.txt\",\"mod2 [2]\",\"mod0 [0]\"\n"
+                          "\"a/b/2.txt\",\"mod2 [2]\",\"mod0 [0]\"\n"
+                          "\"b/3\",\"mod2 [2]\",\"mod0 [0]\"\n");
+
+  depl.setModStatus(2, false);
+  provider_map = depl.getFileProviderMap();
+  REQUIRE(provider_map->size() == 13);
+  REQUIRE(provider_map->find("0.txt")->mod_ids == std::vector<int>{ 0 });
+  REQUIRE(provider_map->find("a/1.txt") == nullptr);
+
+  // changes in sub-directories invalidate the index
+  resetStagingDir();
+  sfs::copy(DATA_DIR / "source" / "0", DATA_DIR / "staging" / "0", sfs::copy_options::recursive);
+  Deployer staging_depl(DATA_DIR / "staging", DATA_DIR / "app", "");
+  staging_depl.addProfile();
+  staging_depl.addMod(0, true);
+  const sfs::path sub_dir = DATA_DIR / "staging" / "0" / "a" / "b";
+  const auto old_write_time = sfs::last_write_time(sub_dir);
+  REQUIRE(staging_depl.getFileProviderMap()->find("a/b/new.txt") == nullptr);
+  std::ofstream(sub_dir / "new.txt") << "content";
+  sfs::last_write_time(sub_dir, old_write_time + std::chrono::seconds(1));
+  REQUIRE(staging_depl.getFileProviderMap()->find("a/b/new.txt")->mod_ids == std::vector<int>{ 0 });
+  sfs::remove(sub_dir / "2.txt");
+  sfs::last_write_time(sub_dir, old_write_time + std::chrono::seconds(2));
+  REQUIRE(staging_depl.getFileProviderMap()->find("a/b/2.txt") == nullptr);
+}
+
+TEST_CASE("Deployments are rolled back", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+  depl.deploy();
+  const std::vector<std::tuple<int, bool>> first_loadorder = depl.getLoadorder();
+  depl.setModStatus(0, false);
+  depl.setModStatus(2, false);
+  depl.deploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod1", true);
+  // deployments without any changes are not recorded
+  depl.deploy();
+  auto generations = depl.getGenerations();
+  REQUIRE(generations.size() == 2);
+  REQUIRE(generations[0].loadorder == first_loadorder);
+  REQUIRE(generations[1].num_changes > 0);
+
+  depl.rollbackToGeneration(generations[0].id);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  REQUIRE(depl.getLoadorder() == first_loadorder);
+  generations = depl.getGenerations();
+  REQUIRE(generations.size() == 3);
+  depl.rollbackToGeneration(generations[1].id);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod1", true);
+  REQUIRE_THROWS(depl.rollbackToGeneration(100));
+
+  depl.setMaxGenerations(2);
+  generations = depl.getGenerations();
+  REQUIRE(generations.size() == 2);
+  depl.rollbackToGeneration(generations[0].id);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  depl.cleanup();
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / ".lmmgenerations"));
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
+
+TEST_CASE("Canceled deployments are rolled back", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.addMod(2, true);
+  depl.deploy();
+  depl.setModStatus(2, false);
+
+  // cancel once the files only provided by mod 2 have been removed, before the files it
+  // overwrites are linked again
+  std::atomic<bool> cancel = false;
+  ProgressNode node([&cancel](float progress)
+                    { cancel = cancel || !sfs::exists(DATA_DIR / "app" / "0"); },
+                    {},
+                    &cancel);
+  REQUIRE_THROWS_AS(depl.deploy(&node), CancellationError);
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "app" / "0"));
+  auto generations = depl.getGenerations();
+  REQUIRE(generations.size() == 2);
+
+  depl.rollbackToGeneration(generations[0].id);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  depl.unDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
+
+TEST_CASE("Rollbacks are limited to the current profile", "[deployer]")
+{
+  resetAppDir();
+  Deployer depl = Deployer(DATA_DIR / "source", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(1, true);
+  depl.deploy();
+  depl.addProfile(0);
+  depl.setProfile(1);
+  depl.addMod(0, true);
+  depl.addMod(2, true);
+  depl.changeLoadorder(0, 1);
+  depl.deploy();
+  const auto generations = depl.getGenerations();
+  REQUIRE(generations.size() == 2);
+  REQUIRE(generations[0].profile == 0);
+  REQUIRE(generations[1].profile == 1);
+
+  REQUIRE_THROWS(depl.rollbackToGeneration(generations[0].id));
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
+  depl.setProfile(0);
+  REQUIRE_THROWS(depl.rollbackToGeneration(generations[1].id));
+  depl.rollbackToGeneration(generations[0].id);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod1", true);
+  depl.unDeploy();
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app", true);
+}
@@ -0,0 +1,131 @@
+#include "../src/core/deployer.h"
+#include "../src/core/deploymentwatcher.h"
+#include "test_utils.h"
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+namespace sfs = std::filesystem;
+
+
+// events are processed asynchronously, so wait until the expected number of paths is recorded
+std::set<sfs::path> waitForModifiedPaths(DeploymentWatcher& watcher, int num_paths)
+{
+  std::set<sfs::path> paths;
+  for(int i = 0; i < 200 && paths.size() < num_paths; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto modified_paths = watcher.takeModifiedPaths();
+    REQUIRE(modified_paths);
+    paths = *modified_paths;
+  }
+  return paths;
+}
+
+TEST_CASE("Changes in watched directories are recorded", "[watcher]")
+{
+  resetAppDir();
+  sfs::create_directories(DATA_DIR / "app" / "a" / "b");
+  sfs::create_directories(DATA_DIR / "app" / "c");
+  std::ofstream(DATA_DIR / "app" / "a" / "b" / "file") << "content";
+  std::ofstream(DATA_DIR / "app" / "c" / "file") << "content";
+  std::ofstream(DATA_DIR / "app" / "a" / "written_file") << "content";
+
+  DeploymentWatcher full_sweep_watcher(DATA_DIR / "app", {});
+  REQUIRE_FALSE(full_sweep_watcher.takeModifiedPaths());
+  REQUIRE(full_sweep_watcher.takeModifiedPaths()->empty());
+
+  DeploymentWatcher watcher(DATA_DIR / "app", { "a", sfs::path("a") / "b" }, false);
+  REQUIRE(watcher.takeModifiedPaths()->empty());
+  sfs::remove(DATA_DIR / "app" / "a" / "b" / "file");
+  std::ofstream(DATA_DIR / "app" / "new_file") << "content";
+  sfs::remove(DATA_DIR / "app" / "c" / "file");
+  std::ofstream(DATA_DIR / "app" / "a" / "written_file", std::ios::app) << "more content";
+  watcher.addModifiedPaths({ "other_file" });
+
+  const std::set<sfs::path> expected_paths = { sfs::path("a") / "b" / "file",
+                                               sfs::path("a") / "written_file",
+                                               "new_file",
+                                               "other_file" };
+  REQUIRE(waitForModifiedPaths(watcher, expected_paths.size()) == expected_paths);
+  REQUIRE_THROWS(DeploymentWatcher(DATA_DIR / "app", { "missing" }));
+}
+
+TEST_CASE("Failed watchers always require a full check", "[watcher]")
+{
+  resetAppDir();
+  DeploymentWatcher watcher(DATA_DIR / "app", {}, false);
+  REQUIRE(watcher.takeModifiedPaths()->empty());
+
+  // replace the inotify descriptor with one that can not be read from
+  int inotify_fd = -1;
+  for(const auto& entry : sfs::directory_iterator("/proc/self/fd"))
+  {
+    std::error_code ec;
+    if(sfs::read_symlink(entry.path(), ec) == "anon_inode:inotify")
+      inotify_fd = std::stoi(entry.path().filename().string());
+  }
+  REQUIRE(inotify_fd >= 0);
+  const int write_only_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  REQUIRE(dup2(write_only_fd, inotify_fd) == inotify_fd);
+  close(write_only_fd);
+  // wake up the watcher thread
+  std::ofstream(DATA_DIR / "app" / "new_file") << "content";
+
+  bool failed = false;
+  for(int i = 0; i < 200 && !failed; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    failed = !watcher.takeModifiedPaths();
+  }
+  REQUIRE(failed);
+  for(int i = 0; i < 3; i++)
+  {
+    watcher.addModifiedPaths({ "new_file" });
+    REQUIRE_FALSE(watcher.takeModifiedPaths());
+  }
+}
+
+TEST_CASE("Only tracked files are checked for external changes", "[watcher]")
+{
+  resetAppDir();
+  resetStagingDir();
+  sfs::copy(DATA_DIR / "source" / "0", DATA_DIR / "staging" / "0", sfs::copy_options::recursive);
+  sfs::copy(DATA_DIR / "source" / "1", DATA_DIR / "staging" / "1", sfs::copy_options::recursive);
+
+  Deployer depl = Deployer(DATA_DIR / "staging", DATA_DIR / "app", "");
+  depl.addProfile();
+  depl.addMod(0, true);
+  depl.addMod(1, true);
+  depl.deploy();
+
+  // files changed before tracking was enabled are found by the initial full check
+  sfs::remove(DATA_DIR / "app" / "6");
+  sfs::copy(DATA_DIR / "source" / "external_changes" / "6", DATA_DIR / "app");
+  depl.setTrackExternalChanges(true);
+  REQUIRE(depl.tracksExternalChanges());
+  auto changes = depl.getExternallyModifiedFiles();
+  REQUIRE(changes.size() == 1);
+  REQUIRE(changes[0].first == "6");
+
+  sfs::remove(DATA_DIR / "app" / "b" / "3aBc");
+  sfs::copy(DATA_DIR / "source" / "external_changes" / "3aBc", DATA_DIR / "app" / "b");
+  for(int i = 0; i < 200 && changes.size() < 2; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    changes = depl.getExternallyModifiedFiles();
+  }
+  const std::set<std::pair<sfs::path, int>> expected_changes = { { "6", 1 },
+                                                                 { sfs::path("b") / "3aBc", 0 } };
+  REQUIRE(std::set<std::pair<sfs::path, int>>(changes.begin(), changes.end()) ==
+          expected_changes);
+
+  // deployment restores all links and resets the tracked changes
+  depl.deploy();
+  REQUIRE(depl.getExternallyModifiedFiles().empty());
+  depl.setTrackExternalChanges(false);
+  REQUIRE_FALSE(depl.tracksExternalChanges());
+}
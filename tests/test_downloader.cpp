@@ -0,0 +1,223 @@
+#include "../src/core/cryptography.h"
+#include "../src/core/downloader.h"
+#include "test_utils.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <fstream>
+#include <netinet/in.h>
+#include <random>
+#include <regex>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+
+/*!
+ * \brief Minimal HTTP server serving one file from memory. Supports HEAD requests and
+ * single range GET requests. Can simulate interrupted connections.
+ */
+class TestServer
+{
+public:
+  TestServer(const std::string& content) : content_(content)
+  {
+    socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    REQUIRE(bind(socket_, (sockaddr*)&address, sizeof(address)) == 0);
+    REQUIRE(listen(socket_, 16) == 0);
+    socklen_t length = sizeof(address);
+    getsockname(socket_, (sockaddr*)&address, &length);
+    port_ = ntohs(address.sin_port);
+    accept_thread_ = std::thread([this]() { acceptConnections(); });
+  }
+
+  ~TestServer()
+  {
+    running_ = false;
+    shutdown(socket_, SHUT_RDWR);
+    close(socket_);
+    accept_thread_.join();
+    for(auto& thread : connection_threads_)
+      thread.join();
+  }
+
+  std::string getUrl() const { return std::format("http://127.0.0.1:{}/file.zip", port_); }
+
+  uint64_t getBytesSent() const { return bytes_sent_; }
+
+  void setMaxBytesPerRequest(uint64_t max_bytes) { max_bytes_per_request_ = max_bytes; }
+
+private:
+  std::string content_;
+  int socket_;
+  int port_;
+  std::atomic<bool> running_ = true;
+  std::atomic<uint64_t> bytes_sent_ = 0;
+  std::atomic<uint64_t> max_bytes_per_request_ = UINT64_MAX;
+  std::thread accept_thread_;
+  std::vector<std::thread> connection_threads_;
+
+  void acceptConnections()
+  {
+    while(running_)
+    {
+      const int connection = accept(socket_, nullptr, nullptr);
+      if(connection < 0)
+        return;
+      connection_threads_.emplace_back([this, connection]() { handleConnection(connection); });
+    }
+  }
+
+  void handleConnection(int connection)
+  {
+    std::string request;
+    char buffer[4096];
+    while(request.find("\r\n\r\n") == std::string::npos)
+    {
+      const ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+      if(received <= 0)
+      {
+        close(connection);
+        return;
+      }
+      request.append(buffer, received);
+    }
+
+    uint64_t start = 0;
+    uint64_t end = content_.size();
+    bool is_range_request = false;
+    std::smatch match;
+    if(std::regex_search(request, match, std::regex(R"(Range: bytes=(\d+)-(\d+))")))
+    {
+      start = std::stoull(match[1].str());
+      end = std::stoull(match[2].str()) + 1;
+      is_range_request = true;
+    }
+    std::string header = std::format("HTTP/1.1 {}\r\n"
+                                     "Content-Length: {}\r\n"
+                                     "Accept-Ranges: bytes\r\n"
+                                     "ETag: \"test\"\r\n"
+                                     "Connection: close\r\n",
+                                     is_range_request ? "206 Partial Content" : "200 OK",
+                                     end - start);
+    if(is_range_request)
+      header += std::format("Content-Range: bytes {}-{}/{}\r\n", start, end - 1, content_.size());
+    header += "\r\n";
+    send(connection, header.data(), header.size(), MSG_NOSIGNAL);
+
+    if(request.starts_with("GET"))
+    {
+      const uint64_t size = std::min(end - start, max_bytes_per_request_.load());
+      uint64_t sent = 0;
+      while(sent < size)
+      {
+        const ssize_t ret = send(connection,
+                                 content_.data() + start + sent,
+                                 std::min<uint64_t>(size - sent, 65536),
+                                 MSG_NOSIGNAL);
+        if(ret <= 0)
+          break;
+        sent += ret;
+      }
+      bytes_sent_ += sent;
+    }
+    close(connection);
+  }
+};
+
+std::string generateContent(uint64_t size)
+{
+  std::default_random_engine e(42);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::string content(size, '\0');
+  for(char& c : content)
+    c = dist(e);
+  return content;
+}
+
+std::string computeMd5(const std::string& content)
+{
+  cryptography::Md5Hasher hasher;
+  hasher.update(content.data(), content.size());
+  return hasher.finalize();
+}
+
+std::string readFile(const sfs::path& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST_CASE("Files are downloaded in parallel", "[downloader]")
+{
+  resetStagingDir();
+  const std::string content = generateContent(3 * Downloader::MIN_CHUNK_SIZE + 12345);
+  TestServer server(content);
+  const sfs::path dest_path = DATA_DIR / "staging" / "file.zip";
+
+  Downloader downloader(server.getUrl(), dest_path);
+  downloader.init();
+  REQUIRE(downloader.supportsRanges());
+  REQUIRE(downloader.getTotalSize() == content.size());
+  downloader.setExpectedMd5(computeMd5(content));
+  std::string streamed_content;
+  downloader.setStreamCallback(
+    [&streamed_content](const char* data, uint64_t size)
+    {
+      streamed_content.append(data, size);
+      return true;
+    });
+  downloader.download();
+  REQUIRE(downloader.getMd5() == computeMd5(content));
+  REQUIRE(readFile(dest_path) == content);
+  REQUIRE(streamed_content == content);
+  REQUIRE_FALSE(Downloader::hasResumeState(dest_path));
+  REQUIRE(server.getBytesSent() == content.size());
+}
+
+TEST_CASE("Corrupted downloads are detected", "[downloader]")
+{
+  resetStagingDir();
+  const std::string content = generateContent(Downloader::MIN_CHUNK_SIZE + 10);
+  TestServer server(content);
+  const sfs::path dest_path = DATA_DIR / "staging" / "file.zip";
+
+  Downloader downloader(server.getUrl(), dest_path);
+  downloader.setExpectedMd5("d41d8cd98f00b204e9800998ecf8427e");
+  REQUIRE_THROWS(downloader.download());
+  REQUIRE_FALSE(sfs::exists(dest_path));
+  REQUIRE_FALSE(sfs::exists(Downloader::getResumeStatePath(dest_path)));
+}
+
+TEST_CASE("Interrupted downloads are resumed", "[downloader]")
+{
+  resetStagingDir();
+  const std::string content = generateContent(2 * Downloader::MIN_CHUNK_SIZE + 777);
+  TestServer server(content);
+  const sfs::path dest_path = DATA_DIR / "staging" / "file.zip";
+  server.setMaxBytesPerRequest(1024 * 1024);
+
+  Downloader interrupted_downloader(server.getUrl(), dest_path);
+  interrupted_downloader.setMaxRetries(0);
+  REQUIRE_THROWS(interrupted_downloader.download());
+  REQUIRE(Downloader::hasResumeState(dest_path));
+
+  server.setMaxBytesPerRequest(UINT64_MAX);
+  const uint64_t sent_before_resume = server.getBytesSent();
+  Downloader downloader(server.getUrl(), dest_path);
+  downloader.init();
+  REQUIRE(downloader.getResumedSize() > 0);
+  downloader.setExpectedMd5(computeMd5(content));
+  downloader.download();
+  REQUIRE(readFile(dest_path) == content);
+  REQUIRE_FALSE(Downloader::hasResumeState(dest_path));
+  REQUIRE(server.getBytesSent() - sent_before_resume ==
+          content.size() - downloader.getResumedSize());
+}
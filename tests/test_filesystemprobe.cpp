@@ -0,0 +1,47 @@
+#include "../src/core/deployer.h"
+#include "../src/core/filesystemprobe.h"
+#include "test_utils.h"
+#include <catch2/catch_test_macros.hpp>
+
+namespace sfs = std::filesystem;
+
+
+TEST_CASE("Filesystem capabilities are detected", "[probe]")
+{
+  resetStagingDir();
+  resetAppDir();
+  FilesystemProbe::clearCache();
+  const auto capabilities = FilesystemProbe::probe(DATA_DIR / "staging", DATA_DIR / "app");
+  REQUIRE(capabilities.source_writable);
+  REQUIRE(capabilities.dest_writable);
+  REQUIRE(capabilities.same_device);
+  REQUIRE(capabilities.hard_links);
+  REQUIRE(capabilities.sym_links);
+  verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "source" / "app");
+  REQUIRE(!sfs::exists(DATA_DIR / "staging" / FilesystemProbe::TEST_FILE_NAME));
+  REQUIRE(Deployer::recommendDeployMode(capabilities) == Deployer::hard_link);
+
+  const auto missing_dir = DATA_DIR / "staging" / "missing";
+  const auto invalid_capabilities = FilesystemProbe::probe(DATA_DIR / "staging", missing_dir);
+  REQUIRE(invalid_capabilities.source_writable);
+  REQUIRE_FALSE(invalid_capabilities.dest_writable);
+  REQUIRE_FALSE(invalid_capabilities.hard_links);
+  REQUIRE_FALSE(invalid_capabilities.hard_link_error.empty());
+  sfs::create_directories(missing_dir);
+  REQUIRE(FilesystemProbe::probe(DATA_DIR / "staging", missing_dir).dest_writable);
+  sfs::remove(missing_dir);
+  REQUIRE(FilesystemProbe::probe(DATA_DIR / "staging", missing_dir).dest_writable);
+  REQUIRE_FALSE(FilesystemProbe::probe(DATA_DIR / "staging", missing_dir, false).dest_writable);
+}
+
+TEST_CASE("Deploy modes are recommended", "[probe]")
+{
+  FilesystemCapabilities capabilities;
+  capabilities.sym_links = true;
+  REQUIRE(Deployer::recommendDeployMode(capabilities) == Deployer::sym_link);
+  capabilities.reflinks = true;
+  REQUIRE(Deployer::recommendDeployMode(capabilities) == Deployer::copy);
+  capabilities.hard_links = true;
+  REQUIRE(Deployer::recommendDeployMode(capabilities) == Deployer::hard_link);
+  REQUIRE(Deployer::recommendDeployMode({}) == Deployer::copy);
+}
@@ -2,7 +2,10 @@
 #include "test_utils.h"
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_vector.hpp>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 
@@ -13,6 +16,33 @@ TEST_CASE("Files are extracted", "[installer]")
   verifyDirsAreEqual(DATA_DIR / "source" / "0", DATA_DIR / "staging" / "extract");
 }
 
+TEST_CASE("Files are extracted from streams", "[installer]")
+{
+  resetStagingDir();
+  const std::vector<std::pair<std::string, std::string>> archives{ { "mod0.tar.gz", "0" },
+                                                                   { "mod1.zip", "1" } };
+  for(const auto& [archive, dir] : archives)
+  {
+    REQUIRE(Installer::supportsStreamExtraction(archive));
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    std::thread writer(
+      [write_fd = fds[1], path = DATA_DIR / "source" / archive]()
+      {
+        std::ifstream file(path, std::ios::binary);
+        char buffer[1024];
+        while(file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+          write(write_fd, buffer, file.gcount());
+        close(write_fd);
+      });
+    Installer::extractFromStream(fds[0], DATA_DIR / "staging" / dir);
+    writer.join();
+    close(fds[0]);
+    verifyDirsAreEqual(DATA_DIR / "source" / dir, DATA_DIR / "staging" / dir);
+  }
+  REQUIRE_FALSE(Installer::supportsStreamExtraction("mod.7z"));
+}
+
 TEST_CASE("Mods are (un)installed", "[installer]")
 {
   resetStagingDir();
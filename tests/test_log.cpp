@@ -0,0 +1,44 @@
+#include "../src/core/log.h"
+#include "test_utils.h"
+#include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <set>
+#include <thread>
+
+
+TEST_CASE("Log messages are written to files", "[log]")
+{
+  resetStagingDir();
+  const auto log_dir = DATA_DIR / "staging" / "logs";
+  const auto old_log_level = Log::log_level;
+  Log::log_level = Log::LOG_DEBUG;
+  Log::init(log_dir);
+  const int num_threads = 4;
+  const int num_messages = 5000;
+  std::vector<std::jthread> threads;
+  for(int thread = 0; thread < num_threads; thread++)
+    threads.emplace_back(
+      [thread]()
+      {
+        for(int i = 0; i < num_messages; i++)
+          Log::log(i % 2 == 0 ? Log::LOG_DEBUG : Log::LOG_ERROR,
+                   std::to_string(thread) + "-" + std::to_string(i));
+      });
+  threads.clear();
+  Log::flush();
+  Log::log_level = old_log_level;
+
+  std::ifstream file(log_dir / "limo_log.txt");
+  REQUIRE(file.is_open());
+  std::set<std::string> messages;
+  std::string line;
+  while(std::getline(file, line))
+  {
+    const auto pos = line.find("]: ");
+    REQUIRE(pos != std::string::npos);
+    messages.insert(line.substr(pos + 3));
+  }
+  REQUIRE(messages.size() == num_threads * num_messages);
+  REQUIRE(messages.contains("3-4999"));
+  Log::log_file_path = "";
+}
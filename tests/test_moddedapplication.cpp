@@ -110,12 +110,25 @@ TEST_CASE("State is saved", "[app]")
   app2.deployMods();
   verifyDirsAreEqual(DATA_DIR / "app", DATA_DIR / "target" / "mod012", true);
   verifyDirsAreEqual(DATA_DIR / "app_2", DATA_DIR / "source" / "2", true);
+
+  // costs measured during deployment are restored on startup
+  app2.unDeployMods();
+  const auto plans = app2.planDeploy({ 0, 1 });
+  ModdedApplication app3(DATA_DIR / "staging", "test3");
+  const auto restored_plans = app3.planDeploy({ 0, 1 });
+  REQUIRE(plans.size() == restored_plans.size());
+  for(const auto& [plan, restored_plan] : std::views::zip(plans, restored_plans))
+  {
+    REQUIRE(plan.estimated_seconds > 0);
+    REQUIRE(plan.estimated_seconds == restored_plan.estimated_seconds);
+  }
   sfs::remove_all(DATA_DIR / "app_2");
 }
 
 TEST_CASE("Groups update loadorders", "[app]")
 {
   resetStagingDir();
+  resetAppDir();
   ModdedApplication app(DATA_DIR / "staging", "test");
   app.addDeployer({ DeployerFactory::SIMPLEDEPLOYER, "depl0", DATA_DIR / "app", Deployer::hard_link });
   app.addDeployer({ DeployerFactory::SIMPLEDEPLOYER, "depl1", DATA_DIR / "app_2", Deployer::hard_link });
@@ -188,6 +201,32 @@ TEST_CASE("Mods are split", "[app]")
   sfs::remove(DATA_DIR / "staging" / "lmm_mods.json");
   sfs::remove(DATA_DIR / "staging" / ".lmm_mods.json.bak");
   verifyDirsAreEqual(DATA_DIR / "staging", DATA_DIR / "target" / "split");
+
+  // every sub-directory is moved into a new mod, managed only by the respective deployer
+  auto mod_infos = app.getModInfo();
+  std::ranges::sort(mod_infos, [](const auto& a, const auto& b) { return a.mod.id < b.mod.id; });
+  const std::vector<std::string> expected_names{ "mod 0",
+                                                 "mod 0 [depl1]",
+                                                 "mod 0 [depl1] [depl3]",
+                                                 "mod 0 [depl1] [depl3] [depl3]",
+                                                 "mod 0 [depl1] [depl4]" };
+  REQUIRE(mod_infos.size() == expected_names.size());
+  for(int i = 0; i < mod_infos.size(); i++)
+  {
+    REQUIRE(mod_infos[i].mod.id == i);
+    REQUIRE(mod_infos[i].mod.name == expected_names[i]);
+    REQUIRE(mod_infos[i].deployer_ids == std::vector<int>{ i });
+    REQUIRE_THAT(app.getLoadorder(i),
+                 Catch::Matchers::Equals(std::vector<std::tuple<int, bool>>{ { i, true } }));
+  }
+  REQUIRE(mod_infos[0].mod.size_on_disk == 2);
+  REQUIRE(mod_infos[3].mod.size_on_disk == 2);
+
+  // the last split mod counts as the most recently installed mod
+  app.cleanupFailedInstallation();
+  REQUIRE(app.getModInfo().size() == 4);
+  REQUIRE_FALSE(sfs::exists(DATA_DIR / "staging" / "4"));
+  REQUIRE(sfs::exists(DATA_DIR / "staging" / "3"));
 }
 
 TEST_CASE("Mods are uninstalled", "[app]")
@@ -1,4 +1,5 @@
 #include "../src/core/openmwarchivedeployer.h"
+#include "../src/core/openmwconfig.h"
 #include "../src/core/openmwplugindeployer.h"
 #include "test_utils.h"
 #include <catch2/catch_test_macros.hpp>
@@ -149,3 +150,33 @@ TEST_CASE("Profiles are managed", "[openmw]")
   p_depl.setProfile(1);
   verifyFilesAreEqual(DATA_DIR / "target" / "openmw" / "target" / "openmw.cfg", DATA_DIR / "target" / "openmw" / "1" / "openmw.cfg");
 }
+
+TEST_CASE("Config keys are replaced in one pass", "[openmw]")
+{
+  resetOpenMwFiles();
+
+  const sfs::path config_path = DATA_DIR / "target" / "openmw" / "target" / "openmw.cfg";
+  OpenMwConfig config(config_path);
+  REQUIRE_THAT(config.getValues("fallback-archive"),
+               Catch::Matchers::Equals(std::vector<std::string>{ "Morrowind.bsa", "A.bsa" }));
+  REQUIRE_THAT(config.getValues("content"),
+               Catch::Matchers::Equals(std::vector<std::string>{ "Morrowind.esm" }));
+  REQUIRE_FALSE(config.write());
+
+  config.setValues("content", { "Morrowind.esm", "a.esp" });
+  config.setValues("groundcover", { "c.esp" });
+  config.setValues("fallback-archive", { "Morrowind.bsa" });
+  REQUIRE(config.write());
+  REQUIRE_FALSE(sfs::exists(config_path.string() + ".tmp"));
+
+  OpenMwConfig new_config(config_path);
+  REQUIRE_THAT(new_config.getValues("content"),
+               Catch::Matchers::Equals(std::vector<std::string>{ "Morrowind.esm", "a.esp" }));
+  REQUIRE_THAT(new_config.getValues("groundcover"),
+               Catch::Matchers::Equals(std::vector<std::string>{ "c.esp" }));
+  REQUIRE_THAT(new_config.getValues("fallback-archive"),
+               Catch::Matchers::Equals(std::vector<std::string>{ "Morrowind.bsa" }));
+  REQUIRE(new_config.getValues("fallback").size() == config.getValues("fallback").size());
+  new_config.setValues("content", { "Morrowind.esm", "a.esp" });
+  REQUIRE_FALSE(new_config.write());
+}
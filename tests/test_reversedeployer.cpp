@@ -4,9 +4,11 @@
 #include "test_utils.h"
 #include <catch2/catch_test_macros.hpp>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <ranges>
+#include <sys/stat.h>
 
 namespace sfs = std::filesystem;
 
@@ -37,6 +39,9 @@ std::vector<std::string> files_to_be_ignored = {
 TEST_CASE("Ignored files are updated", "[revdepl]")
 {
   resetDirs();
+  // internal files of the deployer are neither ignored nor managed
+  for(const std::string name : { ".lmmhashes", ".lmmjournal", ".lmmfiles.new" })
+    std::ofstream(DATA_DIR / "target" / "revdepl" / "target" / name) << "data";
   ReverseDeployer depl(DATA_DIR / "source" / "revdepl" / "source",
                        DATA_DIR / "target" / "revdepl" / "target",
                        "depl",
@@ -155,6 +160,8 @@ TEST_CASE("Managed files are deployed", "[revdepl]")
   Deployer depl(DATA_DIR / "source" / "revdepl" / "data",
                 DATA_DIR / "target" / "revdepl" / "target",
                 "depl");
+  // the reference directories do not contain a deployment history
+  depl.setMaxGenerations(0);
   depl.addProfile();
   depl.addMod(0);
   depl.deploy();
@@ -194,3 +201,51 @@ TEST_CASE("Managed files are deployed", "[revdepl]")
   verifyDirsAreEqual(DATA_DIR / "target" / "revdepl" / "target",
                      DATA_DIR / "target" / "revdepl" / "managed_1", false);
 }
+
+TEST_CASE("Unchanged managed files are not redeployed", "[revdepl]")
+{
+  resetDirs();
+  const sfs::path target_dir = DATA_DIR / "target" / "revdepl" / "target";
+  ReverseDeployer rev_depl(DATA_DIR / "source" / "revdepl" / "source",
+                           target_dir,
+                           "depl",
+                           Deployer::sym_link,
+                           false,
+                           true);
+  rev_depl.addProfile();
+  sfs::copy(DATA_DIR / "target" / "revdepl" / "extra_files",
+            target_dir,
+            sfs::copy_options::skip_existing | sfs::copy_options::recursive);
+  rev_depl.deploy();
+  REQUIRE(sfs::is_symlink(target_dir / "a" / "1"));
+  auto get_inode = [](const sfs::path& path)
+  {
+    struct stat file_stat;
+    REQUIRE(lstat(path.c_str(), &file_stat) == 0);
+    return file_stat.st_ino;
+  };
+  const auto inode = get_inode(target_dir / "a" / "1");
+  rev_depl.deploy();
+  REQUIRE(get_inode(target_dir / "a" / "1") == inode);
+
+  // fingerprints are restored from disk
+  ReverseDeployer rev_depl_2(
+    DATA_DIR / "source" / "revdepl" / "source", target_dir, "depl", Deployer::sym_link);
+  rev_depl_2.deploy();
+  REQUIRE(get_inode(target_dir / "a" / "1") == inode);
+
+  const auto names = rev_depl_2.getModNames();
+  const int id = std::ranges::find(names, "a/1") - names.begin();
+  REQUIRE(id < names.size());
+  rev_depl_2.setModStatus(id, false);
+  rev_depl_2.deploy();
+  REQUIRE_FALSE(path_utils::exists(target_dir / "a" / "1"));
+  rev_depl_2.setModStatus(id, true);
+  rev_depl_2.deploy();
+  REQUIRE(sfs::is_symlink(target_dir / "a" / "1"));
+
+  // removed files are deployed again
+  sfs::remove(target_dir / "a" / "1");
+  rev_depl_2.deploy();
+  REQUIRE(sfs::is_symlink(target_dir / "a" / "1"));
+}